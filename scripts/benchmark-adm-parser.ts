@@ -0,0 +1,92 @@
+/* eslint-disable no-console */
+import 'reflect-metadata';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import * as readline from 'readline';
+import { AdmParser } from '../src/util/adm-parser';
+
+/*
+ * Measures the ADM parse throughput on a generated multi-hundred-MB ADM log.
+ *
+ * Usage: npx ts-node scripts/benchmark-adm-parser.ts [sizeInMB=300] [--keep]
+ */
+
+const sizeMb = Number(process.argv.find((x) => /^\d+$/.test(x)) ?? 300);
+const keep = process.argv.includes('--keep');
+const file = path.join(os.tmpdir(), `benchmark-${sizeMb}mb.ADM`);
+
+const pos = (i: number): string => `<${(i * 7) % 15000}.${i % 10}, ${(i * 13) % 15000}.${i % 7}, ${i % 400}.5>`;
+const player = (i: number): string => `Player "Survivor${i % 60}" (id=${(i % 60).toString(36).padStart(8, 'X')}= pos=${pos(i)})`;
+
+const LINE_FACTORIES: ((i: number, time: string) => string)[] = [
+    (i, time) => `${time} | ${player(i)}`,
+    (i, time) => `${time} | ${player(i)}`,
+    (i, time) => `${time} | ${player(i)}`,
+    (i, time) => `${time} | ${player(i)}[HP: ${i % 100}] hit by ${player(i + 1)} into Torso(12) for 14.5 damage (Bullet_556x45) with M4-A1 from ${i % 300}.2 meters`,
+    (i, time) => `${time} | ${player(i)}[HP: ${i % 100}] hit by Infected into Head(0) for 10 damage (MeleeInfected)`,
+    (i, time) => `${time} | Player "Survivor${i % 60}" (DEAD) (id=${(i % 60).toString(36).padStart(8, 'X')}= pos=${pos(i)}) killed by ${player(i + 3)} with SVD from 320.5 meters`,
+    (i, time) => `${time} | Player "Survivor${i % 60}"(id=${(i % 60).toString(36).padStart(8, 'X')}=) is connected`,
+    (i, time) => `${time} | Chat("Survivor${i % 60}"(id=${(i % 60).toString(36).padStart(8, 'X')}=)): hello world ${i}`,
+    (i, time) => `${time} | ##### PlayerList log: 60 players`,
+    (i, time) => `${time} | ${player(i)} placed Fireplace`,
+];
+
+const generate = async (): Promise<void> => {
+    if (fs.existsSync(file) && fs.statSync(file).size >= sizeMb * 1024 * 1024) {
+        return;
+    }
+    console.log(`Generating ${sizeMb} MB ADM log at ${file}`);
+    const out = fs.createWriteStream(file);
+    out.write('AdminLog started on 2023-05-06 at 00:00:00\n');
+    let written = 0;
+    let i = 0;
+    while (written < sizeMb * 1024 * 1024) {
+        const secs = Math.floor(i / 50) % 86400;
+        const time = [Math.floor(secs / 3600), Math.floor(secs / 60) % 60, secs % 60]
+            .map((x) => String(x).padStart(2, '0'))
+            .join(':');
+        const line = `${LINE_FACTORIES[i % LINE_FACTORIES.length](i, time)}\n`;
+        written += line.length;
+        i++;
+        if (!out.write(line)) {
+            await new Promise((r) => out.once('drain', r));
+        }
+    }
+    await new Promise((r) => out.end(r));
+};
+
+const run = async (): Promise<void> => {
+    await generate();
+
+    const parser = new AdmParser();
+    const counts: Record<string, number> = {};
+    let lines = 0;
+    let events = 0;
+
+    const bytes = fs.statSync(file).size;
+    const start = process.hrtime.bigint();
+    const reader = readline.createInterface({
+        input: fs.createReadStream(file, { highWaterMark: 1024 * 1024 }),
+        crlfDelay: Infinity,
+    });
+    for await (const line of reader) {
+        lines++;
+        const event = parser.parse(line, 0);
+        if (event) {
+            events++;
+            counts[event.type] = (counts[event.type] ?? 0) + 1;
+        }
+    }
+    const seconds = Number(process.hrtime.bigint() - start) / 1e9;
+
+    console.log(`Parsed ${lines} lines (${(bytes / 1024 / 1024).toFixed(1)} MB) into ${events} events in ${seconds.toFixed(2)}s`);
+    console.log(`Throughput: ${(lines / seconds).toFixed(0)} lines/s, ${(bytes / 1024 / 1024 / seconds).toFixed(1)} MB/s`);
+    console.log('Events by type:', counts);
+
+    if (!keep) {
+        fs.unlinkSync(file);
+    }
+};
+
+void run();
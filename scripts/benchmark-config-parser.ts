@@ -0,0 +1,82 @@
+/* eslint-disable no-console */
+import * as fs from 'fs';
+import { ConfigParser } from '../src/util/config-parser';
+
+/*
+ * Measures the config parse and write throughput.
+ * Without a file, config.cpp-like configs of the same size but growing nesting depth are generated,
+ * the parse time should stay about the same for all depths.
+ *
+ * Usage: npx ts-node scripts/benchmark-config-parser.ts [config.cpp] [sizeInMB=20]
+ */
+
+const file = process.argv.slice(2).find((x) => !/^\d+$/.test(x));
+const sizeMb = Number(process.argv.slice(2).find((x) => /^\d+$/.test(x)) ?? 20);
+const DEPTHS = [1, 4, 16, 64];
+
+const classBody = (i: number, tabs: string): string[] => [
+    `${tabs}scope=2;`,
+    `${tabs}displayName="Item ${i} ""quoted""";`,
+    `${tabs}model="\\dz\\gear\\item_${i}.p3d"; // model`,
+    `${tabs}weight=${i % 1000}.5;`,
+    `${tabs}itemSize[]={${i % 5},${i % 3}};`,
+    `${tabs}hiddenSelections[]={"camoGround","camoMale"};`,
+    `${tabs}hiddenSelectionsTextures[]=`,
+    `${tabs}{`,
+    `${tabs}\t"dz\\gear\\data\\item_${i}_co.paa",`,
+    `${tabs}\t"dz\\gear\\data\\item_${i}_ca.paa"`,
+    `${tabs}};`,
+];
+
+const generate = (depth: number): string => {
+    const lines: string[] = ['class CfgVehicles', '{', '\tclass Inventory_Base;'];
+    let size = 0;
+    let i = 0;
+    while (size < sizeMb * 1024 * 1024) {
+        // a chain of nested classes, the innermost has the properties
+        const chain: string[] = [];
+        for (let level = 0; level < depth; level++) {
+            const tabs = '\t'.repeat(level + 1);
+            chain.push(`${tabs}class Item_${i}_${level}: Inventory_Base`, `${tabs}{`);
+        }
+        chain.push(...classBody(i, '\t'.repeat(depth + 1)));
+        for (let level = depth - 1; level >= 0; level--) {
+            chain.push(`${'\t'.repeat(level + 1)}};`);
+        }
+        for (const line of chain) {
+            size += line.length + 2;
+        }
+        lines.push(...chain);
+        i++;
+    }
+    lines.push('};');
+    return lines.join('\r\n');
+};
+
+const measure = <T>(fnc: () => T): [T, number] => {
+    const start = process.hrtime.bigint();
+    const result = fnc();
+    return [result, Number(process.hrtime.bigint() - start) / 1e9];
+};
+
+const bench = (name: string, content: string): void => {
+    const parser = new ConfigParser();
+    const mb = content.length / 1024 / 1024;
+
+    const [parsed, parseSecs] = measure(() => parser.cfg2json(content));
+    const [written, writeSecs] = measure(() => parser.json2cfg(parsed));
+
+    console.log(
+        `${name}: ${mb.toFixed(1)} MB`
+        + ` | cfg2json ${parseSecs.toFixed(2)}s (${(mb / parseSecs).toFixed(1)} MB/s)`
+        + ` | json2cfg ${writeSecs.toFixed(2)}s (${(written.length / 1024 / 1024 / writeSecs).toFixed(1)} MB/s)`,
+    );
+};
+
+if (file) {
+    bench(file, fs.readFileSync(file, { encoding: 'utf-8' }));
+} else {
+    for (const depth of DEPTHS) {
+        bench(`depth ${depth}`, generate(depth));
+    }
+}
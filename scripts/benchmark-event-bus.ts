@@ -0,0 +1,76 @@
+/* eslint-disable no-console */
+import 'reflect-metadata';
+import { EventEmitter2 } from 'eventemitter2';
+import { EventBus } from '../src/control/event-bus';
+import { LoggerFactory } from '../src/services/loggerfactory';
+import { InternalEventTypes } from '../src/types/events';
+import { LogEntryEvent, LogTypeEnum } from '../src/types/log-reader';
+
+/*
+ * Measures the LOG_ENTRY throughput of the event bus with a few listeners (like log search, adm events and a websocket).
+ * "emitter" is the previous path, where every event went through EventEmitter2 to async listeners.
+ *
+ * Usage: npx ts-node scripts/benchmark-event-bus.ts [events=1000000] [batchSize=500]
+ */
+
+const numbers = process.argv.slice(2).filter((x) => /^\d+$/.test(x)).map(Number);
+const count = numbers[0] ?? 1_000_000;
+const batchSize = numbers[1] ?? 500;
+const LISTENERS = 3;
+
+const events: LogEntryEvent[] = [];
+for (let i = 0; i < count; i++) {
+    events.push({
+        type: LogTypeEnum.RPT,
+        entry: { timestamp: i, message: `12:00:00 Line ${i}` },
+    });
+}
+
+let received = 0;
+
+const measure = async (name: string, run: () => void | Promise<void>): Promise<void> => {
+    received = 0;
+    const start = process.hrtime.bigint();
+    await run();
+    // let async listeners finish
+    await new Promise((r) => setImmediate(r));
+    const secs = Number(process.hrtime.bigint() - start) / 1e9;
+    console.log(
+        `${name.padEnd(22)}: ${(count / secs / 1e6).toFixed(2)}M events/s`
+        + ` (${secs.toFixed(2)}s, ${received} deliveries)`,
+    );
+};
+
+const main = async (): Promise<void> => {
+    await measure('emitter (before)', () => {
+        const emitter = new EventEmitter2();
+        for (let i = 0; i < LISTENERS; i++) {
+            emitter.on(InternalEventTypes.LOG_ENTRY, async () => { received++; }, { objectify: true });
+        }
+        for (const event of events) {
+            emitter.emit(InternalEventTypes.LOG_ENTRY, event);
+        }
+    });
+
+    await measure('emit', () => {
+        const eventBus = new EventBus(new LoggerFactory());
+        for (let i = 0; i < LISTENERS; i++) {
+            eventBus.on(InternalEventTypes.LOG_ENTRY, async () => { received++; });
+        }
+        for (const event of events) {
+            eventBus.emit(InternalEventTypes.LOG_ENTRY, event);
+        }
+    });
+
+    await measure(`emitBatch (${batchSize})`, () => {
+        const eventBus = new EventBus(new LoggerFactory());
+        for (let i = 0; i < LISTENERS; i++) {
+            eventBus.onBatch(InternalEventTypes.LOG_ENTRY, (batch) => { received += batch.length; });
+        }
+        for (let i = 0; i < events.length; i += batchSize) {
+            eventBus.emitBatch(InternalEventTypes.LOG_ENTRY, events.slice(i, i + batchSize));
+        }
+    });
+};
+
+void main();
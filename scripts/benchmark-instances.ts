@@ -0,0 +1,176 @@
+/* eslint-disable no-console */
+import 'reflect-metadata';
+import * as childProcess from 'child_process';
+import * as crypto from 'crypto';
+import * as fs from 'fs';
+import * as os from 'os';
+import * as path from 'path';
+import { container } from 'tsyringe';
+import { ManagerController } from '../src/control/manager-controller';
+import { InstanceSupervisor } from '../src/control/instance-supervisor';
+import { Paths } from '../src/services/paths';
+import { ModStore } from '../src/services/mod-store';
+
+/*
+ * Compares the memory of N server instances in one manager process with N separate manager processes.
+ * All services of the instances are created (not started), so it measures the per-instance overhead of the services.
+ *
+ * Also compares the disk usage of the installed mods: copied into every server folder (separate managers / useModStore disabled)
+ * and deployed from the shared mod store. The workshop downloads are the same for both and not counted.
+ *
+ * Usage: npx ts-node scripts/benchmark-instances.ts [instances=3]
+ */
+
+const MODS = 5;
+const FILES_PER_MOD = 8;
+const FILE_SIZE = 1024 * 1024;
+
+interface MemoryResult {
+    rss: number;
+    heapUsed: number;
+}
+
+const mb = (bytes: number): string => `${(bytes / 1024 / 1024).toFixed(1)}MB`;
+
+const createInstances = (count: number): void => {
+    const cwd = fs.mkdtempSync(path.join(os.tmpdir(), 'dzsm-instances-'));
+    const instances = [];
+    for (let i = 0; i < count; i++) {
+        fs.mkdirSync(path.join(cwd, `server-${i}`));
+        instances.push({ id: `server-${i}`, path: `server-${i}` });
+    }
+    fs.writeFileSync(path.join(cwd, InstanceSupervisor.INSTANCES_FILE), JSON.stringify({ instances }));
+
+    // keep the imported controller (and with it all services) registered
+    void ManagerController;
+    container.resolve(Paths).setCwd(cwd);
+    const supervisor = container.resolve(InstanceSupervisor);
+    for (const definition of supervisor.readInstances()) {
+        const instanceContainer = supervisor.createInstanceContainer(definition);
+        for (const service of InstanceSupervisor.INSTANCE_SERVICES) {
+            instanceContainer.resolve(service);
+        }
+    }
+    fs.rmSync(cwd, { recursive: true, force: true });
+};
+
+/**
+ * @returns the size of all files in the dir, hardlinked files are counted once
+ */
+const diskUsage = (dir: string, seen = new Set<string>()): number => {
+    let total = 0;
+    for (const entry of fs.readdirSync(dir, { withFileTypes: true })) {
+        const file = path.join(dir, entry.name);
+        if (entry.isDirectory()) {
+            total += diskUsage(file, seen);
+        } else {
+            const stat = fs.statSync(file);
+            const key = `${stat.dev}:${stat.ino}`;
+            if (!seen.has(key)) {
+                seen.add(key);
+                total += stat.size;
+            }
+        }
+    }
+    return total;
+};
+
+const createWorkshop = (dir: string): string[] => {
+    // the same key file is part of every mod, like the shared signing keys of a mod pack
+    const key = crypto.randomBytes(4096);
+    const modIds: string[] = [];
+    for (let i = 0; i < MODS; i++) {
+        const modId = `${1000000 + i}`;
+        const modDir = path.join(dir, modId);
+        fs.mkdirSync(path.join(modDir, 'addons'), { recursive: true });
+        fs.mkdirSync(path.join(modDir, 'keys'), { recursive: true });
+        for (let j = 0; j < FILES_PER_MOD; j++) {
+            fs.writeFileSync(path.join(modDir, 'addons', `file${j}.pbo`), crypto.randomBytes(FILE_SIZE));
+        }
+        fs.writeFileSync(path.join(modDir, 'keys', 'pack.bikey'), key);
+        modIds.push(modId);
+    }
+    return modIds;
+};
+
+const measureDisk = async (count: number, useModStore: boolean): Promise<number> => {
+    const cwd = fs.mkdtempSync(path.join(os.tmpdir(), 'dzsm-disk-'));
+    try {
+        const workshop = path.join(cwd, 'workshop');
+        const modIds = createWorkshop(workshop);
+
+        const instances = [];
+        for (let i = 0; i < count; i++) {
+            fs.mkdirSync(path.join(cwd, `server-${i}`));
+            instances.push({ id: `server-${i}`, path: `server-${i}` });
+        }
+        fs.writeFileSync(path.join(cwd, InstanceSupervisor.INSTANCES_FILE), JSON.stringify({ instances }));
+
+        container.resolve(Paths).setCwd(cwd);
+        const supervisor = container.resolve(InstanceSupervisor);
+        for (const definition of supervisor.readInstances()) {
+            const instanceContainer = supervisor.createInstanceContainer(definition);
+            const serverDir = path.join(cwd, definition.path);
+            for (const modId of modIds) {
+                const target = path.join(serverDir, `@${modId}`);
+                if (useModStore) {
+                    const modStore = instanceContainer.resolve(ModStore);
+                    await modStore.ingest(modId, path.join(workshop, modId));
+                    await modStore.deploy(modId, target);
+                } else {
+                    await instanceContainer.resolve(Paths).copyDirFromTo(path.join(workshop, modId), target);
+                }
+            }
+        }
+
+        // server folders and the store share a set, so objects linked into several folders count once
+        const seen = new Set<string>();
+        return fs.readdirSync(cwd, { withFileTypes: true })
+            .filter((x) => x.isDirectory() && x.name !== 'workshop')
+            .reduce((total, x) => total + diskUsage(path.join(cwd, x.name), seen), 0);
+    } finally {
+        fs.rmSync(cwd, { recursive: true, force: true });
+    }
+};
+
+const measureChild = (count: number): Promise<MemoryResult> => new Promise((resolve, reject) => {
+    const child = childProcess.fork(
+        __filename,
+        ['--child', `${count}`],
+        {
+            execArgv: [...process.execArgv, '--expose-gc'],
+            stdio: ['ignore', 'ignore', 'inherit', 'ipc'],
+        },
+    );
+    child.on('message', (result: MemoryResult) => resolve(result));
+    child.on('error', reject);
+});
+
+const main = async (): Promise<void> => {
+    if (process.argv[2] === '--child') {
+        createInstances(Number(process.argv[3]));
+        (global as any).gc?.();
+        const memory = process.memoryUsage();
+        process.send({ rss: memory.rss, heapUsed: memory.heapUsed } as MemoryResult);
+        process.exit(0);
+    }
+
+    const count = Number(process.argv[2] ?? 3);
+
+    const single = await measureChild(count);
+    const separate = await Promise.all([...Array(count)].map(() => measureChild(1)));
+    const sum = (results: MemoryResult[], key: keyof MemoryResult): number =>
+        results.reduce((total, x) => total + x[key], 0);
+
+    console.log(`one process, ${count} instances : rss ${mb(single.rss)}, heap ${mb(single.heapUsed)}`);
+    console.log(
+        `${count} processes, 1 instance: rss ${mb(sum(separate, 'rss'))}, heap ${mb(sum(separate, 'heapUsed'))}`,
+    );
+
+    const copied = await measureDisk(count, false);
+    const stored = await measureDisk(count, true);
+    console.log(`${count} instances x ${MODS} mods, copied    : disk ${mb(copied)}`);
+    console.log(`${count} instances x ${MODS} mods, mod store : disk ${mb(stored)}`);
+};
+
+void main();
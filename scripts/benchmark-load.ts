@@ -0,0 +1,320 @@
+/* eslint-disable no-console */
+import 'reflect-metadata';
+import * as childProcess from 'child_process';
+import * as dgram from 'dgram';
+import * as fs from 'fs';
+import * as net from 'net';
+import * as os from 'os';
+import * as path from 'path';
+import { monitorEventLoopDelay } from 'perf_hooks';
+import { container } from 'tsyringe';
+import { ManagerController } from '../src/control/manager-controller';
+import { EventBus } from '../src/control/event-bus';
+import { Config } from '../src/config/config';
+import { ConfigFileHelper } from '../src/config/config-file-helper';
+import { Paths } from '../src/services/paths';
+import { RCON } from '../src/services/rcon';
+import { IngameReport } from '../src/services/ingame-report';
+import { Sqlite3Wrapper } from '../src/services/database';
+import { InternalEventTypes } from '../src/types/events';
+import { LogLevel } from '../src/util/logger';
+import { detectOS } from '../src/util/detect-os';
+import { FakeServerOptions, FakeServerStats } from './load-test/fake-dayz-server';
+
+/*
+ * End-to-end load test of the manager against a simulated DayZ server (scripts/load-test/fake-dayz-server.ts).
+ *
+ * The manager runs in this process with all its services, the fake server in a child process which is
+ * detected like the real server. After the warmup, the harness measures:
+ * - ingest latency of the log lines (written -> LOG_ENTRY event) per log type
+ * - ingest latency of the ingame reports (written / posted -> processed)
+ * - RCON round trips of the players command
+ * - event loop lag, heap growth and SQLite writes (statements, transactions and rows per second)
+ *
+ * Usage: npx ts-node scripts/benchmark-load.ts [--duration=60] [--warmup=10] [--rpt=200] [--adm=100] [--script=50]
+ *          [--players=60] [--vehicles=100] [--tick=1000] [--rest] [--rconMessages=2] [--json=result.json] [--keep]
+ */
+
+const arg = (name: string, fallback: number): number => {
+    const value = process.argv.find((x) => x.startsWith(`--${name}=`));
+    return value ? Number(value.split('=')[1]) : fallback;
+};
+const flag = (name: string): boolean => process.argv.includes(`--${name}`);
+
+const duration = arg('duration', 60) * 1000;
+const warmup = arg('warmup', 10) * 1000;
+const jsonOut = process.argv.find((x) => x.startsWith('--json='))?.split('=')[1];
+const initialCwd = process.cwd();
+
+class Samples {
+
+    private values: number[] = [];
+
+    public add(value: number): void {
+        this.values.push(value);
+    }
+
+    public summary(): { count: number; avg: number; p50: number; p95: number; max: number } {
+        const sorted = [...this.values].sort((a, b) => a - b);
+        const at = (q: number): number => sorted[Math.min(sorted.length - 1, Math.floor(sorted.length * q))] ?? 0;
+        return {
+            count: sorted.length,
+            avg: sorted.length ? Math.round(sorted.reduce((a, b) => a + b, 0) / sorted.length) : 0,
+            p50: at(0.5),
+            p95: at(0.95),
+            max: sorted[sorted.length - 1] ?? 0,
+        };
+    }
+
+}
+
+const freeTcpPort = (): Promise<number> => new Promise((r) => {
+    const server = net.createServer().listen(0, '127.0.0.1', () => {
+        const port = (server.address() as net.AddressInfo).port;
+        server.close(() => r(port));
+    });
+});
+
+const freeUdpPort = (): Promise<number> => new Promise((r) => {
+    const socket = dgram.createSocket('udp4');
+    socket.bind(0, '127.0.0.1', () => {
+        const port = socket.address().port;
+        socket.close(() => r(port));
+    });
+});
+
+/**
+ * The manager identifies the server by its executable, so the fake server runs from a copy of node at the server exe path
+ */
+const createServerExe = (serverDir: string, exe: string): string => {
+    const exePath = path.join(serverDir, exe);
+    fs.mkdirSync(serverDir, { recursive: true });
+    try {
+        fs.linkSync(process.execPath, exePath);
+    } catch {
+        fs.copyFileSync(process.execPath, exePath);
+        fs.chmodSync(exePath, 0o755);
+    }
+    return exePath;
+};
+
+const startFakeServer = (exePath: string, options: FakeServerOptions): Promise<childProcess.ChildProcess> => new Promise((resolve, reject) => {
+    const child = childProcess.fork(
+        path.join(__dirname, 'load-test', 'fake-dayz-server.ts'),
+        [JSON.stringify(options)],
+        {
+            execPath: exePath,
+            execArgv: ['-r', require.resolve('ts-node/register/transpile-only')],
+            cwd: path.dirname(exePath),
+        },
+    );
+    child.once('message', (message) => (message === 'started' ? resolve(child) : reject(new Error(`${message}`))));
+    child.once('exit', (code) => reject(new Error(`Fake server exited with ${code}`)));
+});
+
+const stopFakeServer = (child: childProcess.ChildProcess): Promise<FakeServerStats> => new Promise((r) => {
+    child.once('message', (stats: FakeServerStats) => r(stats));
+    child.send('stop');
+});
+
+/**
+ * Counts the statements, transactions and written rows of all databases
+ */
+const instrumentSqlite = (): { statements: number; transactions: number; rows: number; samples: Samples } => {
+    const counters = { statements: 0, transactions: 0, rows: 0, samples: new Samples() };
+    const proto = Sqlite3Wrapper.prototype as any;
+    const run = proto.run;
+    proto.run = function (...args: any[]) {
+        const start = process.hrtime.bigint();
+        const result = run.apply(this, args);
+        counters.samples.add(Number(process.hrtime.bigint() - start) / 1e6);
+        counters.statements++;
+        counters.rows += result?.changes ?? 0;
+        return result;
+    };
+    const transaction = proto.transaction;
+    proto.transaction = function (...args: any[]) {
+        const changes = (): number => this.db.prepare('SELECT total_changes() AS c').get().c;
+        const before = changes();
+        const start = process.hrtime.bigint();
+        const result = transaction.apply(this, args);
+        counters.samples.add(Number(process.hrtime.bigint() - start) / 1e6);
+        counters.transactions++;
+        counters.rows += changes() - before;
+        return result;
+    };
+    return counters;
+};
+
+const main = async (): Promise<void> => {
+    const rest = flag('rest');
+    const cwd = fs.mkdtempSync(path.join(os.tmpdir(), 'dzsm-load-'));
+    const exe = detectOS() === 'windows' ? 'DayZServer_x64.exe' : 'DayZServer_x64';
+    const [rconPort, webPort, ingameApiPort] = await Promise.all([freeUdpPort(), freeTcpPort(), freeTcpPort()]);
+    const rconPassword = 'loadtest';
+
+    const config = Object.assign(new Config(), {
+        loglevel: LogLevel.WARN,
+        serverPath: 'DayZServer',
+        serverExe: exe,
+        profilesPath: 'profiles',
+        rconPort,
+        rconPassword,
+        webPort,
+        ingameApiPort,
+        ingameApiKey: 'loadtest',
+        ingameReportViaRest: rest,
+        ingameReportIntervall: arg('tick', 1000) / 1000,
+        serverProcessPollIntervall: 1000,
+        // never restart or update anything, the fake server is managed by the harness
+        lockServerRestart: true,
+        disableServerLockLogs: true,
+        disableStuckCheck: true,
+        modUpdateChekerIntervall: 2_000_000_000,
+        updateModsOnStartup: false,
+        updateServerOnStartup: false,
+        metricPollIntervall: 1000,
+        rconPlayerReconcileInterval: 5000,
+    } as Partial<Config>);
+    fs.writeFileSync(path.join(cwd, ConfigFileHelper.CFG_NAME), JSON.stringify(config, null, 4));
+
+    const serverDir = path.join(cwd, 'DayZServer');
+    const fakeOptions: FakeServerOptions = {
+        profilesPath: path.join(serverDir, 'profiles'),
+        rptRate: arg('rpt', 200),
+        admRate: arg('adm', 100),
+        scriptRate: arg('script', 50),
+        markerEvery: 10,
+        players: arg('players', 60),
+        vehicles: arg('vehicles', 100),
+        tickInterval: arg('tick', 1000),
+        rconPort,
+        rconPassword,
+        rconMessageRate: arg('rconMessages', 2),
+    };
+    const fakeServer = await startFakeServer(createServerExe(serverDir, exe), fakeOptions);
+    console.log(`Fake server started (pid ${fakeServer.pid}), working dir: ${cwd}`);
+
+    process.chdir(cwd);
+    container.resolve(Paths).setCwd(cwd);
+
+    const sqlite = instrumentSqlite();
+    const eventBus = container.resolve(EventBus);
+    const rcon = container.resolve(RCON);
+    const ingameReport = container.resolve(IngameReport);
+
+    let measuring = false;
+    const logLatency = new Map<string, Samples>();
+    const reportLatency = new Samples();
+    const rconLatency = new Samples();
+    let linesIngested = 0;
+
+    eventBus.onBatch(InternalEventTypes.LOG_ENTRY, (events) => {
+        if (!measuring) return;
+        const now = Date.now();
+        linesIngested += events.length;
+        for (const event of events) {
+            const marker = event.entry.message.lastIndexOf(' lt=');
+            if (marker >= 0) {
+                if (!logLatency.has(event.type)) {
+                    logLatency.set(event.type, new Samples());
+                }
+                logLatency.get(event.type).add(now - Number(event.entry.message.slice(marker + 4)));
+            }
+        }
+    });
+
+    const processIngameReport = ingameReport.processIngameReport.bind(ingameReport);
+    ingameReport.processIngameReport = async (report) => {
+        const sentAt = (report as any)?.sentAt;
+        if (measuring && sentAt) {
+            reportLatency.add(Date.now() - sentAt);
+        }
+        return processIngameReport(report);
+    };
+
+    const controller = container.resolve(ManagerController);
+    await controller.start();
+
+    const rconPoll = setInterval(() => {
+        if (!measuring || !rcon.isConnected()) return;
+        const start = Date.now();
+        void rcon.getPlayersRaw().then(() => rconLatency.add(Date.now() - start));
+    }, 1000);
+
+    console.log(`Warming up for ${warmup / 1000}s..`);
+    await new Promise((r) => setTimeout(r, warmup));
+
+    (global as any).gc?.();
+    const heapStart = process.memoryUsage();
+    const sqliteStart = { ...sqlite };
+    sqlite.samples = new Samples();
+    const lag = monitorEventLoopDelay({ resolution: 10 });
+    lag.enable();
+    measuring = true;
+    let heapMax = heapStart.heapUsed;
+    const heapPoll = setInterval(() => {
+        heapMax = Math.max(heapMax, process.memoryUsage().heapUsed);
+    }, 1000);
+
+    console.log(`Measuring for ${duration / 1000}s..`);
+    await new Promise((r) => setTimeout(r, duration));
+
+    measuring = false;
+    lag.disable();
+    clearInterval(rconPoll);
+    clearInterval(heapPoll);
+    (global as any).gc?.();
+    const heapEnd = process.memoryUsage();
+    const secs = duration / 1000;
+
+    const fakeStats = await stopFakeServer(fakeServer);
+    await controller.stop();
+
+    const result = {
+        options: { ...fakeOptions, rest, duration: secs, warmup: warmup / 1000 },
+        written: fakeStats,
+        ingest: {
+            linesPerSec: Math.round(linesIngested / secs),
+            latencyMs: [...logLatency.entries()].reduce(
+                (acc, [type, samples]) => ({ ...acc, [type]: samples.summary() }),
+                {} as Record<string, ReturnType<Samples['summary']>>,
+            ),
+            ingameReportLatencyMs: reportLatency.summary(),
+        },
+        rcon: {
+            playersRoundTripMs: rconLatency.summary(),
+            commands: rcon.getCommandStats(),
+        },
+        eventLoopLagMs: {
+            mean: Math.round(lag.mean / 1e6),
+            p99: Math.round(lag.percentile(99) / 1e6),
+            max: Math.round(lag.max / 1e6),
+        },
+        heap: {
+            startMB: +(heapStart.heapUsed / 1048576).toFixed(1),
+            endMB: +(heapEnd.heapUsed / 1048576).toFixed(1),
+            maxMB: +(heapMax / 1048576).toFixed(1),
+            growthMBPerMin: +((heapEnd.heapUsed - heapStart.heapUsed) / 1048576 / (secs / 60)).toFixed(2),
+            rssMB: +(heapEnd.rss / 1048576).toFixed(1),
+        },
+        sqlite: {
+            statementsPerSec: Math.round((sqlite.statements - sqliteStart.statements) / secs),
+            transactionsPerSec: +((sqlite.transactions - sqliteStart.transactions) / secs).toFixed(1),
+            rowsPerSec: Math.round((sqlite.rows - sqliteStart.rows) / secs),
+            durationMs: sqlite.samples.summary(),
+        },
+    };
+
+    console.log(JSON.stringify(result, null, 2));
+    process.chdir(initialCwd);
+    if (jsonOut) {
+        fs.writeFileSync(jsonOut, JSON.stringify(result, null, 2));
+    }
+    if (!flag('keep')) {
+        fs.rmSync(cwd, { recursive: true, force: true });
+    }
+    process.exit(0);
+};
+
+void main();
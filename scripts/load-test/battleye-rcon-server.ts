@@ -0,0 +1,155 @@
+import * as dgram from 'dgram';
+
+/*
+ * Minimal BattlEye RCon server (UDP, protocol v2) for the simulated DayZ server.
+ *
+ * Packet: 'B' 'E' <crc32 LE of the rest> 0xFF <type> <payload>
+ * - 0x00 login: password -> 0x01 (ok) / 0x00 (wrong)
+ * - 0x01 command: seq + command -> seq + response (empty command = keep alive)
+ * - 0x02 server message: seq + message, acknowledged by the client with seq
+ */
+
+const CRC_TABLE = new Int32Array(256).map((_, n) => {
+    let c = n;
+    for (let k = 0; k < 8; k++) {
+        c = (c & 1) ? (0xEDB88320 ^ (c >>> 1)) : (c >>> 1);
+    }
+    return c;
+});
+
+const crc32 = (buffer: Buffer): number => {
+    let crc = -1;
+    for (const byte of buffer) {
+        crc = CRC_TABLE[(crc ^ byte) & 0xFF] ^ (crc >>> 8);
+    }
+    return (crc ^ -1) >>> 0;
+};
+
+const packet = (type: number, payload: Buffer): Buffer => {
+    const body = Buffer.concat([Buffer.from([0xFF, type]), payload]);
+    const header = Buffer.alloc(6);
+    header.write('BE', 0, 'ascii');
+    header.writeUInt32LE(crc32(body), 2);
+    return Buffer.concat([header, body]);
+};
+
+/** max payload of a single response packet, longer responses are split */
+const MAX_PAYLOAD = 1024;
+
+export type RconCommandHandler = (command: string) => string;
+
+export interface RconServerStats {
+    logins: number;
+    commands: number;
+    keepAlives: number;
+    messagesSent: number;
+    messagesAcknowledged: number;
+}
+
+export class BattleyeRconServer {
+
+    /** response per command verb, unknown commands get an empty response */
+    public handlers = new Map<string, RconCommandHandler>();
+
+    public readonly stats: RconServerStats = {
+        logins: 0,
+        commands: 0,
+        keepAlives: 0,
+        messagesSent: 0,
+        messagesAcknowledged: 0,
+    };
+
+    private socket: dgram.Socket | undefined;
+    private client: { address: string; port: number } | undefined;
+    private messageSeq = 0;
+
+    public constructor(
+        private port: number,
+        private password: string,
+    ) {}
+
+    public async start(): Promise<void> {
+        this.socket = dgram.createSocket('udp4');
+        this.socket.on('message', (msg, rinfo) => this.handle(msg, rinfo));
+        await new Promise<void>((r) => this.socket.bind(this.port, '127.0.0.1', () => r()));
+    }
+
+    public stop(): void {
+        this.socket?.close();
+        this.socket = undefined;
+    }
+
+    public isClientConnected(): boolean {
+        return !!this.client;
+    }
+
+    /** sends a server message (i.e. a player connect) to the logged in client */
+    public broadcast(message: string): void {
+        if (!this.client) {
+            return;
+        }
+        const seq = this.messageSeq;
+        this.messageSeq = (this.messageSeq + 1) % 256;
+        this.send(packet(0x02, Buffer.concat([Buffer.from([seq]), Buffer.from(message)])));
+        this.stats.messagesSent++;
+    }
+
+    private send(buffer: Buffer): void {
+        this.socket?.send(buffer, this.client.port, this.client.address);
+    }
+
+    private handle(msg: Buffer, rinfo: dgram.RemoteInfo): void {
+        if (msg.length < 8 || msg.toString('ascii', 0, 2) !== 'BE' || msg.readUInt32LE(2) !== crc32(msg.subarray(6))) {
+            return;
+        }
+        const type = msg[7];
+        const payload = msg.subarray(8);
+
+        if (type === 0x00) {
+            const ok = payload.toString() === this.password;
+            if (ok) {
+                this.client = { address: rinfo.address, port: rinfo.port };
+                this.stats.logins++;
+            }
+            this.socket?.send(packet(0x00, Buffer.from([ok ? 0x01 : 0x00])), rinfo.port, rinfo.address);
+            return;
+        }
+
+        if (!this.client || this.client.port !== rinfo.port) {
+            return;
+        }
+
+        if (type === 0x02) {
+            this.stats.messagesAcknowledged++;
+            return;
+        }
+
+        if (type === 0x01) {
+            const seq = payload[0];
+            const command = payload.subarray(1).toString();
+            if (!command) {
+                this.stats.keepAlives++;
+                this.send(packet(0x01, Buffer.from([seq])));
+                return;
+            }
+            this.stats.commands++;
+            const handler = this.handlers.get(command.split(' ')[0]);
+            this.respond(seq, Buffer.from(handler ? handler(command) : ''));
+        }
+    }
+
+    private respond(seq: number, data: Buffer): void {
+        if (data.length <= MAX_PAYLOAD) {
+            this.send(packet(0x01, Buffer.concat([Buffer.from([seq]), data])));
+            return;
+        }
+        const count = Math.ceil(data.length / MAX_PAYLOAD);
+        for (let i = 0; i < count; i++) {
+            this.send(packet(0x01, Buffer.concat([
+                Buffer.from([seq, 0x00, count, i]),
+                data.subarray(i * MAX_PAYLOAD, (i + 1) * MAX_PAYLOAD),
+            ])));
+        }
+    }
+
+}
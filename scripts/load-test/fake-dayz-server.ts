@@ -0,0 +1,281 @@
+import * as fs from 'fs';
+import * as http from 'http';
+import * as path from 'path';
+import { BattleyeRconServer, RconServerStats } from './battleye-rcon-server';
+
+/*
+ * Simulated DayZ server for the load test (scripts/benchmark-load.ts).
+ *
+ * It is started from a copy of the node binary placed at the configured server exe path,
+ * so the manager detects it like the real server process. It then behaves like the server with the DZSM mod:
+ * - appends RPT, ADM and script log lines to the profiles dir at the configured rates
+ * - reports N players and vehicles via DZSM-TICK.json or POST /ingamereport, depending on DZSMApiOptions.json
+ * - answers BattlEye RCon and sends player connect / disconnect messages
+ *
+ * Every nth log line and every report carries the time it was written (lt=<ms> / sentAt),
+ * so the harness can measure how long the manager took to ingest it.
+ */
+
+export interface FakeServerOptions {
+    profilesPath: string;
+    /** log lines per second */
+    rptRate: number;
+    admRate: number;
+    scriptRate: number;
+    /** every nth log line carries its write time */
+    markerEvery: number;
+    players: number;
+    vehicles: number;
+    /** ms between ingame reports */
+    tickInterval: number;
+    rconPort: number;
+    rconPassword: string;
+    /** player connect / disconnect messages per second */
+    rconMessageRate: number;
+}
+
+export interface FakeServerStats {
+    lines: { RPT: number; ADM: number; SCRIPT: number };
+    bytes: number;
+    reports: { file: number; rest: number; restErrors: number; restAvgMs: number; restMaxMs: number };
+    rcon: RconServerStats;
+}
+
+const WRITE_INTERVAL = 100;
+
+const pad = (x: number, length: number = 2): string => String(x).padStart(length, '0');
+const time = (date: Date): string => `${pad(date.getHours())}:${pad(date.getMinutes())}:${pad(date.getSeconds())}`;
+const playerId = (i: number): string => `${(i % 1000).toString(36).padStart(8, 'X')}=`;
+const pos = (i: number, t: number): string => `<${(i * 97 + t) % 15000}.5, ${(i * 13 + t) % 15000}.2, ${i % 400}.0>`;
+const player = (i: number, t: number): string => `Player "Survivor${i}" (id=${playerId(i)} pos=${pos(i, t)})`;
+
+const ADM_LINES: ((i: number, t: number) => string)[] = [
+    (i, t) => player(i, t),
+    (i, t) => player(i, t),
+    (i, t) => `${player(i, t)}[HP: ${i % 100}] hit by ${player(i + 1, t)} into Torso(12) for 14.5 damage (Bullet_556x45) with M4-A1 from ${i % 300}.2 meters`,
+    (i, t) => `${player(i, t)}[HP: ${i % 100}] hit by Infected into Head(0) for 10 damage (MeleeInfected)`,
+    (i, t) => `Player "Survivor${i}" (DEAD) (id=${playerId(i)} pos=${pos(i, t)}) killed by ${player(i + 3, t)} with SVD from 320.5 meters`,
+    (i, t) => `${player(i, t)} placed Fireplace`,
+];
+
+const RPT_LINES: ((i: number) => string)[] = [
+    (i) => `[CE][Storage] Restore: ${i} items restored`,
+    (i) => `Player "Survivor${i}"(id=${playerId(i)}) has been disconnected`,
+    (i) => `SCRIPT (E): @"scripts/4_World/entities/manbase/playerbase.c,${i}": NULL pointer to instance`,
+    (i) => `Average server FPS: ${40 + (i % 20)}.12 (measured interval: 30 s)`,
+];
+
+const SCRIPT_LINES: ((i: number) => string)[] = [
+    (i) => `SCRIPT       : [DZSM] player ${i} position update`,
+    (i) => `SCRIPT       : Creating item Apple at ${i % 15000} 0 ${i % 9000}`,
+];
+
+interface LogFile {
+    fd: number;
+    rate: number;
+    pending: number;
+    written: number;
+    line: (i: number, now: Date, marker: string) => string;
+}
+
+export class FakeDayZServer {
+
+    private rcon: BattleyeRconServer;
+    private files: Record<'RPT' | 'ADM' | 'SCRIPT', LogFile>;
+    private timers: NodeJS.Timeout[] = [];
+    private restTotalMs = 0;
+
+    public readonly stats: FakeServerStats;
+
+    public constructor(private options: FakeServerOptions) {
+        this.rcon = new BattleyeRconServer(options.rconPort, options.rconPassword);
+        this.stats = {
+            lines: { RPT: 0, ADM: 0, SCRIPT: 0 },
+            bytes: 0,
+            reports: { file: 0, rest: 0, restErrors: 0, restAvgMs: 0, restMaxMs: 0 },
+            rcon: this.rcon.stats,
+        };
+    }
+
+    public async start(): Promise<void> {
+        const started = new Date();
+        const stamp = `${started.getFullYear()}-${pad(started.getMonth() + 1)}-${pad(started.getDate())}`
+            + `_${pad(started.getHours())}-${pad(started.getMinutes())}-${pad(started.getSeconds())}`;
+        fs.mkdirSync(this.options.profilesPath, { recursive: true });
+        const open = (name: string): number => fs.openSync(path.join(this.options.profilesPath, name), 'a');
+
+        const adm = open(`DayZServer_x64_${stamp}.ADM`);
+        fs.writeSync(adm, `AdminLog started on ${stamp.slice(0, 10)} at ${time(started)}\n`);
+
+        this.files = {
+            RPT: {
+                fd: open(`DayZServer_x64_${stamp}.RPT`),
+                rate: this.options.rptRate,
+                pending: 0,
+                written: 0,
+                line: (i, now, marker) => `${time(now)}.${pad(now.getMilliseconds(), 3)} ${RPT_LINES[i % RPT_LINES.length](i % 100)}${marker}`,
+            },
+            ADM: {
+                fd: adm,
+                rate: this.options.admRate,
+                pending: 0,
+                written: 0,
+                // the marker is put into a chat message, so the line is still parsed like a real one
+                line: (i, now, marker) => `${time(now)} | ${marker
+                    ? `Chat("Survivor${i % 100}"(id=${playerId(i % 100)})):${marker}`
+                    : ADM_LINES[i % ADM_LINES.length](i % 100, i)}`,
+            },
+            SCRIPT: {
+                fd: open(`script_${stamp}.log`),
+                rate: this.options.scriptRate,
+                pending: 0,
+                written: 0,
+                line: (i, now, marker) => `${time(now)}.${pad(now.getMilliseconds(), 3)} ${SCRIPT_LINES[i % SCRIPT_LINES.length](i)}${marker}`,
+            },
+        };
+
+        this.setupRcon();
+        await this.rcon.start();
+
+        this.timers.push(setInterval(() => this.writeLogs(), WRITE_INTERVAL));
+        this.timers.push(setInterval(() => void this.report(), this.options.tickInterval));
+        if (this.options.rconMessageRate > 0) {
+            let toggle = 0;
+            this.timers.push(setInterval(() => {
+                // players above the reported ones join and leave
+                const id = this.options.players + (toggle % 10);
+                this.rcon.broadcast(toggle % 20 < 10
+                    ? `Player #${id} Survivor${id} (127.0.0.1:2304) connected`
+                    : `Player #${id} Survivor${id} disconnected`);
+                toggle++;
+            }, 1000 / this.options.rconMessageRate));
+        }
+    }
+
+    public stop(): void {
+        this.timers.forEach((x) => clearInterval(x));
+        this.timers = [];
+        this.rcon.stop();
+        for (const file of Object.values(this.files ?? {})) {
+            fs.closeSync(file.fd);
+        }
+    }
+
+    private setupRcon(): void {
+        this.rcon.handlers.set('players', () => {
+            const lines = ['Players on server:', '[#] [IP Address]:[Port] [Ping] [GUID] [Name]', '-'.repeat(50)];
+            for (let i = 0; i < this.options.players; i++) {
+                lines.push(`${i}   127.0.0.1:${2304 + i}   ${20 + (i % 50)}   ${i.toString(16).padStart(32, 'a')}(OK) Survivor${i}`);
+            }
+            lines.push(`(${this.options.players} players in total)`);
+            return lines.join('\n');
+        });
+        this.rcon.handlers.set('bans', () => 'GUID Bans:\n[#] [GUID] [Minutes left] [Reason]\n' + '-'.repeat(50));
+    }
+
+    private writeLogs(): void {
+        const now = new Date();
+        for (const [type, file] of Object.entries(this.files)) {
+            file.pending += file.rate * WRITE_INTERVAL / 1000;
+            const count = Math.floor(file.pending);
+            file.pending -= count;
+            if (!count) {
+                continue;
+            }
+
+            const lines: string[] = [];
+            for (let i = 0; i < count; i++) {
+                const n = file.written++;
+                const marker = n % this.options.markerEvery === 0 ? ` lt=${now.valueOf()}` : '';
+                lines.push(file.line(n, now, marker));
+            }
+            const chunk = `${lines.join('\n')}\n`;
+            fs.writeSync(file.fd, chunk);
+            this.stats.lines[type as keyof FakeServerStats['lines']] += count;
+            this.stats.bytes += chunk.length;
+        }
+    }
+
+    private createReport(): any {
+        const t = Math.floor(Date.now() / 1000);
+        const entries = (count: number, entryType: string, type: string): any[] => [...Array(count)].map((_, i) => ({
+            entryType,
+            type,
+            name: `${type}${i}`,
+            id: i,
+            position: `${(i * 97 + t) % 15000}.5 ${i % 400}.0 ${(i * 13 + t) % 15000}.2`,
+            speed: '0 0 0',
+            damage: (i % 10) / 10,
+        }));
+        return {
+            players: entries(this.options.players, 'player', 'SurvivorM_Mirek'),
+            vehicles: entries(this.options.vehicles, 'vehicle', 'OffroadHatchback'),
+            sentAt: Date.now(),
+        };
+    }
+
+    /**
+     * The mod reads the api options written by the manager and either posts the report or writes the tick file
+     */
+    private async report(): Promise<void> {
+        let apiOptions: { host: string; key: string; useApiForReport: boolean } | undefined;
+        try {
+            apiOptions = JSON.parse(fs.readFileSync(path.join(this.options.profilesPath, 'DZSMApiOptions.json')) + '');
+        } catch {
+            // not written yet
+        }
+
+        const report = this.createReport();
+        if (!apiOptions?.useApiForReport) {
+            const file = path.join(this.options.profilesPath, 'DZSM-TICK.json');
+            fs.writeFileSync(`${file}.tmp`, JSON.stringify(report));
+            fs.renameSync(`${file}.tmp`, file);
+            this.stats.reports.file++;
+            return;
+        }
+
+        const start = Date.now();
+        try {
+            await new Promise<void>((resolve, reject) => {
+                const req = http.request(
+                    `http://${apiOptions.host}/ingamereport?key=${encodeURIComponent(apiOptions.key)}`,
+                    { method: 'POST', headers: { 'Content-Type': 'application/json' } },
+                    (res) => {
+                        res.resume();
+                        res.on('end', () => (res.statusCode === 200 ? resolve() : reject(new Error(`${res.statusCode}`))));
+                    },
+                );
+                req.on('error', reject);
+                req.end(JSON.stringify(report));
+            });
+            const duration = Date.now() - start;
+            const reports = this.stats.reports;
+            reports.rest++;
+            this.restTotalMs += duration;
+            reports.restAvgMs = Math.round(this.restTotalMs / reports.rest);
+            reports.restMaxMs = Math.max(reports.restMaxMs, duration);
+        } catch {
+            this.stats.reports.restErrors++;
+        }
+    }
+
+}
+
+/* started by the harness with the options as first argument, stopped via ipc */
+if (require.main === module) {
+    const server = new FakeDayZServer(JSON.parse(process.argv[2]));
+    process.on('message', (message) => {
+        if (message === 'stop') {
+            server.stop();
+            process.send(server.stats, () => process.exit(0));
+        }
+    });
+    process.on('disconnect', () => process.exit(0));
+    server.start().then(
+        () => process.send('started'),
+        (e) => {
+            console.error(e); // eslint-disable-line no-console
+            process.exit(1);
+        },
+    );
+}
@@ -442,6 +442,8 @@ export type DiscordChannelType =
     | 'notification' // public server notifications are posted here (i.e. server restart, server update, mod update)
     ;
 
+export type IngameMetricStorage = 'snapshot' | 'entity' | 'both';
+
 export class Config {
     /**
      * The instance name of this server
@@ -554,6 +556,18 @@ export class Config {
      */
     public ingameApiKey: string = '';
 
+    /**
+     * The port of the instrumentation endpoint of the manager itself
+     * (timings of its services, queries, RCon commands and requests, event loop lag and memory)
+     * in the prometheus text format on /metrics
+     *
+     * It only listens on localhost.
+     * If 0 it will be serverport + 12, so if your server runs on 2302, the port will be 2314
+     * If -1 the endpoint is disabled
+     */
+    @Reflect.metadata('config-range', [-1, 65535])
+    public instrumentationPort: number = 0;
+
     /**
      * Enable Syberia compatibility.
      */
@@ -643,6 +657,11 @@ export class Config {
      */
     public rconPort: number = 2306;
 
+    /**
+     * Interval (in ms) in which the player list kept from the RCon messages is compared with the actual player list
+     */
+    public rconPlayerReconcileInterval: number = 60000;
+
     /**
      * Local mods
      * Actual modnames like '@MyAwesomeMod'
@@ -797,11 +816,11 @@ export class Config {
      *
      * To schedule backups, use the the event scheduler and the event type 'backup'
      *
-     * To restore backups:
-     * - delete the mpmissions folder in the server folder
-     * - go to the backup folder
-     * - copy the mpmissions_{date} you want to restore into the server folder
-     * - rename the copied folder back to mpmissions
+     * Backups are snapshots: files that did not change since the previous backup are hardlinked,
+     * all others are stored gzipped in mpmissions_{date}/files. The manifest.json lists the files of the snapshot.
+     *
+     * To restore backups, use the 'restorebackup' command (while the server is stopped).
+     * Single files can also be restored by extracting them from the files folder of the backup.
      */
     public backupPath: string = 'backups';
 
@@ -811,6 +830,12 @@ export class Config {
      */
     public backupMaxAge: number = 7;
 
+    /**
+     * Delay (in ms) after the last edit of a central economy entry (i.e. in the types.xml) until the file is written.
+     * Edits within this delay are written together, but files are written at the latest after 5 times the delay.
+     */
+    public economyWriteDelay: number = 1000;
+
     // /////////////////////////// Steam ////////////////////////////////////////
     /**
      * Path to steam CMD
@@ -903,6 +928,21 @@ export class Config {
      */
     public linkModDirs: boolean = false;
 
+    /**
+     * Whether to install copied mods from a content addressed store (only used if linkModDirs is disabled).
+     * Identical files (also across mods) are stored once and hardlinked into the server folder,
+     * so mod updates only replace the changed files.
+     * The store should be on the same drive as the server, otherwise the files are copied.
+     * Hardlinked files share their content with the store, so editing a mod file in the server folder changes it for all
+     * servers using that file. Only enable this if the installed mods are not modified in place.
+     */
+    public useModStore: boolean = false;
+
+    /**
+     * Path of the mod store (relative to the manager or absolute)
+     */
+    public modStorePath: string = 'modstore';
+
     /**
      * Whether to deep compare mods instead of just checking for update timestamps
      */
@@ -924,6 +964,16 @@ export class Config {
      */
     public updateModsMaxBatchFileSize: number = 1_000_000_000;
 
+    /**
+     * How many downloaded mod batches may be installed at the same time.
+     * Finished batches are installed while the next batch is still downloading.
+     *
+     * The batches themselves are always downloaded one after another:
+     * parallel SteamCMD processes on one installation overwrite each other's workshop state (appworkshop_221100.acf),
+     * which loses updates or forces re-downloads of all mods.
+     */
+    public updateModsConcurrency: number = 1;
+
     // /////////////////////////// Events ///////////////////////////////////////
 
     /**
@@ -1038,11 +1088,81 @@ export class Config {
     public metricPollIntervall: number = 10000;
 
     /**
-     * Time (in ms) after which metrics will be removed (tick by tick)
+     * Time (in ms) after which a metric source (players, system status) is considered unresponsive
+     * The sample is skipped and the source is polled again at its next interval
+     */
+    public metricSourceTimeout: number = 5000;
+
+    /**
+     * Per source overrides of the poll interval and timeout (in ms)
+     * Sources are sampled independently, so a slow source does not delay the others
+     *
+     * Example:
+     * <pre>
+     * {
+     *   "PLAYERS": { "interval": 30000, "timeout": 10000 }
+     * }
+     * </pre>
+     */
+    public metricSources: {
+        PLAYERS?: { interval?: number; timeout?: number };
+        SYSTEM?: { interval?: number; timeout?: number };
+        INSTRUMENTATION?: { interval?: number; timeout?: number };
+    } = {};
+
+    /**
+     * Time (in ms) after which metrics will be removed
+     * Metrics are stored in daily partitions which are dropped as a whole once they are expired (checked hourly)
      * Default is 30 days
      */
     public metricMaxAge: number = 2_592_000;
 
+    /**
+     * Time (in ms) after which downsampled metrics will be removed, per rollup tier
+     * Rollups keep one sample per minute / 15 minutes / hour and are used
+     * when the web ui requests metrics with a coarse resolution.
+     * Ranges which reach beyond the retention of a tier are served from a finer tier or the raw metrics.
+     * Default is 7 days for minute, 30 days for quarter hour and 365 days for hourly rollups
+     */
+    public metricRollupMaxAge: {
+        minute: number;
+        quarterHour: number;
+        hour: number;
+    } = {
+        minute: 604_800_000,
+        quarterHour: 2_592_000_000,
+        hour: 31_536_000_000,
+    };
+
+    /**
+     * How the ingame players / vehicles metrics are stored
+     *
+     * 'snapshot' - one entry per report containing all entities (default)
+     * 'entity' - one entry per entity and report with indexed ids and coordinates
+     *   enables fast player tracks and area queries
+     * 'both' - store both representations
+     */
+    public ingameMetricStorage: IngameMetricStorage = 'snapshot';
+
+    /**
+     * Number of lines per log type (SCRIPT, ADM, RPT) kept in memory
+     * Older lines are moved to indexed files in the "log-store" folder and are read from there when requested
+     * A change rebuilds the buffers from the current log files
+     */
+    public logBufferSize: number = 10000;
+
+    /**
+     * Time (in ms) after which parsed ADM events (kills, hits, connects, positions) are removed
+     * Default is 30 days
+     */
+    public admEventMaxAge: number = 2_592_000_000;
+
+    /**
+     * Time (in ms) after which log lines are removed from the log search index
+     * Default is 30 days
+     */
+    public logSearchMaxAge: number = 2_592_000_000;
+
     // /////////////////////////// Hooks ///////////////////////////////////////
     /**
      * Hooks to define custom behaviour when certain events happen
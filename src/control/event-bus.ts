@@ -12,11 +12,30 @@ import { DiscordMessage } from '../types/discord';
 import { GameUpdatedStatus, ModUpdatedStatus } from '../types/steamcmd';
 import { LogLevel } from '../util/logger';
 
+type HighRateEventType = InternalEventTypes.LOG_ENTRY | InternalEventTypes.METRIC_ENTRY;
+
+/**
+ * Events which are emitted for every log line or metric sample.
+ * They bypass the event emitter (wildcards, objectify, async) and are delivered to plain listener arrays.
+ */
+const HIGH_RATE_EVENTS: InternalEventTypes[] = [
+    InternalEventTypes.LOG_ENTRY,
+    InternalEventTypes.METRIC_ENTRY,
+];
+
+interface FastListener {
+    event: HighRateEventType;
+    listener: (data: any) => any;
+    /** whether the listener receives arrays of events */
+    batch: boolean;
+}
+
 @singleton()
 @injectable()
 export class EventBus extends IService {
 
     private readonly EVENT_EMITTER = new EventEmitter2();
+    private readonly fastListeners = new Map<InternalEventTypes, FastListener[]>();
 
     public constructor(
         loggerfactory: LoggerFactory,
@@ -40,35 +59,79 @@ export class EventBus extends IService {
         | InternalEventTypes.GET_INTERNAL_MODS,
         data: any,
     ): void;
-    public emit(name: InternalEventTypes, data?: any): void {
-        try{
-            if(name === InternalEventTypes.DISCORD_MESSAGE 
-                || name === InternalEventTypes.MONITOR_STATE_CHANGE 
-                || name === InternalEventTypes.MOD_UPDATED 
-                || name === InternalEventTypes.GAME_UPDATED){
-                (data: DiscordMessage) => {
-                    const dataLog = data;
-                    this?.log?.log(LogLevel.IMPORTANT, `[emit] name:${name} // DiscordMessage.type: ${dataLog.type} // DiscordMessage.msg: ${dataLog.message} // DiscordMessage.embeds: ${dataLog.embeds}`);
-                }
-                (data: ServerState) => {
-                    const dataLog = data;
-                    this?.log?.log(LogLevel.IMPORTANT, `[emit] name:${name} // ServerState: ${dataLog}`);
-                }
-                (data: ModUpdatedStatus) => {
-                    const dataLog = data;
-                    this?.log?.log(LogLevel.IMPORTANT, `[emit] name:${name} // ModUpdatedStatus.ID: ${dataLog.modIds} // ModUpdatedStatus.success: ${dataLog.success}`);
-                }
-                (data: GameUpdatedStatus) => {
-                    const dataLog = data;
-                    this?.log?.log(LogLevel.IMPORTANT, `[emit] name:${name} // GameUpdatedStatus.success: ${dataLog.success}`);
+    public emit(name: InternalEventTypes, ...data: any[]): void {
+        const fastListeners = this.fastListeners.get(name);
+        if (fastListeners) {
+            for (const fastListener of fastListeners) {
+                this.callFastListener(fastListener, fastListener.batch ? [data[0]] : data[0]);
+            }
+            return;
+        }
+        if (HIGH_RATE_EVENTS.includes(name)) {
+            // no listeners
+            return;
+        }
+        try {
+            this.EVENT_EMITTER.emit(name, ...data);
+        } catch (e) {
+            this.log.log(LogLevel.ERROR, `Failed to emit ${name}`, e);
+        }
+    }
+
+    /**
+     * Emits many events of a high rate type at once.
+     * Batch listeners receive them with a single call, others one by one.
+     */
+    public emitBatch(name: InternalEventTypes.LOG_ENTRY, logEntryEvents: LogEntryEvent[]): void;
+    public emitBatch(name: InternalEventTypes.METRIC_ENTRY, metricEntryEvents: MetricEntryEvent[]): void;
+    public emitBatch(name: HighRateEventType, events: any[]): void {
+        if (!events.length) return;
+        for (const fastListener of this.fastListeners.get(name) ?? []) {
+            if (fastListener.batch) {
+                this.callFastListener(fastListener, events);
+            } else {
+                for (const event of events) {
+                    this.callFastListener(fastListener, event);
                 }
             }
-            this.EVENT_EMITTER.emit(name, data);
-        }catch(e){
-            console.log(`[event-bus] emit() ERORR: ${e}`);
         }
     }
 
+    /**
+     * Errors of a listener are contained, so the other listeners still receive the event.
+     * Returned promises are not awaited (like for all emits), attaching handlers to them would cost more than the delivery itself.
+     */
+    private callFastListener(fastListener: FastListener, data: any): void {
+        try {
+            fastListener.listener(data);
+        } catch (e) {
+            this.log.log(LogLevel.ERROR, `Listener of ${fastListener.event} failed`, e);
+        }
+    }
+
+    /**
+     * Listeners of high rate events are kept in plain arrays, which are replaced on change,
+     * so emitting never copies or looks them up by pattern
+     */
+    private addFastListener(event: HighRateEventType, listener: (data: any) => any, batch: boolean): Listener {
+        const fastListener: FastListener = { event, listener, batch };
+        this.fastListeners.set(event, [...(this.fastListeners.get(event) ?? []), fastListener]);
+        const handle = {
+            event,
+            listener,
+            off: () => {
+                const remaining = (this.fastListeners.get(event) ?? []).filter((x) => x !== fastListener);
+                if (remaining.length) {
+                    this.fastListeners.set(event, remaining);
+                } else {
+                    this.fastListeners.delete(event);
+                }
+                return handle;
+            },
+        };
+        return handle as any as Listener;
+    }
+
     public on(name: InternalEventTypes.DISCORD_MESSAGE, listener: (message: DiscordMessage) => Promise<any>): Listener;
     public on(name: InternalEventTypes.MONITOR_STATE_CHANGE, listener: (newState: ServerState, previousState: ServerState) => Promise<any>): Listener;
     public on(name: InternalEventTypes.METRIC_ENTRY, listener: (metricEntryEvent: MetricEntryEvent) => Promise<any>): Listener;
@@ -81,6 +144,9 @@ export class EventBus extends IService {
         listener: () => Promise<any>,
     ): Listener;
     public on(name: InternalEventTypes, listener: (...data: any[]) => Promise<any>): Listener {
+        if (HIGH_RATE_EVENTS.includes(name)) {
+            return this.addFastListener(name as HighRateEventType, listener, false);
+        }
         try{
             return this.EVENT_EMITTER.on(name, listener, { objectify: true }) as Listener;
         }catch(e){
@@ -88,7 +154,17 @@ export class EventBus extends IService {
         }
     }
 
+    /**
+     * Listens to high rate events in batches. Single emits are passed as a batch of one.
+     */
+    public onBatch(name: InternalEventTypes.LOG_ENTRY, listener: (logEntryEvents: LogEntryEvent[]) => any): Listener;
+    public onBatch(name: InternalEventTypes.METRIC_ENTRY, listener: (metricEntryEvents: MetricEntryEvent[]) => any): Listener;
+    public onBatch(name: HighRateEventType, listener: (events: any[]) => any): Listener {
+        return this.addFastListener(name, listener, true);
+    }
+
     public clear(name: InternalEventTypes): void {
+        this.fastListeners.delete(name);
         try{
             this.EVENT_EMITTER.removeAllListeners(name);
         }catch(e){
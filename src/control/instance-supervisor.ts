@@ -0,0 +1,232 @@
+import * as path from 'path';
+import { container, DependencyContainer, inject, injectable, Lifecycle, singleton } from 'tsyringe';
+import { ManagerController } from './manager-controller';
+import { Manager } from './manager';
+import { EventBus } from './event-bus';
+import { LoggerFactory } from '../services/loggerfactory';
+import { Paths } from '../services/paths';
+import { Database, DatabaseConnections } from '../services/database';
+import { SteamCMD, SteamCmdLock, SteamMetaData } from '../services/steamcmd';
+import { ConfigFileHelper } from '../config/config-file-helper';
+import { ConfigWatcher } from '../services/config-watcher';
+import { Requirements } from '../services/requirements';
+import { ServerDetector } from '../services/server-detector';
+import { ServerStarter } from '../services/server-starter';
+import { Processes, ProcessSpawner, LinuxProcessFetcher, WindowsProcessFetcher } from '../services/processes';
+import { NetSH } from '../services/netsh';
+import { Downloader } from '../services/download';
+import { ModStore } from '../services/mod-store';
+import { Monitor } from '../services/monitor';
+import { RCON } from '../services/rcon';
+import { Events } from '../services/events';
+import { Hooks } from '../services/hooks';
+import { Backups } from '../services/backups';
+import { LogReader } from '../services/log-reader';
+import { LogSearch } from '../services/log-search';
+import { AdmEvents } from '../services/adm-events';
+import { MissionFiles } from '../services/mission-files';
+import { EconomyStore } from '../services/economy-store';
+import { IngameReport } from '../services/ingame-report';
+import { SystemReporter } from '../services/system-reporter';
+import { Metrics } from '../services/metrics';
+import { MetricsCollector } from '../services/metrics-collector';
+import { ManagerInstrumentation } from '../services/manager-instrumentation';
+import { SyberiaCompat } from '../services/syberia-compat';
+import { DiscordBot } from '../services/discord';
+import { DiscordEventConverter } from '../services/discord-event-converter';
+import { DiscordMessageHandler } from '../interface/discord-message-handler';
+import { Interface } from '../interface/interface';
+import { REST } from '../interface/rest';
+import { IngameREST } from '../interface/ingame-rest';
+import { FSAPI, InjectionTokens } from '../util/apis';
+import { Logger, LogLevel } from '../util/logger';
+
+export interface InstanceDefinition {
+    /** unique id, used in logs and to partition the shared metrics */
+    id: string;
+    /** working dir of the instance (containing its server-manager.json), relative to the manager's working dir */
+    path: string;
+}
+
+export interface InstancesConfig {
+    instances: InstanceDefinition[];
+}
+
+export interface Instance {
+    definition: InstanceDefinition;
+    container: DependencyContainer;
+    controller: ManagerController;
+}
+
+/**
+ * Runs multiple server instances in one manager process.
+ *
+ * Every instance gets its own container, so all services (monitor, RCON, log reader, REST, ...) exist once per instance
+ * and use the config in the instance dir.
+ * SteamCMD, the workshop downloads, the mod store and the metrics database are shared and stay in the manager's working dir.
+ */
+@singleton()
+@injectable()
+export class InstanceSupervisor {
+
+    public static readonly INSTANCES_FILE = 'server-manager-instances.json';
+
+    /** services which exist once for all instances */
+    public static readonly SHARED_SERVICES: any[] = [
+        InstanceSupervisor,
+        DatabaseConnections,
+        SteamCmdLock,
+    ];
+
+    /**
+     * services which exist once per instance (the LoggerFactory is created separately).
+     * The stateful services are started in this order, so every service is listed after the services it injects.
+     * New services must be added here, otherwise all instances would share the root container's instance.
+     */
+    public static readonly INSTANCE_SERVICES: any[] = [
+        Paths,
+        ConfigFileHelper,
+        ConfigWatcher,
+        Manager,
+        ProcessSpawner,
+        WindowsProcessFetcher,
+        LinuxProcessFetcher,
+        Processes,
+        ServerDetector,
+        Downloader,
+        SteamMetaData,
+        EventBus,
+        ModStore,
+        SteamCMD,
+        Database,
+        Metrics,
+        IngameReport,
+        NetSH,
+        Requirements,
+        RCON,
+        Hooks,
+        ServerStarter,
+        DiscordEventConverter,
+        Monitor,
+        SystemReporter,
+        ManagerInstrumentation,
+        MetricsCollector,
+        LogReader,
+        AdmEvents,
+        LogSearch,
+        Backups,
+        MissionFiles,
+        EconomyStore,
+        Interface,
+        DiscordMessageHandler,
+        DiscordBot,
+        ManagerController,
+        Events,
+        SyberiaCompat,
+        REST,
+        IngameREST,
+    ];
+
+    private log: Logger;
+    private instances: Instance[] = [];
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private paths: Paths,
+        @inject(InjectionTokens.fs) private fs: FSAPI,
+    ) {
+        this.log = loggerFactory.createLogger('Instances');
+    }
+
+    /**
+     * @returns the configured instances or undefined if the manager runs a single server
+     */
+    public readInstances(): InstanceDefinition[] | undefined {
+        const file = path.join(this.paths.cwd(), InstanceSupervisor.INSTANCES_FILE);
+        if (!this.fs.existsSync(file)) {
+            return undefined;
+        }
+
+        const { instances } = JSON.parse(this.fs.readFileSync(file) + '') as InstancesConfig;
+        if (!instances?.length) {
+            throw new Error(`${InstanceSupervisor.INSTANCES_FILE} does not contain any instances`);
+        }
+        const ids = new Set<string>();
+        const paths = new Set<string>();
+        for (const instance of instances) {
+            if (!instance?.id || !instance.path) {
+                throw new Error('Each instance needs an id and a path');
+            }
+            const instancePath = this.getInstancePath(instance).toLowerCase();
+            if (ids.has(instance.id) || paths.has(instancePath)) {
+                throw new Error(`Instance ${instance.id} is not unique`);
+            }
+            ids.add(instance.id);
+            paths.add(instancePath);
+        }
+        return instances;
+    }
+
+    private getInstancePath(definition: InstanceDefinition): string {
+        return this.paths.isAbsolute(definition.path)
+            ? definition.path
+            : path.join(this.paths.cwd(), definition.path);
+    }
+
+    /**
+     * Creates a container with its own instance of every instance service,
+     * everything else (the shared services and the APIs) is resolved from the root container
+     */
+    public createInstanceContainer(definition: InstanceDefinition): DependencyContainer {
+        const instanceContainer = container.createChildContainer();
+        for (const service of InstanceSupervisor.INSTANCE_SERVICES) {
+            instanceContainer.register(service, service, { lifecycle: Lifecycle.Singleton });
+        }
+
+        const loggerFactory = new LoggerFactory();
+        loggerFactory.instance = definition.id;
+        instanceContainer.register(LoggerFactory, { useValue: loggerFactory });
+        instanceContainer.register(InjectionTokens.container, { useValue: instanceContainer });
+
+        const paths = instanceContainer.resolve(Paths);
+        paths.setCwd(this.getInstancePath(definition));
+        paths.setSharedCwd(this.paths.cwd());
+        instanceContainer.resolve(Manager).instanceName = definition.id;
+
+        return instanceContainer;
+    }
+
+    public getInstances(): Instance[] {
+        return this.instances;
+    }
+
+    public async start(definitions: InstanceDefinition[]): Promise<void> {
+        process.title = `Server-Manager (${definitions.map((x) => x.id).join(', ')})`;
+        this.instances = definitions.map((definition) => {
+            const instanceContainer = this.createInstanceContainer(definition);
+            return {
+                definition,
+                container: instanceContainer,
+                controller: instanceContainer.resolve(ManagerController),
+            };
+        });
+
+        this.log.log(LogLevel.IMPORTANT, `Starting ${this.instances.length} instances`);
+        // SteamCMD calls of the instances are coordinated by the shared lock
+        await Promise.all(this.instances.map(async (instance) => {
+            await instance.controller.start();
+        }));
+    }
+
+    public async stop(): Promise<void> {
+        await Promise.all(this.instances.map(async (instance) => {
+            try {
+                await instance.controller.stop();
+            } catch (e) {
+                this.log.log(LogLevel.ERROR, `Failed to stop instance ${instance.definition.id}`, e);
+            }
+        }));
+        this.instances = [];
+    }
+
+}
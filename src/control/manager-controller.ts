@@ -5,7 +5,7 @@ import { Logger, LogLevel } from '../util/logger';
 import { IStatefulService } from '../types/service';
 import { Requirements } from '../services/requirements';
 import { ConfigWatcher } from '../services/config-watcher';
-import { container, injectable, Lifecycle, registry, singleton } from 'tsyringe';
+import { container, DependencyContainer, inject, injectable, Lifecycle, registry, singleton } from 'tsyringe';
 import { LoggerFactory } from '../services/loggerfactory';
 import { ServerDetector } from '../services/server-detector';
 import { IngameReport } from '../services/ingame-report';
@@ -20,6 +20,7 @@ import { Events } from '../services/events';
 import { Hooks } from '../services/hooks';
 import { LogReader } from '../services/log-reader';
 import { MissionFiles } from '../services/mission-files';
+import { EconomyStore } from '../services/economy-store';
 import { SystemReporter } from '../services/system-reporter';
 import { DiscordBot } from '../services/discord';
 import { Interface } from '../interface/interface';
@@ -29,6 +30,8 @@ import { MetricsCollector } from '../services/metrics-collector';
 import { IngameREST } from '../interface/ingame-rest';
 import { SyberiaCompat } from '../services/syberia-compat';
 import { DiscordEventConverter } from '../services/discord-event-converter';
+import { Config } from '../config/config';
+import { formatTaskTimings, GraphTask, runTaskGraph, TaskGraphError, TaskGraphResult } from '../util/task-graph';
 
 @singleton()
 @registry([
@@ -48,6 +51,10 @@ import { DiscordEventConverter } from '../services/discord-event-converter';
     token: InjectionTokens.pty,
     useValue: ptyModule,
     },
+    {
+    token: InjectionTokens.container,
+    useValue: container,
+    },
 
     // standalone services
     {
@@ -76,6 +83,11 @@ import { DiscordEventConverter } from '../services/discord-event-converter';
     options: { lifecycle: Lifecycle.Singleton },
     },
     {
+    token: EconomyStore,
+    useClass: EconomyStore,
+    options: { lifecycle: Lifecycle.Singleton },
+    },
+    {
     token: SystemReporter,
     useClass: SystemReporter,
     options: { lifecycle: Lifecycle.Singleton },
@@ -121,7 +133,29 @@ import { DiscordEventConverter } from '../services/discord-event-converter';
 @injectable()
 export class ManagerController {
 
+    /**
+     * Config keys which change the setup or the paths used by all services, a change of them restarts the manager.
+     * Other changes are applied by the services themselves.
+     */
+    public static readonly RESTART_CONFIG_KEYS: (keyof Config)[] = [
+        'instanceId',
+        'serverPath',
+        'serverExe',
+        'profilesPath',
+        'experimentalServer',
+        'dayzSteamAppId',
+        'dayzServerSteamAppId',
+        'dayzExperimentalServerSteamAppId',
+        'steamCmdPath',
+        'steamWsMods',
+        'steamWsServerMods',
+        'linkModDirs',
+        'useModStore',
+        'modStorePath',
+    ];
+
     private working = false;
+    private reloading: Promise<void> = Promise.resolve();
     private started = false;
     private skipInitialCheck: boolean = false;
 
@@ -136,6 +170,7 @@ export class ManagerController {
         private ingameReport: IngameReport,
         private requirements: Requirements,
         private discord: DiscordBot,
+        @inject(InjectionTokens.container) private container: DependencyContainer,
     ) {
         this.log = loggerFactory.createLogger('Bootstrap');
     }
@@ -148,10 +183,10 @@ export class ManagerController {
         this.log.log(
             LogLevel.DEBUG,
             'Currently Registered Services',
-            ([...((container as any)._registry).entries()].map((x) => x[0]?.name || x[0]).filter((x) => typeof x === 'string')),
+            ([...((this.container as any)._registry).entries()].map((x) => x[0]?.name || x[0]).filter((x) => typeof x === 'string')),
         );
         const statefulServices = [];
-        for (const [token] of ((container as any)._registry).entries()) {
+        for (const [token] of ((this.container as any)._registry).entries()) {
             const protos = [];
             let proto = Object.getPrototypeOf(token);
             while (proto) {
@@ -163,7 +198,46 @@ export class ManagerController {
                 statefulServices.push(token);
             }
         }
-        return statefulServices.map((x) => container.resolve(x));
+        return statefulServices.map((x) => this.container.resolve(x));
+    }
+
+    /**
+     * A service depends on the earlier registered services it injects, directly or through stateless services.
+     * Only earlier ones are considered, so the dependencies are never cyclic and keep the registration order.
+     */
+    private getServiceDependencies(services: IStatefulService[]): Map<IStatefulService, IStatefulService[]> {
+        const byType = new Map<any, IStatefulService>(services.map((x) => [x.constructor, x]));
+        const dependencies = new Map<IStatefulService, IStatefulService[]>();
+        services.forEach((service, index) => {
+            const found = new Set<IStatefulService>();
+            const visited = new Set<any>([service.constructor]);
+            const visit = (type: any): void => {
+                const paramTypes: any[] = Reflect.getMetadata('design:paramtypes', type) ?? [];
+                for (const paramType of paramTypes) {
+                    if (typeof paramType !== 'function' || visited.has(paramType)) continue;
+                    visited.add(paramType);
+                    const dependency = byType.get(paramType);
+                    if (dependency) {
+                        if (services.indexOf(dependency) < index) {
+                            found.add(dependency);
+                        }
+                    } else {
+                        visit(paramType);
+                    }
+                }
+            };
+            visit(service.constructor);
+            dependencies.set(service, [...found]);
+        });
+        return dependencies;
+    }
+
+    private async runSteps(steps: GraphTask[]): Promise<TaskGraphResult> {
+        const result = await runTaskGraph(steps);
+        for (const timing of result.timings) {
+            this.log.log(LogLevel.DEBUG, `${timing.name} took ${timing.duration}ms`);
+        }
+        return result;
     }
 
     public async stop(force?: boolean): Promise<void> {
@@ -183,15 +257,24 @@ export class ManagerController {
             this.log.log(LogLevel.ERROR, `Failed to unwatch config`, e);
         }
         this.log.log(LogLevel.DEBUG, 'Stopping all running services..');
-        for (const service of this.getStatefulServices()) {
-            this.log.log(LogLevel.DEBUG, `Stopping ${this.getServiceName(service)}..`);
-            try {
-                await service.stop();
-            } catch (e) {
-                this.log.log(LogLevel.ERROR, `Failed to stop service: ${this.getServiceName(service)}`, e);
-            }
-        }
-        this.log.log(LogLevel.DEBUG, 'Stopping completed..');
+        // services are stopped before the services they depend on
+        const services = this.getStatefulServices();
+        const dependencies = this.getServiceDependencies(services);
+        const result = await this.runSteps(services.map((service) => ({
+            name: this.getServiceName(service),
+            dependsOn: services
+                .filter((x) => dependencies.get(x).includes(service))
+                .map((x) => this.getServiceName(x)),
+            run: async () => {
+                this.log.log(LogLevel.DEBUG, `Stopping ${this.getServiceName(service)}..`);
+                try {
+                    await service.stop();
+                } catch (e) {
+                    this.log.log(LogLevel.ERROR, `Failed to stop service: ${this.getServiceName(service)}`, e);
+                }
+            },
+        })));
+        this.log.log(LogLevel.DEBUG, `Stopping completed in ${result.duration}ms`);
         this.working = false;
         this.started = false;
         this.manager.initDone = false;
@@ -209,38 +292,37 @@ export class ManagerController {
 
         const config = this.configWatcher.watch(
             /* istanbul ignore next */
-            () => this.reloadConfig(),
+            (newConfig, changed) => this.reloadConfig(newConfig, changed),
         );
 
         this.manager.config = config;
+        this.applyLogLevel(config);
 
-        // apply initial log level
-        const { loglevel } = config;
-        if (typeof loglevel === 'number' && loglevel >= LogLevel.DEBUG && loglevel <= LogLevel.ERROR) {
-            Logger.defaultLogLevel = loglevel;
+        // set the process title, unless it runs multiple instances
+        if (!this.manager.instanceName) {
+            process.title = `Server-Manager ${this.manager.getServerExePath()}`;
         }
 
-        // set the process title
-        process.title = `Server-Manager ${this.manager.getServerExePath()}`;
-
-        // check any requirements before even starting
-        await this.requirements.check();
-
         this.log.log(LogLevel.DEBUG, 'Setting up services..');
-
-        // init
-        this.log.log(LogLevel.DEBUG, 'Services are set up');
         try {
-
-            await this.initialSetup();
-
-            this.log.log(LogLevel.DEBUG, 'Initial Check done. Starting Init..');
-            for (const service of this.getStatefulServices()) {
-                this.log.log(LogLevel.DEBUG, `Starting ${this.getServiceName(service)}..`);
-                await service.start();
-            }
+            const result = await this.runSteps(this.getStartupSteps());
+            this.log.log(
+                LogLevel.INFO,
+                `Startup took ${result.duration}ms, critical path: ${formatTaskTimings(result.criticalPath)}`,
+            );
         } catch (e) {
-            this.log.log(LogLevel.ERROR, e?.message, e);
+            if (e instanceof TaskGraphError) {
+                this.log.log(LogLevel.ERROR, `Startup failed after: ${formatTaskTimings(e.result.timings)}`);
+                this.log.log(LogLevel.ERROR, e.reason?.message, e.reason);
+            } else {
+                this.log.log(LogLevel.ERROR, e?.message, e);
+            }
+            // only this instance is stopped, the others keep running
+            if (this.manager.instanceName) {
+                this.started = true;
+                await this.stop(true);
+                return;
+            }
             process.exit(1);
         }
 
@@ -251,52 +333,143 @@ export class ManagerController {
         this.log.log(LogLevel.IMPORTANT, 'Waiting for first server monitor tick..');
     }
 
-    /* istanbul ignore next */
-    private reloadConfig(): void {
-        if (!this.manager?.initDone) {
-            return;
+    private applyLogLevel(config: Config): void {
+        const { loglevel } = config;
+        if (typeof loglevel === 'number' && loglevel >= LogLevel.DEBUG && loglevel <= LogLevel.ERROR) {
+            Logger.defaultLogLevel = loglevel;
         }
-        this.log.log(LogLevel.IMPORTANT, 'Reloading config...');
-        void this.start();
     }
 
-    private async initialSetup(): Promise<void> {
+    /**
+     * Reloads are queued, so changes are applied in the order they were made
+     */
+    public reloadConfig(config: Config, changed: (keyof Config)[]): Promise<void> {
+        this.reloading = this.reloading
+            .then(() => this.applyConfig(config, changed))
+            .catch(/* istanbul ignore next */ (e) => {
+                this.log.log(LogLevel.ERROR, 'Failed to reload config', e);
+            });
+        return this.reloading;
+    }
 
-        if (this.skipInitialCheck || await this.serverDetector.isServerRunning()) {
-            this.log.log(LogLevel.IMPORTANT, 'Skipping initial SteamCMD check because the server is already running');
+    private async applyConfig(config: Config, changed: (keyof Config)[]): Promise<void> {
+        if (!this.manager?.initDone) {
             return;
         }
 
-        this.log.log(LogLevel.IMPORTANT, 'Initially checking SteamCMD, Server Installation and Mods. Please wait. This may take some minutes...');
-        const steamCmdOk = await this.steamCmd.checkSteamCmd();
-        if (!steamCmdOk) {
-            throw new Error('SteamCMD init failed');
+        const restartKeys = changed.filter((x) => ManagerController.RESTART_CONFIG_KEYS.includes(x));
+        if (restartKeys.length) {
+            this.log.log(LogLevel.IMPORTANT, `Reloading config... (restart required by: ${restartKeys.join(', ')})`);
+            await this.start();
+            return;
         }
 
-        // ingame report mod
-        await this.ingameReport.installMod();
-        // Server
-        if (!await this.steamCmd.checkServer() || this.manager.config.updateServerOnStartup) {
-            if (!await this.steamCmd.updateServer()) {
-                throw new Error('Server installation failed');
-            }
-        }
-        if (!await this.steamCmd.checkServer()) {
-            throw new Error('Server installation failed');
-        }
+        this.log.log(LogLevel.IMPORTANT, `Applying config changes: ${changed.join(', ')}`);
+        this.manager.config = config;
+        this.applyLogLevel(config);
 
-        // Mods
-        if (!await this.steamCmd.checkMods() || this.manager.config.updateModsOnStartup) {
-            if (!await this.steamCmd.updateAllMods()) {
-                throw new Error('Updating Mods failed');
-            }
-        }
-        if (!await this.steamCmd.installMods()) {
-            throw new Error('Installing Mods failed');
-        }
-        if (!await this.steamCmd.checkMods()) {
-            throw new Error('Mod installation failed');
+        // restarted services are started after the services they depend on, like on startup
+        const services = this.getStatefulServices();
+        const dependencies = this.getServiceDependencies(services);
+        try {
+            const result = await this.runSteps(services.map((service) => ({
+                name: this.getServiceName(service),
+                dependsOn: dependencies.get(service).map((x) => this.getServiceName(x)),
+                run: () => service.applyConfig(changed),
+            })));
+            this.log.log(LogLevel.IMPORTANT, `Config changes applied in ${result.duration}ms`);
+        } catch (e) {
+            this.log.log(LogLevel.ERROR, `Failed to apply config changes, restarting: ${e?.message}`, e?.reason ?? e);
+            await this.start();
         }
     }
 
+    /**
+     * The startup as a dependency graph, independent steps are run concurrently:
+     *
+     * - the requirements are checked first, the check may end the process
+     * - all SteamCMD calls (SteamCMD itself, server and mods) are made in sequence
+     * - the ingame report mod is installed alongside
+     * - the services are started once the setup is done, each one after the services it depends on
+     */
+    private getStartupSteps(): GraphTask[] {
+        let skipSetup = this.skipInitialCheck;
+        const setupStep = (name: string, run: () => Promise<void>, dependsOn: string[] = ['detectServer']): GraphTask => ({
+            name,
+            dependsOn,
+            run: async () => {
+                if (!skipSetup) {
+                    await run();
+                }
+            },
+        });
+
+        const setupSteps: GraphTask[] = [
+            {
+                // check any requirements before anything is installed or started,
+                // the check ends the process if mandatory runtime libs are missing
+                name: 'requirements',
+                run: () => this.requirements.check(),
+            },
+            {
+                name: 'detectServer',
+                dependsOn: ['requirements'],
+                run: async () => {
+                    if (skipSetup || await this.serverDetector.isServerRunning()) {
+                        skipSetup = true;
+                        this.log.log(LogLevel.IMPORTANT, 'Skipping initial SteamCMD check because the server is already running');
+                    } else {
+                        this.log.log(LogLevel.IMPORTANT, 'Initially checking SteamCMD, Server Installation and Mods. Please wait. This may take some minutes...');
+                    }
+                },
+            },
+            setupStep('steamCmd', async () => {
+                if (!await this.steamCmd.checkSteamCmd()) {
+                    throw new Error('SteamCMD init failed');
+                }
+            }),
+            setupStep('ingameReportMod', () => this.ingameReport.installMod()),
+            setupStep('server', async () => {
+                if (!await this.steamCmd.checkServer() || this.manager.config.updateServerOnStartup) {
+                    if (!await this.steamCmd.updateServer()) {
+                        throw new Error('Server installation failed');
+                    }
+                }
+                if (!await this.steamCmd.checkServer()) {
+                    throw new Error('Server installation failed');
+                }
+            }, ['steamCmd']),
+            setupStep('mods', async () => {
+                if (!await this.steamCmd.checkMods() || this.manager.config.updateModsOnStartup) {
+                    // mods are installed as soon as their batch is downloaded
+                    if (!await this.steamCmd.updateAllMods({ install: true })) {
+                        throw new Error('Updating Mods failed');
+                    }
+                }
+                if (!await this.steamCmd.installMods()) {
+                    throw new Error('Installing Mods failed');
+                }
+                if (!await this.steamCmd.checkMods()) {
+                    throw new Error('Mod installation failed');
+                }
+            }, ['server']),
+        ];
+
+        const services = this.getStatefulServices();
+        const dependencies = this.getServiceDependencies(services);
+        const serviceSteps = services.map((service): GraphTask => ({
+            name: this.getServiceName(service),
+            dependsOn: [
+                ...setupSteps.map((x) => x.name),
+                ...dependencies.get(service).map((x) => this.getServiceName(x)),
+            ],
+            run: () => {
+                this.log.log(LogLevel.DEBUG, `Starting ${this.getServiceName(service)}..`);
+                return service.start();
+            },
+        }));
+
+        return [...setupSteps, ...serviceSteps];
+    }
+
 }
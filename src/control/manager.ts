@@ -23,6 +23,9 @@ export class Manager {
 
     public processCreatedDate = new Date();
 
+    /** id of this server instance if the manager runs multiple instances, undefined otherwise */
+    public instanceName: string | undefined;
+
     public constructor(
         loggerFactory: LoggerFactory,
         private paths: Paths,
@@ -107,6 +110,13 @@ export class Manager {
         return this.config.serverPort + 11;
     }
 
+    public getInstrumentationPort(): number {
+        if ((this.config.instrumentationPort ?? 0) !== 0) {
+            return this.config.instrumentationPort;
+        }
+        return this.config.serverPort + 12;
+    }
+
     public async getServerCfg(): Promise<ServerCfg> {
         if (this.config.serverCfg) {
             return this.config.serverCfg;
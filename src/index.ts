@@ -1,5 +1,6 @@
 import 'reflect-metadata';
 import { ManagerController } from './control/manager-controller';
+import { InstanceSupervisor } from './control/instance-supervisor';
 import { isRunFromWindowsGUI } from './util/is-run-from-gui';
 import * as childProcess from 'child_process';
 import { container } from 'tsyringe';
@@ -33,6 +34,13 @@ void (async () => {
         }
     });
 
-    await container.resolve(ManagerController).start();
+    // multiple server instances if configured, a single one otherwise
+    const supervisor = container.resolve(InstanceSupervisor);
+    const instances = supervisor.readInstances();
+    if (instances) {
+        await supervisor.start(instances);
+    } else {
+        await container.resolve(ManagerController).start();
+    }
 
 })();
@@ -4,6 +4,7 @@
 import * as express from 'express';
 import * as path from 'path';
 import { loggerMiddleware } from '../middleware/logger';
+import { instrumentationMiddleware } from '../middleware/instrumentation';
 
 import { Manager } from '../control/manager';
 import { Server } from 'http';
@@ -15,6 +16,7 @@ import { Database } from '../services/database';
 import { IngameReport } from '../services/ingame-report';
 import { FSAPI, InjectionTokens } from '../util/apis';
 import { Paths } from '../services/paths';
+import { Config } from '../config/config';
 
 interface IngameConfig {
     host: string;
@@ -27,6 +29,17 @@ interface IngameConfig {
 @injectable()
 export class IngameREST extends IStatefulService {
 
+    public readonly configKeys: (keyof Config)[] = [
+        'ingameApiPort',
+        'publishIngameApi',
+        'ingameApiHostOverride',
+        'ingameApiKey',
+        'ingameReportViaRest',
+        'ingameReportIntervall',
+        'dataDump',
+        'serverPort',
+    ];
+
     public express: express.Application | undefined;
     public server: Server | undefined;
 
@@ -79,6 +92,7 @@ export class IngameREST extends IStatefulService {
         this.express.use(express.json({ limit: '50mb' }));
         this.express.use(express.urlencoded({ extended: true }));
         this.express.use(loggerMiddleware);
+        this.express.use(instrumentationMiddleware('ingame', this.manager.instanceName));
 
         // controllers
         this.setupControllers();
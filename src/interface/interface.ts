@@ -1,21 +1,31 @@
-import { injectable, singleton } from 'tsyringe';
+import { delay, inject, injectable, singleton } from 'tsyringe';
 import { Manager } from '../control/manager';
 import { Backups } from '../services/backups';
 import { LogReader } from '../services/log-reader';
+import { AdmEvents } from '../services/adm-events';
+import { LogSearch } from '../services/log-search';
 import { LoggerFactory } from '../services/loggerfactory';
 import { Metrics } from '../services/metrics';
+import { MetricsCollector } from '../services/metrics-collector';
 import { MissionFiles } from '../services/mission-files';
+import { EconomyStore } from '../services/economy-store';
 import { Monitor } from '../services/monitor';
 import { SystemReporter } from '../services/system-reporter';
 import { RCON } from '../services/rcon';
 import { SteamCMD } from '../services/steamcmd';
-import { CommandMap, Request, RequestTemplate, Response, ResponsePartHandler } from '../types/interface';
+import { CommandMap, Request, RequestOptions, RequestTemplate, Response, ResponsePartHandler } from '../types/interface';
 import { IService } from '../types/service';
 import { LogLevel } from '../util/logger';
 import { makeTable } from '../util/table';
 import { constants as HTTP } from 'http2';
 import { ConfigFileHelper } from '../config/config-file-helper';
 import { ServerDetector } from '../services/server-detector';
+import { EntityTrackPoint, IngameEntityMetricType, MetricPageQuery } from '../types/metrics';
+import { AdmEventType } from '../types/adm';
+import { LogType } from '../types/log-reader';
+import { REST } from './rest';
+import { DiscordBot } from '../services/discord';
+import { instrumentation } from '../util/instrumentation';
 
 /* istanbul ignore next */
 const parseBoolean = (val: any): boolean => true === val || 'true' === val;
@@ -37,11 +47,17 @@ export class Interface extends IService {
         private systemReporter: SystemReporter,
         private serverDetector: ServerDetector,
         private metrics: Metrics,
+        private metricsCollector: MetricsCollector,
         private steamCmd: SteamCMD,
         private logReader: LogReader,
+        private admEvents: AdmEvents,
+        private logSearch: LogSearch,
         private backup: Backups,
         private missionFiles: MissionFiles,
         private configFileHelper: ConfigFileHelper,
+        private economyStore: EconomyStore,
+        @inject(delay(() => REST)) private rest: REST,
+        @inject(delay(() => DiscordBot)) private discord: DiscordBot,
     ) {
         super(loggerFactory.createLogger('Manager'));
         this.setupCommandMap();
@@ -71,6 +87,11 @@ export class Interface extends IService {
                 level: 'view',
                 action: this.getBans,
             })],
+            ['rconstats', RequestTemplate.build({
+                level: 'manage',
+                disableDiscord: true,
+                action: () => this.rcon.getCommandStats(),
+            })],
             ['shutdown', RequestTemplate.build({
                 method: 'post',
                 level: 'manage',
@@ -157,8 +178,82 @@ export class Interface extends IService {
                 method: 'get',
                 level: 'manage',
                 disableDiscord: true,
-                params: [{ name: 'type', location: 'query' }, { name: 'since', optional: true, location: 'query', parse: parseNumber }],
-                action: (req, params) => this.metrics.fetchMetrics(params.type, params.since ? Number(params.since) : undefined),
+                params: [
+                    { name: 'type', location: 'query' },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'until', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'resolution', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'cursor', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'limit', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'fields', optional: true, location: 'query' },
+                    { name: 'stream', optional: true, location: 'query', parse: parseBoolean },
+                ],
+                action: (req, params, opts) => this.fetchMetrics(req, params, opts),
+            })],
+            ['metricsources', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                action: () => this.metricsCollector.getSourceStats(),
+            })],
+            ['websocketstats', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                action: () => this.rest.getWebsocketStats(),
+            })],
+            ['discordstats', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                action: () => this.discord.getDispatchStats(),
+            })],
+            ['instrumentation', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                action: () => instrumentation.getReport(this.manager.instanceName),
+            })],
+            ['entitytrack', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [
+                    { name: 'type', location: 'query' },
+                    { name: 'id', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'name', optional: true, location: 'query' },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'until', optional: true, location: 'query', parse: parseNumber },
+                ],
+                action: (req, params) => this.fetchEntityMetric(params, (type) => this.metrics.fetchEntityTrack(type, {
+                    // 0 is a valid entity id
+                    id: (params.id !== undefined && params.id !== '') ? Number(params.id) : undefined,
+                    name: params.name,
+                    since: params.since ? Number(params.since) : undefined,
+                    until: params.until ? Number(params.until) : undefined,
+                })),
+            })],
+            ['entityarea', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [
+                    { name: 'type', location: 'query' },
+                    { name: 'minX', location: 'query', parse: parseNumber },
+                    { name: 'maxX', location: 'query', parse: parseNumber },
+                    { name: 'minZ', location: 'query', parse: parseNumber },
+                    { name: 'maxZ', location: 'query', parse: parseNumber },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'until', optional: true, location: 'query', parse: parseNumber },
+                ],
+                action: (req, params) => this.fetchEntityMetric(params, (type) => this.metrics.fetchEntitiesInArea(type, {
+                    minX: Number(params.minX),
+                    maxX: Number(params.maxX),
+                    minZ: Number(params.minZ),
+                    maxZ: Number(params.maxZ),
+                    since: params.since ? Number(params.since) : undefined,
+                    until: params.until ? Number(params.until) : undefined,
+                })),
             })],
             ['deleteMetrics', RequestTemplate.build({
                 method: 'delete',
@@ -169,7 +264,9 @@ export class Interface extends IService {
                 action: (req, params) => {
                     const days = Number(params.maxAgeDays);
                     if (days > 0) {
-                        this.metrics.deleteMetrics(days * 24 * 60 * 60 * 1000);
+                        const maxAge = days * 24 * 60 * 60 * 1000;
+                        this.metrics.deleteMetrics(maxAge);
+                        this.metrics.deleteRollups({ minute: maxAge, quarterHour: maxAge, hour: maxAge });
                     }
                 },
             })],
@@ -177,8 +274,79 @@ export class Interface extends IService {
                 method: 'get',
                 level: 'manage',
                 disableDiscord: true,
-                params: [{ name: 'type', location: 'query' }, { name: 'since', optional: true, location: 'query', parse: parseNumber }],
-                action: (req, params) => this.logReader.fetchLogs(params.type, params.since ? Number(params.since) : undefined),
+                params: [
+                    { name: 'type', location: 'query' },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'limit', optional: true, location: 'query', parse: parseNumber },
+                ],
+                action: (req, params) => this.logReader.fetchLogs(
+                    params.type,
+                    params.since ? Number(params.since) : undefined,
+                    params.limit ? Number(params.limit) : undefined,
+                ),
+            })],
+            ['logsearch', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [
+                    { name: 'q', location: 'query' },
+                    { name: 'types', optional: true, location: 'query' },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'until', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'cursor', optional: true, location: 'query' },
+                    { name: 'limit', optional: true, location: 'query', parse: parseNumber },
+                ],
+                action: (req, params) => this.logSearch.search({
+                    query: String(params.q),
+                    types: params.types
+                        ? String(params.types).split(',').map((x) => x.trim().toUpperCase()).filter((x) => !!x) as LogType[]
+                        : undefined,
+                    since: params.since ? Number(params.since) : undefined,
+                    until: params.until ? Number(params.until) : undefined,
+                    cursor: params.cursor ? String(params.cursor) : undefined,
+                    limit: params.limit ? Number(params.limit) : undefined,
+                }),
+            })],
+            ['admevents', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [
+                    { name: 'types', optional: true, location: 'query' },
+                    { name: 'player', optional: true, location: 'query' },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'until', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'cursor', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'limit', optional: true, location: 'query', parse: parseNumber },
+                ],
+                action: (req, params) => this.admEvents.queryEvents({
+                    types: params.types
+                        ? String(params.types).split(',').map((x) => x.trim().toUpperCase()).filter((x) => !!x) as AdmEventType[]
+                        : undefined,
+                    player: params.player,
+                    since: params.since ? Number(params.since) : undefined,
+                    until: params.until ? Number(params.until) : undefined,
+                    cursor: params.cursor ? Number(params.cursor) : undefined,
+                    limit: params.limit ? Number(params.limit) : undefined,
+                }),
+            })],
+            ['admpositions', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [
+                    { name: 'player', location: 'query' },
+                    { name: 'since', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'until', optional: true, location: 'query', parse: parseNumber },
+                    { name: 'limit', optional: true, location: 'query', parse: parseNumber },
+                ],
+                action: (req, params) => this.admEvents.queryPositions(
+                    params.player,
+                    params.since ? Number(params.since) : undefined,
+                    params.until ? Number(params.until) : undefined,
+                    params.limit ? Number(params.limit) : undefined,
+                ),
             })],
             ['login', RequestTemplate.build({
                 method: 'post',
@@ -242,6 +410,26 @@ export class Interface extends IService {
                 level: 'manage',
                 action: () => this.backup.getBackups(),
             })],
+            ['restorebackup', RequestTemplate.build({
+                method: 'post',
+                level: 'manage',
+                disableDiscord: true,
+                params: [{ name: 'backup' }, { name: 'files', optional: true }],
+                action: (req, params) => this.backup.restoreBackup(
+                    params.backup,
+                    params.files ? [].concat(params.files) : undefined,
+                ),
+            })],
+            ['diffbackups', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [
+                    { name: 'from', location: 'query' },
+                    { name: 'to', optional: true, location: 'query' },
+                ],
+                action: (req, params) => this.backup.diffBackups(params.from, params.to || undefined),
+            })],
             ['writemissionfile', RequestTemplate.build({
                 method: 'post',
                 level: 'manage',
@@ -259,14 +447,21 @@ export class Interface extends IService {
                 level: 'manage',
                 disableDiscord: true,
                 params: [{ name: 'file', location: 'query' }],
-                action: (req, params) => this.missionFiles.readMissionFile(params.file),
+                action: async (req, params) => {
+                    // pending economy edits of the file
+                    await this.economyStore.flush(params.file);
+                    return this.missionFiles.readMissionFile(params.file);
+                },
             })],
             ['readmissionfiles', RequestTemplate.build({
                 method: 'post',
                 level: 'manage',
                 disableDiscord: true,
                 params: [{ name: 'files' }],
-                action: (req, params) => Promise.all(params.files.map((x: string) => this.missionFiles.readMissionFile(x))),
+                action: (req, params) => Promise.all(params.files.map(async (x: string) => {
+                    await this.economyStore.flush(x);
+                    return this.missionFiles.readMissionFile(x);
+                })),
             })],
             ['readmissiondir', RequestTemplate.build({
                 method: 'get',
@@ -275,6 +470,55 @@ export class Interface extends IService {
                 params: [{ name: 'dir', location: 'query' }],
                 action: async (req, params) => this.missionFiles.readMissionDir(params.dir),
             })],
+            ['economyentries', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [{ name: 'file', location: 'query' }],
+                action: (req, params) => this.economyStore.listEntries(params.file),
+            })],
+            ['economyentry', RequestTemplate.build({
+                method: 'get',
+                level: 'manage',
+                disableDiscord: true,
+                params: [{ name: 'file', location: 'query' }, { name: 'name', location: 'query' }],
+                action: (req, params) => this.economyStore.getEntry(params.file, params.name),
+            })],
+            ['updateeconomyentry', RequestTemplate.build({
+                method: 'post',
+                level: 'manage',
+                disableDiscord: true,
+                params: [{ name: 'file' }, { name: 'name' }, { name: 'entry' }, { name: 'createBackup', optional: true, parse: parseBoolean }],
+                action: (req, params) => this.economyStore.updateEntry(
+                    params.file,
+                    params.name,
+                    params.entry,
+                    params.createBackup,
+                ),
+            })],
+            ['patcheconomyentry', RequestTemplate.build({
+                method: 'post',
+                level: 'manage',
+                disableDiscord: true,
+                params: [{ name: 'file' }, { name: 'name' }, { name: 'patch' }, { name: 'createBackup', optional: true, parse: parseBoolean }],
+                action: (req, params) => this.economyStore.patchEntry(
+                    params.file,
+                    params.name,
+                    params.patch,
+                    params.createBackup,
+                ),
+            })],
+            ['deleteeconomyentry', RequestTemplate.build({
+                method: 'post',
+                level: 'manage',
+                disableDiscord: true,
+                params: [{ name: 'file' }, { name: 'name' }, { name: 'createBackup', optional: true, parse: parseBoolean }],
+                action: (req, params) => this.economyStore.deleteEntry(
+                    params.file,
+                    params.name,
+                    params.createBackup,
+                ),
+            })],
             ['writeprofilefile', RequestTemplate.build({
                 method: 'post',
                 level: 'manage',
@@ -377,6 +621,54 @@ export class Interface extends IService {
         return this.rcon.getBans();
     };
 
+    /**
+     * Without cursor or limit the whole range is returned as a list (legacy behaviour).
+     * With cursor or limit a single page is returned, with stream every page is sent as partial response.
+     */
+    private fetchMetrics = async (
+        req: Request,
+        params: Record<string, any>,
+        opts: RequestOptions,
+    ): Promise<any> => {
+        const query: MetricPageQuery = {
+            since: params.since ? Number(params.since) : undefined,
+            until: params.until ? Number(params.until) : undefined,
+            resolution: params.resolution ? Number(params.resolution) : undefined,
+            cursor: params.cursor ? Number(params.cursor) : undefined,
+            limit: params.limit ? Number(params.limit) : undefined,
+            fields: params.fields
+                ? (Array.isArray(params.fields) ? params.fields : String(params.fields).split(','))
+                    .map((x) => String(x).trim())
+                    .filter((x) => !!x)
+                : undefined,
+        };
+
+        if (req.canStream && parseBoolean(params.stream)) {
+            const count = await this.metrics.streamMetrics(
+                params.type,
+                query,
+                (page) => opts.partialResponseCallback({ body: page }),
+            );
+            return { count };
+        }
+
+        if (query.cursor || query.limit) {
+            return this.metrics.fetchMetricsPage(params.type, query);
+        }
+
+        return (await this.metrics.fetchMetricsPage(params.type, query)).items;
+    };
+
+    private fetchEntityMetric = async (
+        params: Record<string, any>,
+        fetcher: (type: IngameEntityMetricType) => Promise<EntityTrackPoint[]>,
+    ): Promise<EntityTrackPoint[]> => {
+        if (!this.metrics.isEntityMetric(params.type)) {
+            throw new Response(HTTP.HTTP_STATUS_BAD_REQUEST, `Unsupported entity metric type: ${params.type}`);
+        }
+        return fetcher(params.type);
+    };
+
     // apply RBAC and audit
     private async actionRbacCheck(req: Request, x: RequestTemplate): Promise<Response | null> {
         if (x.level) {
@@ -4,6 +4,7 @@ import * as basicAuth from 'express-basic-auth';
 import * as compression from 'compression';
 import * as path from 'path';
 import { loggerMiddleware } from '../middleware/logger';
+import { instrumentationMiddleware } from '../middleware/instrumentation';
 
 import { Manager } from '../control/manager';
 import { Server } from 'http';
@@ -15,17 +16,25 @@ import { injectable, singleton } from 'tsyringe';
 import { EventBus } from '../control/event-bus';
 import { InternalEventTypes } from '../types/events';
 import { Listener } from 'eventemitter2';
-import { WebsocketCommand, WebsocketListenerEvent, WebsocketListenerType, WebsocketMessage } from '../types/websocket';
+import { WebsocketCommand, WebsocketListenerType, WebsocketMessage } from '../types/websocket';
+import { DEFAULT_WEBSOCKET_QUEUE_OPTIONS, WebsocketQueue, WebsocketQueueOptions, WebsocketQueueStats } from './websocket-queue';
 import { Interface } from './interface';
+import { constants as HTTP } from 'http2';
+import { Config } from '../config/config';
 
 @singleton()
 @injectable()
 export class REST extends IStatefulService {
 
+    public readonly configKeys: (keyof Config)[] = ['webPort', 'publishWebServer', 'serverPort'];
+
     public express: express.Application | undefined;
     public server: Server | undefined;
     public wsServer: ws.Server | undefined;
-    public wsClients: Map<ws, { user: string, listeners: Listener[]}> | undefined;
+    public wsClients: Map<ws, { user: string, types: Set<WebsocketListenerType>, queue: WebsocketQueue }> | undefined;
+    public wsQueueOptions: WebsocketQueueOptions = DEFAULT_WEBSOCKET_QUEUE_OPTIONS;
+    /** one event bus listener per listener type, which is shared by all clients */
+    private wsListeners = new Map<WebsocketListenerType, Listener>();
 
     public host: string | undefined;
     public port: number | undefined;
@@ -34,6 +43,7 @@ export class REST extends IStatefulService {
     public router = express.Router();
 
     private readonly UI_FILES = path.join(__dirname, '../ui');
+    private readonly NDJSON = 'application/x-ndjson';
 
     public constructor(
         loggerFactory: LoggerFactory,
@@ -60,6 +70,7 @@ export class REST extends IStatefulService {
         this.express.use(express.json({ limit: '50mb' }));
         this.express.use(express.urlencoded({ extended: true }));
         this.express.use(loggerMiddleware);
+        this.express.use(instrumentationMiddleware('rest', this.manager.instanceName));
 
         // static content
         this.express.use(express.static(this.UI_FILES));
@@ -85,11 +96,9 @@ export class REST extends IStatefulService {
         this.wsServer.on('connection', (socket: any) => {
             socket.on('message', (message) => this.handleWsMessage(socket, message));
             socket.on('close', () => {
-                const socketData = (this.wsClients?.get(socket)?.listeners || []);
+                this.wsClients?.get(socket)?.queue.close();
                 this.wsClients?.delete(socket);
-                for (const listener of socketData) {
-                    listener.off();
-                }
+                this.releaseWsEventListeners();
             });
         });
 
@@ -129,7 +138,8 @@ export class REST extends IStatefulService {
                             wsSocket,
                             {
                                 user: username,
-                                listeners: this.wsClients.get(wsSocket)?.listeners || [],
+                                types: new Set(),
+                                queue: new WebsocketQueue(wsSocket, username, this.wsQueueOptions),
                             },
                         );
                         this.wsServer.emit('connection', wsSocket, request);
@@ -164,23 +174,39 @@ export class REST extends IStatefulService {
         }
 
         this.log.log(LogLevel.DEBUG, `Registering: ${listenerType} for ${user}`);
-        const listener = this.eventBus.on(
-            eventType as any,
-            async (event) => {
-                socket.send(JSON.stringify({
-                    cmd: WebsocketCommand.LISTENER_EVENT,
-                    data: {
-                        type: listenerType,
-                        event: event,
-                    },
-                } as WebsocketMessage<WebsocketListenerEvent>));
-            },
-        );
-        const socketDetails = this.wsClients.get(socket);
-        if (!socketDetails.listeners) {
-            socketDetails.listeners = [];
+        this.wsClients.get(socket).types.add(listenerType);
+        if (!this.wsListeners.has(listenerType)) {
+            this.wsListeners.set(listenerType, this.eventBus.on(
+                eventType as any,
+                async (event) => this.fanOutWsEvent(listenerType, event),
+            ));
+        }
+    }
+
+    /**
+     * Queues an event for all subscribed clients, the event is serialized only once for all of them
+     */
+    private fanOutWsEvent(listenerType: WebsocketListenerType, event: any): void {
+        let serialized: string | undefined;
+        for (const client of this.wsClients?.values() ?? []) {
+            if (client.types.has(listenerType)) {
+                serialized = serialized ?? JSON.stringify(event) ?? 'null';
+                client.queue.push(listenerType, serialized);
+            }
         }
-        socketDetails.listeners.push(listener);
+    }
+
+    private releaseWsEventListeners(): void {
+        for (const [type, listener] of [...this.wsListeners]) {
+            if (![...(this.wsClients?.values() ?? [])].some((x) => x.types.has(type))) {
+                listener.off();
+                this.wsListeners.delete(type);
+            }
+        }
+    }
+
+    public getWebsocketStats(): WebsocketQueueStats[] {
+        return [...(this.wsClients?.values() ?? [])].map((x) => x.queue.getStats());
     }
 
     private handleWsMessage(socket: ws, message: ws.Data): void {
@@ -245,7 +271,7 @@ export class REST extends IStatefulService {
 
             const internalResponse = await this.eventInterface.execute(
                 internalRequest,
-                /* istanbul ignore next */ (part) => this.websocketRespond(socket, part),
+                /* istanbul ignore next */ (part) => this.websocketRespond(socket, { ...part, uuid: request.uuid }),
             );
 
             await this.websocketRespond(socket, internalResponse);
@@ -347,9 +373,68 @@ export class REST extends IStatefulService {
         internalRequest.resource = resource;
         internalRequest.user = username;
 
-        const internalResponse = await this.eventInterface.execute(internalRequest);
+        // clients accepting NDJSON receive partial responses as separate lines while they are produced
+        const ndjson = !!internalRequest.accept?.includes(this.NDJSON);
+        internalRequest.canStream = ndjson;
+
+        const internalResponse = ndjson
+            ? await this.eventInterface.execute(internalRequest, (part) => this.writeNdjsonLine(res, part.body))
+            : await this.eventInterface.execute(internalRequest);
+
+        if (!res.headersSent) {
+            res.status(internalResponse.status).send(internalResponse.body);
+            return;
+        }
+
+        // the client went away while the response was streamed, nobody is left to read the result
+        if (this.isClosed(res)) {
+            return;
+        }
+
+        // the status was already sent with the first part
+        await this.writeNdjsonLine(
+            res,
+            internalResponse.status === HTTP.HTTP_STATUS_OK
+                ? internalResponse.body
+                : { status: internalResponse.status, error: internalResponse.body },
+        );
+        res.end();
+    }
+
+    private writeNdjsonLine(res: express.Response, body: unknown): Promise<void> {
+        if (!res.headersSent) {
+            res.status(HTTP.HTTP_STATUS_OK);
+            res.type(this.NDJSON);
+        }
+        return new Promise((r, e) => {
+            // a client that already disconnected will neither drain nor close again
+            if (this.isClosed(res)) {
+                e(new Error('Client closed the connection'));
+                return;
+            }
+            const flushed = res.write(`${JSON.stringify(body)}\n`);
+            // compression would buffer the line otherwise
+            (res as any).flush?.();
+            if (flushed) {
+                r();
+                return;
+            }
+            // wait until the client consumed the last line, abort the stream if it went away instead
+            const onDrain = (): void => {
+                res.off('close', onClose);
+                r();
+            };
+            const onClose = (): void => {
+                res.off('drain', onDrain);
+                e(new Error('Client closed the connection'));
+            };
+            res.once('drain', onDrain);
+            res.once('close', onClose);
+        });
+    }
 
-        res.status(internalResponse.status).send(internalResponse.body);
+    private isClosed(res: express.Response): boolean {
+        return res.destroyed || res.writableEnded;
     }
 
     public stop(): Promise<void> {
@@ -360,10 +445,11 @@ export class REST extends IStatefulService {
 
             const wsClients = [...(this.wsClients?.entries() || [])];
             for (const client of wsClients) {
-                client[1]?.listeners?.forEach((listener) => listener.off());
+                client[1]?.queue.close();
                 client[0].close(1001);
             }
             this.wsClients = undefined;
+            this.releaseWsEventListeners();
 
             this.server?.close((error) => {
                 if (error) {
@@ -0,0 +1,167 @@
+import * as ws from 'ws';
+import { WebsocketCommand, WebsocketListenerType } from '../types/websocket';
+
+export interface WebsocketQueueOptions {
+    /** ms events are collected before they are sent as one frame */
+    batchInterval: number;
+    /** max events per frame */
+    maxBatchSize: number;
+    /** bytes waiting in the socket above which nothing is sent until the client caught up */
+    maxBufferedAmount: number;
+    /** max queued events per listener type, the oldest events are dropped above */
+    maxQueueSize: number;
+}
+
+export interface WebsocketQueueStats {
+    user: string;
+    /** events waiting to be sent */
+    queued: number;
+    /** events dropped because the client was too slow */
+    dropped: number;
+    events: number;
+    frames: number;
+    framesPerSecond: number;
+    /** bytes waiting in the socket */
+    bufferedAmount: number;
+}
+
+export const DEFAULT_WEBSOCKET_QUEUE_OPTIONS: WebsocketQueueOptions = {
+    batchInterval: 100,
+    maxBatchSize: 500,
+    maxBufferedAmount: 1024 * 1024,
+    maxQueueSize: 5000,
+};
+
+interface ListenerQueue {
+    /** serialized events */
+    events: string[];
+    /** dropped since the last frame */
+    dropped: number;
+}
+
+/**
+ * Outbound listener events of a single websocket client.
+ *
+ * Events are collected and sent as one frame per listener type and interval.
+ * While the client does not keep up (the socket buffers too much), events stay queued
+ * and the oldest ones are dropped. The next frame tells the client how many were dropped.
+ */
+export class WebsocketQueue {
+
+    private queues = new Map<WebsocketListenerType, ListenerQueue>();
+    private timer: any;
+
+    private dropped = 0;
+    private events = 0;
+    private frames = 0;
+    private windowStart = Date.now();
+    private windowFrames = 0;
+    private framesPerSecond = 0;
+
+    public constructor(
+        private socket: ws,
+        public readonly user: string,
+        private options: WebsocketQueueOptions = DEFAULT_WEBSOCKET_QUEUE_OPTIONS,
+    ) {}
+
+    /**
+     * @param type the listener type
+     * @param event the serialized event, so it is serialized only once for all clients
+     */
+    public push(type: WebsocketListenerType, event: string): void {
+        let queue = this.queues.get(type);
+        if (!queue) {
+            queue = { events: [], dropped: 0 };
+            this.queues.set(type, queue);
+        }
+        queue.events.push(event);
+
+        // drop in chunks, so a full queue is not shifted on every event
+        if (queue.events.length > this.options.maxQueueSize * 1.1) {
+            const excess = queue.events.length - this.options.maxQueueSize;
+            queue.events.splice(0, excess);
+            queue.dropped += excess;
+            this.dropped += excess;
+        }
+
+        this.schedule();
+    }
+
+    private schedule(): void {
+        if (!this.timer) {
+            this.timer = setTimeout(() => {
+                this.timer = undefined;
+                this.flush();
+            }, this.options.batchInterval);
+        }
+    }
+
+    /**
+     * Sends the queued events, unless the client is still busy with the previous frames
+     */
+    public flush(): void {
+        if (this.socket.readyState !== ws.OPEN) {
+            this.queues.clear();
+            return;
+        }
+        if (this.socket.bufferedAmount > this.options.maxBufferedAmount) {
+            this.schedule();
+            return;
+        }
+
+        for (const [type, queue] of this.queues) {
+            if (!queue.events.length && !queue.dropped) continue;
+
+            const events = queue.events.splice(0, this.options.maxBatchSize);
+            this.send(type, events, queue.dropped);
+            this.events += events.length;
+            queue.dropped = 0;
+            if (queue.events.length) {
+                this.schedule();
+            }
+        }
+    }
+
+    /**
+     * Sends a WebsocketListenerEvents message, which is built from the already serialized events
+     */
+    private send(type: WebsocketListenerType, events: string[], dropped: number): void {
+        this.socket.send(
+            `{"cmd":${JSON.stringify(WebsocketCommand.LISTENER_EVENTS)}`
+            + `,"data":{"type":${JSON.stringify(type)},"events":[${events.join(',')}],"dropped":${dropped}}}`,
+        );
+        this.frames++;
+
+        const now = Date.now();
+        this.windowFrames++;
+        if (now - this.windowStart >= 1000) {
+            this.framesPerSecond = this.windowFrames * 1000 / (now - this.windowStart);
+            this.windowStart = now;
+            this.windowFrames = 0;
+        }
+    }
+
+    public getStats(): WebsocketQueueStats {
+        // the rate is outdated if nothing was sent for a while
+        const elapsed = Date.now() - this.windowStart;
+        const framesPerSecond = elapsed >= 2000
+            ? this.windowFrames * 1000 / elapsed
+            : this.framesPerSecond;
+        return {
+            user: this.user,
+            queued: [...this.queues.values()].reduce((sum, x) => sum + x.events.length, 0),
+            dropped: this.dropped,
+            events: this.events,
+            frames: this.frames,
+            framesPerSecond: Math.round(framesPerSecond * 10) / 10,
+            bufferedAmount: this.socket.bufferedAmount,
+        };
+    }
+
+    public close(): void {
+        clearTimeout(this.timer);
+        this.timer = undefined;
+        this.queues.clear();
+    }
+
+}
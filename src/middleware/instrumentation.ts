@@ -0,0 +1,33 @@
+import { Request, Response } from 'express';
+import { performance } from 'perf_hooks';
+import { HTTP_REQUEST_DURATION, instanceLabels, instrumentation } from '../util/instrumentation';
+
+/**
+ * Records the latency of the requests per matched route.
+ * Requests without a route (static files, 404s, rejected auth) share one label, so the label values stay few.
+ * @param server the name of the server (i.e. 'rest' or 'ingame')
+ * @param instance the server instance (if the manager runs multiple)
+ * @returns the middleware
+ */
+export const instrumentationMiddleware = (
+    server: string,
+    instance?: string,
+) => (req: Request, resp: Response, next: any): void => {
+    const start = performance.now();
+    resp.on(
+        'finish',
+        () => {
+            instrumentation.observe(
+                HTTP_REQUEST_DURATION,
+                instanceLabels(instance, {
+                    server,
+                    method: req.method,
+                    route: req.route?.path ? `${req.baseUrl ?? ''}${req.route.path}` : 'other',
+                    status: `${Math.floor(resp.statusCode / 100)}xx`,
+                }),
+                performance.now() - start,
+            );
+        },
+    );
+    next();
+};
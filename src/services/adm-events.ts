@@ -0,0 +1,262 @@
+import { injectable, singleton } from 'tsyringe';
+import { Listener } from 'eventemitter2';
+import { IStatefulService } from '../types/service';
+import { LoggerFactory } from './loggerfactory';
+import { Manager } from '../control/manager';
+import { EventBus } from '../control/event-bus';
+import { Database, DatabaseTypes } from './database';
+import { InternalEventTypes } from '../types/events';
+import { LogMessage, LogTypeEnum } from '../types/log-reader';
+import { AdmEvent, AdmEventQuery, AdmEventTypeEnum, AdmPosition, AdmStoredEvent } from '../types/adm';
+import { AdmParser } from '../util/adm-parser';
+import { LogLevel } from '../util/logger';
+
+const EVENT_COLUMNS: (keyof AdmEvent)[] = [
+    'timestamp',
+    'type',
+    'playerId',
+    'playerName',
+    'x',
+    'y',
+    'z',
+    'hp',
+    'sourceId',
+    'sourceName',
+    'sourceX',
+    'sourceY',
+    'sourceZ',
+    'bodyPart',
+    'damage',
+    'ammo',
+    'weapon',
+    'distance',
+    'message',
+];
+
+@singleton()
+@injectable()
+export class AdmEvents extends IStatefulService {
+
+    public static readonly BATCH_SIZE = 1000;
+    public static readonly MAX_PAGE_SIZE = 5000;
+
+    public flushInterval = 1000;
+    public retentionInterval = 3_600_000;
+
+    private parser = new AdmParser();
+    private pending: AdmEvent[] = [];
+    private listener: Listener | undefined;
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private manager: Manager,
+        private eventBus: EventBus,
+        private database: Database,
+    ) {
+        super(loggerFactory.createLogger('AdmEvents'));
+    }
+
+    public async start(): Promise<void> {
+        const db = this.database.getDatabase(DatabaseTypes.ADM_EVENTS);
+        db.run(`
+            CREATE TABLE IF NOT EXISTS ADM_EVENTS (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                timestamp UNSIGNED BIG INT NOT NULL,
+                type TEXT NOT NULL,
+                playerId TEXT,
+                playerName TEXT,
+                x REAL,
+                y REAL,
+                z REAL,
+                hp REAL,
+                sourceId TEXT,
+                sourceName TEXT,
+                sourceX REAL,
+                sourceY REAL,
+                sourceZ REAL,
+                bodyPart TEXT,
+                damage REAL,
+                ammo TEXT,
+                weapon TEXT,
+                distance REAL,
+                message TEXT
+            );
+        `);
+        db.run('CREATE INDEX IF NOT EXISTS ADM_EVENTS_TS ON ADM_EVENTS (timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_EVENTS_TYPE_TS ON ADM_EVENTS (type, timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_EVENTS_PLAYER_TS ON ADM_EVENTS (playerId, timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_EVENTS_PLAYERNAME_TS ON ADM_EVENTS (playerName, timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_EVENTS_SOURCE_TS ON ADM_EVENTS (sourceId, timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_EVENTS_SOURCENAME_TS ON ADM_EVENTS (sourceName, timestamp);');
+        db.run(`
+            CREATE TABLE IF NOT EXISTS ADM_POSITIONS (
+                timestamp UNSIGNED BIG INT NOT NULL,
+                playerId TEXT NOT NULL,
+                playerName TEXT,
+                x REAL,
+                y REAL,
+                z REAL
+            );
+        `);
+        db.run('CREATE INDEX IF NOT EXISTS ADM_POSITIONS_PLAYER_TS ON ADM_POSITIONS (playerId, timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_POSITIONS_PLAYERNAME_TS ON ADM_POSITIONS (playerName, timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS ADM_POSITIONS_TS ON ADM_POSITIONS (timestamp);');
+
+        this.listener = this.eventBus.onBatch(InternalEventTypes.LOG_ENTRY, (events) => {
+            for (const x of events) {
+                if (x?.type === LogTypeEnum.ADM) {
+                    this.ingest(x.entry);
+                }
+            }
+        });
+
+        this.timers.addInterval('flush', () => this.flush(), this.flushInterval);
+        this.timers.addInterval(
+            'retention',
+            /* istanbul ignore next */ () => this.cleanup(),
+            this.retentionInterval,
+        );
+    }
+
+    public async stop(): Promise<void> {
+        this.timers.removeAllTimers();
+        this.listener?.off();
+        this.listener = undefined;
+        this.flush();
+        this.parser.reset();
+    }
+
+    /**
+     * Parses an ADM line and queues the resulting event for the next batch write
+     * @param entry the log line
+     */
+    public ingest(entry: LogMessage): void {
+        const event = this.parser.parse(entry.message, entry.timestamp);
+        if (!event) {
+            return;
+        }
+        this.pending.push(event);
+        if (this.pending.length >= AdmEvents.BATCH_SIZE) {
+            this.flush();
+        }
+    }
+
+    /**
+     * Writes all queued events in a single transaction
+     */
+    public flush(): void {
+        if (!this.pending.length) {
+            return;
+        }
+        const events = this.pending;
+        this.pending = [];
+
+        try {
+            this.database.getDatabase(DatabaseTypes.ADM_EVENTS).transaction((db) => {
+                const eventStmt = db.prepare(`
+                    INSERT INTO ADM_EVENTS (${EVENT_COLUMNS.join(', ')})
+                    VALUES (${EVENT_COLUMNS.map(() => '?').join(', ')})
+                `);
+                const positionStmt = db.prepare(`
+                    INSERT INTO ADM_POSITIONS (timestamp, playerId, playerName, x, y, z)
+                    VALUES (?, ?, ?, ?, ?, ?)
+                `);
+                for (const event of events) {
+                    if (event.type === AdmEventTypeEnum.POSITION) {
+                        positionStmt.run([
+                            event.timestamp,
+                            event.playerId,
+                            event.playerName ?? null,
+                            event.x ?? null,
+                            event.y ?? null,
+                            event.z ?? null,
+                        ]);
+                    } else {
+                        eventStmt.run(EVENT_COLUMNS.map((col) => event[col] ?? null));
+                    }
+                }
+            });
+        } catch (e) {
+            this.log.log(LogLevel.ERROR, `Failed to write ${events.length} ADM events`, e);
+        }
+    }
+
+    private cleanup(): void {
+        const maxAge = this.manager.config?.admEventMaxAge;
+        if (!maxAge || maxAge <= 0) {
+            return;
+        }
+        const delTs = new Date().valueOf() - maxAge;
+        const db = this.database.getDatabase(DatabaseTypes.ADM_EVENTS);
+        db.run('DELETE FROM ADM_EVENTS WHERE timestamp < ?', delTs);
+        db.run('DELETE FROM ADM_POSITIONS WHERE timestamp < ?', delTs);
+    }
+
+    private getPageSize(limit?: number): number {
+        return Math.min(limit > 0 ? limit : AdmEvents.MAX_PAGE_SIZE, AdmEvents.MAX_PAGE_SIZE);
+    }
+
+    /**
+     * Queries the stored events ordered by id (which is the order of the log)
+     * @param query filter and paging options
+     */
+    public queryEvents(query: AdmEventQuery): AdmStoredEvent[] {
+        this.flush();
+
+        const where: string[] = ['id > ?'];
+        const params: any[] = [query.cursor ?? 0];
+        if (query.types?.length) {
+            where.push(`type IN (${query.types.map(() => '?').join(', ')})`);
+            params.push(...query.types);
+        }
+        if (query.player) {
+            where.push('(playerId = ? OR playerName = ? OR sourceId = ? OR sourceName = ?)');
+            params.push(query.player, query.player, query.player, query.player);
+        }
+        if (query.since) {
+            where.push('timestamp > ?');
+            params.push(query.since);
+        }
+        if (query.until) {
+            where.push('timestamp <= ?');
+            params.push(query.until);
+        }
+
+        return this.database.getDatabase(DatabaseTypes.ADM_EVENTS).all(
+            `
+                SELECT * FROM ADM_EVENTS
+                WHERE ${where.join(' AND ')}
+                ORDER BY id ASC
+                LIMIT ?
+            `,
+            ...params,
+            this.getPageSize(query.limit),
+        );
+    }
+
+    /**
+     * Queries the positions of a player (by id or name) from the periodic player list
+     * @param player the player id or name
+     * @param since lower timestamp bound (exclusive)
+     * @param until upper timestamp bound (inclusive)
+     * @param limit max number of positions
+     */
+    public queryPositions(player: string, since?: number, until?: number, limit?: number): AdmPosition[] {
+        this.flush();
+
+        return this.database.getDatabase(DatabaseTypes.ADM_EVENTS).all(
+            `
+                SELECT * FROM ADM_POSITIONS
+                WHERE (playerId = ? OR playerName = ?) AND timestamp > ? AND timestamp <= ?
+                ORDER BY timestamp ASC
+                LIMIT ?
+            `,
+            player,
+            player,
+            since ?? 0,
+            until || Number.MAX_SAFE_INTEGER,
+            this.getPageSize(limit),
+        );
+    }
+
+}
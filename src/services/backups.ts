@@ -1,13 +1,35 @@
 import { Manager } from '../control/manager';
 import { LogLevel } from '../util/logger';
+import * as crypto from 'crypto';
 import * as path from 'path';
+import * as zlib from 'zlib';
+import { pipeline } from 'stream';
 import { Paths } from '../services/paths';
 import { FileDescriptor } from '../types/log-reader';
+import { BackupDiff, BackupFileEntry, BackupManifest, BackupRestoreResult, BackupResult } from '../types/backups';
 import { IService } from '../types/service';
 import { LoggerFactory } from './loggerfactory';
+import { Monitor } from './monitor';
+import { ServerState } from '../types/monitor';
 import { FSAPI, InjectionTokens } from '../util/apis';
 import { inject, injectable, singleton } from 'tsyringe';
 
+const MANIFEST_FILE = 'manifest.json';
+const FILES_DIR = 'files';
+
+interface Snapshot {
+    manifest: BackupManifest;
+    /** backups of older versions are plain copies of the mission files */
+    legacy: boolean;
+}
+
+/**
+ * Creates snapshots of the mpmissions folder.
+ *
+ * Each snapshot has a manifest with the hash of every file.
+ * Files that did not change since the previous snapshot are hardlinked from it, all others are stored gzipped.
+ * Backups of older versions (plain copies without a manifest) can still be compared and restored.
+ */
 @singleton()
 @injectable()
 export class Backups extends IService {
@@ -16,31 +38,106 @@ export class Backups extends IService {
         loggerFactory: LoggerFactory,
         private manager: Manager,
         private paths: Paths,
+        private monitor: Monitor,
         @inject(InjectionTokens.fs) private fs: FSAPI,
     ) {
         super(loggerFactory.createLogger('Backups'));
     }
 
-    public async createBackup(): Promise<void> {
+    private getMissionsDir(): string {
+        return path.join(this.manager.getServerPath(), 'mpmissions');
+    }
+
+    public async createBackup(): Promise<BackupResult | undefined> {
         const backups = this.getBackupDir();
 
         await this.fs.promises.mkdir(backups, { recursive: true });
 
-        const mpmissions = path.join(this.manager.getServerPath(), 'mpmissions');
+        const mpmissions = this.getMissionsDir();
         if (!this.fs.existsSync(mpmissions)) {
             this.log.log(LogLevel.WARN, 'Skipping backup because mpmissions folder does not exist');
             return;
         }
 
         const now = new Date();
-        const curMarker = `mpmissions_${now.getFullYear()}-${now.getMonth() + 1}-${now.getDate()}-${now.getHours()}-${now.getMinutes()}`;
+        const marker = `mpmissions_${now.getFullYear()}-${now.getMonth() + 1}-${now.getDate()}-${now.getHours()}-${now.getMinutes()}`;
+        let curMarker = marker;
+        for (let i = 1; this.fs.existsSync(path.join(backups, curMarker)); i++) {
+            curMarker = `${marker}-${i}`;
+        }
 
         this.log.log(LogLevel.IMPORTANT, `Creating backup ${curMarker}`);
 
+        const previous = await this.getLatestSnapshot();
+        const prevManifest = previous ? this.readManifest(previous) : undefined;
         const curBackup = path.join(backups, curMarker);
-        await this.paths.copyDirFromTo(mpmissions, curBackup);
+        const result: BackupResult = {
+            backup: curMarker,
+            files: 0,
+            linked: 0,
+            stored: 0,
+            totalBytes: 0,
+            storedBytes: 0,
+        };
+        const manifest: BackupManifest = {
+            created: now.valueOf(),
+            previous,
+            files: {},
+        };
+
+        // the snapshot is built in a temp dir, so incomplete snapshots are never used as the base of the next one
+        const tmpBackup = `${curBackup}.tmp`;
+        if (this.fs.existsSync(tmpBackup)) {
+            await this.paths.removeLink(tmpBackup);
+        }
+
+        for (const file of await this.listFiles(mpmissions)) {
+            const source = path.join(mpmissions, file);
+            const target = this.getStoredPath(tmpBackup, file);
+            const stat = await this.fs.promises.stat(source);
+            const known = prevManifest?.files[file];
+            await this.fs.promises.mkdir(path.dirname(target), { recursive: true });
+
+            let entry: BackupFileEntry;
+            if (known?.size === stat.size && known?.mtime === stat.mtimeMs) {
+                entry = known;
+            } else {
+                const hash = await this.compress(source, target);
+                entry = { hash, size: stat.size, mtime: stat.mtimeMs };
+            }
+
+            const prevStored = previous && this.getStoredPath(path.join(backups, previous), file);
+            if (entry.hash === known?.hash && this.fs.existsSync(prevStored)) {
+                if (this.fs.existsSync(target)) {
+                    await this.fs.promises.unlink(target);
+                }
+                this.linkOrCopy(prevStored, target);
+                result.linked++;
+            } else {
+                if (entry === known) {
+                    // the previous stored file is missing
+                    entry = { ...entry, hash: await this.compress(source, target) };
+                }
+                result.stored++;
+                result.storedBytes += (await this.fs.promises.stat(target)).size;
+            }
+
+            manifest.files[file] = entry;
+            result.files++;
+            result.totalBytes += stat.size;
+        }
+
+        await this.fs.promises.writeFile(path.join(tmpBackup, MANIFEST_FILE), JSON.stringify(manifest));
+        await this.fs.promises.rename(tmpBackup, curBackup);
+
+        this.log.log(
+            LogLevel.IMPORTANT,
+            `Created backup ${curMarker}: ${result.files} files, ${result.linked} unchanged, ${result.stored} stored (${result.storedBytes} of ${result.totalBytes} bytes)`,
+        );
 
         void this.cleanup();
+
+        return result;
     }
 
     private getBackupDir(): string {
@@ -50,14 +147,124 @@ export class Backups extends IService {
         return path.join(this.paths.cwd(), this.manager.config.backupPath);
     }
 
+    private getStoredPath(backupDir: string, file: string): string {
+        return path.join(backupDir, FILES_DIR, `${file}.gz`);
+    }
+
+    /**
+     * @returns the files in the dir relative to it with forward slashes
+     */
+    private async listFiles(dir: string): Promise<string[]> {
+        return (await this.paths.findFilesInDir(dir))
+            .map((x) => path.relative(dir, x).split(path.sep).join('/'))
+            .sort();
+    }
+
+    private linkOrCopy(source: string, target: string): void {
+        try {
+            this.fs.linkSync(source, target);
+        } catch {
+            this.fs.copyFileSync(source, target);
+        }
+    }
+
+    private hashFile(file: string): Promise<string> {
+        return new Promise<string>((res, rej) => {
+            const hash = crypto.createHash('sha256');
+            this.fs.createReadStream(file)
+                .on('error', rej)
+                .on('data', (chunk) => hash.update(chunk))
+                .on('end', () => res(hash.digest('hex')));
+        });
+    }
+
+    /**
+     * Gzips the source in a single read
+     * @returns the hash of the uncompressed content
+     */
+    private compress(source: string, target: string): Promise<string> {
+        return new Promise<string>((res, rej) => {
+            const hash = crypto.createHash('sha256');
+            const input = this.fs.createReadStream(source);
+            input.on('data', (chunk) => hash.update(chunk));
+            pipeline(
+                input,
+                zlib.createGzip(),
+                this.fs.createWriteStream(target),
+                (e) => (e ? rej(e) : res(hash.digest('hex'))),
+            );
+        });
+    }
+
+    private decompress(source: string, target: string): Promise<void> {
+        return new Promise<void>((res, rej) => {
+            pipeline(
+                this.fs.createReadStream(source),
+                zlib.createGunzip(),
+                this.fs.createWriteStream(target),
+                (e) => (e ? rej(e) : res()),
+            );
+        });
+    }
+
+    public readManifest(backup: string): BackupManifest | undefined {
+        try {
+            return JSON.parse(
+                this.fs.readFileSync(path.join(this.getBackupDir(), path.basename(backup), MANIFEST_FILE)) + '',
+            );
+        } catch {
+            return undefined;
+        }
+    }
+
+    /**
+     * Reads the manifest of a backup.
+     * For backups without a manifest (created by older versions), it is built by scanning the backup dir.
+     * @param backup the backup
+     */
+    private async getSnapshot(backup: string): Promise<Snapshot> {
+        const manifest = this.readManifest(backup);
+        if (manifest) {
+            return { manifest, legacy: false };
+        }
+
+        const backupDir = path.join(this.getBackupDir(), path.basename(backup));
+        if (!this.fs.existsSync(backupDir)) {
+            throw new Error(`Backup ${backup} does not exist`);
+        }
+        const files: Record<string, BackupFileEntry> = {};
+        for (const file of await this.listFiles(backupDir)) {
+            const source = path.join(backupDir, file);
+            const stat = await this.fs.promises.stat(source);
+            files[file] = { hash: await this.hashFile(source), size: stat.size, mtime: stat.mtimeMs };
+        }
+        return {
+            manifest: { created: (await this.fs.promises.stat(backupDir)).mtimeMs, files },
+            legacy: true,
+        };
+    }
+
+    private async getLatestSnapshot(): Promise<string | undefined> {
+        let latest: { file: string; created: number } | undefined;
+        for (const backup of await this.getBackups()) {
+            const created = this.readManifest(backup.file)?.created;
+            if (created && (!latest || created >= latest.created)) {
+                latest = { file: backup.file, created };
+            }
+        }
+        return latest?.file;
+    }
+
     public async getBackups(): Promise<FileDescriptor[]> {
         const backups = this.getBackupDir();
         const files = await this.fs.promises.readdir(backups);
         const foundBackups: FileDescriptor[] = [];
         for (const file of files) {
-            const fullPath = path.join(backups, file);
-            const stats = await this.fs.promises.stat(fullPath);
-            if (file.startsWith('mpmissions_') && stats.isDirectory()) {
+            if (!file.startsWith('mpmissions_') || file.endsWith('.tmp')) {
+                continue;
+            }
+            const stats = await this.fs.promises.stat(path.join(backups, file));
+            if (stats.isDirectory()) {
                 foundBackups.push({
                     file,
                     mtime: stats.mtime.getTime(),
@@ -67,12 +274,112 @@ export class Backups extends IService {
         return foundBackups;
     }
 
+    /**
+     * Compares two snapshots
+     * @param from the older snapshot
+     * @param to the newer snapshot, compared with the current mission files if omitted
+     */
+    public async diffBackups(from: string, to?: string): Promise<BackupDiff> {
+        const fromManifest = (await this.getSnapshot(from)).manifest;
+        const toFiles = to ? (await this.getSnapshot(to)).manifest.files : undefined;
+
+        const diff: BackupDiff = { added: [], removed: [], changed: [] };
+        const mpmissions = this.getMissionsDir();
+        const current = toFiles ? Object.keys(toFiles) : await this.listFiles(mpmissions);
+        for (const file of current) {
+            const old = fromManifest.files[file];
+            if (!old) {
+                diff.added.push(file);
+            } else if (!await this.isSame(old, toFiles?.[file], path.join(mpmissions, file))) {
+                diff.changed.push(file);
+            }
+        }
+        const currentSet = new Set(current);
+        diff.removed = Object.keys(fromManifest.files).filter((x) => !currentSet.has(x));
+        return diff;
+    }
+
+    /**
+     * @returns whether the entry matches the other entry or (if not given) the content of the file
+     */
+    private async isSame(entry: BackupFileEntry, other: BackupFileEntry | undefined, file: string): Promise<boolean> {
+        if (other) {
+            return entry.hash === other.hash;
+        }
+        const stat = await this.fs.promises.stat(file);
+        if (stat.size !== entry.size) {
+            return false;
+        }
+        return (stat.mtimeMs === entry.mtime) || (await this.hashFile(file) === entry.hash);
+    }
+
+    /**
+     * Restores the mission files of a snapshot.
+     * Files which already match the snapshot are skipped.
+     * The server must be stopped, because it keeps the mission loaded and writes the storage while running.
+     *
+     * @param backup the snapshot
+     * @param files only restore these files, otherwise files that are not part of the snapshot are removed as well
+     */
+    public async restoreBackup(backup: string, files?: string[]): Promise<BackupRestoreResult> {
+        if (this.monitor.serverState !== ServerState.STOPPED) {
+            throw new Error(`Backups can only be restored while the server is stopped (current state: ${this.monitor.serverState})`);
+        }
+
+        const { manifest, legacy } = await this.getSnapshot(backup);
+
+        const backupDir = path.join(this.getBackupDir(), path.basename(backup));
+        const mpmissions = this.getMissionsDir();
+        const result: BackupRestoreResult = { restored: 0, unchanged: 0, removed: 0 };
+        const restore = files ?? Object.keys(manifest.files);
+
+        this.log.log(LogLevel.IMPORTANT, `Restoring backup ${backup}`);
+
+        for (const file of restore) {
+            const entry = manifest.files[file];
+            if (!entry) {
+                throw new Error(`${file} is not part of backup ${backup}`);
+            }
+            const target = path.join(mpmissions, file);
+            if (this.fs.existsSync(target) && await this.isSame(entry, undefined, target)) {
+                result.unchanged++;
+                continue;
+            }
+            await this.fs.promises.mkdir(path.dirname(target), { recursive: true });
+            const tmp = `${target}.restore`;
+            if (legacy) {
+                await this.fs.promises.copyFile(path.join(backupDir, file), tmp);
+            } else {
+                await this.decompress(this.getStoredPath(backupDir, file), tmp);
+            }
+            await this.fs.promises.rename(tmp, target);
+            result.restored++;
+        }
+
+        if (!files) {
+            for (const file of await this.listFiles(mpmissions)) {
+                if (!manifest.files[file]) {
+                    await this.fs.promises.unlink(path.join(mpmissions, file));
+                    result.removed++;
+                }
+            }
+        }
+
+        this.log.log(
+            LogLevel.IMPORTANT,
+            `Restored backup ${backup}: ${result.restored} restored, ${result.unchanged} unchanged, ${result.removed} removed`,
+        );
+
+        return result;
+    }
+
     public async cleanup(): Promise<void> {
         const now = new Date().valueOf();
         const backups = await this.getBackups();
         for (const backup of backups) {
             if ((now - backup.mtime) > (this.manager.config.backupMaxAge * 24 * 60 * 60 * 1000)) {
-                await this.paths.removeLink(backup.file);
+                // hardlinked files stay available to the newer snapshots
+                await this.paths.removeLink(path.join(this.getBackupDir(), backup.file));
             }
         }
     }
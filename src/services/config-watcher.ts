@@ -8,7 +8,11 @@ import { IService } from '../types/service';
 import { LoggerFactory } from './loggerfactory';
 import { CHOKIDAR, InjectionTokens } from '../util/apis';
 
-export type ConfigCallback = (config: Config) => any;
+/**
+ * @param config the new config
+ * @param changed the top level keys which differ from the previous config
+ */
+export type ConfigCallback = (config: Config, changed: (keyof Config)[]) => any;
 
 @singleton()
 @registry([{
@@ -22,6 +26,7 @@ export class ConfigWatcher extends IService {
 
     private configFileWatcher: chokidarModule.FSWatcher | undefined;
     private configFileHash: string | undefined;
+    private config: Config | undefined;
 
     public constructor(
         loggerFactory: LoggerFactory,
@@ -39,9 +44,8 @@ export class ConfigWatcher extends IService {
             throw new Error(`Config missing or invalid`);
         }
 
-        this.configFileHash = crypto.createHash('md5')
-            .update(JSON.stringify(config))
-            .digest('hex');
+        this.configFileHash = this.hash(config);
+        this.config = config;
 
         this.configFileWatcher = this.chokidar.watch(
             cfgPath,
@@ -61,6 +65,21 @@ export class ConfigWatcher extends IService {
         return config;
     }
 
+    private hash(value: any): string {
+        return crypto.createHash('md5')
+            .update(JSON.stringify(value) ?? '')
+            .digest('hex');
+    }
+
+    /**
+     * @returns the top level keys which differ between both configs
+     */
+    public getChangedKeys(previous: Config, updated: Config): (keyof Config)[] {
+        const keys = new Set([...Object.keys(previous ?? {}), ...Object.keys(updated ?? {})]);
+        return [...keys]
+            .filter((key) => JSON.stringify(previous?.[key]) !== JSON.stringify(updated?.[key])) as (keyof Config)[];
+    }
+
     public checkForChange(cb: ConfigCallback): void {
         this.log.log(LogLevel.INFO, 'Detected config file change...');
 
@@ -70,16 +89,17 @@ export class ConfigWatcher extends IService {
             return;
         }
 
-        const newHash = crypto.createHash('md5')
-            .update(JSON.stringify(updatedConfig))
-            .digest('hex');
-
+        const newHash = this.hash(updatedConfig);
         if (newHash === this.configFileHash) {
             this.log.log(LogLevel.WARN, 'Skipping config reload because no changes were found');
             return;
         }
 
-        cb(updatedConfig);
+        const changed = this.getChangedKeys(this.config, updatedConfig);
+        this.configFileHash = newHash;
+        this.config = updatedConfig;
+
+        cb(updatedConfig, changed);
     }
 
     public async stopWatching(): Promise<void> {
@@ -87,6 +107,7 @@ export class ConfigWatcher extends IService {
             await this.configFileWatcher.close();
             this.configFileWatcher = undefined;
         }
+        this.config = undefined;
     }
 
 }
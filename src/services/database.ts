@@ -1,9 +1,30 @@
 import * as sqlite3 from 'better-sqlite3';
+import * as path from 'path';
 import { Manager } from '../control/manager';
 import { IStatefulService } from '../types/service';
 import { LogLevel } from '../util/logger';
 import { injectable, singleton } from 'tsyringe';
 import { LoggerFactory } from './loggerfactory';
+import { Paths } from './paths';
+import {
+    Histogram,
+    instanceLabels,
+    instrumentation,
+    InstrumentationLabels,
+    SQLITE_QUERY_DURATION,
+} from '../util/instrumentation';
+
+type QueryMethod = 'run' | 'first' | 'all' | 'allRaw' | 'transaction';
+const QUERY_METHODS: QueryMethod[] = ['run', 'first', 'all', 'allRaw', 'transaction'];
+
+// per method, so the queries do not need a lookup
+const queryDurations = (labels: InstrumentationLabels): Record<QueryMethod, Histogram> => {
+    const durations = {} as Record<QueryMethod, Histogram>;
+    for (const method of QUERY_METHODS) {
+        durations[method] = instrumentation.histogram(SQLITE_QUERY_DURATION, { ...labels, method });
+    }
+    return durations;
+};
 
 /* istanbul ignore next */
 export class Sqlite3Wrapper {
@@ -16,9 +37,27 @@ export class Sqlite3Wrapper {
     }
 
     private db: sqlite3.Database;
+    private durations: Record<QueryMethod, Histogram>;
 
-    public constructor(file: string, opts?: sqlite3.Options) {
+    /**
+     * @param file the database file
+     * @param opts the connection options
+     * @param labels the labels of the query duration series
+     */
+    public constructor(file: string, opts?: sqlite3.Options, labels: InstrumentationLabels = {}) {
         this.db = Sqlite3Wrapper.createDb(file, opts);
+        this.durations = queryDurations(labels);
+    }
+
+    /**
+     * @param labels the labels of the query duration series
+     * @returns a wrapper of the same connection, which records its queries with the given labels
+     */
+    public withLabels(labels: InstrumentationLabels): Sqlite3Wrapper {
+        const wrapper: Sqlite3Wrapper = Object.create(Sqlite3Wrapper.prototype);
+        wrapper.db = this.db;
+        wrapper.durations = queryDurations(labels);
+        return wrapper;
     }
 
     /**
@@ -27,8 +66,10 @@ export class Sqlite3Wrapper {
      * @param params the params
      */
     public run(sql: string, ...params: any[]): sqlite3.RunResult {
-        const stmt = this.db.prepare(sql);
-        return stmt.run(params);
+        return this.durations.run.time(() => {
+            const stmt = this.db.prepare(sql);
+            return stmt.run(params);
+        });
     }
 
     /**
@@ -37,8 +78,10 @@ export class Sqlite3Wrapper {
      * @param params the params
      */
     public first(sql: string, ...params: any[]): any {
-        const stmt = this.db.prepare(sql);
-        return stmt.get(params);
+        return this.durations.first.time(() => {
+            const stmt = this.db.prepare(sql);
+            return stmt.get(params);
+        });
     }
 
     /**
@@ -47,8 +90,10 @@ export class Sqlite3Wrapper {
      * @param params the params
      */
     public all(sql: string, ...params: any[]): any[] {
-        const stmt = this.db.prepare(sql);
-        return stmt.all(params);
+        return this.durations.all.time(() => {
+            const stmt = this.db.prepare(sql);
+            return stmt.all(params);
+        });
     }
 
     /**
@@ -57,8 +102,10 @@ export class Sqlite3Wrapper {
      * @param params the params
      */
     public allRaw(sql: string, ...params: any[]): any[] {
-        const stmt = this.db.prepare(sql);
-        return stmt.raw().all(params);
+        return this.durations.allRaw.time(() => {
+            const stmt = this.db.prepare(sql);
+            return stmt.raw().all(params);
+        });
     }
 
     /**
@@ -67,7 +114,7 @@ export class Sqlite3Wrapper {
      * @param params the params
      */
     public transaction(fn: (db: sqlite3.Database) => any): any[] {
-        return this.db.transaction(fn)(this.db);
+        return this.durations.transaction.time(() => this.db.transaction(fn)(this.db));
     }
 
     public close(): void {
@@ -79,18 +126,57 @@ export class Sqlite3Wrapper {
 // eslint-disable-next-line no-shadow
 export enum DatabaseTypes {
     METRICS,
+    ADM_EVENTS,
+    LOG_SEARCH,
 }
 
 interface DbConfig {
     file: string;
     opts: sqlite3.Options;
+    /** whether the file is shared by all server instances (and partitioned by its users) */
+    shared?: boolean;
+}
+
+/**
+ * Open database files of the process.
+ * Server instances using the same file share the connection, it is closed when the last one releases it.
+ */
+@singleton()
+export class DatabaseConnections {
+
+    private connections = new Map<string, { db: Sqlite3Wrapper; refs: number }>();
+
+    /**
+     * @param file the database file
+     * @param opts the connection options
+     * @param labels the labels of the query duration series of this user
+     * @returns the (possibly shared) connection
+     */
+    public acquire(file: string, opts: sqlite3.Options, labels: InstrumentationLabels = {}): Sqlite3Wrapper {
+        let connection = this.connections.get(file);
+        if (!connection) {
+            connection = { db: new Sqlite3Wrapper(file, opts, labels), refs: 0 };
+            this.connections.set(file, connection);
+        }
+        connection.refs++;
+        return connection.db.withLabels(labels);
+    }
+
+    public release(file: string): void {
+        const connection = this.connections.get(file);
+        if (connection && --connection.refs <= 0) {
+            connection.db.close();
+            this.connections.delete(file);
+        }
+    }
+
 }
 
 @singleton()
 @injectable()
 export class Database extends IStatefulService {
 
-    private databases = new Map<DatabaseTypes, Sqlite3Wrapper>();
+    private databases = new Map<DatabaseTypes, { db: Sqlite3Wrapper; file: string }>();
     private dbConfigs = new Map<DatabaseTypes, DbConfig>([
         [
             DatabaseTypes.METRICS,
@@ -99,6 +185,25 @@ export class Database extends IStatefulService {
                 opts: {
                     readonly: false,
                 },
+                shared: true,
+            },
+        ],
+        [
+            DatabaseTypes.ADM_EVENTS,
+            {
+                file: 'adm-events.db',
+                opts: {
+                    readonly: false,
+                },
+            },
+        ],
+        [
+            DatabaseTypes.LOG_SEARCH,
+            {
+                file: 'log-search.db',
+                opts: {
+                    readonly: false,
+                },
             },
         ],
     ]);
@@ -106,6 +211,8 @@ export class Database extends IStatefulService {
     public constructor(
         loggerFactory: LoggerFactory,
         public manager: Manager,
+        private paths: Paths,
+        private connections: DatabaseConnections,
     ) {
         super(loggerFactory.createLogger('Database'));
         this.log.log(LogLevel.INFO, `Database Setup: node ${process.versions.node} : v${process.versions.modules}-${process.platform}-${process.arch}`);
@@ -116,11 +223,9 @@ export class Database extends IStatefulService {
     }
 
     public async stop(): Promise<void> {
-        for (const db of this.databases.entries()) {
-            if (db[1]) {
-                db[1].close();
-            }
-            this.databases.delete(db[0]);
+        for (const [type, { file }] of this.databases.entries()) {
+            this.connections.release(file);
+            this.databases.delete(type);
         }
     }
 
@@ -135,16 +240,16 @@ export class Database extends IStatefulService {
                     },
                 };
 
-            this.databases.set(
-                type,
-                new Sqlite3Wrapper(
-                    dbConfig.file,
-                    dbConfig.opts,
-                ),
+            const file = path.join(
+                dbConfig.shared ? this.paths.sharedCwd() : this.paths.cwd(),
+                dbConfig.file,
             );
+            // shared files are queried by all instances, so the series are labeled by the querying one
+            const labels = instanceLabels(this.manager.instanceName, { db: DatabaseTypes[type]?.toLowerCase() ?? String(type) });
+            this.databases.set(type, { db: this.connections.acquire(file, dbConfig.opts, labels), file });
         }
 
-        return this.databases.get(type);
+        return this.databases.get(type).db;
 
     }
 
@@ -0,0 +1,367 @@
+import { IncomingMessage } from 'http';
+import { MessageEmbed } from 'discord.js';
+import { HTTPSAPI } from '../util/apis';
+import { Logger, LogLevel } from '../util/logger';
+import { request } from '../util/request';
+
+export const DISCORD_API_URL = 'https://discord.com/api/v9';
+
+/** limits of a single discord message */
+export const DISCORD_MAX_CONTENT_LENGTH = 2000;
+export const DISCORD_MAX_EMBEDS = 10;
+export const DISCORD_MAX_EMBED_LENGTH = 6000;
+
+export interface DiscordPayload {
+    content?: string;
+    embeds?: (MessageEmbed | Record<string, any>)[];
+}
+
+export interface DiscordSendResult {
+    /** http status of the response */
+    status: number;
+    /** requests left in the current rate limit window */
+    remaining?: number;
+    /** ms until the rate limit window resets */
+    resetAfter?: number;
+    /** ms to wait before retrying, if the request was rate limited (429) */
+    retryAfter?: number;
+    /** whether the rate limit applies to all channels */
+    global?: boolean;
+}
+
+export type DiscordTransport = (channelId: string, payload: DiscordPayload) => Promise<DiscordSendResult>;
+
+export interface DiscordDispatchOptions {
+    /** ms messages are collected before they are sent as one discord message */
+    batchInterval: number;
+    /** max queued messages per channel, older messages are collapsed into a summary above */
+    maxQueueSize: number;
+}
+
+export interface DiscordChannelStats {
+    channelId: string;
+    /** messages waiting to be sent */
+    queued: number;
+    /** messages sent */
+    sent: number;
+    /** discord messages (requests) the sent messages were combined into */
+    requests: number;
+    /** messages that were only counted in a summary because the queue was full */
+    collapsed: number;
+    /** messages dropped because discord rejected them */
+    failed: number;
+    /** responses with status 429 */
+    rateLimited: number;
+    /** ms the last sent message waited in the queue */
+    lastDelay: number;
+    avgDelay: number;
+    maxDelay: number;
+}
+
+export const DEFAULT_DISCORD_DISPATCH_OPTIONS: DiscordDispatchOptions = {
+    batchInterval: 500,
+    maxQueueSize: 50,
+};
+
+interface QueuedMessage {
+    payload: DiscordPayload;
+    queuedAt: number;
+}
+
+interface ChannelQueue {
+    messages: QueuedMessage[];
+    /** messages dropped from the queue which were not yet reported in a summary */
+    collapsed: number;
+    blockedUntil: number;
+    sending: boolean;
+    timer?: any;
+    stats: DiscordChannelStats;
+    totalDelay: number;
+}
+
+/**
+ * Approximation of the characters discord counts towards the embed limit
+ */
+export const embedLength = (embed: MessageEmbed | Record<string, any>): number => {
+    let length = (embed.title?.length ?? 0)
+        + (embed.description?.length ?? 0)
+        + (embed.footer?.text?.length ?? 0)
+        + (embed.author?.name?.length ?? 0);
+    for (const field of embed.fields ?? []) {
+        length += (field.name?.length ?? 0) + (field.value?.length ?? 0);
+    }
+    return length;
+};
+
+const header = (res: IncomingMessage, name: string): number | undefined => {
+    const value = Number(res.headers[name]);
+    return Number.isFinite(value) && res.headers[name] !== undefined ? value : undefined;
+};
+
+/**
+ * Sends messages with the discord REST api and reports the rate limit headers of the responses
+ */
+export const createDiscordRestTransport = (
+    https: HTTPSAPI,
+    token: string,
+    apiUrl: string = DISCORD_API_URL,
+): DiscordTransport => async (channelId: string, payload: DiscordPayload) => {
+    const res = await request(
+        https,
+        `${apiUrl}/channels/${channelId}/messages`,
+        {
+            method: 'POST',
+            headers: {
+                'Authorization': `Bot ${token}`,
+                'Content-Type': 'application/json',
+            },
+            body: JSON.stringify(payload),
+        },
+    );
+
+    const resetAfter = header(res, 'x-ratelimit-reset-after');
+    const result: DiscordSendResult = {
+        status: res.statusCode,
+        remaining: header(res, 'x-ratelimit-remaining'),
+        resetAfter: resetAfter === undefined ? undefined : resetAfter * 1000,
+    };
+    if (res.statusCode === 429) {
+        let body: any;
+        try {
+            body = JSON.parse(res.body);
+        } catch (e) {
+            body = {};
+        }
+        const retryAfter = body.retry_after ?? header(res, 'retry-after');
+        result.retryAfter = (retryAfter ?? 1) * 1000;
+        result.global = !!body.global || res.headers['x-ratelimit-global'] === 'true';
+    }
+    return result;
+};
+
+/**
+ * Outbound discord messages, queued per channel.
+ *
+ * Messages that pile up are combined into as few discord messages as the limits allow.
+ * The rate limit headers of the responses are honored, so the queue waits for the reset instead of running into a 429.
+ * If a channel still falls behind, the oldest messages are collapsed into a summary line.
+ */
+export class DiscordDispatchQueue {
+
+    private channels = new Map<string, ChannelQueue>();
+    private transport?: DiscordTransport;
+    private globalBlockedUntil = 0;
+
+    public constructor(
+        private log: Logger,
+        public options: DiscordDispatchOptions = DEFAULT_DISCORD_DISPATCH_OPTIONS,
+    ) {}
+
+    /**
+     * Starts sending, messages pushed before are kept until then
+     */
+    public start(transport: DiscordTransport): void {
+        this.transport = transport;
+        for (const channelId of this.channels.keys()) {
+            this.schedule(channelId);
+        }
+    }
+
+    /**
+     * Stops sending, queued messages are kept
+     */
+    public stop(): void {
+        this.transport = undefined;
+        for (const queue of this.channels.values()) {
+            clearTimeout(queue.timer);
+            queue.timer = undefined;
+        }
+    }
+
+    public push(channelId: string, payload: DiscordPayload): void {
+        const queue = this.getQueue(channelId);
+        queue.messages.push({ payload, queuedAt: Date.now() });
+        this.collapseOverflow(queue);
+        this.schedule(channelId);
+    }
+
+    private collapseOverflow(queue: ChannelQueue): void {
+        if (queue.messages.length > this.options.maxQueueSize) {
+            const excess = queue.messages.length - this.options.maxQueueSize;
+            queue.messages.splice(0, excess);
+            queue.collapsed += excess;
+            queue.stats.collapsed += excess;
+        }
+    }
+
+    private getQueue(channelId: string): ChannelQueue {
+        let queue = this.channels.get(channelId);
+        if (!queue) {
+            queue = {
+                messages: [],
+                collapsed: 0,
+                blockedUntil: 0,
+                sending: false,
+                stats: {
+                    channelId,
+                    queued: 0,
+                    sent: 0,
+                    requests: 0,
+                    collapsed: 0,
+                    failed: 0,
+                    rateLimited: 0,
+                    lastDelay: 0,
+                    avgDelay: 0,
+                    maxDelay: 0,
+                },
+                totalDelay: 0,
+            };
+            this.channels.set(channelId, queue);
+        }
+        return queue;
+    }
+
+    private schedule(channelId: string, minDelay: number = this.options.batchInterval): void {
+        const queue = this.channels.get(channelId);
+        if (!this.transport || queue.timer || queue.sending || (!queue.messages.length && !queue.collapsed)) {
+            return;
+        }
+        const blockedFor = Math.max(queue.blockedUntil, this.globalBlockedUntil) - Date.now();
+        queue.timer = setTimeout(() => {
+            queue.timer = undefined;
+            void this.flush(channelId);
+        }, Math.max(minDelay, blockedFor));
+    }
+
+    /**
+     * Takes as many queued messages as fit into one discord message
+     */
+    private takeBatch(queue: ChannelQueue): { batch: QueuedMessage[]; payload: DiscordPayload } {
+        const lines: string[] = [];
+        let contentLength = 0;
+        const embeds: DiscordPayload['embeds'] = [];
+        let embedsLength = 0;
+
+        if (queue.collapsed) {
+            const summary = `*${queue.collapsed} older message(s) were skipped, because discord could not keep up*`;
+            lines.push(summary);
+            contentLength += summary.length;
+        }
+
+        let taken = 0;
+        for (const message of queue.messages) {
+            const content = message.payload.content;
+            const addedContent = content ? content.length + (lines.length ? 1 : 0) : 0;
+            const messageEmbeds = message.payload.embeds ?? [];
+            const addedEmbeds = messageEmbeds.reduce((sum, x) => sum + embedLength(x), 0);
+
+            const fits = contentLength + addedContent <= DISCORD_MAX_CONTENT_LENGTH
+                && embeds.length + messageEmbeds.length <= DISCORD_MAX_EMBEDS
+                && embedsLength + addedEmbeds <= DISCORD_MAX_EMBED_LENGTH;
+            // a single message that is too large is sent as is and rejected by discord
+            if (!fits && (taken || lines.length)) {
+                break;
+            }
+
+            if (content) {
+                lines.push(content);
+                contentLength += addedContent;
+            }
+            embeds.push(...messageEmbeds);
+            embedsLength += addedEmbeds;
+            taken++;
+        }
+
+        const payload: DiscordPayload = {};
+        if (lines.length) {
+            payload.content = lines.join('\n');
+        }
+        if (embeds.length) {
+            payload.embeds = embeds;
+        }
+        return { batch: queue.messages.slice(0, taken), payload };
+    }
+
+    public async flush(channelId: string): Promise<void> {
+        const queue = this.channels.get(channelId);
+        const transport = this.transport;
+        if (!queue || !transport || queue.sending) {
+            return;
+        }
+        // a limit might have been hit by another channel since this flush was scheduled
+        if (Math.max(queue.blockedUntil, this.globalBlockedUntil) > Date.now()) {
+            this.schedule(channelId, 0);
+            return;
+        }
+
+        const { batch, payload } = this.takeBatch(queue);
+        if (!batch.length && !payload.content) {
+            return;
+        }
+        const collapsed = queue.collapsed;
+        queue.messages.splice(0, batch.length);
+        queue.collapsed = 0;
+        queue.sending = true;
+
+        try {
+            const result = await transport(channelId, payload);
+            const now = Date.now();
+
+            if (result.status === 429) {
+                queue.stats.rateLimited++;
+                const blockedUntil = now + result.retryAfter;
+                if (result.global) {
+                    this.globalBlockedUntil = blockedUntil;
+                } else {
+                    queue.blockedUntil = blockedUntil;
+                }
+                this.log.log(LogLevel.WARN, `Discord rate limit hit for channel ${channelId}, retrying in ${result.retryAfter}ms`);
+                this.requeue(queue, batch, collapsed);
+            } else {
+                if (result.remaining === 0 && result.resetAfter) {
+                    queue.blockedUntil = now + result.resetAfter;
+                }
+                if (result.status >= 200 && result.status < 300) {
+                    this.recordSent(queue, batch, now);
+                } else {
+                    queue.stats.failed += batch.length;
+                    this.log.log(LogLevel.ERROR, `Discord rejected message for channel ${channelId} with status ${result.status}`);
+                }
+            }
+        } catch (e) {
+            queue.stats.failed += batch.length;
+            this.log.log(LogLevel.ERROR, `Failed to send discord message to channel ${channelId}`, e);
+        } finally {
+            queue.sending = false;
+        }
+
+        this.schedule(channelId, 0);
+    }
+
+    private requeue(queue: ChannelQueue, batch: QueuedMessage[], collapsed: number): void {
+        queue.messages.unshift(...batch);
+        queue.collapsed += collapsed;
+        this.collapseOverflow(queue);
+    }
+
+    private recordSent(queue: ChannelQueue, batch: QueuedMessage[], now: number): void {
+        const stats = queue.stats;
+        stats.requests++;
+        for (const message of batch) {
+            const delay = now - message.queuedAt;
+            stats.sent++;
+            queue.totalDelay += delay;
+            stats.lastDelay = delay;
+            stats.maxDelay = Math.max(stats.maxDelay, delay);
+        }
+        stats.avgDelay = stats.sent ? Math.round(queue.totalDelay / stats.sent) : 0;
+    }
+
+    public getStats(): DiscordChannelStats[] {
+        return [...this.channels.values()].map((queue) => ({
+            ...queue.stats,
+            queued: queue.messages.length,
+        }));
+    }
+
+}
@@ -1,28 +1,38 @@
 import {
-    TextChannel,
     Client,
     Message,
-    MessageEmbed,
     Intents   
 } from 'discord.js';
 import { DiscordMessageHandler } from '../interface/discord-message-handler';
 import { IStatefulService } from '../types/service';
 import { LogLevel } from '../util/logger';
 import { Manager } from '../control/manager';
-import { injectable, singleton } from 'tsyringe';
+import { inject, injectable, singleton } from 'tsyringe';
 import { LoggerFactory } from './loggerfactory';
 import { EventBus } from '../control/event-bus';
 import { InternalEventTypes } from '../types/events';
 import { DiscordMessage } from '../types/discord';
+import { Config } from '../config/config';
+import { HTTPSAPI, InjectionTokens } from '../util/apis';
+import {
+    createDiscordRestTransport,
+    DISCORD_API_URL,
+    DiscordChannelStats,
+    DiscordDispatchQueue,
+    DiscordPayload,
+} from './discord-dispatch';
 
 @singleton()
 @injectable()
 export class DiscordBot extends IStatefulService {
 
+    public readonly configKeys: (keyof Config)[] = ['discordBotToken'];
+
     public client: Client | undefined;
-    private ready = false;
 
-    private msgQueue: DiscordMessage[] = [];
+    /** messages are sent with the REST api through this queue, it holds them until the bot is logged in */
+    public readonly dispatchQueue: DiscordDispatchQueue;
+    public apiUrl: string = DISCORD_API_URL;
 
     public debug: boolean = true;
 
@@ -31,9 +41,12 @@ export class DiscordBot extends IStatefulService {
         private manager: Manager,
         private messageHandler: DiscordMessageHandler,
         private eventBus: EventBus,
+        @inject(InjectionTokens.https) private https: HTTPSAPI,
     ) {
         super(loggerFactory.createLogger('Discord'));
 
+        this.dispatchQueue = new DiscordDispatchQueue(this.log);
+
         this.eventBus.on(
             InternalEventTypes.DISCORD_MESSAGE,
             /* istanbul ignore next */ (message: DiscordMessage) => this.sendMessage(message),
@@ -78,7 +91,9 @@ export class DiscordBot extends IStatefulService {
             this.log.log(LogLevel.IMPORTANT, `Starting login discord bot with token: ${this.manager.config.discordBotToken}`);
             await client.login(this.manager.config.discordBotToken);
             this.client = client;
-            this.sendQueuedMessage();
+            this.dispatchQueue.start(
+                createDiscordRestTransport(this.https, this.manager.config.discordBotToken, this.apiUrl),
+            );
         } catch (e) {
             this.log.log(LogLevel.WARN, 'Not starting discord bot, login failed', e);
         }
@@ -86,18 +101,6 @@ export class DiscordBot extends IStatefulService {
 
     private onReady(): void {
         this.log.log(LogLevel.IMPORTANT, 'Discord Ready!');
-        this.ready = true;
-        this.sendQueuedMessage();
-    }
-
-    private sendQueuedMessage(): void {
-        setTimeout(() => {
-            const msgQueue = this.msgQueue;
-            this.msgQueue = [];
-            for (const msg of msgQueue) {
-                this.sendMessage(msg);
-            }
-        }, 1000);
     }
 
     private onMessage(message: Message) : void {
@@ -116,43 +119,55 @@ export class DiscordBot extends IStatefulService {
     }
 
     public async stop(): Promise<void> {
-        this.ready = false;
+        this.dispatchQueue.stop();
         if (this.client) {
             await this.client.destroy();
             this.client = undefined;
         }
     }
 
-    public async sendMessage(message: DiscordMessage): Promise<void> {
+    private getChannelId(message: DiscordMessage): string | undefined {
+        if (message.channelID) {
+            return message.channelID;
+        }
+        switch (message.type) {
+            case 'notification':
+                return this.manager.config.channelNoti;
+            case 'admin':
+                return this.manager.config.channelAdmin;
+            case 'rcon':
+                return this.manager.config.channelRCON;
+            default:
+                return undefined;
+        }
+    }
 
-        if (!this.client || !this.ready) {
-            this.log.log(LogLevel.WARN, `Queueing message because client did not start or is not yet ready`, this.ready);
-            this.msgQueue.push(message);
+    /**
+     * Queues the message for its channel, it is sent (possibly combined with others) by the dispatch queue
+     */
+    public async sendMessage(message: DiscordMessage): Promise<void> {
+        const channelId = this.getChannelId(message);
+        if (!channelId) {
+            this.log.log(LogLevel.DEBUG, `No channel configured for discord message of type ${message.type}`);
             return;
         }
 
-        let TargetChannel;
-
-        if(message.type.toString() === 'notification'){
-            TargetChannel = this.client.channels.cache.get(`${this.manager.config.channelNoti}`) as TextChannel;
-        }else if(message.type.toString() === 'admin'){
-            TargetChannel = this.client.channels.cache.get(`${this.manager.config.channelAdmin}`) as TextChannel;
-        }else if(message.type.toString() === 'rcon'){
-            TargetChannel = this.client.channels.cache.get(`${this.manager.config.channelRCON}`) as TextChannel;
+        const payload: DiscordPayload = {};
+        if (message.embed) {
+            payload.embeds = [message.embed];
+        } else if (message.embeds?.length) {
+            payload.embeds = message.embeds;
+        } else if (message.message) {
+            payload.content = message.message;
+        } else {
+            return;
         }
 
+        this.dispatchQueue.push(channelId, payload);
+    }
 
-        if(message.embed != undefined) {
-            this.log.log(LogLevel.IMPORTANT, `embed : ${JSON.stringify(message.embed)}`);
-            TargetChannel?.send({embed:message.embed})
-        } else if(message.embeds != undefined) {
-            this.log.log(LogLevel.IMPORTANT, `embeds : ${JSON.stringify(message.embeds)}`);
-            TargetChannel?.send({embeds:message.embeds})
-        } else if(message.message != '' && message.message != undefined){
-            this.log.log(LogLevel.IMPORTANT, `message : ${message.message}`);
-            TargetChannel?.send(`${message.message}`);
-            //TargetChannel?.send({content: message.message});
-        }
+    public getDispatchStats(): DiscordChannelStats[] {
+        return this.dispatchQueue.getStats();
     }
 
 }
@@ -0,0 +1,377 @@
+import { inject, injectable, singleton } from 'tsyringe';
+import { Manager } from '../control/manager';
+import { HookTypeEnum } from '../config/config';
+import { EconomyElement, EconomyFileStats, EconomyPatch } from '../types/economy';
+import { IStatefulService } from '../types/service';
+import { FSAPI, InjectionTokens } from '../util/apis';
+import {
+    EconomyXmlDocument,
+    EconomyXmlSegment,
+    joinEconomyXml,
+    parseEconomyElement,
+    patchEconomyElement,
+    serializeEconomyElement,
+    splitEconomyXml,
+} from '../util/economy-xml';
+import { LogLevel } from '../util/logger';
+import { Backups } from './backups';
+import { Hooks } from './hooks';
+import { LoggerFactory } from './loggerfactory';
+import { MissionFiles } from './mission-files';
+
+/** files are written at the latest after this many times the write delay */
+const MAX_WRITE_DELAY_FACTOR = 5;
+
+type EconomyEdit = (file: LoadedEconomyFile) => any;
+
+interface LoadedEconomyFile {
+    file: string;
+    path: string;
+    doc: EconomyXmlDocument;
+    index: Map<string, EconomyXmlSegment>;
+    duplicates: number;
+    mtime: number;
+    size: number;
+    /** edits which are not written yet, they are applied again if the file was changed on disk */
+    edits: EconomyEdit[];
+    dirtySince?: number;
+    createBackup: boolean;
+    lastWrite?: number;
+    /** the file is being written, changes on disk are our own */
+    writing?: boolean;
+}
+
+const clone = <T>(x: T): T => JSON.parse(JSON.stringify(x));
+
+/**
+ * Indexed model of the central economy files (types.xml, cfgspawnabletypes.xml, events.xml, ...).
+ *
+ * The files are split into their top level entries, which are indexed by their name and only parsed when needed.
+ * Edits only re-serialize the edited entry and are written to disk debounced,
+ * so many small edits of the same file result in a single write.
+ */
+@singleton()
+@injectable()
+export class EconomyStore extends IStatefulService {
+
+    private files = new Map<string, LoadedEconomyFile>();
+    private loading = new Map<string, Promise<LoadedEconomyFile>>();
+    private writing = new Map<string, Promise<void>>();
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private manager: Manager,
+        private missionFiles: MissionFiles,
+        private backup: Backups,
+        private hooks: Hooks,
+        @inject(InjectionTokens.fs) private fs: FSAPI,
+    ) {
+        super(loggerFactory.createLogger('EconomyStore'));
+    }
+
+    public async start(): Promise<void> {
+        // files are loaded on first use
+    }
+
+    public async stop(): Promise<void> {
+        this.timers.removeAllTimers();
+        try {
+            await this.flush();
+        } finally {
+            this.files.clear();
+        }
+    }
+
+    private async getPath(file: string): Promise<string> {
+        const filePath = await this.missionFiles.getMissionPath(file);
+        if (!filePath) {
+            throw new Error(`Invalid file: ${file}`);
+        }
+        return filePath;
+    }
+
+    private reindex(loaded: LoadedEconomyFile): void {
+        loaded.index = new Map();
+        loaded.duplicates = 0;
+        for (const segment of loaded.doc.segments) {
+            if (!segment.name) {
+                continue;
+            }
+            if (loaded.index.has(segment.name)) {
+                loaded.duplicates++;
+            }
+            loaded.index.set(segment.name, segment);
+        }
+    }
+
+    private async refresh(file: string, filePath: string): Promise<LoadedEconomyFile> {
+        const loaded = this.files.get(filePath);
+        if (loaded?.writing) {
+            return loaded;
+        }
+        const stat = await this.fs.promises.stat(filePath);
+        if (loaded && loaded.mtime === stat.mtimeMs && loaded.size === stat.size) {
+            return loaded;
+        }
+
+        const content = String(await this.fs.promises.readFile(filePath, { encoding: 'utf-8' }));
+        const fresh: LoadedEconomyFile = {
+            file,
+            path: filePath,
+            doc: splitEconomyXml(content),
+            index: new Map(),
+            duplicates: 0,
+            mtime: stat.mtimeMs,
+            size: stat.size,
+            edits: loaded?.edits ?? [],
+            dirtySince: loaded?.dirtySince,
+            createBackup: loaded?.createBackup ?? false,
+            lastWrite: loaded?.lastWrite,
+        };
+        this.reindex(fresh);
+
+        if (loaded) {
+            this.log.log(LogLevel.INFO, `${file} was changed on disk, reloading it`);
+            fresh.edits = fresh.edits.filter((edit) => {
+                try {
+                    edit(fresh);
+                    return true;
+                } catch (e) {
+                    this.log.log(LogLevel.WARN, `Dropped an edit of ${file} which does not apply to the changed file: ${e?.message}`);
+                    return false;
+                }
+            });
+        } else {
+            this.log.log(LogLevel.DEBUG, `Loaded ${fresh.index.size} entries of ${file}`);
+        }
+
+        this.files.set(filePath, fresh);
+        return fresh;
+    }
+
+    private async getFile(file: string): Promise<LoadedEconomyFile> {
+        const filePath = await this.getPath(file);
+        const pending = this.loading.get(filePath);
+        if (pending) {
+            return pending;
+        }
+        const loading = this.refresh(file, filePath)
+            .finally(() => this.loading.delete(filePath));
+        this.loading.set(filePath, loading);
+        return loading;
+    }
+
+    private getEntrySegment(loaded: LoadedEconomyFile, name: string): EconomyXmlSegment {
+        const segment = loaded.index.get(name);
+        if (!segment) {
+            throw new Error(`${name} not found in ${loaded.file}`);
+        }
+        return segment;
+    }
+
+    private parseSegment(segment: EconomyXmlSegment): EconomyElement {
+        if (!segment.element) {
+            segment.element = parseEconomyElement(segment.raw);
+        }
+        return segment.element;
+    }
+
+    /**
+     * Replaces the raw entry, using the indentation and line endings of the file
+     */
+    private setSegmentElement(loaded: LoadedEconomyFile, segment: EconomyXmlSegment, element: EconomyElement): void {
+        const indent = /[ \t]*$/.exec(segment.before)[0];
+        const sample = [segment, ...loaded.doc.segments].find((x) => x.raw.includes('\n'))?.raw || '';
+        const childIndent = /\n([ \t]*)</.exec(sample)?.[1];
+        const unit = childIndent?.startsWith(indent) && childIndent.length > indent.length
+            ? childIndent.slice(indent.length)
+            : '    ';
+        const newline = `${sample}${loaded.doc.head}`.includes('\r\n') ? '\r\n' : '\n';
+
+        segment.raw = serializeEconomyElement(element, indent, unit, newline);
+        segment.element = element;
+    }
+
+    private async edit<T>(file: string, createBackup: boolean | undefined, edit: (loaded: LoadedEconomyFile) => T): Promise<T> {
+        const loaded = await this.getFile(file);
+        const result = edit(loaded);
+        loaded.edits.push(edit);
+        loaded.createBackup = loaded.createBackup || !!createBackup;
+        loaded.dirtySince = loaded.dirtySince ?? Date.now();
+        this.scheduleWrite(loaded);
+        return result;
+    }
+
+    private scheduleWrite(loaded: LoadedEconomyFile): void {
+        const timer = `write-${loaded.path}`;
+        const delay = this.manager.config?.economyWriteDelay ?? 1000;
+        const maxWait = loaded.dirtySince + (delay * MAX_WRITE_DELAY_FACTOR) - Date.now();
+        this.timers.removeTimer(timer);
+        this.timers.addTimeout(
+            timer,
+            () => this.write(loaded.path).catch((e) => {
+                this.log.log(LogLevel.ERROR, `Failed to write ${loaded.file}`, e);
+            }),
+            Math.max(0, Math.min(delay, maxWait)),
+        );
+    }
+
+    /**
+     * Writes are queued per file, so they never overlap
+     */
+    private write(filePath: string): Promise<void> {
+        const previous = this.writing.get(filePath) ?? Promise.resolve();
+        const next = previous
+            .catch(/* istanbul ignore next */ () => undefined)
+            .then(() => this.writeNow(filePath));
+        this.writing.set(filePath, next);
+        return next;
+    }
+
+    private async writeNow(filePath: string): Promise<void> {
+        this.timers.removeTimer(`write-${filePath}`);
+        if (!this.files.get(filePath)?.edits.length) {
+            return;
+        }
+        // picks up changes on disk, the pending edits are applied to them
+        const loaded = await this.getFile(this.files.get(filePath).file);
+
+        const { edits, createBackup } = loaded;
+        loaded.edits = [];
+        loaded.createBackup = false;
+        loaded.dirtySince = undefined;
+        loaded.writing = true;
+        try {
+            if (createBackup) {
+                await this.backup.createBackup();
+            }
+            const tmp = `${filePath}.tmp`;
+            await this.fs.promises.writeFile(tmp, joinEconomyXml(loaded.doc));
+            await this.fs.promises.rename(tmp, filePath);
+            const stat = await this.fs.promises.stat(filePath);
+            loaded.mtime = stat.mtimeMs;
+            loaded.size = stat.size;
+            loaded.lastWrite = Date.now();
+        } catch (e) {
+            loaded.edits = [...edits, ...loaded.edits];
+            loaded.createBackup = loaded.createBackup || createBackup;
+            loaded.dirtySince = loaded.dirtySince ?? Date.now();
+            throw e;
+        } finally {
+            loaded.writing = false;
+        }
+
+        this.log.log(LogLevel.INFO, `Wrote ${edits.length} edit(s) to ${loaded.file}`);
+        await this.hooks.executeHooks(HookTypeEnum.missionChanged);
+    }
+
+    /**
+     * Writes pending edits immediately
+     * @param file the file, all files if omitted
+     */
+    public async flush(file?: string): Promise<void> {
+        if (file) {
+            const filePath = await this.getPath(file);
+            if (this.files.has(filePath)) {
+                await this.write(filePath);
+            }
+            return;
+        }
+        for (const filePath of [...this.files.keys()]) {
+            await this.write(filePath);
+        }
+    }
+
+    /**
+     * @returns the names of all entries of the file
+     */
+    public async listEntries(file: string): Promise<string[]> {
+        return [...(await this.getFile(file)).index.keys()];
+    }
+
+    public async getEntry(file: string, name: string): Promise<EconomyElement | undefined> {
+        const segment = (await this.getFile(file)).index.get(name);
+        return segment ? clone(this.parseSegment(segment)) : undefined;
+    }
+
+    public async getEntries(file: string, names: string[]): Promise<Record<string, EconomyElement>> {
+        const loaded = await this.getFile(file);
+        const entries: Record<string, EconomyElement> = {};
+        for (const name of names) {
+            const segment = loaded.index.get(name);
+            if (segment) {
+                entries[name] = clone(this.parseSegment(segment));
+            }
+        }
+        return entries;
+    }
+
+    /**
+     * Replaces an entry or adds it at the end of the file
+     */
+    public async updateEntry(file: string, name: string, entry: EconomyElement, createBackup?: boolean): Promise<EconomyElement> {
+        const update = clone(entry);
+        return this.edit(file, createBackup, (loaded) => {
+            const first = loaded.doc.segments[0];
+            let segment = loaded.index.get(name);
+            if (!segment) {
+                const last = loaded.doc.segments[loaded.doc.segments.length - 1];
+                segment = {
+                    name,
+                    before: /\r?\n[ \t]*$/.exec(last?.before ?? '')?.[0] ?? '\n    ',
+                    raw: '',
+                };
+                loaded.doc.segments.push(segment);
+                loaded.index.set(name, segment);
+            }
+            const element: EconomyElement = {
+                tag: update.tag || /^<\s*([^\s/>]+)/.exec(segment.raw || first?.raw || '')?.[1] || 'type',
+                attributes: { ...update.attributes, name },
+                children: update.children ?? [],
+                text: update.text,
+            };
+            this.setSegmentElement(loaded, segment, element);
+            return clone(element);
+        });
+    }
+
+    /**
+     * Edits single values of an entry
+     * @see EconomyPatch
+     */
+    public async patchEntry(file: string, name: string, patch: EconomyPatch, createBackup?: boolean): Promise<EconomyElement> {
+        return this.edit(file, createBackup, (loaded) => {
+            const segment = this.getEntrySegment(loaded, name);
+            const element = clone(this.parseSegment(segment));
+            patchEconomyElement(element, patch);
+            this.setSegmentElement(loaded, segment, element);
+            return clone(element);
+        });
+    }
+
+    /**
+     * @returns whether the entry existed
+     */
+    public async deleteEntry(file: string, name: string, createBackup?: boolean): Promise<boolean> {
+        if (!(await this.getFile(file)).index.has(name)) {
+            return false;
+        }
+        return this.edit(file, createBackup, (loaded) => {
+            const segment = this.getEntrySegment(loaded, name);
+            loaded.doc.segments.splice(loaded.doc.segments.indexOf(segment), 1);
+            this.reindex(loaded);
+            return true;
+        });
+    }
+
+    public getStats(): EconomyFileStats[] {
+        return [...this.files.values()].map((x) => ({
+            file: x.file,
+            entries: x.index.size,
+            duplicates: x.duplicates,
+            pendingEdits: x.edits.length,
+            lastWrite: x.lastWrite,
+        }));
+    }
+
+}
@@ -11,12 +11,15 @@ import { Backups } from './backups';
 import { EventBus } from '../control/event-bus';
 import { InternalEventTypes } from '../types/events';
 import { ServerDetector } from './server-detector';
+import { Config } from '../config/config';
 
 
 @singleton()
 @injectable()
 export class Events extends IStatefulService {
 
+    public readonly configKeys: (keyof Config)[] = ['events'];
+
     public tasks: cron.Job[] = [];
 
     public constructor(
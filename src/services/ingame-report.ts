@@ -11,6 +11,7 @@ import { Metrics } from './metrics';
 import { FSAPI, InjectionTokens } from '../util/apis';
 import { EventBus } from '../control/event-bus';
 import { InternalEventTypes } from '../types/events';
+import { Histogram, instanceLabels, instrumentation, TIMER_CALLBACK_DURATION } from '../util/instrumentation';
 
 @singleton()
 @injectable()
@@ -26,6 +27,7 @@ export class IngameReport extends IStatefulService {
     public intervalTimeout: number = 1000;
     public readTimeout: number = 1000;
     private lastTickTimestamp: number = 0;
+    private scanTickDuration: Histogram;
     private tickFilePath: string;
 
     public constructor(
@@ -55,8 +57,12 @@ export class IngameReport extends IStatefulService {
             this.TICK_FILE,
         );
 
+        this.scanTickDuration = instrumentation.histogram(
+            TIMER_CALLBACK_DURATION,
+            instanceLabels(this.manager.instanceName, { service: 'IngameReport', timer: 'scanTick' }),
+        );
         this.timers.addInterval('scanTick', () => {
-            void this.scanTick();
+            void this.scanTickDuration.time(() => this.scanTick());
         }, this.intervalTimeout);
     }
 
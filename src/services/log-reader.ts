@@ -3,20 +3,22 @@ import { Manager } from '../control/manager';
 import { IStatefulService } from '../types/service';
 import { LogLevel } from '../util/logger';
 import * as path from 'path';
-import * as tail from 'tail';
 import { ServerState } from '../types/monitor';
-import { FileDescriptor, LogMessage, LogType, LogTypeEnum } from '../types/log-reader';
-import { reverseIndexSearch } from '../util/reverse-index-search';
+import { FileDescriptor, LogEntryEvent, LogMessage, LogType, LogTypeEnum, TailPosition } from '../types/log-reader';
+import { LogStore } from '../util/log-store';
+import { FileTailer } from '../util/file-tailer';
 import { inject, injectable, singleton } from 'tsyringe';
 import { LoggerFactory } from './loggerfactory';
 import { FSAPI, InjectionTokens } from '../util/apis';
 import { EventBus } from '../control/event-bus';
 import { InternalEventTypes } from '../types/events';
+import { Paths } from './paths';
+import { Config } from '../config/config';
 
 export interface LogContainer {
     logFiles?: FileDescriptor[];
-    logLines?: LogMessage[];
-    tail?: tail.Tail;
+    store?: LogStore;
+    tail?: FileTailer;
     filter: (file: string) => boolean;
 }
 
@@ -42,17 +44,39 @@ export class LogReader extends IStatefulService {
     };
     /* eslint-enable @typescript-eslint/naming-convention */
 
+    public readonly configKeys: (keyof Config)[] = ['logBufferSize'];
+
     public initDelay = 5000;
+    /** relative to the working dir of the instance */
+    public storePath = 'log-store';
+    public offsetsPath = 'log-offsets.json';
+    public offsetSaveInterval = 5000;
+
+    private offsets: { [Property in LogType]?: TailPosition } | undefined;
+    private offsetsDirty = false;
 
     public constructor(
         loggerFactory: LoggerFactory,
         private manager: Manager,
         private eventBus: EventBus,
+        private paths: Paths,
         @inject(InjectionTokens.fs) private fs: FSAPI,
     ) {
         super(loggerFactory.createLogger('LogReader'));
     }
 
+    private resolvePath(file: string): string {
+        return this.paths.isAbsolute(file) ? file : path.join(this.paths.cwd(), file);
+    }
+
+    public getStorePath(): string {
+        return this.resolvePath(this.storePath);
+    }
+
+    public getOffsetsPath(): string {
+        return this.resolvePath(this.offsetsPath);
+    }
+
     public async start(): Promise<void> {
         this.eventBus.on(InternalEventTypes.MONITOR_STATE_CHANGE, async (x) => {
             if (x === ServerState.STARTED) {
@@ -64,15 +88,95 @@ export class LogReader extends IStatefulService {
     }
 
     public async stop(): Promise<void> {
+        this.timers.removeAllTimers();
         for (const type of Object.keys(LogTypeEnum)) {
             const container = this.logMap[type as LogType];
-            const t = container?.tail;
-            if (t) {
-                t.unwatch();
-            }
+            container?.tail?.stop();
+            container.tail = undefined;
             container.logFiles = [];
-            container.logLines = [];
+            container.store?.clear();
+        }
+        this.saveOffsets();
+    }
+
+    /**
+     * The stores are sized when they are created, so a new buffer size replaces them.
+     * The followed files are registered again, which refills the new stores up to the saved offsets
+     * without emitting the lines again.
+     * @param changed the changed config keys
+     */
+    public async applyConfig(changed: (keyof Config)[]): Promise<void> {
+        if (!changed.some((x) => this.configKeys.includes(x))) {
+            return;
+        }
+        const following = this.getActiveFiles().length > 0;
+        for (const type of Object.keys(LogTypeEnum)) {
+            const container = this.logMap[type as LogType];
+            container.tail?.stop();
+            container.tail = undefined;
+            container.store?.clear();
+            container.store = undefined;
+        }
+        if (following) {
+            await this.registerReaders();
+        }
+    }
+
+    private loadOffsets(): { [Property in LogType]?: TailPosition } {
+        if (!this.offsets) {
+            this.offsets = {};
+            try {
+                const offsetsPath = this.getOffsetsPath();
+                if (this.fs.existsSync(offsetsPath)) {
+                    this.offsets = JSON.parse(this.fs.readFileSync(offsetsPath, { encoding: 'utf-8' })) ?? {};
+                }
+            } catch (e) {
+                this.log.log(LogLevel.WARN, 'Failed to read the log offsets, reading logs from the beginning', e);
+            }
         }
+        return this.offsets;
+    }
+
+    private saveOffsets(): void {
+        if (!this.offsetsDirty) {
+            return;
+        }
+        this.offsetsDirty = false;
+        try {
+            this.fs.writeFileSync(this.getOffsetsPath(), JSON.stringify(this.offsets));
+        } catch (e) {
+            this.log.log(LogLevel.WARN, 'Failed to save the log offsets', e);
+        }
+    }
+
+    /**
+     * @param file the file name
+     * @returns the type of log the file contains, if any
+     */
+    public getLogType(file: string): LogType | undefined {
+        const name = path.basename(file);
+        return (Object.keys(LogTypeEnum) as LogType[]).find((type) => this.logMap[type].filter(name));
+    }
+
+    /**
+     * @returns the files which are currently followed
+     */
+    public getActiveFiles(): string[] {
+        return (Object.keys(LogTypeEnum) as LogType[])
+            .map((type) => this.logMap[type].tail?.FILE)
+            .filter((x) => !!x);
+    }
+
+    private getStore(type: LogType): LogStore {
+        const container = this.logMap[type];
+        if (!container.store) {
+            container.store = new LogStore(
+                this.fs,
+                path.join(this.getStorePath(), type),
+                this.manager.config?.logBufferSize || 10000,
+            );
+        }
+        return container.store;
     }
 
     private async findLatestFiles(): Promise<void> {
@@ -119,80 +223,109 @@ export class LogReader extends IStatefulService {
         );
     }
 
+    /**
+     * Starts following the latest file of each log type.
+     * Files which were already (partially) read before are resumed at their persisted offset
+     * (identified by path, inode and first bytes), only new, rotated or truncated files are read from the beginning.
+     */
     private async registerReaders(): Promise<void> {
         await this.findLatestFiles();
+        const offsets = this.loadOffsets();
 
-        const createTail = (type: string, logContainer: LogContainer, retry?: number): void => {
-            logContainer.logLines = [];
-            if (logContainer?.logFiles?.length) {
-                if(this.fs.existsSync(logContainer.logFiles[0].file)) {
-                    logContainer.tail = new tail.Tail(
-                        logContainer?.logFiles[0]?.file,
-                        {
-                            follow: true,
-                            fromBeginning: true,
-                            flushAtEOF: true,
-                        },
-                    );
-                    logContainer?.tail?.on('error', /* istanbul ignore next */ (e) => {
-                        this.log.log(LogLevel.WARN, `Error reading ${type} - ${logContainer?.logFiles[0]?.file} - exist = ${this.fs.existsSync(logContainer.logFiles[0].file)}`);//, e);
-                        logContainer.tail.unwatch();
-                        if (!retry || retry < 1) {
-                            setTimeout(
-                                () => {
-                                    try {
-                                        createTail(type, logContainer, (retry ?? 0) + 1);
-                                    } catch (createTailError) {
-                                        this.log.log(LogLevel.WARN, `Error creating file reader ${type} - ${logContainer?.logFiles[0]?.file} - exist = ${this.fs.existsSync(logContainer.logFiles[0].file)}`);//, createTailError);
-                                    }
-                                },
-                                10000,
-                            );
-                        }
-                    });
-                    logContainer?.tail?.on('line', (line) => {
-                        if (line) {
+        const createTail = async (type: LogType, logContainer: LogContainer): Promise<void> => {
+            logContainer.tail?.stop();
+            logContainer.tail = undefined;
+            const store = this.getStore(type);
+            store.clear();
+
+            const file = logContainer?.logFiles?.[0]?.file;
+            if (!file || !this.fs.existsSync(file)) {
+                return;
+            }
+
+            // the lines of each read chunk are emitted as one batch
+            let batch: LogEntryEvent[] = [];
+            logContainer.tail = new FileTailer(
+                this.fs,
+                file,
+                (line, position) => {
+                    offsets[type] = position;
+                    this.offsetsDirty = true;
+                    if (line) {
+                        if (this.log.isLevelEnabled(LogLevel.DEBUG)) {
                             this.log.log(LogLevel.DEBUG, `${type} - ${line}`);
-                            const logEntry = {
-                                timestamp: new Date().valueOf(),
-                                message: line,
-                            };
-                            logContainer?.logLines?.push(logEntry);
-                            this.eventBus.emit(
-                                InternalEventTypes.LOG_ENTRY,
-                                {
-                                    type: type as LogTypeEnum,
-                                    entry: logEntry,
-                                },
-                            );
                         }
-                    });
+                        const logEntry = store.push({
+                            timestamp: Date.now(),
+                            message: line,
+                        });
+                        batch.push({
+                            type: type as LogTypeEnum,
+                            entry: logEntry,
+                            position,
+                        });
+                    }
+                },
+                (e) => {
+                    this.log.log(LogLevel.WARN, `Error reading ${type} - ${file}`, e);
+                },
+            );
+            logContainer.tail.onChunkDone = () => {
+                if (batch.length) {
+                    const events = batch;
+                    batch = [];
+                    this.eventBus.emitBatch(InternalEventTypes.LOG_ENTRY, events);
                 }
+            };
+
+            // lines before the resumed offset were already processed, so they are only restored to the buffer
+            const startOffset = await logContainer.tail.start(
+                offsets[type],
+                (line) => {
+                    if (line) {
+                        store.push({
+                            timestamp: Date.now(),
+                            message: line,
+                        });
+                    }
+                },
+            );
+            if (startOffset) {
+                this.log.log(LogLevel.INFO, `Resuming ${type} - ${file} at offset ${startOffset}`);
             }
         };
 
         for (const type of Object.keys(LogTypeEnum)) {
-            const logContainer = this.logMap[type as LogType];
             try {
-                createTail(type, logContainer);
+                await createTail(type as LogType, this.logMap[type as LogType]);
             } catch (createTailError) {
                 this.log.log(LogLevel.WARN, `Error creating file reader ${type}`, createTailError);
             }
         }
+
+        this.timers.removeTimer('saveOffsets');
+        this.timers.addInterval(
+            'saveOffsets',
+            /* istanbul ignore next */ () => this.saveOffsets(),
+            this.offsetSaveInterval,
+        );
     }
 
-    public async fetchLogs(type: LogType, since?: number): Promise<LogMessage[]> {
-        const logs = this.logMap[type]?.logLines ?? [];
-        if (since && since > 0) {
-            const idx = reverseIndexSearch(logs, (x) => x.timestamp <= since);
-            if (idx !== -1) {
-                if (idx + 1 >= logs.length) {
-                    return [];
-                }
-                return logs.slice(idx + 1);
-            }
+    /**
+     * Fetches log lines newer than since, oldest first.
+     * Returns at most one buffer size of lines,
+     * so callers page through the history by passing the last timestamp as since.
+     * Without since, the newest page is returned.
+     * @param type the log type
+     * @param since lower timestamp bound (exclusive)
+     * @param limit max number of lines
+     */
+    public async fetchLogs(type: LogType, since?: number, limit?: number): Promise<LogMessage[]> {
+        const store = this.logMap[type]?.store;
+        if (!store) {
+            return [];
         }
-        return logs;
+        return store.fetch(since, limit || store.CAPACITY);
     }
 
 }
@@ -0,0 +1,414 @@
+import { inject, injectable, singleton } from 'tsyringe';
+import { Listener } from 'eventemitter2';
+import * as path from 'path';
+import { IStatefulService } from '../types/service';
+import { LoggerFactory } from './loggerfactory';
+import { Manager } from '../control/manager';
+import { EventBus } from '../control/event-bus';
+import { Database, DatabaseTypes } from './database';
+import { LogReader } from './log-reader';
+import { InternalEventTypes } from '../types/events';
+import { LogType, TailPosition } from '../types/log-reader';
+import { LogSearchPage, LogSearchQuery } from '../types/log-search';
+import { FileTailer } from '../util/file-tailer';
+import { FSAPI, InjectionTokens } from '../util/apis';
+import { LogLevel } from '../util/logger';
+
+interface PendingLine {
+    type: LogType;
+    file: string | null;
+    timestamp: number;
+    message: string;
+}
+
+const DAY = 86_400_000;
+const FILE_DATE_REGEX = /(\d{4})[-_](\d{2})[-_](\d{2})[-_ ](\d{2})[-_]?(\d{2})[-_]?(\d{2})/;
+const LINE_TIME_REGEX = /^\s*(\d{1,2}):(\d{2}):(\d{2})(?:\.(\d{1,3}))?/;
+
+/**
+ * Full text index over the server logs.
+ *
+ * Lines are indexed as the LogReader emits them, rotated files in the profiles folder are indexed in the background.
+ * The indexed position of each file is stored, so no file is read twice.
+ */
+@singleton()
+@injectable()
+export class LogSearch extends IStatefulService {
+
+    public static readonly BATCH_SIZE = 1000;
+    public static readonly DEFAULT_PAGE_SIZE = 100;
+    public static readonly MAX_PAGE_SIZE = 1000;
+
+    public flushInterval = 1000;
+    public scanInterval = 600_000;
+    public retentionInterval = 3_600_000;
+
+    private pending: PendingLine[] = [];
+    private pendingPositions = new Map<string, { type: LogType; position: TailPosition }>();
+    private positions = new Map<string, TailPosition | null>();
+    private listener: Listener | undefined;
+    private scanning: Promise<number> | undefined;
+    private stopped = false;
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private manager: Manager,
+        private eventBus: EventBus,
+        private database: Database,
+        private logReader: LogReader,
+        @inject(InjectionTokens.fs) private fs: FSAPI,
+    ) {
+        super(loggerFactory.createLogger('LogSearch'));
+    }
+
+    public async start(): Promise<void> {
+        this.stopped = false;
+        const db = this.database.getDatabase(DatabaseTypes.LOG_SEARCH);
+        db.run(`
+            CREATE TABLE IF NOT EXISTS LOG_LINES (
+                id INTEGER PRIMARY KEY AUTOINCREMENT,
+                type TEXT NOT NULL,
+                file TEXT,
+                timestamp UNSIGNED BIG INT NOT NULL,
+                message TEXT NOT NULL
+            );
+        `);
+        db.run('CREATE INDEX IF NOT EXISTS LOG_LINES_TS ON LOG_LINES (timestamp);');
+        db.run('CREATE INDEX IF NOT EXISTS LOG_LINES_FILE ON LOG_LINES (file);');
+        // external content table, so the messages are stored only once
+        // new lines are added to it per batch (which is a lot faster than an insert trigger)
+        db.run(`
+            CREATE VIRTUAL TABLE IF NOT EXISTS LOG_LINES_FTS
+            USING fts5(message, content='LOG_LINES', content_rowid='id');
+        `);
+        db.run(`
+            CREATE TRIGGER IF NOT EXISTS LOG_LINES_AD AFTER DELETE ON LOG_LINES BEGIN
+                INSERT INTO LOG_LINES_FTS (LOG_LINES_FTS, rowid, message) VALUES ('delete', old.id, old.message);
+            END;
+        `);
+        db.run(`
+            CREATE TABLE IF NOT EXISTS LOG_FILES (
+                file TEXT PRIMARY KEY,
+                type TEXT NOT NULL,
+                position TEXT NOT NULL
+            );
+        `);
+
+        this.listener = this.eventBus.onBatch(InternalEventTypes.LOG_ENTRY, (events) => {
+            for (const x of events) {
+                this.add(x.type, x.entry.timestamp, x.entry.message, x.position);
+            }
+        });
+
+        this.timers.addInterval('flush', () => this.flush(), this.flushInterval);
+        this.timers.addInterval(
+            'scan',
+            /* istanbul ignore next */ () => this.scanHistory(),
+            this.scanInterval,
+        );
+        this.timers.addInterval(
+            'retention',
+            /* istanbul ignore next */ () => this.cleanup(),
+            this.retentionInterval,
+        );
+        void this.scanHistory();
+    }
+
+    public async stop(): Promise<void> {
+        this.timers.removeAllTimers();
+        this.listener?.off();
+        this.listener = undefined;
+        this.stopped = true;
+        await this.scanning;
+        this.flush();
+        this.positions.clear();
+    }
+
+    private getPosition(file: string): TailPosition | null {
+        if (!this.positions.has(file)) {
+            const row = this.database.getDatabase(DatabaseTypes.LOG_SEARCH).first(
+                'SELECT position FROM LOG_FILES WHERE file = ?',
+                file,
+            );
+            this.positions.set(file, row ? JSON.parse(row.position) : null);
+        }
+        return this.positions.get(file);
+    }
+
+    /**
+     * @returns true if the position is within the already indexed part of the same file
+     */
+    private isIndexed(position: TailPosition): boolean {
+        const indexed = this.getPosition(position.file);
+        if (!indexed || indexed.ino !== position.ino || position.offset > indexed.offset) {
+            return false;
+        }
+        // the first bytes grow until they are complete, so the shorter one must be a prefix of the other
+        const a = Buffer.from(indexed.head ?? '', 'base64');
+        const b = Buffer.from(position.head ?? '', 'base64');
+        const len = Math.min(a.length, b.length);
+        return a.subarray(0, len).equals(b.subarray(0, len));
+    }
+
+    /**
+     * Queues a log line for the next batch write
+     * @param type the log type
+     * @param timestamp the time of the line
+     * @param message the line
+     * @param position the position in the file after the line
+     */
+    public add(type: LogType, timestamp: number, message: string, position?: TailPosition): void {
+        if (position) {
+            if (this.isIndexed(position)) {
+                return;
+            }
+            this.positions.set(position.file, position);
+            this.pendingPositions.set(position.file, { type, position });
+        }
+        if (!message) {
+            return;
+        }
+        this.pending.push({
+            type,
+            file: position?.file ?? null,
+            timestamp,
+            message,
+        });
+        if (this.pending.length >= LogSearch.BATCH_SIZE) {
+            this.flush();
+        }
+    }
+
+    /**
+     * Writes all queued lines and the reached file positions in a single transaction
+     */
+    public flush(): void {
+        if (!this.pending.length && !this.pendingPositions.size) {
+            return;
+        }
+        const lines = this.pending;
+        const positions = [...this.pendingPositions.entries()];
+        this.pending = [];
+        this.pendingPositions.clear();
+
+        try {
+            this.database.getDatabase(DatabaseTypes.LOG_SEARCH).transaction((db) => {
+                if (lines.length) {
+                    const lastId = (db.prepare('SELECT IFNULL(MAX(id), 0) AS id FROM LOG_LINES').get() as any).id;
+                    const lineStmt = db.prepare('INSERT INTO LOG_LINES (type, file, timestamp, message) VALUES (?, ?, ?, ?)');
+                    for (const line of lines) {
+                        lineStmt.run([line.type, line.file, line.timestamp, line.message]);
+                    }
+                    db.prepare('INSERT INTO LOG_LINES_FTS (rowid, message) SELECT id, message FROM LOG_LINES WHERE id > ?').run([lastId]);
+                }
+                const fileStmt = db.prepare('INSERT OR REPLACE INTO LOG_FILES (file, type, position) VALUES (?, ?, ?)');
+                for (const [file, { type, position }] of positions) {
+                    fileStmt.run([file, type, JSON.stringify(position)]);
+                }
+            });
+        } catch (e) {
+            this.log.log(LogLevel.ERROR, `Failed to index ${lines.length} log lines`, e);
+        }
+    }
+
+    /**
+     * Indexes the log files in the profiles folder which are not followed by the LogReader, oldest first
+     * @returns the number of indexed lines
+     */
+    public async scanHistory(): Promise<number> {
+        if (!this.scanning) {
+            this.scanning = this.doScanHistory().finally(() => {
+                this.scanning = undefined;
+            });
+        }
+        return this.scanning;
+    }
+
+    private async doScanHistory(): Promise<number> {
+        const profiles = this.manager.getProfilesPath();
+        const active = new Set(this.logReader.getActiveFiles());
+
+        let files: { file: string; type: LogType; mtime: number }[] = [];
+        try {
+            for (const name of await this.fs.promises.readdir(profiles)) {
+                const type = this.logReader.getLogType(name);
+                const file = path.join(profiles, name);
+                if (type && !active.has(file)) {
+                    files.push({ file, type, mtime: (await this.fs.promises.stat(file)).mtime.getTime() });
+                }
+            }
+        } catch (e) {
+            this.log.log(LogLevel.WARN, 'Failed to list the log files', e);
+            return 0;
+        }
+        files = files.sort((a, b) => a.mtime - b.mtime);
+
+        let count = 0;
+        for (const { file, type, mtime } of files) {
+            if (this.stopped) {
+                break;
+            }
+            try {
+                count += await this.indexFile(type, file, mtime);
+            } catch (e) {
+                this.log.log(LogLevel.WARN, `Failed to index ${file}`, e);
+            }
+        }
+        this.flush();
+        return count;
+    }
+
+    private async indexFile(type: LogType, file: string, mtime: number): Promise<number> {
+        let resume = this.getPosition(file);
+        const size = (await this.fs.promises.stat(file)).size;
+        if (resume?.offset === size) {
+            return 0;
+        }
+
+        const db = this.database.getDatabase(DatabaseTypes.LOG_SEARCH);
+        let count = 0;
+        let day = 0;
+        let lastTimestamp = 0;
+        const tailer = new FileTailer(
+            this.fs,
+            file,
+            (line, position) => {
+                const time = LINE_TIME_REGEX.exec(line);
+                if (time) {
+                    const timeOfDay = ((Number(time[1]) * 60 + Number(time[2])) * 60 + Number(time[3])) * 1000
+                        + Number((time[4] ?? '0').padEnd(3, '0'));
+                    let timestamp = day + timeOfDay;
+                    if (timestamp < lastTimestamp - 3_600_000) {
+                        // midnight
+                        day += DAY;
+                        timestamp += DAY;
+                    }
+                    lastTimestamp = timestamp;
+                }
+                count++;
+                this.add(type, lastTimestamp, line, position);
+            },
+        );
+
+        if (resume && !(await tailer.canResume(resume))) {
+            this.flush();
+            db.run('DELETE FROM LOG_LINES WHERE file = ?', file);
+            this.positions.set(file, null);
+            resume = null;
+        }
+
+        if (resume) {
+            lastTimestamp = db.first('SELECT MAX(timestamp) AS ts FROM LOG_LINES WHERE file = ?', file)?.ts ?? 0;
+        }
+        if (!lastTimestamp) {
+            lastTimestamp = this.getFileTimestamp(file, mtime);
+        }
+        const date = new Date(lastTimestamp);
+        day = new Date(date.getFullYear(), date.getMonth(), date.getDate()).valueOf();
+
+        await tailer.start(resume, undefined, false);
+        if (count) {
+            this.log.log(LogLevel.INFO, `Indexed ${count} lines of ${file}`);
+        }
+        return count;
+    }
+
+    /**
+     * @returns the start time of the log file (from its name if possible, server log files are named after their start)
+     */
+    private getFileTimestamp(file: string, mtime: number): number {
+        const match = FILE_DATE_REGEX.exec(path.basename(file));
+        if (match) {
+            const [year, month, date, h, m, s] = match.slice(1).map((x) => Number(x));
+            return new Date(year, month - 1, date, h, m, s).valueOf();
+        }
+        return mtime;
+    }
+
+    private cleanup(): void {
+        const maxAge = this.manager.config?.logSearchMaxAge;
+        if (!maxAge || maxAge <= 0) {
+            return;
+        }
+        this.database.getDatabase(DatabaseTypes.LOG_SEARCH).run(
+            'DELETE FROM LOG_LINES WHERE timestamp < ?',
+            new Date().valueOf() - maxAge,
+        );
+    }
+
+    /**
+     * Converts the search words into a FTS query, so user input can not produce syntax errors
+     */
+    private toFtsQuery(query: string): string {
+        return (query ?? '')
+            .split(/\s+/)
+            .filter((x) => !!x && x !== '*')
+            .map((x) => {
+                const prefix = x.endsWith('*');
+                const word = prefix ? x.slice(0, -1) : x;
+                return `"${word.replace(/"/g, '""')}"${prefix ? '*' : ''}`;
+            })
+            .join(' ');
+    }
+
+    /**
+     * Searches the indexed log lines, newest first.
+     * Lines are ordered by their timestamp (not by insertion), so history indexed after live lines is paged in place.
+     * @param query the search words and filter / paging options
+     */
+    public search(query: LogSearchQuery): LogSearchPage {
+        const match = this.toFtsQuery(query.query);
+        if (!match) {
+            return { items: [] };
+        }
+        this.flush();
+
+        const limit = Math.min(query.limit > 0 ? query.limit : LogSearch.DEFAULT_PAGE_SIZE, LogSearch.MAX_PAGE_SIZE);
+        const where: string[] = ['LOG_LINES_FTS MATCH ?'];
+        const params: any[] = [match];
+        const cursor = this.parseCursor(query.cursor);
+        if (cursor) {
+            where.push('(l.timestamp < ? OR (l.timestamp = ? AND l.id < ?))');
+            params.push(cursor.timestamp, cursor.timestamp, cursor.id);
+        }
+        if (query.types?.length) {
+            where.push(`l.type IN (${query.types.map(() => '?').join(', ')})`);
+            params.push(...query.types);
+        }
+        if (query.since) {
+            where.push('l.timestamp > ?');
+            params.push(query.since);
+        }
+        if (query.until) {
+            where.push('l.timestamp <= ?');
+            params.push(query.until);
+        }
+
+        const items = this.database.getDatabase(DatabaseTypes.LOG_SEARCH).all(
+            `
+                SELECT l.id, l.type, l.file, l.timestamp, l.message
+                FROM LOG_LINES_FTS f
+                JOIN LOG_LINES l ON l.id = f.rowid
+                WHERE ${where.join(' AND ')}
+                ORDER BY l.timestamp DESC, l.id DESC
+                LIMIT ?
+            `,
+            ...params,
+            limit,
+        );
+        const last = items[items.length - 1];
+        return {
+            items,
+            nextCursor: items.length === limit ? `${last.timestamp}:${last.id}` : undefined,
+        };
+    }
+
+    private parseCursor(cursor?: string): { timestamp: number; id: number } | undefined {
+        const [timestamp, id] = (cursor ?? '').split(':').map((x) => Number(x));
+        if (!cursor || !Number.isFinite(timestamp) || !Number.isFinite(id)) {
+            return undefined;
+        }
+        return { timestamp, id };
+    }
+
+}
@@ -5,8 +5,11 @@ import { Logger } from '../util/logger';
 @injectable()
 export class LoggerFactory {
 
+    /** id of the server instance the loggers belong to, if the manager runs multiple instances */
+    public instance?: string;
+
     public createLogger(context: string): Logger {
-        return new Logger(context);
+        return new Logger(context, this.instance);
     }
 
 }
@@ -0,0 +1,87 @@
+import * as http from 'http';
+import { Manager } from '../control/manager';
+import { InstrumentationReport } from '../types/metrics';
+import { IStatefulService } from '../types/service';
+import { injectable, singleton } from 'tsyringe';
+import { LoggerFactory } from './loggerfactory';
+import { LogLevel } from '../util/logger';
+import { Config } from '../config/config';
+import { instrumentation } from '../util/instrumentation';
+
+/**
+ * Exposes the instrumentation of the manager process on a local prometheus endpoint.
+ * The values are collected by the process wide registry in util/instrumentation.
+ * In a multi server process, each instance serves its own series and the process wide ones.
+ */
+@singleton()
+@injectable()
+export class ManagerInstrumentation extends IStatefulService {
+
+    public readonly configKeys: (keyof Config)[] = ['instrumentationPort', 'serverPort'];
+
+    public readonly host = '127.0.0.1';
+    public port: number;
+
+    private server: http.Server | undefined;
+    private started = false;
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private manager: Manager,
+    ) {
+        super(loggerFactory.createLogger('Instrumentation'));
+    }
+
+    public async start(): Promise<void> {
+        await this.stop();
+        this.started = true;
+        instrumentation.startProcessMetrics();
+
+        this.port = this.manager.getInstrumentationPort();
+        if (this.port < 0) {
+            return;
+        }
+
+        const server = http.createServer((req, res) => {
+            if (req.method === 'GET' && req.url?.split('?')[0] === '/metrics') {
+                res.writeHead(200, { 'Content-Type': 'text/plain; version=0.0.4; charset=utf-8' });
+                res.end(instrumentation.toPrometheus(this.manager.instanceName));
+            } else {
+                res.writeHead(404);
+                res.end();
+            }
+        });
+        this.server = server;
+
+        await new Promise<void>((r) => {
+            // the endpoint is optional, so a used port does not stop the manager
+            server.once('error', (e) => {
+                this.log.log(LogLevel.WARN, `Failed to start the instrumentation endpoint on port ${this.port}`, e);
+                r();
+            });
+            server.listen(this.port, this.host, () => {
+                this.log.log(LogLevel.INFO, `Instrumentation listening on http://${this.host}:${this.port}/metrics`);
+                r();
+            });
+        });
+    }
+
+    public async stop(): Promise<void> {
+        if (!this.started) {
+            return;
+        }
+        this.started = false;
+        instrumentation.stopProcessMetrics();
+
+        const server = this.server;
+        this.server = undefined;
+        if (server?.listening) {
+            await new Promise<void>((r) => server.close(() => r()));
+        }
+    }
+
+    public getReport(): InstrumentationReport {
+        return instrumentation.getReport(this.manager.instanceName);
+    }
+
+}
@@ -1,5 +1,5 @@
 import { Manager } from '../control/manager';
-import { MetricType, MetricTypeEnum } from '../types/metrics';
+import { MetricSourceStats, MetricType, MetricTypeEnum } from '../types/metrics';
 import { LogLevel } from '../util/logger';
 import { IStatefulService } from '../types/service';
 import { injectable, singleton } from 'tsyringe';
@@ -7,12 +7,28 @@ import { LoggerFactory } from './loggerfactory';
 import { RCON } from './rcon';
 import { SystemReporter } from './system-reporter';
 import { Metrics } from './metrics';
+import { ManagerInstrumentation } from './manager-instrumentation';
+import { Config } from '../config/config';
+import { instanceLabels, instrumentation, TIMER_CALLBACK_DURATION } from '../util/instrumentation';
+
+interface MetricSource {
+    type: MetricType;
+    sample: () => Promise<any>;
+}
+
+class MetricSourceTimeout extends Error {}
 
 @singleton()
 @injectable()
 export class MetricsCollector extends IStatefulService {
 
+    public readonly configKeys: (keyof Config)[] = ['metricSources', 'metricPollIntervall'];
+
     public initialTimeout = 1000;
+    public retentionInterval = 3_600_000;
+
+    private running = new Set<MetricType>();
+    private stats = new Map<MetricType, MetricSourceStats>();
 
     public constructor(
         loggerFactory: LoggerFactory,
@@ -20,6 +36,7 @@ export class MetricsCollector extends IStatefulService {
         private metrics: Metrics,
         private rcon: RCON,
         private systemReporter: SystemReporter,
+        private managerInstrumentation: ManagerInstrumentation,
     ) {
         super(loggerFactory.createLogger('MetricsCollector'));
     }
@@ -31,9 +48,22 @@ export class MetricsCollector extends IStatefulService {
             'initialTimeout',
             () => {
                 this.timers.removeTimer('initialTimeout');
-                this.timers.addInterval('tick', () => {
-                    void this.tick();
-                }, this.manager.config.metricPollIntervall);
+                for (const source of this.getSources()) {
+                    const duration = instrumentation.histogram(
+                        TIMER_CALLBACK_DURATION,
+                        instanceLabels(this.manager.instanceName, { service: 'MetricsCollector', timer: `sample-${source.type}` }),
+                    );
+                    void duration.time(() => this.sample(source));
+                    this.timers.addInterval(`sample-${source.type}`, () => {
+                        void duration.time(() => this.sample(source));
+                    }, this.getSourceInterval(source.type));
+                }
+
+                // metrics are partitioned by day, so there is no need to clean up on every tick
+                this.cleanup();
+                this.timers.addInterval('retention', () => {
+                    this.cleanup();
+                }, this.retentionInterval);
             },
             this.initialTimeout,
         );
@@ -43,31 +73,114 @@ export class MetricsCollector extends IStatefulService {
         this.timers.removeAllTimers();
     }
 
-    private async tick(): Promise<void> {
+    private getSources(): MetricSource[] {
+        return [
+            { type: MetricTypeEnum.PLAYERS, sample: () => this.rcon.getPlayers() },
+            { type: MetricTypeEnum.SYSTEM, sample: () => this.systemReporter.getSystemReport() },
+            { type: MetricTypeEnum.INSTRUMENTATION, sample: async () => this.managerInstrumentation.getReport() },
+        ];
+    }
 
-        this.log.log(LogLevel.DEBUG, 'Tick');
+    private getSourceInterval(type: MetricType): number {
+        return this.manager.config.metricSources?.[type]?.interval || this.manager.config.metricPollIntervall;
+    }
 
-        await this.pushMetric(MetricTypeEnum.PLAYERS, () => this.rcon.getPlayers());
+    private getSourceTimeout(type: MetricType): number {
+        return this.manager.config.metricSources?.[type]?.timeout || this.manager.config.metricSourceTimeout;
+    }
 
-        await this.pushMetric(MetricTypeEnum.SYSTEM, () => this.systemReporter.getSystemReport());
+    public getSourceStats(): MetricSourceStats[] {
+        return [...this.stats.values()].map((x) => ({ ...x }));
+    }
 
-        if (this.manager.config.metricMaxAge && this.manager.config.metricMaxAge > 0) {
-            this.metrics.deleteMetrics(this.manager.config.metricMaxAge);
+    private getStats(type: MetricType): MetricSourceStats {
+        let stats = this.stats.get(type);
+        if (!stats) {
+            stats = { type, samples: 0, failures: 0, timeouts: 0, skipped: 0 };
+            this.stats.set(type, stats);
         }
+        return stats;
+    }
 
+    private recordLatency(stats: MetricSourceStats, latency: number): void {
+        stats.lastLatency = latency;
+        stats.maxLatency = Math.max(stats.maxLatency ?? 0, latency);
+        // exponential moving average, so old outliers fade out
+        stats.avgLatency = stats.avgLatency === undefined
+            ? latency
+            : Math.round(stats.avgLatency * 0.9 + latency * 0.1);
     }
 
-    private async pushMetric(type: MetricType, valueFnc: () => Promise<any>): Promise<void> {
+    /**
+     * Samples a single source and pushes the value with the time it was received.
+     * A source which is still busy with its previous sample is skipped, so slow sources do not pile up.
+     * A timeout only gives up waiting (the late value is dropped), the source stays busy until its sample settles.
+     * @param source the source to sample
+     */
+    private async sample(source: MetricSource): Promise<void> {
+        const stats = this.getStats(source.type);
+        if (this.running.has(source.type)) {
+            stats.skipped++;
+            return;
+        }
+
+        this.running.add(source.type);
+        const start = new Date().valueOf();
+        let timeout: any;
         try {
-            const value = await valueFnc();
+            // also turns synchronous errors of the source into a rejection
+            const pending = new Promise<any>((r) => r(source.sample()));
+            const done = (): void => {
+                this.running.delete(source.type);
+            };
+            pending.then(done, done);
+
+            const timeoutMs = this.getSourceTimeout(source.type);
+            const value = await Promise.race([
+                pending,
+                ...(timeoutMs > 0
+                    ? [new Promise<never>((_, reject) => {
+                        timeout = setTimeout(() => reject(new MetricSourceTimeout()), timeoutMs);
+                    })]
+                    : []),
+            ]);
+            const timestamp = new Date().valueOf();
+            this.recordLatency(stats, timestamp - start);
+            this.log.log(LogLevel.DEBUG, `Sampled ${source.type} in ${timestamp - start}ms`);
+
             if (!!value) {
-                await this.metrics.pushMetricValue(type, {
-                    timestamp: new Date().valueOf(),
+                await this.metrics.pushMetricValue(source.type, {
+                    timestamp,
                     value,
                 });
+                stats.samples++;
+                stats.lastTimestamp = timestamp;
+            }
+        } catch (e) {
+            if (e instanceof MetricSourceTimeout) {
+                stats.timeouts++;
+                this.recordLatency(stats, new Date().valueOf() - start);
+                this.log.log(LogLevel.WARN, `Metric source ${source.type} timed out`);
+            } else {
+                stats.failures++;
+                this.log.log(LogLevel.WARN, 'Failed to evaluate or push metric', e);
+            }
+        } finally {
+            clearTimeout(timeout);
+        }
+    }
+
+    private cleanup(): void {
+        try {
+            if (this.manager.config.metricMaxAge && this.manager.config.metricMaxAge > 0) {
+                this.metrics.deleteMetrics(this.manager.config.metricMaxAge);
+            }
+
+            if (this.manager.config.metricRollupMaxAge) {
+                this.metrics.deleteRollups(this.manager.config.metricRollupMaxAge);
             }
         } catch (e) {
-            this.log.log(LogLevel.WARN, 'Failed to evaluate or push metric', e);
+            this.log.log(LogLevel.WARN, 'Failed to clean up metrics', e);
         }
     }
 
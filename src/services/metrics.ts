@@ -1,24 +1,199 @@
-import { MetricType, MetricTypeEnum, MetricWrapper } from '../types/metrics';
+import {
+    EntityAreaQuery,
+    EntityTrackPoint,
+    EntityTrackQuery,
+    IngameEntityMetricType,
+    MetricRollupTier,
+    MetricRollupTierDefinition,
+    MetricPage,
+    MetricPageQuery,
+    MetricType,
+    MetricTypeEnum,
+    MetricWrapper,
+} from '../types/metrics';
+import { IngameReportEntry } from '../types/ingame-report';
+import { IngameMetricStorage } from '../config/config';
 import { IStatefulService } from '../types/service';
-import { Database, DatabaseTypes } from './database';
+import { Database, DatabaseTypes, Sqlite3Wrapper } from './database';
 import { injectable, singleton } from 'tsyringe';
 import { LoggerFactory } from './loggerfactory';
+import { Manager } from '../control/manager';
 
 @singleton()
 @injectable()
 export class Metrics extends IStatefulService {
 
+    public static readonly ENTITY_METRIC_TYPES: IngameEntityMetricType[] = [
+        MetricTypeEnum.INGAME_PLAYERS,
+        MetricTypeEnum.INGAME_VEHICLES,
+    ];
+
+    // ordered from fine to coarse
+    public static readonly ROLLUP_TIERS: MetricRollupTierDefinition[] = [
+        { tier: 'minute', interval: 60_000 },
+        { tier: 'quarterHour', interval: 900_000 },
+        { tier: 'hour', interval: 3_600_000 },
+    ];
+
+    // audit entries must never be downsampled,
+    // entity snapshots are too large to be copied into every tier and one snapshot per bucket is no useful summary
+    public static readonly ROLLUP_EXCLUDED_TYPES: MetricType[] = [
+        MetricTypeEnum.AUDIT,
+        ...Metrics.ENTITY_METRIC_TYPES,
+    ];
+
+    // raw samples are stored in one table per (UTC) day, so retention can drop whole tables
+    public static readonly PARTITION_SIZE = 86_400_000;
+
+    // default number of items per page when streaming
+    public static readonly PAGE_SIZE = 500;
+
+    // entity id of the placeholder row which records a sample without any entities
+    public static readonly EMPTY_SAMPLE_ID = -1;
+
+    // base table -> sorted partition days
+    private partitions = new Map<string, number[]>();
+    // unpartitioned tables created by older versions
+    private legacyTables = new Set<string>();
+    private partitionsLoaded = false;
+
     public constructor(
         loggerFactory: LoggerFactory,
+        private manager: Manager,
         private database: Database,
     ) {
         super(loggerFactory.createLogger('Metrics'));
     }
 
     public async start(): Promise<void> {
-        for (const metricKey of Object.keys(MetricTypeEnum)) {
-            this.database.getDatabase(DatabaseTypes.METRICS).run(`
-                CREATE TABLE IF NOT EXISTS ${metricKey} (
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        this.loadPartitions();
+
+        for (const metricKey of this.getRollupTypes()) {
+            for (const { tier, interval } of Metrics.ROLLUP_TIERS) {
+                const table = this.getRollupTable(metricKey, tier);
+                db.run(`
+                    CREATE TABLE IF NOT EXISTS ${table} (
+                        bucket INTEGER PRIMARY KEY,
+                        timestamp UNSIGNED BIG INT,
+                        value TEXT
+                    );
+                `);
+                if (!db.first(`SELECT bucket FROM ${table} LIMIT 1`)) {
+                    this.backfillRollup(metricKey, table, interval);
+                }
+            }
+        }
+
+        // rollups of types which are excluded by now
+        for (const metricKey of Metrics.ROLLUP_EXCLUDED_TYPES) {
+            for (const { tier } of Metrics.ROLLUP_TIERS) {
+                db.run(`DROP TABLE IF EXISTS ${this.getRollupTable(metricKey, tier)}`);
+            }
+        }
+    }
+
+    /**
+     * Fills an empty rollup table from the raw samples which were stored before the rollups existed.
+     * Only the first sample of each bucket is kept, same as for new samples.
+     * @param type the metric type
+     * @param table the rollup table
+     * @param interval the bucket size of the tier
+     */
+    private backfillRollup(type: MetricType, table: string, interval: number): void {
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        for (const source of this.getReadTables(this.getSnapshotTable(type))) {
+            db.run(
+                `
+                    INSERT OR IGNORE INTO ${table} (bucket, timestamp, value)
+                    SELECT CAST(timestamp / ? AS INTEGER), timestamp, value FROM ${source}
+                    ORDER BY timestamp ASC
+                `,
+                interval,
+            );
+        }
+    }
+
+    public async stop(): Promise<void> {
+        // nothing
+    }
+
+    public isEntityMetric(type: MetricType): type is IngameEntityMetricType {
+        return Metrics.ENTITY_METRIC_TYPES.includes(type as IngameEntityMetricType);
+    }
+
+    /**
+     * The instances of a multi-instance manager share the metrics database, each one has its own tables
+     */
+    private getTablePrefix(): string {
+        const instance = this.manager.instanceName;
+        return instance ? `I_${instance.replace(/\W/g, '_')}_` : '';
+    }
+
+    private getSnapshotTable(type: MetricType): string {
+        return `${this.getTablePrefix()}${type}`;
+    }
+
+    private getEntityTable(type: IngameEntityMetricType): string {
+        return `${this.getTablePrefix()}${type}_ENTITIES`;
+    }
+
+    private getPartitionedTables(): string[] {
+        return [
+            ...(Object.keys(MetricTypeEnum) as MetricType[]).map((x) => this.getSnapshotTable(x)),
+            ...Metrics.ENTITY_METRIC_TYPES.map((x) => this.getEntityTable(x)),
+        ];
+    }
+
+    private getPartitionTable(base: string, day: number): string {
+        return `${base}_D${day}`;
+    }
+
+    private loadPartitions(): void {
+        const tables: string[] = this.database.getDatabase(DatabaseTypes.METRICS)
+            .all(`SELECT name FROM sqlite_master WHERE type = 'table'`)
+            .map((x) => x.name);
+
+        this.partitions.clear();
+        this.legacyTables.clear();
+        for (const base of this.getPartitionedTables()) {
+            if (tables.includes(base)) {
+                this.legacyTables.add(base);
+            }
+            const prefix = `${base}_D`;
+            this.partitions.set(
+                base,
+                tables
+                    .filter((x) => x.startsWith(prefix) && /^\d+$/.test(x.slice(prefix.length)))
+                    .map((x) => Number(x.slice(prefix.length)))
+                    .sort((a, b) => a - b),
+            );
+        }
+        this.partitionsLoaded = true;
+    }
+
+    private createPartition(base: string, table: string): void {
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        if (base.endsWith('_ENTITIES')) {
+            db.run(`
+                CREATE TABLE IF NOT EXISTS ${table} (
+                    timestamp UNSIGNED BIG INT NOT NULL,
+                    id INTEGER NOT NULL,
+                    name TEXT,
+                    type TEXT,
+                    x REAL,
+                    y REAL,
+                    z REAL,
+                    speed TEXT,
+                    damage REAL
+                );
+            `);
+            db.run(`CREATE INDEX IF NOT EXISTS ${table}_ID_TS ON ${table} (id, timestamp);`);
+            db.run(`CREATE INDEX IF NOT EXISTS ${table}_NAME_TS ON ${table} (name, timestamp);`);
+            db.run(`CREATE INDEX IF NOT EXISTS ${table}_TS_POS ON ${table} (timestamp, x, z);`);
+        } else {
+            db.run(`
+                CREATE TABLE IF NOT EXISTS ${table} (
                     timestamp UNSIGNED BIG INT PRIMARY KEY,
                     value TEXT
                 );
@@ -26,43 +201,504 @@ export class Metrics extends IStatefulService {
         }
     }
 
-    public async stop(): Promise<void> {
-        // nothing
+    /**
+     * Returns the partition table for the given timestamp and creates it if needed
+     * @param base the unpartitioned table name
+     * @param timestamp the sample timestamp
+     */
+    private ensurePartition(base: string, timestamp: number): string {
+        if (!this.partitionsLoaded) {
+            this.loadPartitions();
+        }
+        const day = Math.floor(timestamp / Metrics.PARTITION_SIZE);
+        const table = this.getPartitionTable(base, day);
+        const days = this.partitions.get(base) ?? [];
+        if (!days.includes(day)) {
+            this.createPartition(base, table);
+            days.push(day);
+            days.sort((a, b) => a - b);
+            this.partitions.set(base, days);
+        }
+        return table;
+    }
+
+    /**
+     * Lists all tables (legacy first, then partitions in ascending order) which may contain samples in the given range
+     * @param base the unpartitioned table name
+     * @param since lower timestamp bound
+     * @param until upper timestamp bound
+     */
+    private getReadTables(base: string, since?: number, until?: number): string[] {
+        if (!this.partitionsLoaded) {
+            this.loadPartitions();
+        }
+        const fromDay = Math.floor((since ?? 0) / Metrics.PARTITION_SIZE);
+        const toDay = until ? Math.floor(until / Metrics.PARTITION_SIZE) : Number.MAX_SAFE_INTEGER;
+        return [
+            ...(this.legacyTables.has(base) ? [base] : []),
+            ...(this.partitions.get(base) ?? [])
+                .filter((day) => day >= fromDay && day <= toDay)
+                .map((day) => this.getPartitionTable(base, day)),
+        ];
+    }
+
+    private allPartitions(
+        base: string,
+        since: number | undefined,
+        until: number | undefined,
+        query: (table: string) => string,
+        ...params: any[]
+    ): any[] {
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        let rows: any[] = [];
+        for (const table of this.getReadTables(base, since, until)) {
+            rows = rows.concat(db.all(query(table), ...params));
+        }
+        return rows;
+    }
+
+    /**
+     * Reads the tables of the given range in order until the limit is reached
+     * @param base the unpartitioned table name
+     * @param since lower timestamp bound
+     * @param until upper timestamp bound
+     * @param limit max number of items (all if undefined)
+     * @param fetch reads at most the remaining number of items from one table
+     * @param count counts the items of the fetched rows
+     */
+    private readPartitions(
+        base: string,
+        since: number,
+        until: number,
+        limit: number | undefined,
+        fetch: (db: Sqlite3Wrapper, table: string, remaining?: number) => any[],
+        count: (rows: any[]) => number = (rows) => rows.length,
+    ): any[] {
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        let rows: any[] = [];
+        let found = 0;
+        for (const table of this.getReadTables(base, since, until)) {
+            const remaining = limit ? limit - found : undefined;
+            if (remaining !== undefined && remaining <= 0) {
+                break;
+            }
+            const tableRows = fetch(db, table, remaining);
+            found += count(tableRows);
+            rows = rows.concat(tableRows);
+        }
+        return rows;
+    }
+
+    private getRollupTypes(): MetricType[] {
+        return (Object.keys(MetricTypeEnum) as MetricType[])
+            .filter((x) => !Metrics.ROLLUP_EXCLUDED_TYPES.includes(x));
+    }
+
+    private getRollupTable(type: MetricType, tier: MetricRollupTier): string {
+        return `${this.getTablePrefix()}${type}_ROLLUP_${tier.toUpperCase()}`;
+    }
+
+    private getIngameStorage(): IngameMetricStorage {
+        return this.manager.config?.ingameMetricStorage ?? 'snapshot';
+    }
+
+    private parsePosition(position: string): number[] {
+        const coords = (position ?? '')
+            .replace(/[<>,]/g, ' ')
+            .split(' ')
+            .filter((x) => !!x)
+            .map((x) => Number(x));
+        return [0, 1, 2].map((i) => (Number.isFinite(coords[i]) ? coords[i] : null));
     }
 
     public async pushMetricValue<T extends MetricWrapper<any>>(type: MetricType, value: T): Promise<void> {
-        this.database.getDatabase(DatabaseTypes.METRICS).run(
-            `
-                INSERT INTO ${type} (timestamp, value) VALUES (?, ?)
-            `,
-            value.timestamp,
-            JSON.stringify(value.value),
-        );
+        const storage = this.isEntityMetric(type) ? this.getIngameStorage() : 'snapshot';
+
+        if (storage === 'entity' || storage === 'both') {
+            this.pushEntityValues(type as IngameEntityMetricType, value.timestamp, value.value ?? []);
+        }
+
+        if (storage === 'snapshot' || storage === 'both') {
+            this.database.getDatabase(DatabaseTypes.METRICS).run(
+                `
+                    INSERT INTO ${this.ensurePartition(this.getSnapshotTable(type), value.timestamp)} (timestamp, value) VALUES (?, ?)
+                `,
+                value.timestamp,
+                JSON.stringify(value.value),
+            );
+        }
+
+        if (!Metrics.ROLLUP_EXCLUDED_TYPES.includes(type)) {
+            this.pushRollupValues(type, value);
+        }
     }
 
+    /**
+     * Keeps the first sample of each bucket in every rollup tier.
+     * Buckets are immutable once written, so clients polling with "since" never miss updates.
+     * @param type the metric type
+     * @param value the raw sample
+     */
+    private pushRollupValues<T extends MetricWrapper<any>>(type: MetricType, value: T): void {
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        const json = JSON.stringify(value.value);
+        for (const { tier, interval } of Metrics.ROLLUP_TIERS) {
+            db.run(
+                `
+                    INSERT OR IGNORE INTO ${this.getRollupTable(type, tier)} (bucket, timestamp, value) VALUES (?, ?, ?)
+                `,
+                Math.floor(value.timestamp / interval),
+                value.timestamp,
+                json,
+            );
+        }
+    }
+
+    private pushEntityValues(type: IngameEntityMetricType, timestamp: number, entries: IngameReportEntry[]): void {
+        const table = this.ensurePartition(this.getEntityTable(type), timestamp);
+        this.database.getDatabase(DatabaseTypes.METRICS).transaction((db) => {
+            const stmt = db.prepare(`
+                INSERT INTO ${table}
+                    (timestamp, id, name, type, x, y, z, speed, damage)
+                VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?)
+            `);
+            for (const entry of entries) {
+                const [x, y, z] = this.parsePosition(entry.position);
+                stmt.run([
+                    timestamp,
+                    entry.id,
+                    entry.name ?? null,
+                    entry.type ?? null,
+                    x,
+                    y,
+                    z,
+                    entry.speed ?? null,
+                    entry.damage ?? null,
+                ]);
+            }
+            // without any rows the sample would not exist at all
+            if (!entries.length) {
+                stmt.run([timestamp, Metrics.EMPTY_SAMPLE_ID, null, null, null, null, null, null, null]);
+            }
+        });
+    }
+
+    /**
+     * Drops all partitions which only contain samples older than maxAge.
+     * Partitions are whole days, so samples may be kept up to one day longer than maxAge.
+     * @param maxAge max age in ms
+     */
     public deleteMetrics(maxAge: number): void {
 
+        if (!this.partitionsLoaded) {
+            this.loadPartitions();
+        }
+
         const delTs = new Date().valueOf() - maxAge;
-        for (const key of Object.keys(MetricTypeEnum)) {
-            this.database.getDatabase(DatabaseTypes.METRICS).run(`
-                DELETE FROM ${key} WHERE timestamp < ?
-            `, delTs);
+        const delDay = Math.floor(delTs / Metrics.PARTITION_SIZE);
+        const db = this.database.getDatabase(DatabaseTypes.METRICS);
+        for (const base of this.getPartitionedTables()) {
+            const days = this.partitions.get(base) ?? [];
+            const expired = days.filter((day) => day < delDay);
+            for (const day of expired) {
+                db.run(`DROP TABLE IF EXISTS ${this.getPartitionTable(base, day)}`);
+            }
+            this.partitions.set(base, days.filter((day) => day >= delDay));
+
+            if (this.legacyTables.has(base)) {
+                db.run(`
+                    DELETE FROM ${base} WHERE timestamp < ?
+                `, delTs);
+                if (!db.first(`SELECT timestamp FROM ${base} LIMIT 1`)) {
+                    db.run(`DROP TABLE IF EXISTS ${base}`);
+                    this.legacyTables.delete(base);
+                }
+            }
+        }
+
+    }
+
+    public deleteRollups(maxAges: Partial<Record<MetricRollupTier, number>>): void {
+
+        const now = new Date().valueOf();
+        for (const { tier, interval } of Metrics.ROLLUP_TIERS) {
+            const maxAge = maxAges?.[tier];
+            if (!maxAge || maxAge <= 0) {
+                continue;
+            }
+            const delBucket = Math.floor((now - maxAge) / interval);
+            for (const type of this.getRollupTypes()) {
+                this.database.getDatabase(DatabaseTypes.METRICS).run(`
+                    DELETE FROM ${this.getRollupTable(type, tier)} WHERE bucket < ?
+                `, delBucket);
+            }
+        }
+
+    }
+
+    /**
+     * Checks whether a rollup tier still holds all samples from the given timestamp on
+     * which the raw data holds, i.e. whether the range was not cut off by its retention yet
+     * @param tier the rollup tier
+     * @param since lower timestamp bound
+     */
+    private isRollupRetained(tier: MetricRollupTier, since?: number): boolean {
+        const maxAge = this.manager.config?.metricRollupMaxAge?.[tier];
+        if (!maxAge || maxAge <= 0) {
+            return true;
+        }
+        const now = new Date().valueOf();
+        const rawMaxAge = this.manager.config?.metricMaxAge;
+        const rawStart = rawMaxAge > 0 ? now - rawMaxAge : 0;
+        return now - maxAge <= Math.max(since ?? 0, rawStart);
+    }
+
+    /**
+     * Finds the coarsest rollup tier which still satisfies the requested resolution.
+     * Tiers whose retention does not cover the requested range are skipped in favor of finer tiers or the raw samples.
+     * @param type the metric type
+     * @param resolution the requested time between samples (in ms)
+     * @param since lower timestamp bound of the requested range
+     * @returns the rollup tier or undefined if raw samples are required
+     */
+    public getRollupTierFor(type: MetricType, resolution?: number, since?: number): MetricRollupTierDefinition | undefined {
+        if (!resolution || resolution <= 0 || Metrics.ROLLUP_EXCLUDED_TYPES.includes(type)) {
+            return undefined;
+        }
+        return [...Metrics.ROLLUP_TIERS]
+            .reverse()
+            .find((x) => x.interval <= resolution && this.isRollupRetained(x.tier, since));
+    }
+
+    public async fetchMetrics(type: MetricType, since?: number, resolution?: number): Promise<MetricWrapper<any>[]> {
+        return (await this.fetchMetricsPage(type, { since, resolution })).items;
+    }
+
+    /**
+     * Fetches one page of metrics ordered by timestamp.
+     * Only the rows of the requested page are read and decoded.
+     * @param type the metric type
+     * @param query range, cursor, page size and field projection
+     * @returns the page and the cursor of the next one (if there might be more items)
+     */
+    public async fetchMetricsPage(type: MetricType, query: MetricPageQuery = {}): Promise<MetricPage<any>> {
+        const since = Math.max(query.since ?? 0, query.cursor ?? 0);
+        const until = query.until || Number.MAX_SAFE_INTEGER;
+        const limit = query.limit > 0 ? Math.floor(query.limit) : undefined;
+        const fields = query.fields?.filter((x) => !!x);
+
+        let items: MetricWrapper<any>[];
+        // the tier is chosen by the start of the range (not the cursor), so all pages share one resolution
+        const rollupTier = this.getRollupTierFor(type, query.resolution, query.since);
+        if (rollupTier) {
+            items = this.fetchRollups(type, rollupTier, since, until, limit, fields);
+        } else if (this.isEntityMetric(type) && this.getIngameStorage() === 'entity') {
+            items = this.fetchEntitySnapshots(type, since, until, limit, fields);
+        } else {
+            items = this.readPartitions(
+                this.getSnapshotTable(type),
+                since,
+                until,
+                limit,
+                (db, table, remaining) => db.all(
+                    `
+                        SELECT timestamp, value FROM ${table}
+                        WHERE timestamp > ? AND timestamp <= ?
+                        ORDER BY timestamp ASC
+                        ${remaining ? 'LIMIT ?' : ''}
+                    `,
+                    ...[since, until, remaining].filter((x) => x !== undefined),
+                ),
+            ).map((x) => this.decodeRow(x, fields));
         }
 
+        return {
+            items,
+            nextCursor: (limit && items.length >= limit) ? items[items.length - 1].timestamp : undefined,
+        };
+    }
+
+    /**
+     * Pages through all metrics matching the query and hands every page to the consumer before reading the next one
+     * @param type the metric type
+     * @param query range, page size and field projection
+     * @param onPage consumer of the pages
+     * @returns the total number of items
+     */
+    public async streamMetrics(
+        type: MetricType,
+        query: MetricPageQuery,
+        onPage: (page: MetricPage<any>) => Promise<any>,
+    ): Promise<number> {
+        let count = 0;
+        let cursor = query.cursor;
+        do {
+            const page = await this.fetchMetricsPage(type, {
+                ...query,
+                cursor,
+                limit: query.limit > 0 ? query.limit : Metrics.PAGE_SIZE,
+            });
+            if (page.items.length) {
+                count += page.items.length;
+                await onPage(page);
+            }
+            cursor = page.nextCursor;
+        } while (cursor !== undefined);
+        return count;
     }
 
-    public async fetchMetrics(type: MetricType, since?: number): Promise<MetricWrapper<any>[]> {
+    private decodeRow(row: { timestamp: number, value: string }, fields?: string[]): MetricWrapper<any> {
+        return {
+            timestamp: row.timestamp,
+            value: this.projectValue(JSON.parse(row.value), fields),
+        };
+    }
+
+    private projectValue(value: any, fields?: string[]): any {
+        if (!fields?.length || !value || typeof value !== 'object') {
+            return value;
+        }
+        if (Array.isArray(value)) {
+            return value.map((x) => this.projectValue(x, fields));
+        }
+        const projected = {};
+        for (const field of fields) {
+            if (field in value) {
+                projected[field] = value[field];
+            }
+        }
+        return projected;
+    }
+
+    private fetchRollups(
+        type: MetricType,
+        definition: MetricRollupTierDefinition,
+        since: number,
+        until: number,
+        limit?: number,
+        fields?: string[],
+    ): MetricWrapper<any>[] {
         return this.database.getDatabase(DatabaseTypes.METRICS).all(
             `
-                SELECT * FROM ${type} WHERE timestamp > ? ORDER BY timestamp ASC
+                SELECT timestamp, value FROM ${this.getRollupTable(type, definition.tier)}
+                WHERE bucket >= ? AND timestamp > ? AND timestamp <= ?
+                ORDER BY bucket ASC
+                ${limit ? 'LIMIT ?' : ''}
             `,
-            since ?? 0,
-        ).map((x) => {
-            return {
-                timestamp: x.timestamp,
-                value: JSON.parse(x.value),
-            };
-        });
+            ...[Math.floor(since / definition.interval), since, until, limit].filter((x) => x !== undefined),
+        ).map((x) => this.decodeRow(x, fields));
+    }
+
+    /**
+     * Rebuilds the snapshot representation from the entity rows
+     * so consumers of the legacy format keep working in entity mode
+     * @param type the entity metric type
+     * @param since lower timestamp bound (exclusive)
+     * @param until upper timestamp bound (inclusive)
+     * @param limit max number of snapshots
+     * @param fields entry fields to keep
+     */
+    private fetchEntitySnapshots(
+        type: IngameEntityMetricType,
+        since: number,
+        until: number,
+        limit?: number,
+        fields?: string[],
+    ): MetricWrapper<IngameReportEntry[]>[] {
+        const rows: EntityTrackPoint[] = this.readPartitions(
+            this.getEntityTable(type),
+            since,
+            until,
+            limit,
+            (db, table, remaining) => db.all(
+                remaining
+                    ? `
+                        SELECT * FROM ${table}
+                        WHERE timestamp IN (
+                            SELECT DISTINCT timestamp FROM ${table}
+                            WHERE timestamp > ? AND timestamp <= ?
+                            ORDER BY timestamp ASC
+                            LIMIT ?
+                        )
+                        ORDER BY timestamp ASC
+                    `
+                    : `
+                        SELECT * FROM ${table}
+                        WHERE timestamp > ? AND timestamp <= ?
+                        ORDER BY timestamp ASC
+                    `,
+                ...[since, until, remaining].filter((x) => x !== undefined),
+            ),
+            (x) => new Set(x.map((row) => row.timestamp)).size,
+        );
+
+        const entryType = type === MetricTypeEnum.INGAME_PLAYERS ? 'PLAYER' : 'VEHICLE';
+        const result: MetricWrapper<IngameReportEntry[]>[] = [];
+        for (const row of rows) {
+            let last = result[result.length - 1];
+            if (last?.timestamp !== row.timestamp) {
+                last = { timestamp: row.timestamp, value: [] };
+                result.push(last);
+            }
+            if (row.id === Metrics.EMPTY_SAMPLE_ID) {
+                continue;
+            }
+            last.value.push(this.projectValue(
+                {
+                    entryType,
+                    type: row.type,
+                    name: row.name,
+                    id: row.id,
+                    position: [row.x, row.y, row.z].join(' '),
+                    speed: row.speed,
+                    damage: row.damage,
+                },
+                fields,
+            ));
+        }
+        return result;
+    }
+
+    public async fetchEntityTrack(type: IngameEntityMetricType, query: EntityTrackQuery): Promise<EntityTrackPoint[]> {
+        const useId = typeof query.id === 'number' && !Number.isNaN(query.id) && query.id !== Metrics.EMPTY_SAMPLE_ID;
+        if (!useId && !query.name) {
+            return [];
+        }
+
+        return this.allPartitions(
+            this.getEntityTable(type),
+            query.since,
+            query.until,
+            (table) => `
+                SELECT * FROM ${table}
+                WHERE ${useId ? 'id' : 'name'} = ? AND timestamp > ? AND timestamp <= ?
+                ORDER BY timestamp ASC
+            `,
+            useId ? query.id : query.name,
+            query.since ?? 0,
+            query.until ?? Number.MAX_SAFE_INTEGER,
+        );
+    }
+
+    public async fetchEntitiesInArea(type: IngameEntityMetricType, query: EntityAreaQuery): Promise<EntityTrackPoint[]> {
+        return this.allPartitions(
+            this.getEntityTable(type),
+            query.since,
+            query.until,
+            (table) => `
+                SELECT * FROM ${table}
+                WHERE timestamp > ? AND timestamp <= ?
+                    AND x BETWEEN ? AND ?
+                    AND z BETWEEN ? AND ?
+                ORDER BY timestamp ASC
+            `,
+            query.since ?? 0,
+            query.until ?? Number.MAX_SAFE_INTEGER,
+            Math.min(query.minX, query.maxX),
+            Math.max(query.minX, query.maxX),
+            Math.min(query.minZ, query.maxZ),
+            Math.max(query.minZ, query.maxZ),
+        );
     }
 
 }
@@ -0,0 +1,265 @@
+import * as crypto from 'crypto';
+import * as path from 'path';
+import { inject, injectable, singleton } from 'tsyringe';
+import { Manager } from '../control/manager';
+import { IService } from '../types/service';
+import { ModStoreDeployResult, ModStoreFile, ModStoreIngestResult, ModStoreManifest } from '../types/mod-store';
+import { FSAPI, InjectionTokens } from '../util/apis';
+import { detectOS } from '../util/detect-os';
+import { LogLevel } from '../util/logger';
+import { LoggerFactory } from './loggerfactory';
+import { Paths } from './paths';
+
+/**
+ * Content addressed store for mod files.
+ *
+ * Workshop mods are ingested into `objects/<hash>` once per distinct content, so identical files of different mods are only stored once.
+ * Deployments hardlink the objects into the server folder and only touch files whose content changed.
+ */
+@singleton()
+@injectable()
+export class ModStore extends IService {
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private manager: Manager,
+        private paths: Paths,
+        @inject(InjectionTokens.fs) private fs: FSAPI,
+    ) {
+        super(loggerFactory.createLogger('ModStore'));
+    }
+
+    public getStorePath(): string {
+        let storePath = this.manager.config?.modStorePath || 'modstore';
+        if (!this.paths.isAbsolute(storePath)) {
+            storePath = path.join(this.paths.sharedCwd(), storePath);
+        }
+        return storePath;
+    }
+
+    private getObjectPath(hash: string): string {
+        return path.join(this.getStorePath(), 'objects', hash.slice(0, 2), hash);
+    }
+
+    private getManifestPath(modId: string): string {
+        return path.join(this.getStorePath(), 'manifests', `${modId}.json`);
+    }
+
+    public readManifest(modId: string): ModStoreManifest | undefined {
+        try {
+            return JSON.parse(this.fs.readFileSync(this.getManifestPath(modId)) + '');
+        } catch {
+            return undefined;
+        }
+    }
+
+    private writeAtomic(file: string, write: (tmp: string) => void): void {
+        const tmp = `${file}.${process.pid}.${Math.floor(Math.random() * 1_000_000)}.tmp`;
+        this.fs.mkdirSync(path.dirname(file), { recursive: true });
+        write(tmp);
+        this.fs.renameSync(tmp, file);
+    }
+
+    /**
+     * @returns the files in the dir relative to it with forward slashes
+     */
+    private async listFiles(dir: string, prefix: string = ''): Promise<string[]> {
+        const files: string[] = [];
+        for (const entry of await this.fs.promises.readdir(dir)) {
+            const name = `${entry}`;
+            const stat = await this.fs.promises.lstat(path.join(dir, name));
+            if (stat.isDirectory()) {
+                files.push(...await this.listFiles(path.join(dir, name), `${prefix}${name}/`));
+            } else {
+                files.push(`${prefix}${name}`);
+            }
+        }
+        return files;
+    }
+
+    private hashFile(file: string): Promise<string> {
+        return new Promise<string>((res, rej) => {
+            const hash = crypto.createHash('sha256');
+            this.fs.createReadStream(file)
+                .on('error', rej)
+                .on('data', (chunk) => hash.update(chunk))
+                .on('end', () => res(hash.digest('hex')));
+        });
+    }
+
+    /**
+     * Adds the files of a mod to the store.
+     * Files with the same size and mtime as on the last ingest are not hashed again.
+     * File names are lowercased on linux, so the deployed mod does not need to be renamed.
+     *
+     * @param modId the mod id
+     * @param sourceDir the workshop dir of the mod
+     */
+    public async ingest(modId: string, sourceDir: string): Promise<ModStoreIngestResult> {
+        const lowerCase = detectOS() !== 'windows';
+        const previous = this.readManifest(modId);
+        const result: ModStoreIngestResult = { files: 0, hashed: 0, totalBytes: 0, storedBytes: 0 };
+        const files: Record<string, ModStoreFile> = {};
+
+        for (const file of await this.listFiles(sourceDir)) {
+            const source = path.join(sourceDir, file);
+            const stat = await this.fs.promises.stat(source);
+            const rel = lowerCase ? file.toLowerCase() : file;
+
+            const known = previous?.files[rel];
+            let hash = (known?.size === stat.size && known?.mtime === stat.mtimeMs) ? known.hash : undefined;
+            if (!hash || !this.fs.existsSync(this.getObjectPath(hash))) {
+                hash = await this.hashFile(source);
+                result.hashed++;
+                const object = this.getObjectPath(hash);
+                if (!this.fs.existsSync(object)) {
+                    this.writeAtomic(object, (tmp) => this.fs.copyFileSync(source, tmp));
+                    result.storedBytes += stat.size;
+                }
+            }
+
+            files[rel] = { hash, size: stat.size, mtime: stat.mtimeMs };
+            result.files++;
+            result.totalBytes += stat.size;
+        }
+
+        this.writeAtomic(
+            this.getManifestPath(modId),
+            (tmp) => this.fs.writeFileSync(tmp, JSON.stringify({ modId, files } as ModStoreManifest)),
+        );
+
+        return result;
+    }
+
+    private sameFile(file1: string, file2: string): boolean {
+        const stat1 = this.fs.statSync(file1);
+        const stat2 = this.fs.statSync(file2);
+        return stat1.ino === stat2.ino && stat1.dev === stat2.dev;
+    }
+
+    private async removeEmptyDirs(dir: string, isRoot: boolean = true): Promise<void> {
+        for (const entry of await this.fs.promises.readdir(dir)) {
+            const child = path.join(dir, `${entry}`);
+            if ((await this.fs.promises.lstat(child)).isDirectory()) {
+                await this.removeEmptyDirs(child, false);
+            }
+        }
+        if (!isRoot && !(await this.fs.promises.readdir(dir)).length) {
+            await this.fs.promises.rmdir(dir);
+        }
+    }
+
+    /**
+     * Makes the target dir match the last ingested state of the mod.
+     * Files already linked to the right object are kept, all others are (re)linked and files not part of the mod are removed.
+     *
+     * @param modId the mod id
+     * @param targetDir the mod dir in the server folder
+     */
+    public async deploy(modId: string, targetDir: string): Promise<ModStoreDeployResult> {
+        const manifest = this.readManifest(modId);
+        if (!manifest) {
+            throw new Error(`Mod ${modId} was not ingested`);
+        }
+
+        // links and files from other install methods are replaced
+        if (this.fs.existsSync(targetDir) && !this.fs.lstatSync(targetDir).isDirectory()) {
+            if (!this.paths.removeLink(targetDir)) {
+                throw new Error(`Could not remove ${targetDir}`);
+            }
+        }
+        this.fs.mkdirSync(targetDir, { recursive: true });
+
+        const result: ModStoreDeployResult = { linked: 0, copied: 0, unchanged: 0, removed: 0 };
+        const existing = new Set(await this.listFiles(targetDir));
+        let canLink = true;
+
+        for (const [rel, file] of Object.entries(manifest.files)) {
+            const target = path.join(targetDir, rel);
+            const object = this.getObjectPath(file.hash);
+
+            if (existing.delete(rel)) {
+                if (
+                    this.sameFile(target, object)
+                    || (
+                        !canLink
+                        && this.fs.statSync(target).size === file.size
+                        && await this.hashFile(target) === file.hash
+                    )
+                ) {
+                    result.unchanged++;
+                    continue;
+                }
+                this.fs.unlinkSync(target);
+            }
+
+            this.fs.mkdirSync(path.dirname(target), { recursive: true });
+            if (canLink) {
+                try {
+                    this.fs.linkSync(object, target);
+                    result.linked++;
+                    continue;
+                } catch (e) {
+                    this.log.log(LogLevel.WARN, `Could not hardlink mod files (${e?.code ?? e?.message}), copying them instead`);
+                    canLink = false;
+                }
+            }
+            this.fs.copyFileSync(object, target);
+            result.copied++;
+        }
+
+        for (const rel of existing) {
+            this.fs.unlinkSync(path.join(targetDir, rel));
+            result.removed++;
+        }
+        await this.removeEmptyDirs(targetDir);
+
+        return result;
+    }
+
+    /**
+     * Removes the manifests of other mods and all objects which are not referenced anymore.
+     * Skipped if the store is shared by multiple server instances, because the mods of the other instances are unknown.
+     * @param modIds the mods to keep
+     * @returns the freed bytes
+     */
+    public async prune(modIds: string[]): Promise<number> {
+        if (this.paths.hasSharedCwd()) {
+            this.log.log(LogLevel.DEBUG, 'Not pruning the mod store, because it is shared by multiple instances');
+            return 0;
+        }
+
+        const manifestsDir = path.join(this.getStorePath(), 'manifests');
+        const objectsDir = path.join(this.getStorePath(), 'objects');
+        if (!this.fs.existsSync(manifestsDir) || !this.fs.existsSync(objectsDir)) {
+            return 0;
+        }
+
+        const referenced = new Set<string>();
+        for (const entry of await this.fs.promises.readdir(manifestsDir)) {
+            const modId = path.basename(`${entry}`, '.json');
+            if (!modIds.includes(modId)) {
+                await this.fs.promises.unlink(path.join(manifestsDir, `${entry}`));
+                continue;
+            }
+            Object.values(this.readManifest(modId)?.files ?? {})
+                .forEach((x) => referenced.add(x.hash));
+        }
+
+        let freed = 0;
+        for (const object of await this.listFiles(objectsDir)) {
+            if (!referenced.has(path.basename(object))) {
+                const objectPath = path.join(objectsDir, object);
+                freed += (await this.fs.promises.stat(objectPath)).size;
+                await this.fs.promises.unlink(objectPath);
+            }
+        }
+        await this.removeEmptyDirs(objectsDir);
+
+        if (freed) {
+            this.log.log(LogLevel.INFO, `Removed ${freed} bytes of unused mod files`);
+        }
+        return freed;
+    }
+
+}
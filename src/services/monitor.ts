@@ -13,6 +13,7 @@ import { ServerStarter } from './server-starter';
 import { ServerDetector } from './server-detector';
 import { SteamCMD } from '../services/steamcmd';
 import { DiscordEventConverter } from '../services/discord-event-converter';
+import { Histogram, instanceLabels, instrumentation, TIMER_CALLBACK_DURATION } from '../util/instrumentation';
 
 export type ServerStateListener = (state: ServerState) => any;
 
@@ -23,6 +24,7 @@ export class Monitor extends IStatefulService {
     public loopInterval = 500;
     private tickRunning = false;
     private lastTick = 0;
+    private tickDuration: Histogram;
     private modUpdateCheckerRunning = false;
     private lastModUpdateChecker = 0;
 
@@ -102,6 +104,10 @@ export class Monitor extends IStatefulService {
         if (!this.timers.getTimer('tick')){
             this.lastTick = 0;
             this.tickRunning = false;
+            this.tickDuration = instrumentation.histogram(
+                TIMER_CALLBACK_DURATION,
+                instanceLabels(this.manager.instanceName, { service: 'Monitor', timer: 'tick' }),
+            );
             this.timers.addInterval(
                 'tick',
                 () => {
@@ -122,7 +128,7 @@ export class Monitor extends IStatefulService {
                                 new Date().valueOf(),
                             );
                         };
-                        this.tick().then(cb, cb);
+                        this.tickDuration.time(() => this.tick()).then(cb, cb);
                     }
                 },
                 this.loopInterval,
@@ -35,6 +35,7 @@ export const copySync = (fs: FSAPI, source: string, target: string): void => {
 export class Paths extends IService {
 
     private workingDir: string = process.cwd();
+    private sharedDir: string | undefined;
 
     public constructor(
         loggerFactory: LoggerFactory,
@@ -54,6 +55,25 @@ export class Paths extends IService {
         return this.resolve(this.workingDir);
     }
 
+    /**
+     * Base dir of the files shared by all server instances (SteamCMD, workshop downloads, mod store, metrics).
+     * It is the working dir, unless the manager runs multiple instances.
+     */
+    public setSharedCwd(sharedDir: string): void {
+        this.sharedDir = sharedDir;
+    }
+
+    public sharedCwd(): string {
+        return this.sharedDir ? this.resolve(this.sharedDir) : this.cwd();
+    }
+
+    /**
+     * @returns whether the shared files are used by other server instances as well
+     */
+    public hasSharedCwd(): boolean {
+        return !!this.sharedDir;
+    }
+
     /* istanbul ignore next */
     public resolve(...parts: string[]): string {
         if (this.isAbsolute(parts[0])) {
@@ -6,7 +6,7 @@ import { merge } from '../util/merge';
 import { Paths } from './paths';
 import * as ps from '@senfo/process-list';
 import { inject, injectable, singleton } from 'tsyringe';
-import { CHILDPROCESSAPI, InjectionTokens, PTYAPI } from '../util/apis';
+import { CHILDPROCESSAPI, FSAPI, InjectionTokens, PTYAPI } from '../util/apis';
 import { IService } from '../types/service';
 import { LoggerFactory } from './loggerfactory';
 
@@ -24,6 +24,10 @@ export class ProcessEntry {
     public CreationDate: string = '';
     public UserModeTime: string = '';
     public KernelModeTime: string = '';
+
+    // not initialized, so it is not requested from wmic
+    /** time the entry was sampled at (used to calculate usages between samples) */
+    public SampledAt?: number;
     /* eslint-enable @typescript-eslint/naming-convention */
 
 }
@@ -302,6 +306,7 @@ export class WindowsProcessFetcher extends IService implements IProcessFetcher {
                 dontThrow: true,
             },
         );
+        const sampledAt = new Date().valueOf();
         const procs: ProcessEntry[] = [];
         if (result.stdout) {
             procs.push(
@@ -321,6 +326,7 @@ export class WindowsProcessFetcher extends IService implements IProcessFetcher {
                     .map((x: string[][]) => {
                         let proc = new ProcessEntry();
                         x.forEach((y) => proc = merge(proc, { [y[0]]: y[1] }));
+                        proc.SampledAt = sampledAt;
                         return proc;
                     })
                     .filter((x) => this.paths.samePath(x?.ExecutablePath, exeName)),
@@ -331,6 +337,134 @@ export class WindowsProcessFetcher extends IService implements IProcessFetcher {
 
 }
 
+/**
+ * Reads processes directly from /proc instead of taking a snapshot of all processes
+ */
+@singleton()
+@injectable()
+export class LinuxProcessFetcher extends IService implements IProcessFetcher {
+
+    /** USER_HZ, which is 100 on all common architectures */
+    public static readonly CLOCK_TICKS = 100;
+
+    private bootTime: number | undefined;
+
+    public constructor(
+        loggerFactory: LoggerFactory,
+        private paths: Paths,
+        @inject(InjectionTokens.fs) private fs: FSAPI,
+    ) {
+        super(loggerFactory.createLogger('LinuxProcesses'));
+    }
+
+    public isSupported(): boolean {
+        return this.fs.existsSync('/proc/stat');
+    }
+
+    private async getBootTime(): Promise<number> {
+        if (this.bootTime === undefined) {
+            const stat = await this.fs.promises.readFile('/proc/stat', { encoding: 'utf-8' });
+            this.bootTime = Number(/^btime\s+(\d+)/m.exec(stat)?.[1] ?? 0) * 1000;
+        }
+        return this.bootTime;
+    }
+
+    private async getExecutablePath(pid: string): Promise<string> {
+        try {
+            // the binary might have been replaced (i.e. updated) while the process runs
+            return (await this.fs.promises.readlink(`/proc/${pid}/exe`) as string).replace(/ \(deleted\)$/, '');
+        } catch {
+            // process is gone or belongs to another user
+            return '';
+        }
+    }
+
+    private formatCreationDate(ts: number): string {
+        const date = new Date(ts);
+        return [
+            date.getFullYear(),
+            date.getMonth() + 1,
+            date.getDate(),
+            date.getHours(),
+            date.getMinutes(),
+            date.getSeconds(),
+        ]
+            .map((x) => String(x).padStart(2, '0'))
+            .join('');
+    }
+
+    /**
+     * Samples a single process
+     * @param pid the process id
+     * @returns the process or undefined if it does not exist (anymore)
+     */
+    public async getProcess(pid: string): Promise<ProcessEntry | undefined> {
+        let stat: string;
+        let status: string;
+        try {
+            [stat, status] = await Promise.all([
+                this.fs.promises.readFile(`/proc/${pid}/stat`, { encoding: 'utf-8' }) as Promise<string>,
+                this.fs.promises.readFile(`/proc/${pid}/status`, { encoding: 'utf-8' }) as Promise<string>,
+            ]);
+        } catch {
+            return undefined;
+        }
+        const sampledAt = new Date().valueOf();
+
+        // the name might contain spaces and parentheses, so the fields are read after the last ')'
+        const fields = stat.slice(stat.lastIndexOf(')') + 2).split(' ');
+        const ticksTo100ns = 10_000_000 / LinuxProcessFetcher.CLOCK_TICKS;
+        // fields (after pid and comm) start with state (3), utime is 14, stime 15, starttime 22
+        const utime = Number(fields[11]);
+        const stime = Number(fields[12]);
+        const startTime = Number(fields[19]);
+
+        const statusValue = (key: string): string | undefined => new RegExp(`^${key}:\\s*(.*)$`, 'm').exec(status)?.[1]?.trim();
+        const memKb = parseInt(statusValue('RssAnon') ?? statusValue('VmRSS') ?? '0', 10);
+
+        const [executablePath, cmdline] = await Promise.all([
+            this.getExecutablePath(pid),
+            (this.fs.promises.readFile(`/proc/${pid}/cmdline`, { encoding: 'utf-8' }) as Promise<string>)
+                .catch(/* istanbul ignore next */ () => ''),
+        ]);
+
+        const proc = new ProcessEntry();
+        /* eslint-disable @typescript-eslint/naming-convention */
+        proc.Name = statusValue('Name') ?? stat.slice(stat.indexOf('(') + 1, stat.lastIndexOf(')'));
+        proc.ProcessId = String(pid);
+        proc.ExecutablePath = executablePath;
+        proc.CommandLine = cmdline.replace(/\0+$/, '').split('\0').join(' ');
+        proc.PrivatePageCount = String(memKb * 1024);
+        proc.CreationDate = this.formatCreationDate(
+            (await this.getBootTime()) + (startTime * 1000 / LinuxProcessFetcher.CLOCK_TICKS),
+        );
+        proc.UserModeTime = String(utime * ticksTo100ns);
+        proc.KernelModeTime = String(stime * ticksTo100ns);
+        proc.SampledAt = sampledAt;
+        /* eslint-enable @typescript-eslint/naming-convention */
+        return proc;
+    }
+
+    public async getProcessList(exeName?: string): Promise<ProcessEntry[]> {
+        const pids = (await this.fs.promises.readdir('/proc') as string[])
+            .filter((x) => /^\d+$/.test(x));
+
+        const procs: ProcessEntry[] = [];
+        for (const pid of pids) {
+            // only resolve the executable first, which is all that is needed to filter
+            const executablePath = await this.getExecutablePath(pid);
+            if (executablePath && (!exeName || this.paths.samePath(executablePath, exeName))) {
+                const proc = await this.getProcess(pid);
+                if (proc) {
+                    procs.push(proc);
+                }
+            }
+        }
+        return procs;
+    }
+
+}
+
 @singleton()
 @injectable()
 export class Processes extends IService implements IProcessSpawner, IProcessFetcher {
@@ -339,6 +473,7 @@ export class Processes extends IService implements IProcessSpawner, IProcessFetc
         loggerFactory: LoggerFactory,
         private spawner: ProcessSpawner,
         private windowsProcessFetcher: WindowsProcessFetcher,
+        private linuxProcessFetcher: LinuxProcessFetcher,
         private paths: Paths,
     ) {
         super(loggerFactory.createLogger('Processes'));
@@ -351,6 +486,10 @@ export class Processes extends IService implements IProcessSpawner, IProcessFetc
             return this.windowsProcessFetcher.getProcessList(exeName);
         }
 
+        if (this.linuxProcessFetcher.isSupported()) {
+            return this.linuxProcessFetcher.getProcessList(exeName);
+        }
+
         const snapshot = await ps.snapshot();
         return snapshot
             .map(
@@ -372,6 +511,20 @@ export class Processes extends IService implements IProcessSpawner, IProcessFetc
             .filter(/* istanbul ignore next */ (x) => this.paths.samePath(x?.ExecutablePath, exeName));
     }
 
+    /**
+     * Samples a single known process, which is a lot cheaper than listing all processes on linux
+     * @param pid the process id
+     * @param exeName the executable the process must belong to
+     * @returns the process or undefined if it does not exist (anymore)
+     */
+    public async getProcess(pid: string, exeName?: string): Promise<ProcessEntry | undefined> {
+        if (detectOS() !== 'windows' && this.linuxProcessFetcher.isSupported()) {
+            const proc = await this.linuxProcessFetcher.getProcess(pid);
+            return (proc && (!exeName || this.paths.samePath(proc.ExecutablePath, exeName))) ? proc : undefined;
+        }
+        return (await this.getProcessList(exeName)).find((x) => x.ProcessId === pid);
+    }
+
     public getProcessCPUSpent(proc: ProcessEntry): number {
         return (Number(proc.UserModeTime) / 10000)
         + (Number(proc.KernelModeTime) / 10000);
@@ -384,13 +537,19 @@ export class Processes extends IService implements IProcessSpawner, IProcessFetc
         return (now - start);
     }
 
+    /**
+     * @param proc the process sample
+     * @param prev a previous sample of the same process, if given the usage between both samples is returned
+     * @returns the cpu usage in percent of all cpus (average since the start of the process if there is no previous sample)
+     */
     public getProcessCPUUsage(proc: ProcessEntry, prev?: ProcessEntry): number {
         let curSpent = this.getProcessCPUSpent(proc);
         let curUp = this.getProcessUptime(proc);
 
-        if (prev) {
-            curSpent -= this.getProcessCPUSpent(proc);
-            curUp -= this.getProcessUptime(proc);
+        if (prev && prev.ProcessId === proc.ProcessId) {
+            const now = new Date().valueOf();
+            curSpent -= this.getProcessCPUSpent(prev);
+            curUp = (proc.SampledAt ?? now) - (prev.SampledAt ?? now);
         }
 
         return Math.round(
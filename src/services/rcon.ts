@@ -13,6 +13,15 @@ import { FSAPI, InjectionTokens, RCONSOCKETFACTORY } from '../util/apis';
 import { EventBus } from '../control/event-bus';
 import { InternalEventTypes } from '../types/events';
 import { Listener } from 'eventemitter2';
+import { CommandOptions, CommandPriority, CommandScheduler, CommandStats, CommandTimeoutError } from '../util/command-scheduler';
+import { Config } from '../config/config';
+import { instanceLabels, instrumentation, RCON_COMMAND_DURATION } from '../util/instrumentation';
+
+const PLAYER_CONNECTED_REGEX = /^Player #(\d+) (.+) \(([\d.]+):(\d+)\) connected$/;
+const PLAYER_GUID_REGEX = /^Player #(\d+) (.+) - (?:BE )?GUID: ([0-9a-fA-F]+)/;
+const PLAYER_VERIFIED_GUID_REGEX = /^Verified GUID \(([0-9a-fA-F]+)\) of player #(\d+) (.+)$/;
+const PLAYER_DISCONNECTED_REGEX = /^Player #(\d+) (.+) disconnected$/;
+const PLAYER_KICKED_REGEX = /^Player #(\d+) .* has been kicked by BattlEye/;
 
 export class BattleyeConf {
 
@@ -33,6 +42,8 @@ export class BattleyeConf {
 @injectable()
 export class RCON extends IStatefulService {
 
+    public readonly configKeys: (keyof Config)[] = ['rconPassword', 'rconPort'];
+
     private readonly RND_RCON_PW: string = `RCON${Math.floor(Math.random() * 100000)}`;
 
     private socket: Socket | undefined;
@@ -47,6 +58,25 @@ export class RCON extends IStatefulService {
 
     private stateListener?: Listener;
 
+    /** all commands go through here, so admin actions are not stuck behind polls */
+    private commands = new CommandScheduler<IPacketResponse>(
+        (command) => instrumentation.time(
+            RCON_COMMAND_DURATION,
+            instanceLabels(this.manager.instanceName, { command: command.trim().split(/\s+/)[0] || command }),
+            () => this.connection.command(command),
+        ),
+    );
+
+    /** ms until a command without a response is given up */
+    public commandTimeout: number = 10000;
+
+    /** live player list, updated from the battleye messages and reconciled periodically */
+    private roster = new Map<string, RconPlayer>();
+    private rosterSynced: boolean = false;
+    /** ids of players changed by messages and the roster version of the change, so a reconcile does not revert newer changes */
+    private rosterChanges = new Map<string, number>();
+    private rosterVersion: number = 0;
+
     public constructor(
         loggerFactory: LoggerFactory,
         private manager: Manager,
@@ -149,6 +179,9 @@ export class RCON extends IStatefulService {
 
         this.connection.on('message', (message /* , packet */) => {
 
+            // roster updates are idempotent, so they are applied before the duplicate check
+            this.updateRoster(message);
+
             if (this.duplicateMessageCache.includes(message)) {
                 this.log.log(LogLevel.DEBUG, `duplicate message`, message);
                 return;
@@ -159,7 +192,7 @@ export class RCON extends IStatefulService {
             }
 
             this.log.log(LogLevel.DEBUG, `message`, message);
-            if(!message.includes('discord.gg')){
+            if(!message?.includes('discord.gg')){
                 this.eventBus.emit(
                     InternalEventTypes.DISCORD_MESSAGE,
                     {
@@ -182,6 +215,8 @@ export class RCON extends IStatefulService {
             }
             this.connected = false;
             this.duplicateMessageCache = [];
+            this.timers.removeTimer('reconcilePlayers');
+            this.clearRoster();
         });
 
         this.connection.on('debug', (data) => {
@@ -219,6 +254,13 @@ export class RCON extends IStatefulService {
                 this.connected = true;
                 this.log.log(LogLevel.IMPORTANT, 'connected');
                 void this.sendCommand('say -1 SWT admin CONNECTED.');
+                void this.reconcilePlayers();
+                this.timers.removeTimer('reconcilePlayers');
+                this.timers.addInterval(
+                    'reconcilePlayers',
+                    /* istanbul ignore next */ () => this.reconcilePlayers(),
+                    this.manager.config?.rconPlayerReconcileInterval || 60000,
+                );
             }
         });
     }
@@ -274,7 +316,7 @@ export class RCON extends IStatefulService {
         );
     }
 
-    private async sendCommand(command: string): Promise<string | null> {
+    private async sendCommand(command: string, options?: CommandOptions): Promise<string | null> {
 
         if (!this.connection || !this.connected) {
             return null;
@@ -282,10 +324,12 @@ export class RCON extends IStatefulService {
 
         let response: IPacketResponse = null;
         try {
-            response = await this.connection.command(command);
+            response = await this.commands.schedule(command, { timeout: this.commandTimeout, ...options });
             this.log.log(LogLevel.DEBUG, `response to ${response.command}:\n${response.data}`);
         } catch (e) {
-            if (typeof e === 'object' && (e?.message as string)?.includes('Server connection timed out')) {
+            if (e instanceof CommandTimeoutError) {
+                this.log.log(LogLevel.WARN, `Error while executing RCON command: ${e.message}`);
+            } else if (typeof e === 'object' && (e?.message as string)?.includes('Server connection timed out')) {
                 this.log.log(LogLevel.ERROR, 'Error while executing RCON command: Server connection timed out');
             } else if (
                 typeof e === 'object'
@@ -304,9 +348,19 @@ export class RCON extends IStatefulService {
 
     }
 
+    /**
+     * @returns the count, errors, timeouts and latencies of the sent commands per command verb
+     */
+    public getCommandStats(): Record<string, CommandStats> {
+        return this.commands.getCommandStats();
+    }
+
     public async stop(): Promise<void> {
         this.stateListener?.off();
         this.stateListener = undefined;
+        this.timers.removeAllTimers();
+        this.clearRoster();
+        this.commands.clear(new Error('RCON stopped'));
 
         if (this.connection) {
 
@@ -340,7 +394,7 @@ export class RCON extends IStatefulService {
     }
 
     public async getBansRaw(): Promise<string | null> {
-        return this.sendCommand('bans');
+        return this.sendCommand('bans', { priority: CommandPriority.LOW, coalesce: true });
     }
 
     public async getBans(): Promise<RconBan[]> {
@@ -380,17 +434,10 @@ export class RCON extends IStatefulService {
     }
 
     public async getPlayersRaw(): Promise<string | null> {
-        return this.sendCommand('players');
+        return this.sendCommand('players', { priority: CommandPriority.LOW, coalesce: true });
     }
 
-    public async getPlayers(): Promise<RconPlayer[]> {
-
-        const data = await this.getPlayersRaw();
-
-        if (!data) {
-            return [];
-        }
-
+    private parsePlayers(data: string): RconPlayer[] {
         return matchRegex(
             /(\d+)\s+(\b\d{1,3}\.\d{1,3}\.\d{1,3}\.\d{1,3}):(\d+\b)\s+(\d+)\s+([0-9a-fA-F]+)\(\w+\)\s([\S ]+)$/gim,
             data,
@@ -408,8 +455,110 @@ export class RCON extends IStatefulService {
             }) ?? [];
     }
 
+    private clearRoster(): void {
+        this.roster.clear();
+        this.rosterChanges.clear();
+        this.rosterSynced = false;
+    }
+
+    private copyRoster(): RconPlayer[] {
+        return [...this.roster.values()].map((x) => ({ ...x }));
+    }
+
+    private setRosterPlayer(id: string, player?: RconPlayer): void {
+        if (player) {
+            this.roster.set(id, player);
+        } else {
+            this.roster.delete(id);
+        }
+        this.rosterChanges.set(id, ++this.rosterVersion);
+    }
+
+    /**
+     * Applies player connect, guid, disconnect and kick messages to the roster
+     * @param message the battleye message
+     */
+    private updateRoster(message: string): void {
+        const msg = message?.trim();
+        if (!msg) {
+            return;
+        }
+
+        let match = PLAYER_CONNECTED_REGEX.exec(msg);
+        if (match) {
+            this.setRosterPlayer(match[1], {
+                id: match[1],
+                name: match[2],
+                ip: match[3],
+                port: match[4],
+                ping: '',
+                beguid: '',
+                lobby: true,
+            });
+            return;
+        }
+
+        match = PLAYER_GUID_REGEX.exec(msg);
+        const verified = PLAYER_VERIFIED_GUID_REGEX.exec(msg);
+        if (match || verified) {
+            const id = match ? match[1] : verified[2];
+            const player = this.roster.get(id);
+            if (player) {
+                this.setRosterPlayer(id, {
+                    ...player,
+                    beguid: match ? match[3] : verified[1],
+                });
+            }
+            return;
+        }
+
+        match = PLAYER_DISCONNECTED_REGEX.exec(msg) ?? PLAYER_KICKED_REGEX.exec(msg);
+        if (match) {
+            this.setRosterPlayer(match[1]);
+        }
+    }
+
+    /**
+     * Replaces the roster with the result of the 'players' command.
+     * Players changed by messages while the command was running keep their state from the messages.
+     */
+    public async reconcilePlayers(): Promise<RconPlayer[]> {
+        const requestedVersion = this.rosterVersion;
+        const data = await this.getPlayersRaw();
+        if (data === null) {
+            return this.copyRoster();
+        }
+
+        const roster = new Map(this.parsePlayers(data).map((x) => [x.id, x]));
+        for (const [id, changedAt] of [...this.rosterChanges]) {
+            if (changedAt <= requestedVersion) {
+                this.rosterChanges.delete(id);
+            } else if (this.roster.has(id)) {
+                roster.set(id, this.roster.get(id));
+            } else {
+                roster.delete(id);
+            }
+        }
+        this.roster = roster;
+        this.rosterSynced = true;
+        return this.copyRoster();
+    }
+
+    /**
+     * @returns the current players from memory (the roster is only fetched if it was not synced yet)
+     */
+    public async getPlayers(): Promise<RconPlayer[]> {
+        if (!this.connected) {
+            return [];
+        }
+        if (!this.rosterSynced) {
+            return this.reconcilePlayers();
+        }
+        return this.copyRoster();
+    }
+
     public async kick(player: string): Promise<void> {
-        await this.sendCommand(`kick ${player}`);
+        await this.sendCommand(`kick ${player}`, { priority: CommandPriority.HIGH });
     }
 
     public async kickAll(): Promise<void> {
@@ -421,11 +570,11 @@ export class RCON extends IStatefulService {
     }
 
     public async ban(player: string): Promise<void> {
-        await this.sendCommand(`ban ${player}`);
+        await this.sendCommand(`ban ${player}`, { priority: CommandPriority.HIGH });
     }
 
     public async removeBan(player: string): Promise<void> {
-        await this.sendCommand(`removeban ${player}`);
+        await this.sendCommand(`removeban ${player}`, { priority: CommandPriority.HIGH });
     }
 
     public async reloadBans(): Promise<void> {
@@ -433,7 +582,7 @@ export class RCON extends IStatefulService {
     }
 
     public async shutdown(): Promise<void> {
-        await this.sendCommand('#shutdown');
+        await this.sendCommand('#shutdown', { priority: CommandPriority.HIGH });
     }
 
     public async global(message: string): Promise<void> {
@@ -443,11 +592,11 @@ export class RCON extends IStatefulService {
     }
 
     public async lock(): Promise<void> {
-        await this.sendCommand('#lock');
+        await this.sendCommand('#lock', { priority: CommandPriority.HIGH });
     }
 
     public async unlock(): Promise<void> {
-        await this.sendCommand('#unlock');
+        await this.sendCommand('#unlock', { priority: CommandPriority.HIGH });
     }
 
 }
@@ -10,6 +10,7 @@ import { LoggerFactory } from './loggerfactory';
 export class ServerDetector extends IService {
 
     private lastServerCheckResult?: { ts: number; result: ProcessEntry[] };
+    private knownPid?: string;
 
     public constructor(
         loggerFactory: LoggerFactory,
@@ -24,15 +25,7 @@ export class ServerDetector extends IService {
         if (this.lastServerCheckResult?.ts && (new Date().valueOf() - this.lastServerCheckResult?.ts) < 1000) {
             processList = this.lastServerCheckResult.result;
         } else {
-            processList = await this.processes.getProcessList(
-                this.manager.getServerExePath(),
-            );
-
-            this.log.log(
-                LogLevel.DEBUG,
-                'Fetched new Process list',
-                processList,
-            );
+            processList = await this.fetchDayZProcesses();
 
             this.lastServerCheckResult = {
                 ts: new Date().valueOf(),
@@ -58,6 +51,32 @@ export class ServerDetector extends IService {
             });
     }
 
+    /**
+     * Samples the known server process directly and only lists all processes if it is unknown or gone
+     */
+    private async fetchDayZProcesses(): Promise<ProcessEntry[]> {
+        const exePath = this.manager.getServerExePath();
+        if (this.knownPid) {
+            const proc = await this.processes.getProcess(this.knownPid, exePath);
+            if (proc) {
+                return [proc];
+            }
+            this.log.log(LogLevel.DEBUG, `Server process ${this.knownPid} is gone`);
+            this.knownPid = undefined;
+        }
+
+        const processList = await this.processes.getProcessList(exePath);
+        this.knownPid = processList[0]?.ProcessId || undefined;
+
+        this.log.log(
+            LogLevel.DEBUG,
+            'Fetched new Process list',
+            processList,
+        );
+
+        return processList;
+    }
+
     public async isServerRunning(): Promise<boolean> {
         const processes = await this.getDayZProcesses();
 
@@ -132,7 +132,8 @@ export class ServerStarter extends IService {
 
         // Mods
         if (!await this.steamCmd.checkMods() || this.manager.config.updateModsBeforeServerStart) {
-            if (!await this.steamCmd.updateAllMods()) {
+            // mods are installed as soon as their batch is downloaded
+            if (!await this.steamCmd.updateAllMods({ install: true })) {
                 throw new Error('Mod update failed');
             }
         }
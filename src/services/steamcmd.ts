@@ -12,8 +12,9 @@ import { FSAPI, HTTPSAPI, InjectionTokens } from '../util/apis';
 import { Downloader } from './download';
 import { merge } from '../util/merge';
 import { request } from '../util/request';
-import { DAYZ_APP_ID, DAYZ_EXPERIMENTAL_SERVER_APP_ID, DAYZ_SERVER_APP_ID, LocalMetaData, PublishedFileDetail, SteamApiWorkshopItemDetailsResponse, SteamCmdAppUpdateProgressEvent, SteamCmdEvent, SteamCmdEventListener, SteamCmdExitEvent, SteamCmdModUpdateProgressEvent, SteamCmdOutputEvent, SteamCmdRetryEvent, SteamExitCodes } from '../types/steamcmd';
+import { DAYZ_APP_ID, DAYZ_EXPERIMENTAL_SERVER_APP_ID, DAYZ_SERVER_APP_ID, LocalMetaData, ModUpdatePipelineStats, PublishedFileDetail, SteamApiWorkshopItemDetailsResponse, SteamCmdAppUpdateProgressEvent, SteamCmdEvent, SteamCmdEventListener, SteamCmdExitEvent, SteamCmdModUpdateProgressEvent, SteamCmdOutputEvent, SteamCmdRetryEvent, SteamExitCodes } from '../types/steamcmd';
 import { EventBus } from '../control/event-bus';
+import { ModStore } from './mod-store';
 import { InternalEventTypes } from '../types/events';
 
 @singleton()
@@ -38,7 +39,7 @@ export class SteamMetaData extends IService {
     private getMetaDataPath(): string {
         let metaFolder = this.manager.config?.steamMetaPath ?? '';
         if (!this.paths.isAbsolute(metaFolder)) {
-            metaFolder = path.join(this.paths.cwd(), metaFolder);
+            metaFolder = path.join(this.paths.sharedCwd(), metaFolder);
         }
         return metaFolder;
     }
@@ -160,6 +161,46 @@ export class SteamMetaData extends IService {
 
 }
 
+/**
+ * Coordinates the SteamCMD calls per installation, which is shared by the server instances of a manager.
+ *
+ * Every call runs alone on its installation, parallel calls would overwrite each other's state files
+ * (e.g. the workshop state in appworkshop_221100.acf, which would lose updates or force re-downloads).
+ * Calls start in order, calls on other installations are independent.
+ */
+@singleton()
+export class SteamCmdLock {
+
+    // installation -> released when the last queued call is done
+    private installations = new Map<string, Promise<void>>();
+
+    /**
+     * @param installation the dir of the SteamCMD installation
+     * @param fn the call
+     * @returns the result of the call
+     */
+    public async run<T>(installation: string, fn: () => Promise<T>): Promise<T> {
+        const previous = this.installations.get(installation) ?? Promise.resolve();
+        let release: () => void;
+        const done = new Promise<void>((r) => {
+            release = r;
+        });
+        const queued = previous.then(() => done);
+        this.installations.set(installation, queued);
+
+        await previous;
+        try {
+            return await fn();
+        } finally {
+            release();
+            if (this.installations.get(installation) === queued) {
+                this.installations.delete(installation);
+            }
+        }
+    }
+
+}
+
 @singleton()
 @injectable()
 export class SteamCMD extends IService {
@@ -175,6 +216,10 @@ export class SteamCMD extends IService {
     private dlItemRegex = /Downloading item (?<item>\d+) \.\.\./;
     public isNewModUpdated: boolean = false;
     public listModUpdatedID: string[];
+    /** throughput of the last mod update */
+    public lastModUpdateStats?: ModUpdatePipelineStats;
+    /** mods which were installed by the last update, so installMods can skip them */
+    private pipelineInstalledMods = new Set<string>();
     public constructor(
         loggerFactory: LoggerFactory,
         private manager: Manager,
@@ -183,6 +228,8 @@ export class SteamCMD extends IService {
         private downloader: Downloader,
         private metaData: SteamMetaData,
         private eventBus: EventBus,
+        private modStore: ModStore,
+        private lock: SteamCmdLock,
         //private monitory: Monitor,
         @inject(InjectionTokens.fs) private fs: FSAPI,
     ) {
@@ -192,7 +239,7 @@ export class SteamCMD extends IService {
     private getCmdPath(): string {
         let cmdFolder = this.manager.config?.steamCmdPath ?? '';
         if (!this.paths.isAbsolute(cmdFolder)) {
-            cmdFolder = path.join(this.paths.cwd(), cmdFolder);
+            cmdFolder = path.join(this.paths.sharedCwd(), cmdFolder);
         }
         return path.join(
             cmdFolder,
@@ -312,7 +359,7 @@ export class SteamCMD extends IService {
             // '@ShutdownOnFailedCommand 1',
             // '@NoPromptForPassword 1',
         ];
-        return this.processes.spawnForOutput(
+        return this.lock.run(this.getCmdPath(), () => this.processes.spawnForOutput(
             this.getCmdPath(),
             [...defaultCommands, ...args],
             {
@@ -332,7 +379,7 @@ export class SteamCMD extends IService {
                 pty: this.execMode === 'pty',
                 stdOutHandler: opts?.listener ? opts.listener : undefined,
             },
-        );
+        ));
     }
 
     private async execute(
@@ -501,7 +548,7 @@ export class SteamCMD extends IService {
     private getWsBasePath(): string {
         let wsPath = this.manager.config.steamWorkshopPath;
         if (!path.isAbsolute(wsPath)) {
-            wsPath = path.join(this.paths.cwd(), wsPath);
+            wsPath = path.join(this.paths.sharedCwd(), wsPath);
         }
         return wsPath;
     }
@@ -661,13 +708,42 @@ export class SteamCMD extends IService {
         return true;
     }
 
+    /**
+     * Packs the mods into as few batches as possible (first fit decreasing)
+     * @param mods the mods with their file sizes
+     * @param maxBatchSize max mods per batch
+     * @param maxDownloadSize max bytes per batch, larger mods get a batch on their own
+     */
+    public packModBatches(
+        mods: Partial<PublishedFileDetail>[],
+        maxBatchSize: number,
+        maxDownloadSize: number,
+    ): Partial<PublishedFileDetail>[][] {
+        const batches: { size: number; mods: Partial<PublishedFileDetail>[] }[] = [];
+        const bySize = [...mods].sort((a, b) => (b.file_size || 0) - (a.file_size || 0));
+        for (const mod of bySize) {
+            const size = mod.file_size || 0;
+            let batch = batches.find((x) => x.mods.length < maxBatchSize && (x.size + size) < maxDownloadSize);
+            if (!batch) {
+                batch = { size: 0, mods: [] };
+                batches.push(batch);
+            }
+            batch.mods.push(mod);
+            batch.size += size;
+        }
+        return batches.map((x) => x.mods);
+    }
+
     public async updateAllMods(opts?: {
         force?: boolean,
         validate?: boolean,
         listener?: SteamCmdEventListener,
+        /** install the mods of finished batches while the next batch is downloading */
+        install?: boolean,
     }): Promise<boolean> {
 
         this.listModUpdatedID = [];
+        this.pipelineInstalledMods.clear();
 
         const modIds = opts?.force
             ?  this.manager.getCombinedModIdList()
@@ -679,68 +755,116 @@ export class SteamCMD extends IService {
 
         this.log.log(LogLevel.INFO, `[steamcmd] updateAllMods() running...`);
 
-        // sort descending by size
-        const bySize: Partial<PublishedFileDetail>[] = modsMeta
-            .sort(
-                /* istanbul ignore next */
-                (a, b) => (b.file_size || 0) - (a.file_size || 0),
-            );
-
         // add possibly missing mods with size 0 as its unknown
-        bySize.push(...modIds
-            .filter((x) => !modsMeta.find((meta) => x === meta.publishedfileid))
-            .map(/* istanbul ignore next */ (x) => ({
-                publishedfileid: x,
-                // eslint-disable-next-line @typescript-eslint/naming-convention
-                file_size: 0,
-            }) as Partial<PublishedFileDetail>));
-
-        const maxBatchSize = this.manager.config.updateModsMaxBatchSize || 5;
-        const maxDownloadSize = this.manager.config.updateModsMaxBatchFileSize || 1_000_000_000; // ~1 GB
-        let curBatch: Partial<PublishedFileDetail>[] = [];
-        for (const mod of bySize) {
-            const curBatchFileSize = curBatch.reduce((acc, x) => acc + (x.file_size || 0), 0);
-            // if this mod would exceed the download limit, then execute the batch first
-            if (curBatch.length && (curBatchFileSize + (mod.file_size || 0)) >= maxDownloadSize) {
-                if (!await (this.updateMod(curBatch.map((x) => x.publishedfileid)))) {
-                    this.isNewModUpdated = false;
-                    return false;
-                }else{
-                    this.isNewModUpdated = true;
-                    this.listModUpdatedID = curBatch.map((x) => x.publishedfileid);
+        const mods: Partial<PublishedFileDetail>[] = [
+            ...modsMeta,
+            ...modIds
+                .filter((x) => !modsMeta.find((meta) => x === meta.publishedfileid))
+                .map((x) => ({
+                    publishedfileid: x,
+                    // eslint-disable-next-line @typescript-eslint/naming-convention
+                    file_size: 0,
+                }) as Partial<PublishedFileDetail>),
+        ];
+
+        const batches = this.packModBatches(
+            mods,
+            this.manager.config.updateModsMaxBatchSize || 5,
+            this.manager.config.updateModsMaxBatchFileSize || 1_000_000_000, // ~1 GB
+        );
+        const concurrency = Math.max(1, this.manager.config.updateModsConcurrency || 1);
+
+        const stats: ModUpdatePipelineStats = {
+            batches: batches.length,
+            download: { mods: 0, bytes: 0, duration: 0, throughput: 0 },
+            install: { mods: 0, bytes: 0, duration: 0, throughput: 0 },
+            total: 0,
+        };
+        const started = new Date().valueOf();
+        const batchSize = (batch: Partial<PublishedFileDetail>[]): number => batch.reduce((acc, x) => acc + (x.file_size || 0), 0);
+
+        let failed = false;
+        // the downloaded batches are spread over the install queues
+        const installs = Array.from({ length: concurrency }, () => Promise.resolve());
+        const install = async (batch: Partial<PublishedFileDetail>[]): Promise<void> => {
+            const installStart = new Date().valueOf();
+            for (const mod of batch) {
+                if (failed) {
+                    return;
+                }
+                const modId = mod.publishedfileid;
+                if (!await this.installMod(modId) || !await this.copyModKeys(modId)) {
+                    this.log.log(LogLevel.ERROR, `Failed to install mod: ${modId}`);
+                    failed = true;
+                    return;
                 }
-                curBatch = [];
+                this.pipelineInstalledMods.add(modId);
+                stats.install.mods++;
+                stats.install.bytes += mod.file_size || 0;
             }
-
-            curBatch.push(mod);
-
-            // check if batch is full or exceeds size limit
-            if (curBatchFileSize >= maxDownloadSize || curBatch.length >= maxBatchSize) {
-                if (!await (this.updateMod(
-                    curBatch.map((x) => x.publishedfileid),
+            stats.install.duration += new Date().valueOf() - installStart;
+        };
+
+        // download the batches one after another (they share the workshop state of the installation)
+        // and install the finished ones while the next batch is downloading
+        const download = async (): Promise<void> => {
+            for (const [i, batch] of batches.entries()) {
+                if (failed) {
+                    return;
+                }
+                const batchIds = batch.map((x) => x.publishedfileid);
+                if (!await this.updateMod(
+                    batchIds,
                     {
                         validate: opts?.validate,
                         listener: opts?.listener,
                     },
-                ))) {
-                    this.isNewModUpdated = false;
-                    return false;                    
-                }else{
-                    this.isNewModUpdated = true;
-                    this.listModUpdatedID = curBatch.map((x) => x.publishedfileid);
+                )) {
+                    failed = true;
+                    return;
+                }
+                this.listModUpdatedID.push(...batchIds);
+                stats.download.mods += batch.length;
+                stats.download.bytes += batchSize(batch);
+                stats.download.duration = new Date().valueOf() - started;
+                if (opts?.install) {
+                    installs[i % concurrency] = installs[i % concurrency].then(() => install(batch));
                 }
-                curBatch = [];
             }
+        };
+
+        if (opts?.install && batches.length) {
+            this.fs.mkdirSync(
+                path.join(this.manager.getServerPath(), 'keys'),
+                { recursive: true },
+            );
         }
-        // update the rest
-        if (curBatch.length) {
-            if (!await (this.updateMod(curBatch.map((x) => x.publishedfileid)))) {                
-                this.isNewModUpdated = false;
-                return false;
-            }else{
-                this.isNewModUpdated = true;
-                this.listModUpdatedID = curBatch.map((x) => x.publishedfileid);
-            }
+
+        await download();
+        await Promise.all(installs);
+
+        stats.total = new Date().valueOf() - started;
+        for (const stage of [stats.download, stats.install]) {
+            stage.throughput = stage.duration ? Math.round(stage.bytes / (stage.duration / 1000)) : 0;
+        }
+        this.lastModUpdateStats = stats;
+
+        if (batches.length) {
+            const mb = (bytes: number): string => (bytes / 1_000_000).toFixed(1);
+            this.log.log(
+                LogLevel.INFO,
+                `[steamcmd] updateAllMods() ${batches.length} batches in ${stats.total}ms`
+                + ` - download: ${stats.download.mods} mods, ${mb(stats.download.bytes)} MB, ${mb(stats.download.throughput)} MB/s`
+                + (opts?.install ? ` - install: ${stats.install.mods} mods in ${stats.install.duration}ms, ${mb(stats.install.throughput)} MB/s` : ''),
+            );
+        }
+
+        if (failed) {
+            this.isNewModUpdated = false;
+            return false;
+        }
+        if (this.listModUpdatedID.length) {
+            this.isNewModUpdated = true;
         }
 
         this.log.log(LogLevel.INFO, `[steamcmd] updateAllMods() isNewModUpdated = ${this.isNewModUpdated}`);
@@ -778,6 +902,21 @@ export class SteamCMD extends IService {
                 this.log.log(LogLevel.ERROR, `Linking mod (${modId}) dir failed`);
                 return false;
             }
+        } else if (this.manager.config.useModStore) {
+            // files are lowercased when they are added to the store
+            try {
+                const ingested = await this.modStore.ingest(modId, modDir);
+                const deployed = await this.modStore.deploy(modId, serverDir);
+                this.log.log(
+                    LogLevel.INFO,
+                    `Installed mod (${modId}) from store: ${ingested.hashed}/${ingested.files} files changed, `
+                    + `${deployed.linked} linked, ${deployed.copied} copied, ${deployed.unchanged} unchanged, ${deployed.removed} removed`,
+                );
+            } catch (e) {
+                this.log.log(LogLevel.ERROR, `Installing mod (${modId}) from store failed`, e);
+                return false;
+            }
+            return true;
         } else {
 
             let isUp2Date = false;
@@ -847,13 +986,19 @@ export class SteamCMD extends IService {
 
     public async installMods(): Promise<boolean> {
         this.log.log(LogLevel.INFO, `[steamcmd] installMods() running...`);
-        const modIds = this.manager.getCombinedModIdList();
+        const modIds = this.manager.getCombinedModIdList()
+            .filter((x) => !this.pipelineInstalledMods.has(x));
+        this.pipelineInstalledMods.clear();
 
         const installed = Promise.all(modIds.map((modId) => this.installMod(modId)));
         if (!await installed) {
             return false;
         }
 
+        if (this.manager.config.useModStore && !this.manager.config.linkModDirs) {
+            await this.modStore.prune(this.manager.getCombinedModIdList());
+        }
+
         this.fs.mkdirSync(
             path.join(this.manager.getServerPath(), 'keys'),
             { recursive: true },
@@ -1,4 +1,4 @@
-import { Processes } from '../services/processes';
+import { ProcessEntry, Processes } from '../services/processes';
 import { LogLevel } from '../util/logger';
 import { ServerState, SystemReport } from '../types/monitor';
 import { IService } from '../types/service';
@@ -13,6 +13,7 @@ export class SystemReporter extends IService {
 
     private prevReport: SystemReport | null = null;
     private prevReportTS: number;
+    private prevServerProcess?: ProcessEntry;
 
     public constructor(
         loggerFactory: LoggerFactory,
@@ -45,16 +46,17 @@ export class SystemReporter extends IService {
                 return Math.round((cpuBusy / (t.idle + cpuBusy)) * 100);
             });
 
+            // usages are calculated between the reports (or since the start if there is no previous one)
             let interval = busy + idle;
             let used = busy;
-            if (prevReport?.value?.system?.cpuSpent && prevReport?.value?.system?.uptime) {
-                interval -= prevReport.value.system.uptime;
-                used -= prevReport.value.system.cpuSpent;
+            if (prevReport?.system?.cpuSpent > 0 && prevReport.system.uptime < interval) {
+                interval -= prevReport.system.uptime;
+                used -= prevReport.system.cpuSpent;
             }
 
             const report = new SystemReport();
             report.system = {
-                cpuTotal: Math.round((used / interval) * 100),
+                cpuTotal: Math.round((used / Math.max(interval, 1)) * 100),
                 cpuSpent: busy,
                 uptime: busy + idle,
                 cpuEach: eachCPU,
@@ -64,33 +66,39 @@ export class SystemReporter extends IService {
 
             report.serverState = this.monitor.serverState;
 
+            // the managers own overhead in ms, relative to all cpus like the server usage
             const processCpu = process.cpuUsage();
-            const processUp = process.uptime();
+            const processSpent = (processCpu.system + processCpu.user) / 1000;
+            const processUp = process.uptime() * 1000;
 
             let processInterval = processUp;
-            let processUsed = (processCpu.system + processCpu.user) / 1000000;
-            if (prevReport?.value?.manager?.cpuSpent && prevReport?.value?.manager?.uptime) {
-                processInterval -= prevReport.value.manager.uptime;
-                processUsed -= prevReport.value.manager.cpuSpent;
+            let processUsed = processSpent;
+            if (prevReport?.manager?.cpuSpent > 0 && prevReport.manager.uptime < processUp) {
+                processInterval -= prevReport.manager.uptime;
+                processUsed -= prevReport.manager.cpuSpent;
             }
 
             report.manager = {
-                cpuTotal: Math.round((processUsed / processInterval) * 100),
-                cpuSpent: processCpu.system + processCpu.user,
+                cpuTotal: Math.round(((processUsed / Math.max(processInterval, 1)) * 100) / Math.max(system.cpu.length, 1)),
+                cpuSpent: processSpent,
                 uptime: processUp,
-                mem: Math.floor(process.memoryUsage().heapTotal / 1024 / 1024),
+                mem: Math.floor(process.memoryUsage().rss / 1024 / 1024),
             };
 
             if (this.monitor.serverState === ServerState.STARTED) {
                 const processes = await this.serverDetector.getDayZProcesses();
                 if (processes?.length) {
                     report.server = {
-                        cpuTotal: this.processes.getProcessCPUUsage(processes[0]),
+                        cpuTotal: this.processes.getProcessCPUUsage(
+                            processes[0],
+                            prevReport ? this.prevServerProcess : undefined,
+                        ),
                         cpuSpent: this.processes.getProcessCPUSpent(processes[0]),
                         uptime: this.processes.getProcessUptime(processes[0]),
                         mem: Math.floor(Number(processes[0].PrivatePageCount) / 1024 / 1024),
                     };
                 }
+                this.prevServerProcess = processes?.[0];
             }
 
             this.prevReport = report;
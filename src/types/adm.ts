@@ -0,0 +1,69 @@
+/* istanbul ignore file */
+
+/* eslint-disable no-shadow */
+export enum AdmEventTypeEnum {
+    CONNECT = 'CONNECT',
+    DISCONNECT = 'DISCONNECT',
+    HIT = 'HIT',
+    KILL = 'KILL',
+    DEATH = 'DEATH',
+    SUICIDE = 'SUICIDE',
+    UNCONSCIOUS = 'UNCONSCIOUS',
+    CONSCIOUS = 'CONSCIOUS',
+    CHAT = 'CHAT',
+    POSITION = 'POSITION',
+}
+/* eslint-enable no-shadow */
+
+export type AdmEventType = keyof typeof AdmEventTypeEnum;
+
+/**
+ * A typed ADM log line.
+ * The player is the subject of the line (i.e. the victim of hits and kills),
+ * the source is the attacker (a player or a name like "Infected").
+ */
+export interface AdmEvent {
+    timestamp: number;
+    type: AdmEventType;
+    playerId?: string;
+    playerName?: string;
+    x?: number;
+    y?: number;
+    z?: number;
+    hp?: number;
+    sourceId?: string;
+    sourceName?: string;
+    sourceX?: number;
+    sourceY?: number;
+    sourceZ?: number;
+    bodyPart?: string;
+    damage?: number;
+    ammo?: string;
+    weapon?: string;
+    distance?: number;
+    message?: string;
+}
+
+export interface AdmStoredEvent extends AdmEvent {
+    id: number;
+}
+
+export interface AdmEventQuery {
+    types?: AdmEventType[];
+    /** matches the player or the source by id or name */
+    player?: string;
+    since?: number;
+    until?: number;
+    /** id of the last event of the previous page */
+    cursor?: number;
+    limit?: number;
+}
+
+export interface AdmPosition {
+    timestamp: number;
+    playerId: string;
+    playerName: string;
+    x: number;
+    y: number;
+    z: number;
+}
@@ -0,0 +1,42 @@
+/* istanbul ignore file */
+
+export interface BackupFileEntry {
+    /** sha256 of the uncompressed content */
+    hash: string;
+    size: number;
+    /** mtime of the mission file when the snapshot was taken */
+    mtime: number;
+}
+
+export interface BackupManifest {
+    created: number;
+    /** the snapshot this one was based on */
+    previous?: string;
+    /** files by their path relative to mpmissions (with forward slashes) */
+    files: Record<string, BackupFileEntry>;
+}
+
+export interface BackupResult {
+    backup: string;
+    files: number;
+    /** files hardlinked from the previous snapshot */
+    linked: number;
+    /** files stored compressed */
+    stored: number;
+    /** uncompressed size of the mission files */
+    totalBytes: number;
+    /** compressed size of the stored files */
+    storedBytes: number;
+}
+
+export interface BackupDiff {
+    added: string[];
+    removed: string[];
+    changed: string[];
+}
+
+export interface BackupRestoreResult {
+    restored: number;
+    unchanged: number;
+    removed: number;
+}
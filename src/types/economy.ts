@@ -0,0 +1,30 @@
+/* istanbul ignore file */
+
+export interface EconomyElement {
+    tag: string;
+    attributes: Record<string, string>;
+    children: EconomyElement[];
+    /** text content of elements without children */
+    text?: string;
+}
+
+/**
+ * Edits of a single entry.
+ *
+ * - `tag`: sets the text of the first child with this tag (i.e. `nominal`)
+ * - `tag@attr`: sets an attribute of the first child with this tag (i.e. `flags@count_in_cargo`)
+ * - `@attr`: sets an attribute of the entry itself
+ *
+ * Missing children are created, `null` removes the child or attribute.
+ */
+export type EconomyPatch = Record<string, string | number | null>;
+
+export interface EconomyFileStats {
+    file: string;
+    entries: number;
+    /** entries with a name that occurs more than once (only the last one is editable) */
+    duplicates: number;
+    /** edits that are not written to disk yet */
+    pendingEdits: number;
+    lastWrite?: number;
+}
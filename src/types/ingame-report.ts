@@ -10,6 +10,6 @@ export interface IngameReportEntry {
 }
 
 export interface IngameReportContainer {
-    players: IngameReportContainer[];
-    vehicles: IngameReportContainer[];
+    players: IngameReportEntry[];
+    vehicles: IngameReportEntry[];
 }
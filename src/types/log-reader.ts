@@ -5,6 +5,15 @@ export interface FileDescriptor {
     mtime: number;
 }
 
+export interface TailPosition {
+    file: string;
+    ino: number;
+    /** byte offset after the last complete line */
+    offset: number;
+    /** base64 of the first bytes of the file, because inode numbers get reused right away */
+    head?: string;
+}
+
 export interface LogMessage {
     timestamp: number;
     message: string;
@@ -23,4 +32,6 @@ export type LogType = keyof typeof LogTypeEnum;
 export interface LogEntryEvent {
     type: LogType,
     entry: LogMessage,
+    /** position in the log file after this line */
+    position?: TailPosition,
 }
@@ -0,0 +1,29 @@
+/* istanbul ignore file */
+
+import { LogType } from './log-reader';
+
+export interface LogSearchQuery {
+    /** the words to search for, a trailing * matches prefixes */
+    query: string;
+    types?: LogType[];
+    since?: number;
+    until?: number;
+    /** nextCursor of the previous page */
+    cursor?: string;
+    limit?: number;
+}
+
+export interface LogSearchHit {
+    id: number;
+    type: LogType;
+    file: string;
+    timestamp: number;
+    message: string;
+}
+
+export interface LogSearchPage {
+    /** newest lines first (by timestamp, then id) */
+    items: LogSearchHit[];
+    /** "<timestamp>:<id>" of the last line */
+    nextCursor?: string;
+}
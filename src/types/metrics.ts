@@ -9,6 +9,7 @@ export enum MetricTypeEnum {
     AUDIT = 'AUDIT',
     INGAME_PLAYERS = 'INGAME_PLAYERS',
     INGAME_VEHICLES = 'INGAME_VEHICLES',
+    INSTRUMENTATION = 'INSTRUMENTATION',
 }
 /* eslint-enable no-shadow */
 
@@ -27,3 +28,98 @@ export interface MetricEntryEvent {
     type: MetricType,
     entry: MetricWrapper<any>,
 }
+
+export type IngameEntityMetricType = Extract<MetricType, 'INGAME_PLAYERS' | 'INGAME_VEHICLES'>;
+
+export interface EntityTrackPoint {
+    timestamp: number;
+    id: number;
+    name: string;
+    type: string;
+    x: number;
+    y: number;
+    z: number;
+    speed: string;
+    damage: number;
+}
+
+export interface EntityTrackQuery {
+    id?: number;
+    name?: string;
+    since?: number;
+    until?: number;
+}
+
+export interface EntityAreaQuery {
+    minX: number;
+    maxX: number;
+    minZ: number;
+    maxZ: number;
+    since?: number;
+    until?: number;
+}
+
+export type MetricRollupTier = 'minute' | 'quarterHour' | 'hour';
+
+export interface MetricRollupTierDefinition {
+    tier: MetricRollupTier;
+    interval: number;
+}
+
+export interface MetricPageQuery {
+    /** exclusive lower timestamp bound, overrides since if later */
+    cursor?: number;
+    since?: number;
+    until?: number;
+    resolution?: number;
+    limit?: number;
+    /** keys of the metric value (or its entries for list metrics) to keep */
+    fields?: string[];
+}
+
+export interface MetricPage<T> {
+    items: MetricWrapper<T>[];
+    /** cursor of the next page, undefined if there are no more items */
+    nextCursor?: number;
+}
+
+export interface MetricSourceStats {
+    type: MetricType;
+    /** successfully pushed samples */
+    samples: number;
+    failures: number;
+    timeouts: number;
+    /** ticks skipped because the previous sample was still running */
+    skipped: number;
+    lastLatency?: number;
+    avgLatency?: number;
+    maxLatency?: number;
+    lastTimestamp?: number;
+}
+
+export interface InstrumentationHistogram {
+    name: string;
+    labels: Record<string, string>;
+    count: number;
+    /** all durations are in ms */
+    sum: number;
+    avg: number;
+    max: number;
+}
+
+export interface InstrumentationReport {
+    /** event loop lag of the last window (ms) */
+    eventLoopLag: {
+        mean: number;
+        p99: number;
+        max: number;
+    };
+    /** bytes */
+    memory: {
+        rss: number;
+        heapTotal: number;
+        heapUsed: number;
+        external: number;
+    };
+    histograms: InstrumentationHistogram[];
+}
@@ -0,0 +1,32 @@
+/* istanbul ignore file */
+
+export interface ModStoreFile {
+    /** sha256 of the content */
+    hash: string;
+    size: number;
+    /** mtime of the workshop file, used to skip hashing unchanged files */
+    mtime: number;
+}
+
+export interface ModStoreManifest {
+    modId: string;
+    /** files by their path relative to the mod dir (with forward slashes, lowercase on linux) */
+    files: Record<string, ModStoreFile>;
+}
+
+export interface ModStoreIngestResult {
+    files: number;
+    /** files which had to be hashed because they are new or changed */
+    hashed: number;
+    totalBytes: number;
+    /** bytes added to the store (content that was not stored yet) */
+    storedBytes: number;
+}
+
+export interface ModStoreDeployResult {
+    linked: number;
+    /** files that could not be hardlinked (i.e. the store is on another drive) */
+    copied: number;
+    unchanged: number;
+    removed: number;
+}
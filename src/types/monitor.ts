@@ -43,7 +43,7 @@ export class SystemReport {
         if (this.serverState === ServerState.STARTED) {
             report.push(
                 'Server Usage:',
-                `CPU: ${this.server?.cpuTotal}% (Avg since start)`,
+                `CPU: ${this.server?.cpuTotal}%`,
                 `RAM: ${this.server?.mem} MB`,
             );
         }
@@ -1,4 +1,5 @@
 import { Logger } from '../util/logger';
+import { Config } from '../config/config';
 
 export class IService {
 
@@ -64,9 +65,27 @@ export abstract class IStatefulService extends IService {
 
     protected timers = new TimerHandler();
 
+    /**
+     * Config keys which are only read on start, a change of them restarts the service.
+     * All other keys are expected to be read from the current config on use.
+     */
+    public readonly configKeys: (keyof Config)[] = [];
+
     abstract start(): Promise<void>;
     abstract stop(): Promise<void>;
 
+    /**
+     * Applies a config change without a restart of the manager.
+     * The new config is already set when this is called.
+     * @param changed the changed config keys
+     */
+    public async applyConfig(changed: (keyof Config)[]): Promise<void> {
+        if (changed.some((x) => this.configKeys.includes(x))) {
+            await this.stop();
+            await this.start();
+        }
+    }
+
 }
 
 export interface ServiceConfig {
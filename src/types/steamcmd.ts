@@ -111,6 +111,23 @@ export interface LocalMetaData {
     lastDownloaded?: number;
 }
 
+export interface ModUpdateStageStats {
+    mods: number;
+    bytes: number;
+    /** ms */
+    duration: number;
+    /** bytes per second */
+    throughput: number;
+}
+
+export interface ModUpdatePipelineStats {
+    batches: number;
+    download: ModUpdateStageStats;
+    install: ModUpdateStageStats;
+    /** ms until the last mod was downloaded (and installed) */
+    total: number;
+}
+
 export interface ModUpdatedStatus {
     modIds: string[];
     success: boolean;
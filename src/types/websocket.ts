@@ -2,7 +2,8 @@
 // eslint-disable-next-line no-shadow
 export enum WebsocketCommand {
     REGISTER_LISTENER = 'REGISTER_LISTENER',
-    LISTENER_EVENT = 'LISTENER_EVENT',
+    /** a batch of listener events */
+    LISTENER_EVENTS = 'LISTENER_EVENTS',
 
     REQUEST = 'REQUEST',
     RESPONSE = 'RESPONSE',
@@ -14,9 +15,11 @@ export enum WebsocketListenerType {
     METRICS = 'metrics',
 }
 
-export interface WebsocketListenerEvent {
+export interface WebsocketListenerEvents {
     type: WebsocketListenerType,
-    event: any,
+    events: any[],
+    /** number of events which were dropped before this batch because the client did not keep up */
+    dropped: number,
 }
 
 export interface WebsocketMessage<T> {
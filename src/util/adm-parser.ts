@@ -0,0 +1,229 @@
+import { AdmEvent, AdmEventType, AdmEventTypeEnum } from '../types/adm';
+
+interface PlayerRef {
+    name: string;
+    id: string;
+    x?: number;
+    y?: number;
+    z?: number;
+    end: number;
+}
+
+const HEADER_REGEX = /^AdminLog started on (\d{4})-(\d{2})-(\d{2}) at (\d{2}):(\d{2}):(\d{2})/;
+const TIME_REGEX = /^(\d{1,2}):(\d{2}):(\d{2}) \| /;
+const PLAYER_REGEX = /Player "([^"]*)"\s*(?:\(DEAD\)\s*)?\(id=([^\s)]*)(?:\s+pos=<([^>]*)>)?\)/y;
+const HP_REGEX = /\s*\[HP: ([\d.]+)\]/y;
+const HIT_DETAILS_REGEX = / into ([^(]+)\((\d+)\) for ([\d.]+) damage \(([^)]*)\)(?: with (.+?))?(?: from ([\d.]+) meters)?\s*$/;
+const KILL_DETAILS_REGEX = / with (.+?)(?: from ([\d.]+) meters)?\s*$/;
+const CHAT_REGEX = /^Chat\("([^"]*)"\(id=([^\s)]*)\)\): ?(.*)$/;
+
+const DAY = 86_400_000;
+
+/**
+ * Incremental parser for DayZ ADM log lines.
+ *
+ * ADM lines only contain the time of day, the date is taken from the "AdminLog started on" header
+ * (and advanced on midnight rollover). Without a header the date of reception is used.
+ * ADM positions are <x, z, height>, they are mapped to x / y (height) / z like the ingame report.
+ */
+export class AdmParser {
+
+    private dayStart: number | undefined;
+    private lastSeconds = -1;
+
+    public reset(): void {
+        this.dayStart = undefined;
+        this.lastSeconds = -1;
+    }
+
+    /**
+     * Parses a single ADM line
+     * @param line the raw line
+     * @param receivedAt time the line was read, used if no header was seen yet
+     * @returns the event or undefined if the line is not relevant
+     */
+    public parse(line: string, receivedAt: number = new Date().valueOf()): AdmEvent | undefined {
+        if (!line) {
+            return undefined;
+        }
+
+        const time = TIME_REGEX.exec(line);
+        if (!time) {
+            const header = HEADER_REGEX.exec(line);
+            if (header) {
+                this.dayStart = new Date(Number(header[1]), Number(header[2]) - 1, Number(header[3])).valueOf();
+                this.lastSeconds = -1;
+            }
+            return undefined;
+        }
+
+        const body = line.slice(time[0].length);
+        const type = this.detectType(body);
+        if (!type) {
+            return undefined;
+        }
+
+        const seconds = Number(time[1]) * 3600 + Number(time[2]) * 60 + Number(time[3]);
+        const event: AdmEvent = {
+            timestamp: this.getTimestamp(seconds, receivedAt),
+            type,
+        };
+
+        if (type === AdmEventTypeEnum.CHAT) {
+            const chat = CHAT_REGEX.exec(body);
+            if (!chat) {
+                return undefined;
+            }
+            event.playerName = chat[1];
+            event.playerId = chat[2];
+            event.message = chat[3];
+            return event;
+        }
+
+        const player = this.parsePlayer(body, 0);
+        if (!player) {
+            return undefined;
+        }
+        this.assignPlayer(event, player);
+
+        let rest = player.end;
+        HP_REGEX.lastIndex = rest;
+        const hp = HP_REGEX.exec(body);
+        if (hp) {
+            event.hp = Number(hp[1]);
+            rest = HP_REGEX.lastIndex;
+        }
+
+        if (type === AdmEventTypeEnum.HIT || type === AdmEventTypeEnum.KILL) {
+            this.parseAttack(event, body, body.indexOf(type === AdmEventTypeEnum.HIT ? ' by ' : 'killed by ', rest));
+        }
+
+        return event;
+    }
+
+    private detectType(body: string): AdmEventType | undefined {
+        if (body.startsWith('Chat(')) {
+            return AdmEventTypeEnum.CHAT;
+        }
+        if (!body.startsWith('Player "')) {
+            return undefined;
+        }
+        if (body.endsWith(')') && !body.includes(') ')) {
+            // only the player itself (PlayerList)
+            return AdmEventTypeEnum.POSITION;
+        }
+        if (body.includes(' hit by ')) {
+            return AdmEventTypeEnum.HIT;
+        }
+        if (body.includes(' killed by ')) {
+            return AdmEventTypeEnum.KILL;
+        }
+        if (body.endsWith(' is connected')) {
+            return AdmEventTypeEnum.CONNECT;
+        }
+        if (body.endsWith(' has been disconnected')) {
+            return AdmEventTypeEnum.DISCONNECT;
+        }
+        if (body.includes(') died.')) {
+            return AdmEventTypeEnum.DEATH;
+        }
+        if (body.endsWith(' committed suicide')) {
+            return AdmEventTypeEnum.SUICIDE;
+        }
+        if (body.endsWith(' is unconscious')) {
+            return AdmEventTypeEnum.UNCONSCIOUS;
+        }
+        if (body.endsWith(' regained consciousness')) {
+            return AdmEventTypeEnum.CONSCIOUS;
+        }
+        return undefined;
+    }
+
+    private getTimestamp(seconds: number, receivedAt: number): number {
+        if (this.dayStart === undefined) {
+            const received = new Date(receivedAt);
+            const midnight = new Date(received.getFullYear(), received.getMonth(), received.getDate()).valueOf();
+            const ts = midnight + seconds * 1000;
+            // a line from shortly before midnight read after midnight
+            return ts > receivedAt + 3_600_000 ? ts - DAY : ts;
+        }
+
+        // the time jumped back, so the day changed
+        if (this.lastSeconds >= 0 && seconds + 3600 < this.lastSeconds) {
+            this.dayStart += DAY;
+        }
+        this.lastSeconds = seconds;
+        return this.dayStart + seconds * 1000;
+    }
+
+    private parsePlayer(body: string, start: number): PlayerRef | undefined {
+        PLAYER_REGEX.lastIndex = start;
+        const match = PLAYER_REGEX.exec(body);
+        if (!match) {
+            return undefined;
+        }
+        const ref: PlayerRef = {
+            name: match[1],
+            id: match[2],
+            end: PLAYER_REGEX.lastIndex,
+        };
+        if (match[3]) {
+            const [x, z, y] = match[3].split(',').map((val) => Number(val));
+            ref.x = x;
+            ref.y = y;
+            ref.z = z;
+        }
+        return ref;
+    }
+
+    private assignPlayer(event: AdmEvent, player: PlayerRef): void {
+        event.playerName = player.name;
+        event.playerId = player.id;
+        if (player.x !== undefined) {
+            event.x = player.x;
+            event.y = player.y;
+            event.z = player.z;
+        }
+    }
+
+    private parseAttack(event: AdmEvent, body: string, byIdx: number): void {
+        if (byIdx === -1) {
+            return;
+        }
+        let rest = body.indexOf(' by ', byIdx) + 4;
+        if (body.startsWith('Player "', rest)) {
+            const source = this.parsePlayer(body, rest);
+            if (source) {
+                event.sourceName = source.name;
+                event.sourceId = source.id;
+                event.sourceX = source.x;
+                event.sourceY = source.y;
+                event.sourceZ = source.z;
+                rest = source.end;
+            }
+        } else {
+            const end = body.slice(rest).search(/ into | with |$/);
+            event.sourceName = body.slice(rest, rest + end).trim();
+            rest += end;
+        }
+
+        const tail = body.slice(rest);
+        if (event.type === AdmEventTypeEnum.HIT) {
+            const hit = HIT_DETAILS_REGEX.exec(tail);
+            if (hit) {
+                event.bodyPart = hit[1];
+                event.damage = Number(hit[3]);
+                event.ammo = hit[4];
+                event.weapon = hit[5];
+                event.distance = hit[6] ? Number(hit[6]) : undefined;
+            }
+        } else {
+            const kill = KILL_DETAILS_REGEX.exec(tail);
+            if (kill) {
+                event.weapon = kill[1];
+                event.distance = kill[2] ? Number(kill[2]) : undefined;
+            }
+        }
+    }
+
+}
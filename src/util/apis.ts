@@ -31,4 +31,7 @@ export class InjectionTokens {
 
     public static rconSocket = 'rconSocket';
 
+    /** the container of the current server instance, its services are started and stopped together */
+    public static container = 'container';
+
 }
@@ -0,0 +1,230 @@
+export enum CommandPriority {
+    /** admin actions like kicks, bans and shutdowns */
+    HIGH = 0,
+    NORMAL = 1,
+    /** polls */
+    LOW = 2,
+}
+
+export interface CommandOptions {
+    priority?: CommandPriority;
+    /** ms until the command is given up, 0 to disable */
+    timeout?: number;
+    /** share the result with identical commands that are queued or running (only for read commands) */
+    coalesce?: boolean;
+}
+
+export interface CommandStats {
+    count: number;
+    errors: number;
+    timeouts: number;
+    /** requests answered by an identical command */
+    coalesced: number;
+    /** time from sending to the response (ms) */
+    avgLatency: number;
+    maxLatency: number;
+    /** time spent in the queue (ms) */
+    avgWait: number;
+    lastError?: string;
+}
+
+export class CommandTimeoutError extends Error {
+
+    public constructor(public readonly command: string, timeout: number) {
+        super(`Command timed out after ${timeout}ms: ${command}`);
+        this.name = 'CommandTimeoutError';
+    }
+
+}
+
+interface QueuedCommand<T> {
+    command: string;
+    priority: CommandPriority;
+    timeout: number;
+    coalesce: boolean;
+    queuedAt: number;
+    promise: Promise<T>;
+    resolve: (result: T) => void;
+    reject: (e: Error) => void;
+}
+
+/**
+ * Sends commands with a limited number in flight.
+ *
+ * Queued commands are sent by priority, then in order.
+ * Identical read commands share one request and a command that does not answer in time frees its slot.
+ */
+export class CommandScheduler<T> {
+
+    private queues: QueuedCommand<T>[][] = [[], [], []];
+    private coalescing = new Map<string, QueuedCommand<T>>();
+    private inFlight = 0;
+    private stats = new Map<string, CommandStats>();
+
+    public constructor(
+        private execute: (command: string) => Promise<T>,
+        public readonly MAX_IN_FLIGHT: number = 1,
+        public readonly DEFAULT_TIMEOUT: number = 10000,
+    ) {}
+
+    /** number of commands waiting to be sent */
+    public get pending(): number {
+        return this.queues.reduce((sum, queue) => sum + queue.length, 0);
+    }
+
+    public get running(): number {
+        return this.inFlight;
+    }
+
+    /**
+     * Queues a command
+     * @returns the result of the command, rejects on errors and timeouts
+     */
+    public schedule(command: string, options?: CommandOptions): Promise<T> {
+        const priority = options?.priority ?? CommandPriority.NORMAL;
+        const coalesce = !!options?.coalesce;
+
+        if (coalesce) {
+            const existing = this.coalescing.get(command);
+            if (existing) {
+                this.getStats(command).coalesced++;
+                this.promote(existing, priority);
+                return existing.promise;
+            }
+        }
+
+        let resolve: (result: T) => void;
+        let reject: (e: Error) => void;
+        const promise = new Promise<T>((res, rej) => {
+            resolve = res;
+            reject = rej;
+        });
+        const entry: QueuedCommand<T> = {
+            command,
+            priority,
+            timeout: options?.timeout ?? this.DEFAULT_TIMEOUT,
+            coalesce,
+            queuedAt: Date.now(),
+            promise,
+            resolve,
+            reject,
+        };
+
+        if (coalesce) {
+            this.coalescing.set(command, entry);
+        }
+        this.queues[priority].push(entry);
+        this.next();
+
+        return promise;
+    }
+
+    /**
+     * Rejects all queued commands, running commands are not affected
+     * @param reason the error the commands are rejected with
+     */
+    public clear(reason: Error): void {
+        const queued = this.queues.flat();
+        this.queues = [[], [], []];
+        for (const entry of queued) {
+            this.release(entry);
+            entry.reject(reason);
+        }
+    }
+
+    /**
+     * @returns the stats per command verb (i.e. 'players' or 'kick')
+     */
+    public getCommandStats(): Record<string, CommandStats> {
+        const result: Record<string, CommandStats> = {};
+        for (const [verb, stats] of this.stats) {
+            result[verb] = { ...stats };
+        }
+        return result;
+    }
+
+    private getStats(command: string): CommandStats {
+        const verb = command.trim().split(/\s+/)[0] || command;
+        let stats = this.stats.get(verb);
+        if (!stats) {
+            stats = {
+                count: 0,
+                errors: 0,
+                timeouts: 0,
+                coalesced: 0,
+                avgLatency: 0,
+                maxLatency: 0,
+                avgWait: 0,
+            };
+            this.stats.set(verb, stats);
+        }
+        return stats;
+    }
+
+    private promote(entry: QueuedCommand<T>, priority: CommandPriority): void {
+        const queue = this.queues[entry.priority];
+        const idx = queue.indexOf(entry);
+        if (priority < entry.priority && idx !== -1) {
+            queue.splice(idx, 1);
+            entry.priority = priority;
+            this.queues[priority].push(entry);
+        }
+    }
+
+    private release(entry: QueuedCommand<T>): void {
+        if (this.coalescing.get(entry.command) === entry) {
+            this.coalescing.delete(entry.command);
+        }
+    }
+
+    private next(): void {
+        while (this.inFlight < this.MAX_IN_FLIGHT) {
+            const entry = this.queues.find((queue) => queue.length)?.shift();
+            if (!entry) {
+                return;
+            }
+            this.inFlight++;
+            void this.run(entry);
+        }
+    }
+
+    private async run(entry: QueuedCommand<T>): Promise<void> {
+        const stats = this.getStats(entry.command);
+        const sentAt = Date.now();
+        stats.count++;
+        stats.avgWait += (sentAt - entry.queuedAt - stats.avgWait) / stats.count;
+
+        let timer: any;
+        try {
+            const result = await Promise.race([
+                this.execute(entry.command),
+                new Promise<never>((_, rej) => {
+                    if (entry.timeout > 0) {
+                        timer = setTimeout(
+                            () => rej(new CommandTimeoutError(entry.command, entry.timeout)),
+                            entry.timeout,
+                        );
+                    }
+                }),
+            ]);
+            entry.resolve(result);
+        } catch (e) {
+            stats.errors++;
+            if (e instanceof CommandTimeoutError) {
+                stats.timeouts++;
+            }
+            stats.lastError = e?.message ?? String(e);
+            entry.reject(e);
+        } finally {
+            clearTimeout(timer);
+            const latency = Date.now() - sentAt;
+            stats.avgLatency += (latency - stats.avgLatency) / stats.count;
+            stats.maxLatency = Math.max(stats.maxLatency, latency);
+
+            this.release(entry);
+            this.inFlight--;
+            this.next();
+        }
+    }
+
+}
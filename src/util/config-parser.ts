@@ -1,186 +1,393 @@
+import { Readable } from 'stream';
 
 /**
- * Config parser ported from arma-config-parser
+ * Config parser for the arma config format (serverDZ.cfg, config.cpp)
+ *
+ * Originally ported from arma-config-parser, now a single pass recursive descent parser:
+ * the input is scanned once and nested classes are parsed in place instead of being sliced and re-scanned.
  */
 export class ConfigParser {
 
-    private debug: boolean = false;
+    private input: string = '';
+    private pos: number = 0;
 
-    private find(input: string, ptr: number, search: string): number {
-        const idx = input.indexOf(search, ptr);
-        if (idx !== -1) {
-            return (idx - ptr) + search.length;
+    private unexpectedEnd(): Error {
+        return new Error(`unexpected end of file at position ${this.pos}`);
+    }
+
+    private isIdentifierChar(code: number): boolean {
+        return (code >= 48 && code <= 57) // 0-9
+            || (code >= 65 && code <= 90) // A-Z
+            || (code >= 97 && code <= 122) // a-z
+            || code === 95; // _
+    }
+
+    /**
+     * Skips whitespace, comments and preprocessor lines
+     */
+    private skipBlank(): void {
+        const input = this.input;
+        while (this.pos < input.length) {
+            const c = input[this.pos];
+            if (input.charCodeAt(this.pos) <= 32) {
+                this.pos++;
+            } else if (c === '/' && input[this.pos + 1] === '/') {
+                const eol = input.indexOf('\n', this.pos);
+                this.pos = eol === -1 ? input.length : eol + 1;
+            } else if (c === '/' && input[this.pos + 1] === '*') {
+                const end = input.indexOf('*/', this.pos + 2);
+                this.pos = end === -1 ? input.length : end + 2;
+            } else if (c === '#') {
+                // directives may continue on the next line with a trailing backslash
+                while (this.pos < input.length && input[this.pos] !== '\n') {
+                    this.pos += (input[this.pos] === '\\' && input[this.pos + 1] === '\n') ? 2 : 1;
+                }
+            } else {
+                return;
+            }
         }
-        return -1;
     }
 
-    public cfg2json(input: string, level?: number): any {
-        level = (level || 0) + 1;
+    private readIdentifier(): string {
+        const start = this.pos;
+        while (this.isIdentifierChar(this.input.charCodeAt(this.pos))) {
+            this.pos++;
+        }
+        return this.input.slice(start, this.pos);
+    }
+
+    /**
+     * Reads a quoted string. Doubled quotes are the escape sequence of the format and are kept as they are.
+     * @returns the content between the quotes
+     */
+    private readString(): string {
+        const quote = this.input[this.pos];
+        const start = this.pos + 1;
+        let end = start;
+        for (;;) {
+            end = this.input.indexOf(quote, end);
+            if (end === -1) {
+                this.pos = this.input.length;
+                throw this.unexpectedEnd();
+            }
+            if (this.input[end + 1] !== quote) {
+                break;
+            }
+            end += 2;
+        }
+        this.pos = end + 1;
+        return this.input.slice(start, end);
+    }
 
-        input = input
-            .replace(/\r\n/g, '\n')
-            .replace(/\n\n/g, '\n');
+    /**
+     * Reads an unquoted value until the end of the statement, array element or line
+     */
+    private readRaw(): string {
+        const input = this.input;
+        const start = this.pos;
+        while (this.pos < input.length) {
+            const c = input[this.pos];
+            if (
+                c === ';' || c === ',' || c === '}' || c === '\n'
+                || (c === '/' && (input[this.pos + 1] === '/' || input[this.pos + 1] === '*'))
+            ) {
+                break;
+            }
+            this.pos++;
+        }
+        return input.slice(start, this.pos).trim();
+    }
 
-        let ptr = 0;
-        const output = {};
+    private convertRaw(raw: string): number | boolean | string | undefined {
+        const lower = raw.toLowerCase();
+        if (lower === 'true' || lower === 'false') {
+            return lower === 'true';
+        }
+        const num = Number(raw);
+        if (raw && !isNaN(num)) {
+            return num;
+        }
+        return undefined;
+    }
 
-        let classMatch = null;
-        let arrMatch = null;
-        let stringMatch = null;
-        let boolMatch = null;
-        let numberMatch = null;
-
-        while (ptr < input.length) {
-            let eol = this.find(input, ptr, '\n');
-            if (eol === -1) break;
-            const line = input.slice(ptr, ptr + eol).trim();
-            // eslint-disable-next-line no-cond-assign
-            if (classMatch = line.match(/^class\s+([a-zA-Z0-9_]+)((\s*:\s*([a-zA-Z0-9_]+)){0,1})/i)) {
-                const nextBracket = this.find(input, ptr, '{');
-                const nextSemi = this.find(input, ptr, ';');
-                if (this.debug) {
-                    console.log('classMatch', classMatch[1], level, nextBracket, nextSemi);
-                }
-                if (nextBracket !== -1 && nextBracket < nextSemi) {
-                    ptr += this.find(input, ptr, '{');
-                    const innerStart = ptr;
-                    let parenthesisCount = 1;
-                    while (parenthesisCount > 0) {
-                        const c = input[ptr];
-                        if (!c) {
-                            throw new Error('unexpected end of file - prob a bug when parsing the cfg');
-                        }
-                        if (c === '"' || c === '\'') {
-                            do {
-                                ptr += 1;
-                                ptr += this.find(input, ptr, c);
-                            } while (input[ptr] === c);
-                            continue;
-                        } else if (c === '{') {
-                            parenthesisCount += 1;
-                        } else if (c === '}') {
-                            parenthesisCount -= 1;
-                        }
-                        ptr += 1;
-                    }
-                    output[classMatch[1]] = this.cfg2json(
-                        `${input.slice(innerStart, ptr - 1).trim()}\n`,
-                        level,
-                    );
-                    if (classMatch[4]) {
-                        // eslint-disable-next-line prefer-destructuring
-                        output[classMatch[1]].__inherited = classMatch[4];
-                    }
-                }
-                eol = this.find(input, ptr, '\n');
-            // eslint-disable-next-line no-cond-assign
-            } else if (stringMatch = line.match(/^([a-zA-Z0-9]+)\s*=\s*"(.*)";/i)) {
-                if (this.debug) {
-                    console.log('stringMatch', stringMatch[1], level);
+    /**
+     * Skips an unsupported statement including nested braces, but not the closing brace of the surrounding class
+     */
+    private skipStatement(): void {
+        let depth = 0;
+        while (this.pos < this.input.length) {
+            this.skipBlank();
+            const c = this.input[this.pos];
+            if (c === '"' || c === '\'') {
+                this.readString();
+                continue;
+            }
+            if (c === '{') {
+                depth++;
+            } else if (c === '}') {
+                if (!depth) {
+                    return;
                 }
-                // eslint-disable-next-line prefer-destructuring
-                output[stringMatch[1]] = stringMatch[2] ?? '';
-            // eslint-disable-next-line no-cond-assign
-            } else if (boolMatch = line.match(/^([a-zA-Z0-9]+)\s*=\s*(true|false);/i)) {
-                if (this.debug) {
-                    console.log('boolMatch', boolMatch[1], level);
+                depth--;
+            } else if (c === ';' && !depth) {
+                this.pos++;
+                return;
+            }
+            this.pos++;
+        }
+    }
+
+    private skipSemicolon(): void {
+        this.skipBlank();
+        if (this.input[this.pos] === ';') {
+            this.pos++;
+        }
+    }
+
+    private parseArray(): any[] {
+        // opening brace
+        this.pos++;
+        const output = [];
+        for (;;) {
+            this.skipBlank();
+            const c = this.input[this.pos];
+            if (c === undefined) {
+                throw this.unexpectedEnd();
+            } else if (c === '}') {
+                this.pos++;
+                return output;
+            } else if (c === ',') {
+                this.pos++;
+            } else if (c === '{') {
+                output.push(this.parseArray());
+            } else if (c === '"' || c === '\'') {
+                output.push(this.readString());
+            } else {
+                const raw = this.readRaw();
+                if (raw) {
+                    output.push(this.convertRaw(raw) ?? raw);
+                } else {
+                    // stray semicolon
+                    this.pos++;
                 }
-                // eslint-disable-next-line prefer-destructuring
-                output[boolMatch[1]] = boolMatch[2] === 'true';
-            // eslint-disable-next-line no-cond-assign
-            } else if (numberMatch = line.match(/^([a-zA-Z0-9]+)\s*=\s*([0-9\.\-e]+);/i)) {
-                if (this.debug) {
-                    console.log('numberMatch', numberMatch[1], level);
+            }
+        }
+    }
+
+    private parseClass(output: any): void {
+        this.skipBlank();
+        const name = this.readIdentifier();
+        this.skipBlank();
+        let parent: string | undefined;
+        if (this.input[this.pos] === ':') {
+            this.pos++;
+            this.skipBlank();
+            parent = this.readIdentifier();
+            this.skipBlank();
+        }
+
+        // forward declarations (class X;) are skipped
+        if (!name || this.input[this.pos] !== '{') {
+            this.skipStatement();
+            return;
+        }
+
+        this.pos++;
+        const body = this.parseBody(true);
+        if (parent) {
+            body.__inherited = parent;
+        }
+        output[name] = body;
+    }
+
+    private parseAssignment(output: any, name: string): void {
+        this.skipBlank();
+        let isArray = false;
+        if (this.input[this.pos] === '[') {
+            this.pos++;
+            this.skipBlank();
+            if (this.input[this.pos] !== ']') {
+                this.skipStatement();
+                return;
+            }
+            this.pos++;
+            this.skipBlank();
+            isArray = true;
+        }
+
+        // other operators like += are not supported
+        if (this.input[this.pos] !== '=') {
+            this.skipStatement();
+            return;
+        }
+        this.pos++;
+        this.skipBlank();
+
+        const c = this.input[this.pos];
+        if (isArray) {
+            if (c !== '{') {
+                this.skipStatement();
+                return;
+            }
+            output[name] = this.parseArray();
+        } else if (c === '"' || c === '\'') {
+            output[name] = this.readString();
+        } else {
+            const value = this.convertRaw(this.readRaw());
+            if (value !== undefined) {
+                output[name] = value;
+            }
+        }
+        this.skipSemicolon();
+    }
+
+    private parseBody(nested: boolean): any {
+        const output = {};
+        for (;;) {
+            this.skipBlank();
+            const c = this.input[this.pos];
+            if (c === undefined) {
+                if (nested) {
+                    throw this.unexpectedEnd();
                 }
-                output[numberMatch[1]] = parseFloat(numberMatch[2]);
-            // eslint-disable-next-line no-cond-assign
-            } else if (arrMatch = line.match(/^([a-zA-Z0-9]+)\s*\[\]\s*=\s*/i)) {
-                if (this.debug) {
-                    console.log('arrMatch', arrMatch[1], level);
+                return output;
+            }
+
+            if (c === '}') {
+                this.pos++;
+                if (nested) {
+                    this.skipSemicolon();
+                    return output;
                 }
-                ptr = input.indexOf('{', ptr) + 1;
-                const innerStart = ptr;
-                let parenthesisCount = 1;
-                while (parenthesisCount > 0) {
-                    const c = input[ptr];
-                    if (c === '"' || c === '\'') {
-                        ptr = input.indexOf(c, ptr + 1);
-                    } else if (c === '{') {
-                        parenthesisCount += 1;
-                    } else if (c === '}') {
-                        parenthesisCount -= 1;
-                    }
-                    ptr += 1;
+                continue;
+            }
+
+            if (c === ';') {
+                this.pos++;
+                continue;
+            }
+
+            const name = this.readIdentifier();
+            if (!name) {
+                if (c !== '{' && c !== '"' && c !== '\'') {
+                    this.pos++;
                 }
-                const inner = input
-                    .slice(innerStart, ptr - 1)
-                    .replace(/\{/g, '[')
-                    .replace(/\}/g, ']')
-                    .trim();
-                output[arrMatch[1]] = JSON.parse(`[${inner}]`);
-                eol = this.find(input, ptr, '\n');
+                this.skipStatement();
+            } else if (name.toLowerCase() === 'class') {
+                this.parseClass(output);
+            } else {
+                this.parseAssignment(output, name);
             }
-            ptr += eol;
         }
-        return output;
     }
 
+    /**
+     * Parses a config into an object.
+     * Classes become nested objects (with the parent class as `__inherited`), arrays become arrays.
+     * Unsupported statements (i.e. `+=`, `delete`, macros) are skipped.
+     */
+    public cfg2json(input: string): any {
+        this.input = input;
+        this.pos = 0;
+        try {
+            return this.parseBody(false);
+        } finally {
+            this.input = '';
+        }
+    }
 
-    public json2cfg(input: any, indent? : number): string {
-        indent = indent || 0;
+    private formatArrayValue(v: any): string {
+        if (Array.isArray(v)) {
+            return `{${v.map((x) => this.formatArrayValue(x)).join(',')}}`;
+        }
+        return typeof v === 'string' ? `"${v}"` : `${v}`;
+    }
+
+    private writeArray(key: string, val: any[], tabs: string, output: string[]): void {
+        if (val.some((v) => typeof v === 'string')) {
+            output.push(
+                `${tabs}${key}[]=`,
+                `${tabs}{`,
+            );
+            val.forEach((v, i, a) => {
+                const sep = (i === (a.length - 1)) ? '' : ',';
+                output.push((isNaN(v) || Array.isArray(v)) ? `${tabs}\t${this.formatArrayValue(v)}${sep}` : `${tabs}\t${v}${sep}`);
+            });
+            output.push(`${tabs}};`);
+        } else {
+            output.push(`${tabs}${key}[]=${this.formatArrayValue(val)};`);
+        }
+    }
+
+    private writeEntry(key: string, val: any, indent: number, output: string[]): void {
+        if (key === '__inherited' && typeof val === 'string') {
+            return;
+        }
         const tabs = '\t'.repeat(indent);
-        const output = [];
-        Object.keys(input).forEach((key) => {
-            const val = input[key];
-            let type: string = typeof val;
-            if (type === 'object' && Array.isArray(val)) {
-                type = 'array';
-            }
-            switch (type) {
-                case 'number':
-                case 'boolean': {
-                    output.push(`${tabs}${key}=${val};`);
-                    break;
-                }
-                case 'string': {
-                    output.push(`${tabs}${key}="${val}";`);
-                    break;
-                }
-                case 'array': {
-                    if (val.some((v) => typeof v === 'string')) {
-                        output.push(
-                            `${tabs}${key}[]=`,
-                            `${tabs}{`,
-                        );
-                        val.forEach((v, i, a) => {
-                            if (isNaN(v)) {
-                                output.push(`${tabs}\t"${v}"${(i === (a.length - 1)) ? '' : ','}`);
-                            } else {
-                                output.push(`${tabs}\t${v}${(i === (a.length - 1)) ? '' : ','}`);
-                            }
-                        });
-                        output.push(`${tabs}};`);
-                    } else {
-                        let line = '';
-                        val.forEach((v, i) => {
-                            line = `${line}${v}${(i === (val.length - 1)) ? '' : ','}`;
-                        });
-                        output.push(`${tabs}${key}[]={${line}};`);
-                    }
-                    break;
+        let type: string = typeof val;
+        if (type === 'object' && Array.isArray(val)) {
+            type = 'array';
+        }
+        switch (type) {
+            case 'number':
+            case 'boolean': {
+                output.push(`${tabs}${key}=${val};`);
+                break;
+            }
+            case 'string': {
+                output.push(`${tabs}${key}="${val}";`);
+                break;
+            }
+            case 'array': {
+                this.writeArray(key, val, tabs, output);
+                break;
+            }
+            case 'object': {
+                const parent = typeof val.__inherited === 'string' ? `: ${val.__inherited}` : '';
+                output.push(
+                    `${tabs}class ${key}${parent}`,
+                    `${tabs}{`,
+                );
+                const bodyStart = output.length;
+                for (const innerKey of Object.keys(val)) {
+                    this.writeEntry(innerKey, val[innerKey], indent + 1, output);
                 }
-                case 'object': {
-                    output.push(
-                        `${tabs}class ${key}`,
-                        `${tabs}{`,
-                        this.json2cfg(val, indent + 1),
-                        `${tabs}};`,
-                    );
-                    break;
+                if (output.length === bodyStart) {
+                    output.push('');
                 }
+                output.push(`${tabs}};`);
+                break;
             }
-        });
+        }
+    }
+
+    /**
+     * Writes the config into a single line array which is joined once
+     */
+    public json2cfg(input: any, indent?: number): string {
+        indent = indent || 0;
+        const output: string[] = [];
+        for (const key of Object.keys(input)) {
+            this.writeEntry(key, input[key], indent, output);
+        }
         return (indent === 0) ? (`${output.join('\r\n')}\r\n`) : output.join('\r\n');
     }
 
+    /**
+     * Streaming variant of {@link json2cfg} which emits one chunk per top level entry,
+     * so large configs are never held in memory as a whole
+     */
+    public json2cfgStream(input: any): Readable {
+        const parser = this;
+        return Readable.from((function* () {
+            for (const key of Object.keys(input)) {
+                const output: string[] = [];
+                parser.writeEntry(key, input[key], 0, output);
+                if (output.length) {
+                    yield `${output.join('\r\n')}\r\n`;
+                }
+            }
+        })());
+    }
+
 }
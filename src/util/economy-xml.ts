@@ -0,0 +1,324 @@
+import { EconomyElement, EconomyPatch } from '../types/economy';
+
+/**
+ * A raw top level entry of a central economy file (i.e. a `<type>` of the types.xml)
+ */
+export interface EconomyXmlSegment {
+    name: string;
+    /** whitespace and comments before the entry */
+    before: string;
+    raw: string;
+    /** the parsed entry, only set once it was needed */
+    element?: EconomyElement;
+}
+
+/**
+ * A central economy file split into its top level entries.
+ * Untouched entries are written back exactly as they were read.
+ */
+export interface EconomyXmlDocument {
+    head: string;
+    segments: EconomyXmlSegment[];
+    tail: string;
+}
+
+const ENTITIES: Record<string, string> = {
+    '&lt;': '<',
+    '&gt;': '>',
+    '&amp;': '&',
+    '&quot;': '"',
+    '&apos;': '\'',
+};
+
+const NAME_ATTRIBUTE_REGEX = /\sname\s*=\s*("([^"]*)"|'([^']*)')/;
+const ATTRIBUTE_REGEX = /([^\s=]+)\s*=\s*("([^"]*)"|'([^']*)')/g;
+const TAG_NAME_REGEX = /^<\/?\s*([^\s/>]+)/;
+
+const decode = (text: string): string => text.replace(/&(lt|gt|amp|quot|apos);/g, (x) => ENTITIES[x]);
+
+const encode = (text: string): string => text
+    .replace(/&/g, '&amp;')
+    .replace(/</g, '&lt;')
+    .replace(/>/g, '&gt;')
+    .replace(/"/g, '&quot;');
+
+const invalid = (message: string, pos: number): Error => new Error(`Invalid XML: ${message} at position ${pos}`);
+
+/**
+ * @returns the end of the tag starting at pos (after the `>`), skipping `>` in quoted attributes
+ */
+const findTagEnd = (input: string, pos: number): number => {
+    let quote: string | undefined;
+    for (let i = pos + 1; i < input.length; i++) {
+        const c = input[i];
+        if (quote) {
+            if (c === quote) {
+                quote = undefined;
+            }
+        } else if (c === '"' || c === '\'') {
+            quote = c;
+        } else if (c === '>') {
+            return i + 1;
+        }
+    }
+    throw invalid('unclosed tag', pos);
+};
+
+/**
+ * @returns the end of the markup at pos if it is a comment, declaration or processing instruction
+ */
+const skipSpecial = (input: string, pos: number): number | undefined => {
+    if (input.startsWith('<!--', pos)) {
+        const end = input.indexOf('-->', pos + 4);
+        if (end === -1) {
+            throw invalid('unclosed comment', pos);
+        }
+        return end + 3;
+    }
+    if (input.startsWith('<![CDATA[', pos)) {
+        const end = input.indexOf(']]>', pos);
+        if (end === -1) {
+            throw invalid('unclosed CDATA', pos);
+        }
+        return end + 3;
+    }
+    if (input.startsWith('<?', pos) || input.startsWith('<!', pos)) {
+        return findTagEnd(input, pos);
+    }
+    return undefined;
+};
+
+/**
+ * @returns the end of the element starting at pos (after its closing tag)
+ */
+const findElementEnd = (input: string, pos: number): number => {
+    let depth = 0;
+    let i = pos;
+    do {
+        const next = input.indexOf('<', i);
+        if (next === -1) {
+            throw invalid('unclosed element', pos);
+        }
+        const special = skipSpecial(input, next);
+        if (special !== undefined) {
+            i = special;
+            continue;
+        }
+        i = findTagEnd(input, next);
+        if (input[next + 1] === '/') {
+            depth--;
+        } else if (input[i - 2] !== '/') {
+            depth++;
+        }
+    } while (depth > 0);
+    return i;
+};
+
+const parseAttributes = (tag: string): Record<string, string> => {
+    const attributes: Record<string, string> = {};
+    const body = tag.replace(TAG_NAME_REGEX, '');
+    const regex = new RegExp(ATTRIBUTE_REGEX);
+    let match: RegExpExecArray | null;
+    // eslint-disable-next-line no-cond-assign
+    while (match = regex.exec(body)) {
+        attributes[match[1]] = decode(match[3] ?? match[4]);
+    }
+    return attributes;
+};
+
+/**
+ * Splits a central economy file into its top level entries, which are indexed by their name attribute.
+ * Only the start tags are inspected, the entries themselves are parsed on demand.
+ */
+export const splitEconomyXml = (input: string): EconomyXmlDocument => {
+    // find the root element
+    let pos = 0;
+    let rootEnd: number | undefined;
+    while (rootEnd === undefined) {
+        const next = input.indexOf('<', pos);
+        if (next === -1) {
+            throw invalid('missing root element', pos);
+        }
+        const special = skipSpecial(input, next);
+        if (special !== undefined) {
+            pos = special;
+        } else {
+            rootEnd = findTagEnd(input, next);
+            if (input[rootEnd - 2] === '/') {
+                // empty root like <types/>
+                return { head: input, segments: [], tail: '' };
+            }
+        }
+    }
+
+    const doc: EconomyXmlDocument = { head: input.slice(0, rootEnd), segments: [], tail: '' };
+    pos = rootEnd;
+    let before = pos;
+    for (;;) {
+        const next = input.indexOf('<', pos);
+        if (next === -1) {
+            throw invalid('unclosed root element', rootEnd);
+        }
+        const special = skipSpecial(input, next);
+        if (special !== undefined) {
+            pos = special;
+            continue;
+        }
+        if (input[next + 1] === '/') {
+            doc.tail = input.slice(before);
+            return doc;
+        }
+        const end = findElementEnd(input, next);
+        const startTag = input.slice(next, findTagEnd(input, next));
+        const nameMatch = NAME_ATTRIBUTE_REGEX.exec(startTag);
+        doc.segments.push({
+            name: decode(nameMatch?.[2] ?? nameMatch?.[3] ?? ''),
+            before: input.slice(before, next),
+            raw: input.slice(next, end),
+        });
+        pos = end;
+        before = end;
+    }
+};
+
+export const joinEconomyXml = (doc: EconomyXmlDocument): string => {
+    const parts: string[] = [doc.head];
+    for (const segment of doc.segments) {
+        parts.push(segment.before, segment.raw);
+    }
+    parts.push(doc.tail);
+    return parts.join('');
+};
+
+/**
+ * Parses a single element. Comments, CDATA and processing instructions are dropped.
+ */
+export const parseEconomyElement = (input: string): EconomyElement => {
+    const stack: EconomyElement[] = [];
+    let root: EconomyElement | undefined;
+    let pos = 0;
+    let textStart = 0;
+    while (pos < input.length) {
+        const next = input.indexOf('<', pos);
+        if (next === -1) {
+            break;
+        }
+        const special = skipSpecial(input, next);
+        if (special !== undefined) {
+            pos = special;
+            textStart = special;
+            continue;
+        }
+
+        const end = findTagEnd(input, next);
+        const tag = input.slice(next, end);
+        const tagName = TAG_NAME_REGEX.exec(tag)?.[1];
+        if (!tagName) {
+            throw invalid('missing tag name', next);
+        }
+
+        if (tag[1] === '/') {
+            const current = stack.pop();
+            if (current?.tag !== tagName) {
+                throw invalid(`unexpected closing tag ${tagName}`, next);
+            }
+            if (!current.children.length) {
+                current.text = decode(input.slice(textStart, next)).trim();
+            }
+        } else {
+            const element: EconomyElement = {
+                tag: tagName,
+                attributes: parseAttributes(tag.slice(0, tag.endsWith('/>') ? -2 : -1)),
+                children: [],
+            };
+            if (stack.length) {
+                stack[stack.length - 1].children.push(element);
+            } else if (root) {
+                throw invalid('multiple root elements', next);
+            } else {
+                root = element;
+            }
+            if (!tag.endsWith('/>')) {
+                stack.push(element);
+            }
+        }
+        pos = end;
+        textStart = end;
+    }
+    if (!root || stack.length) {
+        throw invalid('incomplete element', pos);
+    }
+    return root;
+};
+
+/**
+ * Writes an element with one child per line
+ * @param element the element
+ * @param indent the indentation of the element itself, which is expected to be written already
+ * @param unit the additional indentation per level
+ * @param newline the line ending
+ */
+export const serializeEconomyElement = (
+    element: EconomyElement,
+    indent: string = '',
+    unit: string = '    ',
+    newline: string = '\n',
+): string => {
+    const attributes = Object.entries(element.attributes ?? {})
+        .map(([key, value]) => ` ${key}="${encode(`${value}`)}"`)
+        .join('');
+    const children = element.children ?? [];
+    if (children.length) {
+        const childIndent = `${indent}${unit}`;
+        const inner = children
+            .map((child) => `${childIndent}${serializeEconomyElement(child, childIndent, unit, newline)}`)
+            .join(newline);
+        return `<${element.tag}${attributes}>${newline}${inner}${newline}${indent}</${element.tag}>`;
+    }
+    if (element.text !== undefined && element.text !== '') {
+        return `<${element.tag}${attributes}>${encode(`${element.text}`)}</${element.tag}>`;
+    }
+    return `<${element.tag}${attributes}/>`;
+};
+
+/**
+ * Applies a patch to an entry
+ * @see EconomyPatch
+ */
+export const patchEconomyElement = (element: EconomyElement, patch: EconomyPatch): void => {
+    for (const [key, value] of Object.entries(patch)) {
+        const [tag, attribute] = key.split('@');
+        if (!tag) {
+            if (attribute === 'name') {
+                throw new Error('The name of an entry can not be patched');
+            }
+            if (value === null) {
+                delete element.attributes[attribute];
+            } else {
+                element.attributes[attribute] = `${value}`;
+            }
+            continue;
+        }
+
+        if (value === null && !attribute) {
+            element.children = element.children.filter((x) => x.tag !== tag);
+            continue;
+        }
+        let child = element.children.find((x) => x.tag === tag);
+        if (!child) {
+            if (value === null) {
+                continue;
+            }
+            child = { tag, attributes: {}, children: [] };
+            element.children.push(child);
+        }
+        if (!attribute) {
+            child.text = `${value}`;
+            child.children = [];
+        } else if (value === null) {
+            delete child.attributes[attribute];
+        } else {
+            child.attributes[attribute] = `${value}`;
+        }
+    }
+};
@@ -0,0 +1,209 @@
+import { FSAPI } from './apis';
+import { TailPosition } from '../types/log-reader';
+
+const READ_CHUNK_SIZE = 65_536;
+const NEWLINE = 0x0A;
+const HEAD_SIZE = 256;
+
+/**
+ * Follows a file by polling it and emits complete lines together with the byte offset after them.
+ *
+ * The file is identified by path, inode and its first bytes, so replaced (rotated) files are read from the beginning.
+ * Truncated files are read from the beginning as well.
+ */
+export class FileTailer {
+
+    private ino = -1;
+    private offset = 0;
+    private head: Buffer = Buffer.alloc(0);
+    private size = 0;
+    private rest: Buffer = Buffer.alloc(0);
+    private timer: any;
+    private polling = false;
+    private lastError: string | undefined;
+
+    /**
+     * Called after the lines of each read chunk were emitted, so consumers can process them as one batch
+     */
+    public onChunkDone?: () => void;
+
+    public constructor(
+        private fs: FSAPI,
+        public readonly FILE: string,
+        private onLine: (line: string, position: TailPosition) => void,
+        private onError?: (e: Error) => void,
+        public readonly POLL_INTERVAL: number = 1000,
+    ) {}
+
+    public get position(): TailPosition {
+        return {
+            file: this.FILE,
+            ino: this.ino,
+            offset: this.offset,
+            head: this.head.toString('base64'),
+        };
+    }
+
+    /**
+     * Checks whether a previous position still belongs to this file
+     * @param resume the last known position
+     */
+    public async canResume(resume?: TailPosition): Promise<boolean> {
+        if (resume?.file !== this.FILE || !(resume.offset > 0)) {
+            return false;
+        }
+        const stats = await this.fs.promises.stat(this.FILE);
+        return resume.ino === stats.ino
+            && resume.offset <= stats.size
+            && this.matchesHead(Buffer.from(resume.head ?? '', 'base64'));
+    }
+
+    /**
+     * Starts following the file
+     * @param resume the last known position of this file, if it is still valid reading continues from there
+     * @param onBackfill receives the lines before the resumed position (which were already emitted previously)
+     * @param follow whether to keep polling the file, otherwise it is only read once until the current end
+     * @returns the offset reading started at
+     */
+    public async start(resume?: TailPosition, onBackfill?: (line: string) => void, follow: boolean = true): Promise<number> {
+        this.stop();
+
+        const stats = await this.fs.promises.stat(this.FILE);
+        this.reset(stats.ino);
+        this.size = stats.size;
+
+        if (await this.canResume(resume)) {
+            if (onBackfill) {
+                await this.read(resume.offset, (line) => onBackfill(line));
+            }
+            this.offset = resume.offset;
+            this.head = Buffer.from(resume.head ?? '', 'base64');
+            this.rest = Buffer.alloc(0);
+        }
+
+        const startOffset = this.offset;
+        await this.poll();
+        if (!follow) {
+            return startOffset;
+        }
+        this.timer = setInterval(
+            () => {
+                void this.poll();
+            },
+            this.POLL_INTERVAL,
+        );
+        return startOffset;
+    }
+
+    public stop(): void {
+        if (this.timer) {
+            clearInterval(this.timer);
+            this.timer = undefined;
+        }
+    }
+
+    /**
+     * Reads everything which was appended since the last poll
+     */
+    public async poll(): Promise<void> {
+        if (this.polling) {
+            return;
+        }
+        this.polling = true;
+        try {
+            const stats = await this.fs.promises.stat(this.FILE);
+            if (
+                stats.ino !== this.ino
+                || stats.size < this.offset
+                || (stats.size !== this.size && !(await this.matchesHead(this.head)))
+            ) {
+                // replaced or truncated
+                this.reset(stats.ino);
+            }
+            this.size = stats.size;
+            if (this.head.length < HEAD_SIZE && stats.size > this.head.length) {
+                this.head = await this.readHead(Math.min(stats.size, HEAD_SIZE));
+            }
+            if (stats.size > this.offset + this.rest.length) {
+                await this.read(stats.size, (line, offset) => {
+                    this.offset = offset;
+                    this.onLine(line, this.position);
+                });
+            }
+            this.lastError = undefined;
+        } catch (e) {
+            // only report when the error changes, otherwise a missing file is reported on every poll
+            if (e?.message !== this.lastError) {
+                this.lastError = e?.message;
+                this.onError?.(e);
+            }
+        } finally {
+            this.polling = false;
+        }
+    }
+
+    private reset(ino: number): void {
+        this.ino = ino;
+        this.offset = 0;
+        this.head = Buffer.alloc(0);
+        this.rest = Buffer.alloc(0);
+    }
+
+    private async matchesHead(head: Buffer): Promise<boolean> {
+        return (await this.readHead(head.length)).equals(head);
+    }
+
+    private async readHead(length: number): Promise<Buffer> {
+        if (!length) {
+            return Buffer.alloc(0);
+        }
+        const handle = await this.fs.promises.open(this.FILE, 'r');
+        try {
+            const buf = Buffer.alloc(length);
+            const { bytesRead } = await handle.read(buf, 0, length, 0);
+            return buf.subarray(0, bytesRead);
+        } finally {
+            await handle.close();
+        }
+    }
+
+    /**
+     * Reads complete lines from the current offset (plus the buffered partial line) until the given size
+     * @param size the byte offset to read to
+     * @param consumer receives each line and the byte offset after it
+     */
+    private async read(size: number, consumer: (line: string, offset: number) => void): Promise<void> {
+        const handle = await this.fs.promises.open(this.FILE, 'r');
+        try {
+            const buf = Buffer.alloc(READ_CHUNK_SIZE);
+            let position = this.offset + this.rest.length;
+            while (position < size) {
+                const { bytesRead } = await handle.read(buf, 0, Math.min(READ_CHUNK_SIZE, size - position), position);
+                if (!bytesRead) {
+                    break;
+                }
+                position += bytesRead;
+
+                const data = this.rest.length ? Buffer.concat([this.rest, buf.subarray(0, bytesRead)]) : buf.subarray(0, bytesRead);
+                // byte offset of data[0] in the file
+                const dataOffset = position - data.length;
+                let start = 0;
+                let end = data.indexOf(NEWLINE, start);
+                while (end !== -1) {
+                    let lineEnd = end;
+                    if (lineEnd > start && data[lineEnd - 1] === 0x0D) {
+                        lineEnd--;
+                    }
+                    consumer(data.toString('utf-8', start, lineEnd), dataOffset + end + 1);
+                    start = end + 1;
+                    end = data.indexOf(NEWLINE, start);
+                }
+                this.rest = Buffer.from(data.subarray(start));
+                this.onChunkDone?.();
+            }
+        } finally {
+            await handle.close();
+        }
+    }
+
+}
@@ -0,0 +1,322 @@
+import { constants, IntervalHistogram, monitorEventLoopDelay, performance, PerformanceObserver } from 'perf_hooks';
+import { InstrumentationHistogram, InstrumentationReport } from '../types/metrics';
+
+export type InstrumentationLabels = Record<string, string>;
+
+/** upper bounds of the duration buckets (ms) */
+export const DURATION_BUCKETS = [1, 5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000];
+
+export const TIMER_CALLBACK_DURATION = 'dzsm_timer_callback_duration_seconds';
+export const SQLITE_QUERY_DURATION = 'dzsm_sqlite_query_duration_seconds';
+export const RCON_COMMAND_DURATION = 'dzsm_rcon_command_duration_seconds';
+export const HTTP_REQUEST_DURATION = 'dzsm_http_request_duration_seconds';
+export const GC_DURATION = 'dzsm_gc_duration_seconds';
+export const EVENT_LOOP_LAG = 'dzsm_event_loop_lag_seconds';
+export const PROCESS_MEMORY = 'dzsm_process_memory_bytes';
+
+/** the event loop lag is reported per window, so old spikes do not hide the current state */
+export const LAG_WINDOW = 10000;
+
+/** label of the series which belong to one server instance of a multi server process */
+export const INSTANCE_LABEL = 'instance';
+
+const GC_KINDS: Record<number, string> = {
+    [constants.NODE_PERFORMANCE_GC_MAJOR]: 'major',
+    [constants.NODE_PERFORMANCE_GC_MINOR]: 'minor',
+    [constants.NODE_PERFORMANCE_GC_INCREMENTAL]: 'incremental',
+    [constants.NODE_PERFORMANCE_GC_WEAKCB]: 'weakcb',
+};
+
+const HELP: Record<string, string> = {
+    [TIMER_CALLBACK_DURATION]: 'Duration of the periodic service callbacks',
+    [SQLITE_QUERY_DURATION]: 'Duration of the SQLite queries',
+    [RCON_COMMAND_DURATION]: 'Round trip of the RCon commands',
+    [HTTP_REQUEST_DURATION]: 'Latency of the http requests',
+    [GC_DURATION]: 'Duration of the garbage collections',
+};
+
+export interface GaugeValue {
+    labels?: InstrumentationLabels;
+    value: number;
+}
+
+interface Gauge {
+    help: string;
+    collect: () => GaugeValue[];
+}
+
+/**
+ * Duration histogram (ms) with fixed buckets
+ */
+export class Histogram {
+
+    /** non cumulative count per bucket, the last one is +Inf */
+    public readonly counts: number[] = new Array(DURATION_BUCKETS.length + 1).fill(0);
+    public count = 0;
+    public sum = 0;
+    public max = 0;
+
+    public constructor(
+        public readonly name: string,
+        public readonly labels: InstrumentationLabels,
+    ) {}
+
+    public observe(ms: number): void {
+        let i = 0;
+        while (i < DURATION_BUCKETS.length && ms > DURATION_BUCKETS[i]) {
+            i++;
+        }
+        this.counts[i]++;
+        this.count++;
+        this.sum += ms;
+        this.max = Math.max(this.max, ms);
+    }
+
+    /**
+     * Runs the function and observes its duration.
+     * If it returns a promise, the duration lasts until the promise is settled.
+     * @param fn the function to time
+     * @returns the result of the function
+     */
+    public time<T>(fn: () => T): T {
+        const start = performance.now();
+        const result = fn();
+        if (result && typeof (result as any).then === 'function') {
+            const done = (): void => this.observe(performance.now() - start);
+            (result as any).then(done, done);
+        } else {
+            this.observe(performance.now() - start);
+        }
+        return result;
+    }
+
+    public snapshot(): InstrumentationHistogram {
+        return {
+            name: this.name,
+            labels: { ...this.labels },
+            count: this.count,
+            sum: Math.round(this.sum * 1000) / 1000,
+            avg: this.count ? Math.round(this.sum / this.count * 1000) / 1000 : 0,
+            max: Math.round(this.max * 1000) / 1000,
+        };
+    }
+
+}
+
+const formatLabels = (labels: InstrumentationLabels | undefined, extra?: string): string => {
+    const parts = Object.keys(labels ?? {})
+        .map((x) => `${x}="${String(labels[x]).replace(/\\/g, '\\\\').replace(/"/g, '\\"').replace(/\n/g, '\\n')}"`);
+    if (extra) {
+        parts.push(extra);
+    }
+    return parts.length ? `{${parts.join(',')}}` : '';
+};
+
+const seconds = (ms: number): number => ms / 1000;
+
+/**
+ * Adds the instance label to the labels of a series, if the manager runs multiple server instances
+ * @param instance the instance id (undefined for a single server)
+ * @param labels the other labels
+ */
+export const instanceLabels = (instance: string | undefined, labels: InstrumentationLabels = {}): InstrumentationLabels =>
+    (instance ? { ...labels, [INSTANCE_LABEL]: instance } : labels);
+
+/**
+ * Process wide registry of the manager's own metrics.
+ *
+ * It is a module singleton (and not injected) because it is used by helpers like the database wrapper,
+ * which are not created by the container, and because the instances of a multi server process share the process.
+ * Series of a single instance carry the instance label, the readers pass an instance to only see its own series
+ * (plus the process wide ones).
+ */
+export class Instrumentation {
+
+    private histograms = new Map<string, Histogram>();
+    private gauges = new Map<string, Gauge>();
+
+    private processUsers = 0;
+    private eventLoop: IntervalHistogram | undefined;
+    private eventLoopLag: InstrumentationReport['eventLoopLag'] = { mean: 0, p99: 0, max: 0 };
+    private lagWindow: any;
+    private gcObserver: PerformanceObserver | undefined;
+
+    /**
+     * Gets (or creates) the histogram of the metric with the given labels.
+     * Hot paths should keep the returned histogram instead of looking it up on every call.
+     * @param name the metric name
+     * @param labels the labels, which must have a small set of values
+     */
+    public histogram(name: string, labels: InstrumentationLabels = {}): Histogram {
+        const key = `${name}${formatLabels(labels)}`;
+        let histogram = this.histograms.get(key);
+        if (!histogram) {
+            histogram = new Histogram(name, labels);
+            this.histograms.set(key, histogram);
+        }
+        return histogram;
+    }
+
+    public observe(name: string, labels: InstrumentationLabels, ms: number): void {
+        this.histogram(name, labels).observe(ms);
+    }
+
+    public time<T>(name: string, labels: InstrumentationLabels, fn: () => T): T {
+        return this.histogram(name, labels).time(fn);
+    }
+
+    /**
+     * Registers a gauge whose values are collected on read
+     * @param name the metric name
+     * @param help the description
+     * @param collect returns the current values
+     */
+    public registerGauge(name: string, help: string, collect: () => GaugeValue[]): void {
+        this.gauges.set(name, { help, collect });
+    }
+
+    public unregisterGauge(name: string): void {
+        this.gauges.delete(name);
+    }
+
+    /**
+     * @param histogram the histogram
+     * @param instance the reading instance (undefined to read all)
+     * @returns whether the histogram is process wide or belongs to the instance
+     */
+    private isVisible(histogram: Histogram, instance?: string): boolean {
+        const owner = histogram.labels[INSTANCE_LABEL];
+        return !instance || !owner || owner === instance;
+    }
+
+    public getHistograms(instance?: string): InstrumentationHistogram[] {
+        return [...this.histograms.values()]
+            .filter((x) => this.isVisible(x, instance))
+            .map((x) => x.snapshot());
+    }
+
+    /**
+     * Starts measuring the event loop lag and the garbage collections.
+     * Every server instance of the process starts it, so it only stops when the last one stopped.
+     */
+    public startProcessMetrics(): void {
+        if (this.processUsers++ > 0) {
+            return;
+        }
+
+        this.eventLoop = monitorEventLoopDelay({ resolution: 20 });
+        this.eventLoop.enable();
+        this.lagWindow = setInterval(() => this.rollLagWindow(), LAG_WINDOW);
+        this.lagWindow.unref?.();
+
+        this.gcObserver = new PerformanceObserver((list) => {
+            for (const entry of list.getEntries()) {
+                // the kind moved to the details in node 16
+                const kind = (entry as any).detail?.kind ?? (entry as any).kind;
+                this.observe(GC_DURATION, { kind: GC_KINDS[kind] ?? 'other' }, entry.duration);
+            }
+        });
+        this.gcObserver.observe({ entryTypes: ['gc'] });
+
+        this.registerGauge(EVENT_LOOP_LAG, 'Event loop lag of the last window', () => [
+            { labels: { stat: 'mean' }, value: seconds(this.eventLoopLag.mean) },
+            { labels: { stat: 'p99' }, value: seconds(this.eventLoopLag.p99) },
+            { labels: { stat: 'max' }, value: seconds(this.eventLoopLag.max) },
+        ]);
+        this.registerGauge(PROCESS_MEMORY, 'Memory of the process', () => {
+            const memory = this.getMemory();
+            return Object.keys(memory).map((x) => ({ labels: { type: x }, value: memory[x as keyof typeof memory] }));
+        });
+    }
+
+    public stopProcessMetrics(): void {
+        if (this.processUsers === 0 || --this.processUsers > 0) {
+            return;
+        }
+
+        clearInterval(this.lagWindow);
+        this.lagWindow = undefined;
+        this.eventLoop?.disable();
+        this.eventLoop = undefined;
+        this.eventLoopLag = { mean: 0, p99: 0, max: 0 };
+        this.gcObserver?.disconnect();
+        this.gcObserver = undefined;
+        this.unregisterGauge(EVENT_LOOP_LAG);
+        this.unregisterGauge(PROCESS_MEMORY);
+    }
+
+    private rollLagWindow(): void {
+        // the histogram is in ns and has no samples (max 0) if the window was shorter than the resolution
+        const ms = (ns: number): number => (this.eventLoop.max > 0 ? Math.round(ns / 1000) / 1000 : 0);
+        this.eventLoopLag = {
+            mean: ms(this.eventLoop.mean),
+            p99: ms(this.eventLoop.percentile(99)),
+            max: ms(this.eventLoop.max),
+        };
+        this.eventLoop.reset();
+    }
+
+    public getMemory(): InstrumentationReport['memory'] {
+        const memory = process.memoryUsage();
+        return {
+            rss: memory.rss,
+            heapTotal: memory.heapTotal,
+            heapUsed: memory.heapUsed,
+            external: memory.external,
+        };
+    }
+
+    public getReport(instance?: string): InstrumentationReport {
+        return {
+            eventLoopLag: { ...this.eventLoopLag },
+            memory: this.getMemory(),
+            histograms: this.getHistograms(instance),
+        };
+    }
+
+    /**
+     * @param instance only include the series of this instance and the process wide ones
+     * @returns the metrics in the prometheus text exposition format (durations in seconds)
+     */
+    public toPrometheus(instance?: string): string {
+        const lines: string[] = [];
+
+        const byName = new Map<string, Histogram[]>();
+        for (const histogram of this.histograms.values()) {
+            if (!this.isVisible(histogram, instance)) {
+                continue;
+            }
+            if (!byName.has(histogram.name)) {
+                byName.set(histogram.name, []);
+            }
+            byName.get(histogram.name).push(histogram);
+        }
+        for (const [name, histograms] of byName) {
+            lines.push(`# HELP ${name} ${HELP[name] ?? name}`);
+            lines.push(`# TYPE ${name} histogram`);
+            for (const histogram of histograms) {
+                let cumulative = 0;
+                DURATION_BUCKETS.forEach((bound, i) => {
+                    cumulative += histogram.counts[i];
+                    lines.push(`${name}_bucket${formatLabels(histogram.labels, `le="${seconds(bound)}"`)} ${cumulative}`);
+                });
+                lines.push(`${name}_bucket${formatLabels(histogram.labels, 'le="+Inf"')} ${histogram.count}`);
+                lines.push(`${name}_sum${formatLabels(histogram.labels)} ${seconds(histogram.sum)}`);
+                lines.push(`${name}_count${formatLabels(histogram.labels)} ${histogram.count}`);
+            }
+        }
+
+        for (const [name, gauge] of this.gauges) {
+            lines.push(`# HELP ${name} ${gauge.help}`);
+            lines.push(`# TYPE ${name} gauge`);
+            for (const value of gauge.collect()) {
+                lines.push(`${name}${formatLabels(value.labels)} ${value.value}`);
+            }
+        }
+
+        return `${lines.join('\n')}\n`;
+    }
+
+}
+
+export const instrumentation = new Instrumentation();
@@ -0,0 +1,309 @@
+import * as path from 'path';
+import { FSAPI } from './apis';
+import { LogMessage } from '../types/log-reader';
+
+interface SegmentIndexEntry {
+    timestamp: number;
+    offset: number;
+}
+
+interface Segment {
+    file: string;
+    last: number;
+    size: number;
+    lines: number;
+    // sparse index: timestamp and byte offset of every n-th line
+    index: SegmentIndexEntry[];
+}
+
+const READ_CHUNK_SIZE = 65_536;
+const NEWLINE = 0x0A;
+const SEGMENT_FILE = /^segment-\d+\.log$/;
+
+/**
+ * Log lines of one log type.
+ *
+ * The latest lines are kept in a fixed size ring buffer.
+ * Older lines are spilled in batches to append-only segment files (one "timestamp\tmessage" per line)
+ * with a sparse timestamp index, so any range can be read without keeping the history on the heap.
+ * Timestamps are strictly increasing, so the timestamp of any line is a valid paging cursor.
+ */
+export class LogStore {
+
+    private ring: LogMessage[];
+    private head = 0;
+    private count = 0;
+    private lastTimestamp = Number.NEGATIVE_INFINITY;
+
+    private segments: Segment[] = [];
+    private segmentCounter = 0;
+
+    public constructor(
+        private fs: FSAPI,
+        private dir: string,
+        public readonly CAPACITY: number = 10_000,
+        public readonly SEGMENT_SIZE: number = 16_777_216,
+        public readonly INDEX_INTERVAL: number = 256,
+    ) {
+        this.ring = new Array(Math.max(1, CAPACITY));
+        this.removeSegmentFiles();
+    }
+
+    public get size(): number {
+        return this.count + this.segments.reduce((sum, x) => sum + x.lines, 0);
+    }
+
+    public get segmentFiles(): string[] {
+        return this.segments.map((x) => x.file);
+    }
+
+    /**
+     * Removes all lines from memory and disk
+     */
+    public clear(): void {
+        this.ring = new Array(this.ring.length);
+        this.head = 0;
+        this.count = 0;
+        this.lastTimestamp = Number.NEGATIVE_INFINITY;
+        this.segments = [];
+        this.removeSegmentFiles();
+    }
+
+    /**
+     * Removes all segment files in the store dir, including the ones left over from earlier runs
+     * (the segment counter restarts with every run, so those would never be reused or cleaned up)
+     */
+    private removeSegmentFiles(): void {
+        if (!this.fs.existsSync(this.dir)) {
+            return;
+        }
+        for (const file of this.fs.readdirSync(this.dir)) {
+            if (SEGMENT_FILE.test(file)) {
+                this.fs.unlinkSync(path.join(this.dir, file));
+            }
+        }
+    }
+
+    /**
+     * Appends a line. Lines which are not newer than the previous one
+     * (i.e. read within the same millisecond) are moved to the next free millisecond.
+     * @param entry the line
+     * @returns the stored line
+     */
+    public push(entry: LogMessage): LogMessage {
+        const line = entry.timestamp > this.lastTimestamp
+            ? entry
+            : { ...entry, timestamp: this.lastTimestamp + 1 };
+        this.lastTimestamp = line.timestamp;
+
+        if (this.count === this.ring.length) {
+            this.spill(Math.max(1, Math.floor(this.ring.length / 4)));
+        }
+        this.ring[(this.head + this.count) % this.ring.length] = line;
+        this.count++;
+        return line;
+    }
+
+    private at(idx: number): LogMessage {
+        return this.ring[(this.head + idx) % this.ring.length];
+    }
+
+    /**
+     * Moves the oldest lines of the ring buffer to the current segment
+     * @param amount number of lines
+     */
+    private spill(amount: number): void {
+        let segment = this.segments[this.segments.length - 1];
+        if (!segment || segment.size >= this.SEGMENT_SIZE) {
+            if (!this.fs.existsSync(this.dir)) {
+                this.fs.mkdirSync(this.dir, { recursive: true });
+            }
+            segment = {
+                file: path.join(this.dir, `segment-${this.segmentCounter++}.log`),
+                last: this.at(0).timestamp,
+                size: 0,
+                lines: 0,
+                index: [],
+            };
+            this.fs.writeFileSync(segment.file, '');
+            this.segments.push(segment);
+        }
+
+        const chunks: Buffer[] = [];
+        let chunkSize = 0;
+        for (let i = 0; i < amount && this.count > 0; i++) {
+            const line = this.at(0);
+            this.ring[this.head] = undefined;
+            this.head = (this.head + 1) % this.ring.length;
+            this.count--;
+
+            if (segment.lines % this.INDEX_INTERVAL === 0) {
+                segment.index.push({ timestamp: line.timestamp, offset: segment.size + chunkSize });
+            }
+            const buf = Buffer.from(`${line.timestamp}\t${line.message.replace(/[\r\n]/g, ' ')}\n`, 'utf-8');
+            chunks.push(buf);
+            chunkSize += buf.length;
+            segment.lines++;
+            segment.last = line.timestamp;
+        }
+        this.fs.appendFileSync(segment.file, Buffer.concat(chunks));
+        segment.size += chunkSize;
+    }
+
+    /**
+     * Finds the index of the first ring buffer entry newer than the given timestamp
+     * @param since the timestamp
+     */
+    private findInRing(since: number): number {
+        let low = 0;
+        let high = this.count;
+        while (low < high) {
+            const mid = (low + high) >>> 1;
+            if (this.at(mid).timestamp <= since) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+    /**
+     * Finds the byte offset of the last indexed line which is not newer than the given timestamp
+     * @param segment the segment
+     * @param since the timestamp
+     */
+    private findInSegment(segment: Segment, since: number): number {
+        let low = 0;
+        let high = segment.index.length - 1;
+        let offset = 0;
+        while (low <= high) {
+            const mid = (low + high) >>> 1;
+            if (segment.index[mid].timestamp <= since) {
+                offset = segment.index[mid].offset;
+                low = mid + 1;
+            } else {
+                high = mid - 1;
+            }
+        }
+        return offset;
+    }
+
+    /**
+     * Reads the lines of a segment starting at the given offset
+     * @param segment the segment
+     * @param offset the byte offset (must be the start of a line)
+     * @param consumer receives the lines, returns false to stop reading
+     * @returns false if the consumer stopped reading
+     */
+    private async readSegment(
+        segment: Segment,
+        offset: number,
+        consumer: (line: LogMessage) => boolean,
+    ): Promise<boolean> {
+        const handle = await this.fs.promises.open(segment.file, 'r');
+        try {
+            const buf = Buffer.alloc(READ_CHUNK_SIZE);
+            let position = offset;
+            let rest = Buffer.alloc(0);
+            while (position < segment.size) {
+                const { bytesRead } = await handle.read(buf, 0, Math.min(READ_CHUNK_SIZE, segment.size - position), position);
+                if (!bytesRead) {
+                    break;
+                }
+                position += bytesRead;
+
+                const data = rest.length ? Buffer.concat([rest, buf.subarray(0, bytesRead)]) : buf.subarray(0, bytesRead);
+                let start = 0;
+                let end = data.indexOf(NEWLINE, start);
+                while (end !== -1) {
+                    const line = data.toString('utf-8', start, end);
+                    const sep = line.indexOf('\t');
+                    if (!consumer({ timestamp: Number(line.slice(0, sep)), message: line.slice(sep + 1) })) {
+                        return false;
+                    }
+                    start = end + 1;
+                    end = data.indexOf(NEWLINE, start);
+                }
+                rest = Buffer.from(data.subarray(start));
+            }
+        } finally {
+            await handle.close();
+        }
+        return true;
+    }
+
+    /**
+     * Fetches the newest lines, oldest first
+     * @param limit max number of lines
+     */
+    private async fetchLatest(limit: number): Promise<LogMessage[]> {
+        const result: LogMessage[] = [];
+        let skip = this.size - limit;
+        for (const segment of this.segments) {
+            if (skip >= segment.lines) {
+                skip -= segment.lines;
+                continue;
+            }
+            // there is an index entry every INDEX_INTERVAL lines, so whole intervals are skipped via the index
+            const entry = Math.floor(Math.max(0, skip) / this.INDEX_INTERVAL);
+            skip -= entry * this.INDEX_INTERVAL;
+            await this.readSegment(segment, segment.index[entry]?.offset ?? 0, (line) => {
+                if (skip-- <= 0) {
+                    result.push(line);
+                }
+                return true;
+            });
+        }
+        for (let i = Math.max(0, skip); i < this.count; i++) {
+            result.push(this.at(i));
+        }
+        return result;
+    }
+
+    /**
+     * Fetches lines newer than the given timestamp, oldest first.
+     * The timestamp of the last line can be used as "since" of the next call.
+     * Without a timestamp, the newest lines up to the limit are returned.
+     * @param since lower timestamp bound (exclusive)
+     * @param limit max number of lines
+     */
+    public async fetch(since?: number, limit?: number): Promise<LogMessage[]> {
+        if (since === undefined && limit) {
+            return this.fetchLatest(limit);
+        }
+
+        const from = since ?? 0;
+        const result: LogMessage[] = [];
+        const consumer = (line: LogMessage): boolean => {
+            if (line.timestamp <= from) {
+                return true;
+            }
+            if (limit && result.length >= limit) {
+                return false;
+            }
+            result.push(line);
+            return true;
+        };
+
+        // anything older than the ring buffer lives on disk
+        if (!this.count || from < this.at(0).timestamp) {
+            for (const segment of this.segments) {
+                if (segment.last <= from) {
+                    continue;
+                }
+                if (!await this.readSegment(segment, this.findInSegment(segment, from), consumer)) {
+                    return result;
+                }
+            }
+        }
+
+        for (let i = this.findInRing(from); i < this.count; i++) {
+            if (!consumer(this.at(i))) {
+                break;
+            }
+        }
+        return result;
+    }
+
+}
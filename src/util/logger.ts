@@ -73,6 +73,7 @@ export class Logger {
 
     public constructor(
         private context: string,
+        private instance?: string,
     ) { }
 
     private formatContext(context: string): string {
@@ -82,18 +83,25 @@ export class Logger {
         return context.padEnd(this.MAX_CONTEXT_LENGTH);
     }
 
+    /**
+     * Allows to skip building messages which would not be logged anyway
+     */
+    public isLevelEnabled(level: LogLevel): boolean {
+        return level >= (Logger.LOG_LEVELS[this.context] ?? Logger.defaultLogLevel);
+    }
+
     public log(
         level: LogLevel,
         msg: string,
         ...data: any[]
     ): void {
 
-        const allowedLevel = Logger.LOG_LEVELS[this.context] ?? Logger.defaultLogLevel;
-        if (level >= allowedLevel) {
+        if (this.isLevelEnabled(level)) {
             const date = new Date().toLocaleString('VN', { timeZone: 'Asia/ho_chi_minh' });
                 //? new Date().toLocaleString('VN', { timeZone: 'Asia/ho_chi_minh' })
                 //: new Date().toISOString();
-            const fmt = `@${date} | ${LogLevelNames[level]} | ${this.formatContext(this.context)} | ${msg}`;
+            const instance = this.instance ? `[${this.instance}] ` : '';
+            const fmt = `@${date} | ${LogLevelNames[level]} | ${this.formatContext(this.context)} | ${instance}${msg}`;
 
             Logger.LogLevelFncs[level](fmt, data);
         }
@@ -36,6 +36,10 @@ export const request = (
                 },
             );
 
+            req.on('error', (error) => {
+                reject(error);
+            });
+
             if (opts?.body) {
                 req.write(opts.body);
             }
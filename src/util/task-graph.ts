@@ -0,0 +1,169 @@
+export interface GraphTask {
+    name: string;
+    /** names of the tasks that have to be finished before this one is started */
+    dependsOn?: string[];
+    run: () => Promise<unknown>;
+}
+
+export interface TaskTiming {
+    name: string;
+    /** ms since the graph was started */
+    start: number;
+    duration: number;
+    /** not run because a dependency failed */
+    skipped?: boolean;
+    error?: Error;
+}
+
+export interface TaskGraphResult {
+    /** timings in the order the tasks were finished */
+    timings: TaskTiming[];
+    duration: number;
+    /** the chain of tasks which determined the total duration */
+    criticalPath: TaskTiming[];
+}
+
+export class TaskGraphError extends Error {
+
+    public constructor(public readonly result: TaskGraphResult, public readonly reason: Error) {
+        super(reason?.message);
+        this.name = 'TaskGraphError';
+    }
+
+}
+
+/**
+ * @throws if a task is defined twice, depends on an unknown task or the dependencies contain a cycle
+ */
+export const validateTaskGraph = (tasks: GraphTask[]): void => {
+    const byName = new Map<string, GraphTask>();
+    for (const task of tasks) {
+        if (byName.has(task.name)) {
+            throw new Error(`Duplicate task: ${task.name}`);
+        }
+        byName.set(task.name, task);
+    }
+
+    const done = new Set<string>();
+    const visiting: string[] = [];
+    const visit = (task: GraphTask): void => {
+        if (done.has(task.name)) return;
+        if (visiting.includes(task.name)) {
+            throw new Error(`Cyclic task dependency: ${[...visiting.slice(visiting.indexOf(task.name)), task.name].join(' -> ')}`);
+        }
+        visiting.push(task.name);
+        for (const dep of task.dependsOn ?? []) {
+            const depTask = byName.get(dep);
+            if (!depTask) {
+                throw new Error(`Task ${task.name} depends on unknown task ${dep}`);
+            }
+            visit(depTask);
+        }
+        visiting.pop();
+        done.add(task.name);
+    };
+    tasks.forEach(visit);
+};
+
+/**
+ * Follows the dependency that finished last, starting from the task that finished last
+ */
+const getCriticalPath = (tasks: GraphTask[], timings: Map<string, TaskTiming>): TaskTiming[] => {
+    const end = (timing?: TaskTiming): number => (timing && !timing.skipped) ? timing.start + timing.duration : -1;
+    const byName = new Map(tasks.map((x) => [x.name, x]));
+    const path: TaskTiming[] = [];
+    let current = [...timings.values()].reduce((a, b) => (end(b) > end(a) ? b : a), undefined as TaskTiming | undefined);
+    while (current && !current.skipped) {
+        path.unshift(current);
+        current = (byName.get(current.name).dependsOn ?? [])
+            .map((x) => timings.get(x))
+            .reduce((a, b) => (end(b) > end(a) ? b : a), undefined as TaskTiming | undefined);
+    }
+    return path;
+};
+
+/**
+ * Runs tasks as soon as all of their dependencies are finished, independent tasks run concurrently.
+ *
+ * If a task fails, the tasks depending on it are skipped while all others are still run to the end.
+ * @throws TaskGraphError with the first error and the timings once all tasks are settled
+ */
+export const runTaskGraph = async (tasks: GraphTask[]): Promise<TaskGraphResult> => {
+    validateTaskGraph(tasks);
+
+    const graphStart = Date.now();
+    const timings = new Map<string, TaskTiming>();
+    const pending = new Set(tasks.map((x) => x.name));
+    let running = 0;
+    let firstError: Error | undefined;
+
+    return new Promise<TaskGraphResult>((resolve, reject) => {
+        const settle = (): void => {
+            const result: TaskGraphResult = {
+                timings: [...timings.values()],
+                duration: Date.now() - graphStart,
+                criticalPath: getCriticalPath(tasks, timings),
+            };
+            if (firstError) {
+                reject(new TaskGraphError(result, firstError));
+            } else {
+                resolve(result);
+            }
+        };
+
+        const schedule = (): void => {
+            // skipping a task can make others skippable, so repeat until nothing changes
+            let changed = true;
+            while (changed) {
+                changed = false;
+                for (const task of tasks) {
+                    if (!pending.has(task.name)) continue;
+                    const deps = (task.dependsOn ?? []).map((x) => timings.get(x));
+                    if (deps.some((x) => x && (x.skipped || x.error))) {
+                        pending.delete(task.name);
+                        timings.set(task.name, {
+                            name: task.name,
+                            start: Date.now() - graphStart,
+                            duration: 0,
+                            skipped: true,
+                        });
+                        changed = true;
+                    } else if (deps.every((x) => !!x)) {
+                        pending.delete(task.name);
+                        running++;
+                        const start = Date.now();
+                        void Promise.resolve()
+                            .then(() => task.run())
+                            .then(
+                                () => undefined,
+                                (e) => {
+                                    const error = e instanceof Error ? e : new Error(`Task ${task.name} failed: ${e}`);
+                                    firstError = firstError ?? error;
+                                    return error;
+                                },
+                            )
+                            .then((error) => {
+                                timings.set(task.name, {
+                                    name: task.name,
+                                    start: start - graphStart,
+                                    duration: Date.now() - start,
+                                    ...(error ? { error } : {}),
+                                });
+                                running--;
+                                schedule();
+                            });
+                    }
+                }
+            }
+            if (!running && !pending.size) {
+                settle();
+            }
+        };
+
+        schedule();
+    });
+};
+
+export const formatTaskTimings = (timings: TaskTiming[]): string => timings
+    .map((x) => `${x.name} (${x.skipped ? 'skipped' : `${x.duration}ms`})`)
+    .join(' -> ');
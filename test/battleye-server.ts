@@ -0,0 +1,99 @@
+import { Connection, IPacketResponse, Socket } from '@senfo/battleye';
+import { sleep } from './util';
+
+export type FakeCommandHandler = (command: string) => string | Promise<string>;
+
+/**
+ * Local stand-in for the BattlEye RCon server on the api level of the battleye library.
+ *
+ * Register `server.socketFactory` as rconSocket, then script the responses and their latency per command verb.
+ */
+export class FakeBattleyeServer {
+
+    /** response per command verb, unknown commands get an empty response */
+    public handlers = new Map<string, FakeCommandHandler>();
+    /** response time (ms) per command verb */
+    public latency = new Map<string, number>();
+    /** commands that never get a response */
+    public hang = new Set<string>();
+
+    /** commands in the order they reached the server */
+    public received: string[] = [];
+    public maxConcurrent = 0;
+    public connected = false;
+
+    private active = 0;
+    private listeners = new Map<string, ((...args: any[]) => any)[]>();
+
+    public readonly connection = {
+        on: (event: string, cb: (...args: any[]) => any) => {
+            this.listeners.set(event, [...(this.listeners.get(event) ?? []), cb]);
+            return this.connection;
+        },
+        removeAllListeners: () => {
+            this.listeners.clear();
+            return this.connection;
+        },
+        kill: () => {
+            this.connected = false;
+        },
+        command: (command: string) => this.command(command),
+        get connected(): boolean {
+            return true;
+        },
+    } as any as Connection;
+
+    public readonly socket = {
+        on: () => this.socket,
+        removeAllListeners: () => this.socket,
+        connection: () => {
+            // the login is answered asynchronously like the real server
+            setTimeout(() => this.connect());
+            return this.connection;
+        },
+    } as any as Socket;
+
+    public readonly socketFactory = (): Socket => this.socket;
+
+    public connect(): void {
+        this.connected = true;
+        this.emit('connected');
+    }
+
+    public disconnect(): void {
+        this.connected = false;
+        this.emit('disconnected', 'test');
+    }
+
+    /** sends a server message (i.e. player connects) */
+    public message(message: string): void {
+        this.emit('message', message);
+    }
+
+    private emit(event: string, ...args: any[]): void {
+        for (const cb of this.listeners.get(event) ?? []) {
+            void cb(...args);
+        }
+    }
+
+    private async command(command: string): Promise<IPacketResponse> {
+        this.received.push(command);
+        const verb = command.split(' ')[0];
+
+        if (this.hang.has(verb)) {
+            return new Promise<IPacketResponse>(() => { /* never answers */ });
+        }
+
+        this.active++;
+        this.maxConcurrent = Math.max(this.maxConcurrent, this.active);
+        try {
+            await sleep(this.latency.get(verb) ?? 0);
+            const handler = this.handlers.get(verb);
+            const data = handler ? await handler(command) : '';
+            return { command, data } as IPacketResponse;
+        } finally {
+            this.active--;
+        }
+    }
+
+}
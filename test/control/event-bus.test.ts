@@ -0,0 +1,100 @@
+import 'reflect-metadata';
+
+import * as sinon from 'sinon';
+import { expect } from '../expect';
+import { disableConsole, enableConsole } from '../util';
+import { DependencyContainer, Lifecycle, container } from 'tsyringe';
+import { EventBus } from '../../src/control/event-bus';
+import { InternalEventTypes } from '../../src/types/events';
+import { ServerState } from '../../src/types/monitor';
+import { LogEntryEvent, LogTypeEnum } from '../../src/types/log-reader';
+
+describe('Test class EventBus', () => {
+
+    let injector: DependencyContainer;
+    let eventBus: EventBus;
+
+    const logEntry = (message: string): LogEntryEvent => ({
+        type: LogTypeEnum.RPT,
+        entry: { timestamp: 1, message },
+    });
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        container.reset();
+        injector = container.createChildContainer();
+        injector.register(EventBus, EventBus, { lifecycle: Lifecycle.Singleton });
+        eventBus = injector.resolve(EventBus);
+    });
+
+    it('EventBus-emit', async () => {
+        const listener = sinon.stub().resolves();
+        const handle = eventBus.on(InternalEventTypes.MONITOR_STATE_CHANGE, listener);
+
+        eventBus.emit(InternalEventTypes.MONITOR_STATE_CHANGE, ServerState.STARTED, ServerState.STARTING);
+        expect(listener.calledOnceWith(ServerState.STARTED, ServerState.STARTING)).to.be.true;
+
+        handle.off();
+        eventBus.emit(InternalEventTypes.MONITOR_STATE_CHANGE, ServerState.STOPPED, ServerState.STARTED);
+        expect(listener.callCount).to.equal(1);
+
+        // request collects the results of all listeners
+        eventBus.on(InternalEventTypes.GET_INTERNAL_MODS, async () => ['@mod']);
+        expect(await Promise.all(await eventBus.request(InternalEventTypes.GET_INTERNAL_MODS))).to.deep.equal([['@mod']]);
+    });
+
+    it('EventBus-fast-path', async () => {
+        const single: string[] = [];
+        const batches: string[][] = [];
+        const singleHandle = eventBus.on(InternalEventTypes.LOG_ENTRY, async (x) => {
+            single.push(x.entry.message);
+        });
+        eventBus.onBatch(InternalEventTypes.LOG_ENTRY, (x) => {
+            batches.push(x.map((y) => y.entry.message));
+        });
+
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, logEntry('a'));
+        eventBus.emitBatch(InternalEventTypes.LOG_ENTRY, [logEntry('b'), logEntry('c')]);
+        eventBus.emitBatch(InternalEventTypes.LOG_ENTRY, []);
+
+        expect(single).to.deep.equal(['a', 'b', 'c']);
+        expect(batches).to.deep.equal([['a'], ['b', 'c']]);
+
+        singleHandle.off();
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, logEntry('d'));
+        expect(single).to.deep.equal(['a', 'b', 'c']);
+        expect(batches.length).to.equal(3);
+
+        eventBus.clear(InternalEventTypes.LOG_ENTRY);
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, logEntry('e'));
+        eventBus.emitBatch(InternalEventTypes.LOG_ENTRY, [logEntry('f')]);
+        expect(batches.length).to.equal(3);
+    });
+
+    it('EventBus-fast-path-errors', async () => {
+        const received: string[] = [];
+        eventBus.on(InternalEventTypes.LOG_ENTRY, (() => {
+            throw new Error('sync');
+        }) as any);
+        eventBus.onBatch(InternalEventTypes.LOG_ENTRY, () => {
+            throw new Error('sync');
+        });
+        eventBus.on(InternalEventTypes.LOG_ENTRY, async (x) => {
+            received.push(x.entry.message);
+        });
+
+        // failing listeners do not affect the others
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, logEntry('a'));
+        eventBus.emitBatch(InternalEventTypes.LOG_ENTRY, [logEntry('b')]);
+
+        expect(received).to.deep.equal(['a', 'b']);
+    });
+
+});
@@ -0,0 +1,181 @@
+import 'reflect-metadata';
+
+import * as sinon from 'sinon';
+import * as path from 'path';
+import { expect } from '../expect';
+import { disableConsole, enableConsole, fakeChildProcess, memfs } from '../util';
+import { container, injectable, Lifecycle } from 'tsyringe';
+import { InstanceSupervisor } from '../../src/control/instance-supervisor';
+import { ManagerController } from '../../src/control/manager-controller';
+import { Manager } from '../../src/control/manager';
+import { EventBus } from '../../src/control/event-bus';
+import { LoggerFactory } from '../../src/services/loggerfactory';
+import { Paths } from '../../src/services/paths';
+import { DatabaseConnections } from '../../src/services/database';
+import { SteamCmdLock } from '../../src/services/steamcmd';
+import { InjectionTokens } from '../../src/util/apis';
+import { LogReader } from '../../src/services/log-reader';
+
+@injectable()
+class TestController {
+    public start = sinon.stub().resolves();
+    public stop = sinon.stub().resolves();
+
+    public constructor(public manager: Manager) {}
+}
+
+describe('Test class InstanceSupervisor', () => {
+
+    let root: string;
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        container.reset();
+        root = path.resolve('/manager');
+
+        memfs(
+            {
+                [InstanceSupervisor.INSTANCES_FILE]: JSON.stringify({
+                    instances: [
+                        { id: 'chernarus', path: 'chernarus' },
+                        { id: 'livonia', path: path.resolve('/servers/livonia') },
+                    ],
+                }),
+            },
+            root,
+            container,
+        );
+        fakeChildProcess(container);
+
+        // the services are registered in the root container like with the decorators
+        for (const service of [InstanceSupervisor, LoggerFactory, Paths, Manager, EventBus, DatabaseConnections, SteamCmdLock]) {
+            container.register(service as any, service as any, { lifecycle: Lifecycle.Singleton });
+        }
+        container.register(ManagerController, TestController as any, { lifecycle: Lifecycle.ContainerScoped });
+        container.resolve(Paths).setCwd(root);
+    });
+
+    afterEach(() => {
+        sinon.restore();
+    });
+
+    it('InstanceSupervisor-readInstances', () => {
+        const fs = container.resolve<any>(InjectionTokens.fs);
+        const supervisor = container.resolve(InstanceSupervisor);
+        const file = path.join(root, InstanceSupervisor.INSTANCES_FILE);
+
+        expect(supervisor.readInstances().map((x) => x.id)).to.deep.equal(['chernarus', 'livonia']);
+
+        fs.writeFileSync(file, JSON.stringify({ instances: [] }));
+        expect(() => supervisor.readInstances()).to.throw('does not contain any instances');
+
+        fs.writeFileSync(file, JSON.stringify({ instances: [{ id: 'a' }] }));
+        expect(() => supervisor.readInstances()).to.throw('needs an id and a path');
+
+        fs.writeFileSync(file, JSON.stringify({ instances: [{ id: 'a', path: 'a' }, { id: 'b', path: 'A' }] }));
+        expect(() => supervisor.readInstances()).to.throw('Instance b is not unique');
+
+        fs.unlinkSync(file);
+        expect(supervisor.readInstances()).to.be.undefined;
+    });
+
+    it('InstanceSupervisor-containers', () => {
+        const supervisor = container.resolve(InstanceSupervisor);
+        const [chernarus, livonia] = supervisor.readInstances().map((x) => supervisor.createInstanceContainer(x));
+
+        // each instance has its own services
+        expect(chernarus.resolve(Manager)).to.not.equal(livonia.resolve(Manager));
+        expect(chernarus.resolve(EventBus)).to.not.equal(livonia.resolve(EventBus));
+        expect(chernarus.resolve(Manager)).to.equal(chernarus.resolve(Manager));
+        expect(chernarus.resolve(Manager).instanceName).to.equal('chernarus');
+        expect(chernarus.resolve<any>(InjectionTokens.container)).to.equal(chernarus);
+        expect(chernarus.resolve(LoggerFactory).instance).to.equal('chernarus');
+
+        // in its own dir
+        expect(chernarus.resolve(Paths).cwd()).to.equal(path.join(root, 'chernarus'));
+        expect(livonia.resolve(Paths).cwd()).to.equal(path.resolve('/servers/livonia'));
+        expect(chernarus.resolve(Paths).sharedCwd()).to.equal(root);
+        expect(container.resolve(Paths).sharedCwd()).to.equal(root);
+
+        // all other services are registered per instance
+        for (const service of InstanceSupervisor.INSTANCE_SERVICES) {
+            expect(InstanceSupervisor.SHARED_SERVICES).to.not.include(service);
+            expect(chernarus.isRegistered(service)).to.be.true;
+        }
+
+        // shared services
+        expect(chernarus.resolve(DatabaseConnections)).to.equal(livonia.resolve(DatabaseConnections));
+        expect(chernarus.resolve(SteamCmdLock)).to.equal(container.resolve(SteamCmdLock));
+        expect(chernarus.resolve(InjectionTokens.fs)).to.equal(container.resolve(InjectionTokens.fs));
+    });
+
+    it('InstanceSupervisor-service-order', () => {
+        // the start order of the stateful services follows the registration order
+        const services = InstanceSupervisor.INSTANCE_SERVICES;
+        const injected = (service: any): any[] => (Reflect.getMetadata('design:paramtypes', service) ?? [])
+            .filter((x) => services.includes(x));
+        const reaches = (from: any, to: any, seen = new Set<any>()): boolean => injected(from)
+            .some((x) => x === to || (!seen.has(x) && seen.add(x) && reaches(x, to, seen)));
+        services.forEach((service, index) => {
+            for (const dependency of injected(service)) {
+                // cyclic (delayed) injections can not be ordered
+                if (reaches(dependency, service)) continue;
+                expect(services.indexOf(dependency), `${service.name} injects ${dependency.name}`).to.be.lessThan(index);
+            }
+        });
+    });
+
+    it('InstanceSupervisor-start-stop', async () => {
+        // the test controller is created per container by its own registration
+        sinon.stub(InstanceSupervisor, 'INSTANCE_SERVICES').value([Manager, EventBus, Paths]);
+        const supervisor = container.resolve(InstanceSupervisor);
+        await supervisor.start(supervisor.readInstances());
+
+        const instances = supervisor.getInstances();
+        const controllers = instances.map((x) => x.controller as any as TestController);
+        expect(instances.map((x) => x.definition.id)).to.deep.equal(['chernarus', 'livonia']);
+        expect(controllers[0]).to.not.equal(controllers[1]);
+        expect(controllers[0].manager.instanceName).to.equal('chernarus');
+        expect(controllers.every((x) => x.start.calledOnce)).to.be.true;
+
+        controllers[1].stop.rejects(new Error('Test'));
+        await supervisor.stop();
+        expect(controllers.every((x) => x.stop.calledOnce)).to.be.true;
+        expect(supervisor.getInstances()).to.be.empty;
+    });
+
+    it('InstanceSupervisor-instance-files', () => {
+        container.register(LogReader, LogReader, { lifecycle: Lifecycle.Singleton });
+        const fs = container.resolve<any>(InjectionTokens.fs);
+        const supervisor = container.resolve(InstanceSupervisor);
+        const readers = supervisor.readInstances()
+            .map((x) => supervisor.createInstanceContainer(x).resolve(LogReader));
+
+        // the log store and the offsets are kept per instance
+        expect(readers[0].getStorePath()).to.equal(path.join(root, 'chernarus', 'log-store'));
+        expect(readers[1].getStorePath()).to.equal(path.join(path.resolve('/servers/livonia'), 'log-store'));
+
+        readers.forEach((reader, i) => {
+            fs.mkdirSync(path.dirname(reader.getOffsetsPath()), { recursive: true });
+            reader['offsets'] = { RPT: { file: `server${i}.rpt`, ino: i, offset: i } };
+            reader['offsetsDirty'] = true;
+            reader['saveOffsets']();
+        });
+
+        expect(JSON.parse(fs.readFileSync(path.join(root, 'chernarus', 'log-offsets.json'), 'utf-8')).RPT.file)
+            .to.equal('server0.rpt');
+        expect(JSON.parse(fs.readFileSync(path.resolve('/servers/livonia/log-offsets.json'), 'utf-8')).RPT.file)
+            .to.equal('server1.rpt');
+
+        readers[0]['getStore']('RPT').push({ timestamp: 1, message: 'chernarus' });
+        expect(readers[1]['getStore']('RPT')).to.not.equal(readers[0]['getStore']('RPT'));
+    });
+
+});
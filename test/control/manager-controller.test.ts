@@ -4,7 +4,7 @@ import * as sinon from 'sinon';
 import { ImportMock } from 'ts-mock-imports';
 import { ManagerController } from '../../src/control/manager-controller';
 import { VALID_CONFIG } from '../config/config-validate.test';
-import { StubInstance, disableConsole, enableConsole, stubClass } from '../util';
+import { StubInstance, disableConsole, enableConsole, sleep, stubClass } from '../util';
 import { Manager } from '../../src/control/manager';
 import { expect } from '../expect';
 import { DependencyContainer, Lifecycle, container, injectable, singleton } from 'tsyringe';
@@ -16,6 +16,7 @@ import { Requirements } from '../../src/services/requirements';
 import { IStatefulService } from '../../src/types/service';
 import { Config } from '../../src/config/config';
 import { DiscordBot } from '../../src/services/discord';
+import { InjectionTokens } from '../../src/util/apis';
 
 class TestMonitor {
     public startCalled = false;
@@ -86,6 +87,16 @@ export class TestStateful extends IStatefulService {
     }
 }
 
+@injectable()
+export class TestDependentStateful extends IStatefulService {
+    public start = sinon.stub();
+    public stop = sinon.stub();
+
+    public constructor(public dependency: TestStateful) {
+        super(undefined!);
+    }
+}
+
 
 describe('Test class ManagerController', () => {
 
@@ -120,6 +131,7 @@ describe('Test class ManagerController', () => {
         injector.register(IngameReport, stubClass(IngameReport), { lifecycle: Lifecycle.Singleton });
         injector.register(Requirements, stubClass(Requirements), { lifecycle: Lifecycle.Singleton });
         injector.register(DiscordBot, stubClass(DiscordBot), { lifecycle: Lifecycle.Singleton });
+        injector.register(InjectionTokens.container, { useValue: container });
         
         configWatcher = injector.resolve(ConfigWatcher) as any;
         manager = injector.resolve(Manager) as any;
@@ -158,4 +170,136 @@ describe('Test class ManagerController', () => {
         expect(manager.initDone).to.be.false;
         
     });
-});
\ No newline at end of file
+
+    it('ManagerController-dependencies', async () => {
+
+        container.register(TestStateful, TestStateful, { lifecycle: Lifecycle.Singleton });
+        container.register(TestDependentStateful, TestDependentStateful, { lifecycle: Lifecycle.Singleton });
+        const testStateful = container.resolve(TestStateful);
+        const dependent = container.resolve(TestDependentStateful);
+
+        configWatcher.watch.resolves(new Config());
+        steamCmd.checkSteamCmd.resolves(true);
+        steamCmd.checkServer.resolves(true);
+        steamCmd.checkMods.resolves(true);
+        steamCmd.installMods.resolves(true);
+
+        const order: string[] = [];
+        // the requirements are checked before the setup runs
+        requirements.check.callsFake(async () => {
+            await sleep(10);
+            order.push('requirements');
+        });
+        steamCmd.checkSteamCmd.callsFake(async () => {
+            order.push('steamCmd');
+            return true;
+        });
+        testStateful.start.callsFake(async () => {
+            await sleep(10);
+            order.push('start dependency');
+        });
+        dependent.start.callsFake(async () => order.push('start dependent'));
+        testStateful.stop.callsFake(async () => order.push('stop dependency'));
+        dependent.stop.callsFake(async () => {
+            await sleep(10);
+            order.push('stop dependent');
+        });
+
+        const controller = injector.resolve(ManagerController);
+        await controller.start();
+        await controller.stop();
+
+        expect(order).to.deep.equal([
+            'requirements',
+            'steamCmd',
+            'start dependency',
+            'start dependent',
+            'stop dependent',
+            'stop dependency',
+        ]);
+    });
+
+    it('ManagerController-setup-failure', async () => {
+
+        container.register(TestStateful, TestStateful, { lifecycle: Lifecycle.Singleton });
+        const testStateful = container.resolve(TestStateful);
+
+        configWatcher.watch.resolves(new Config());
+        steamCmd.checkSteamCmd.resolves(false);
+        const exit = sinon.stub(process, 'exit');
+
+        try {
+            const controller = injector.resolve(ManagerController);
+            await controller.start();
+        } finally {
+            exit.restore();
+        }
+
+        expect(exit.calledWith(1)).to.be.true;
+        expect(steamCmd.checkServer.called).to.be.false;
+        expect(testStateful.start.called).to.be.false;
+    });
+
+    it('ManagerController-instance-setup-failure', async () => {
+
+        manager.instanceName = 'chernarus';
+        configWatcher.watch.resolves(new Config());
+        steamCmd.checkSteamCmd.resolves(false);
+        const exit = sinon.stub(process, 'exit');
+
+        try {
+            const controller = injector.resolve(ManagerController);
+            await controller.start();
+        } finally {
+            exit.restore();
+        }
+
+        // only the instance is stopped, the process keeps running the other instances
+        expect(exit.called).to.be.false;
+        expect(configWatcher.stopWatching.calledOnce).to.be.true;
+        expect(steamCmd.checkServer.called).to.be.false;
+    });
+
+    it('ManagerController-reloadConfig', async () => {
+
+        container.register(TestStateful, TestStateful, { lifecycle: Lifecycle.Singleton });
+        const testStateful = container.resolve(TestStateful);
+        (testStateful as any).configKeys = ['discordBotToken'];
+
+        configWatcher.watch.returns(new Config());
+        steamCmd.checkSteamCmd.resolves(true);
+        steamCmd.checkServer.resolves(true);
+        steamCmd.checkMods.resolves(true);
+        steamCmd.installMods.resolves(true);
+
+        const controller = injector.resolve(ManagerController);
+        await controller.start();
+        expect(testStateful.start.callCount).to.equal(1);
+
+        // keys read on use only replace the config
+        const liveConfig = new Config();
+        liveConfig.channelAdmin = 'admin';
+        await controller.reloadConfig(liveConfig, ['channelAdmin']);
+        expect(manager.config).to.equal(liveConfig);
+        expect(testStateful.stop.callCount).to.equal(0);
+        expect(testStateful.start.callCount).to.equal(1);
+
+        // keys read on start restart the service
+        const serviceConfig = new Config();
+        serviceConfig.discordBotToken = 'token';
+        await controller.reloadConfig(serviceConfig, ['discordBotToken']);
+        expect(manager.config).to.equal(serviceConfig);
+        expect(testStateful.stop.callCount).to.equal(1);
+        expect(testStateful.start.callCount).to.equal(2);
+        expect(configWatcher.watch.callCount).to.equal(1);
+
+        // other keys restart the manager
+        const restartConfig = new Config();
+        restartConfig.serverPath = 'other';
+        await controller.reloadConfig(restartConfig, ['serverPath']);
+        expect(configWatcher.watch.callCount).to.equal(2);
+        expect(testStateful.start.callCount).to.equal(3);
+
+        await controller.stop();
+    });
+});
@@ -191,6 +191,14 @@ describe('Test class Manager', () => {
         expect(result).to.be.equal(9999);
     });
 
+    it('Manager-getInstrumentationPort', () => {
+        const manager = getConfiguredManager();
+        expect(manager.getInstrumentationPort()).to.be.equal(manager.config.serverPort + 12);
+
+        manager.config.instrumentationPort = -1;
+        expect(manager.getInstrumentationPort()).to.be.equal(-1);
+    });
+
     it('Manager-getServerInfo', () => {
         const manager = getConfiguredManager();
         const result = manager.getServerInfo();
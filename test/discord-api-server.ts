@@ -0,0 +1,102 @@
+import * as http from 'http';
+import { AddressInfo } from 'net';
+
+export interface ReceivedDiscordMessage {
+    channelId: string;
+    authorization: string;
+    body: any;
+    time: number;
+}
+
+/**
+ * Local stand-in for the message endpoint of the discord REST api.
+ *
+ * Each channel is its own rate limit bucket of `limit` requests per `window` ms,
+ * the responses carry the same rate limit headers as discord.
+ * Requests above the limit are answered with 429.
+ */
+export class FakeDiscordApi {
+
+    public limit = 5;
+    /** ms */
+    public window = 1000;
+    /** requests answered with 429 regardless of the bucket */
+    public forceRateLimit = 0;
+    public forceGlobal = false;
+
+    /** successfully posted messages */
+    public received: ReceivedDiscordMessage[] = [];
+    /** requests answered with 429 */
+    public rateLimited = 0;
+
+    private buckets = new Map<string, { remaining: number; resetAt: number }>();
+    private server: http.Server;
+
+    public get url(): string {
+        return `http://127.0.0.1:${(this.server.address() as AddressInfo).port}/api/v9`;
+    }
+
+    public async start(): Promise<void> {
+        this.server = http.createServer((req, res) => this.handle(req, res));
+        await new Promise<void>((r) => this.server.listen(0, '127.0.0.1', () => r()));
+    }
+
+    public async stop(): Promise<void> {
+        await new Promise((r) => this.server.close(r));
+    }
+
+    private handle(req: http.IncomingMessage, res: http.ServerResponse): void {
+        const match = /^\/api\/v9\/channels\/(\w+)\/messages$/.exec(req.url);
+        if (req.method !== 'POST' || !match) {
+            res.writeHead(404);
+            res.end();
+            return;
+        }
+
+        const chunks: Buffer[] = [];
+        req.on('data', (chunk) => chunks.push(chunk));
+        req.on('end', () => {
+            const channelId = match[1];
+            const now = Date.now();
+
+            let bucket = this.buckets.get(channelId);
+            if (!bucket || bucket.resetAt <= now) {
+                bucket = { remaining: this.limit, resetAt: now + this.window };
+                this.buckets.set(channelId, bucket);
+            }
+            const resetAfter = (bucket.resetAt - now) / 1000;
+
+            if (this.forceRateLimit > 0 || bucket.remaining <= 0) {
+                const global = this.forceRateLimit > 0 && this.forceGlobal;
+                this.forceRateLimit = Math.max(0, this.forceRateLimit - 1);
+                this.rateLimited++;
+                res.writeHead(429, {
+                    'Content-Type': 'application/json',
+                    'Retry-After': `${Math.ceil(resetAfter)}`,
+                    'X-RateLimit-Limit': `${this.limit}`,
+                    'X-RateLimit-Remaining': '0',
+                    'X-RateLimit-Reset-After': `${resetAfter}`,
+                    ...(global ? { 'X-RateLimit-Global': 'true' } : {}),
+                });
+                res.end(JSON.stringify({ message: 'You are being rate limited.', retry_after: resetAfter, global }));
+                return;
+            }
+
+            bucket.remaining--;
+            this.received.push({
+                channelId,
+                authorization: req.headers.authorization,
+                body: JSON.parse(Buffer.concat(chunks).toString()),
+                time: now,
+            });
+            res.writeHead(200, {
+                'Content-Type': 'application/json',
+                'X-RateLimit-Limit': `${this.limit}`,
+                'X-RateLimit-Remaining': `${bucket.remaining}`,
+                'X-RateLimit-Reset-After': `${resetAfter}`,
+            });
+            res.end(JSON.stringify({ id: `${this.received.length}`, channel_id: channelId }));
+        });
+    }
+
+}
@@ -8,13 +8,19 @@ import { Manager } from '../../src/control/manager';
 import { RCON } from '../../src/services/rcon';
 import { Monitor } from '../../src/services/monitor';
 import { Metrics } from '../../src/services/metrics';
+import { MetricsCollector } from '../../src/services/metrics-collector';
 import { SteamCMD } from '../../src/services/steamcmd';
 import { LogReader } from '../../src/services/log-reader';
+import { AdmEvents } from '../../src/services/adm-events';
+import { LogSearch } from '../../src/services/log-search';
 import { Backups } from '../../src/services/backups';
 import { MissionFiles } from '../../src/services/mission-files';
 import { ConfigFileHelper } from '../../src/config/config-file-helper';
 import { ServerDetector } from '../../src/services/server-detector';
 import { SystemReporter } from '../../src/services/system-reporter';
+import { EconomyStore } from '../../src/services/economy-store';
+import { REST } from '../../src/interface/rest';
+import { DiscordBot } from '../../src/services/discord';
 
 
 describe('Test Interface', () => {
@@ -27,11 +33,17 @@ describe('Test Interface', () => {
     let systemReporter: StubInstance<SystemReporter>;
     let serverDetector: StubInstance<ServerDetector>;
     let metrics: StubInstance<Metrics>;
+    let metricsCollector: StubInstance<MetricsCollector>;
     let steamCmd: StubInstance<SteamCMD>;
     let logReader: StubInstance<LogReader>;
+    let admEvents: StubInstance<AdmEvents>;
+    let logSearch: StubInstance<LogSearch>;
     let backups: StubInstance<Backups>;
     let missionFiles: StubInstance<MissionFiles>;
     let configFileHelper: StubInstance<ConfigFileHelper>;
+    let economyStore: StubInstance<EconomyStore>;
+    let rest: StubInstance<REST>;
+    let discord: StubInstance<DiscordBot>;
 
     before(() => {
         disableConsole();
@@ -54,11 +66,17 @@ describe('Test Interface', () => {
         injector.register(SystemReporter, stubClass(SystemReporter), { lifecycle: Lifecycle.Singleton });
         injector.register(ServerDetector, stubClass(ServerDetector), { lifecycle: Lifecycle.Singleton });
         injector.register(Metrics, stubClass(Metrics), { lifecycle: Lifecycle.Singleton });
+        injector.register(MetricsCollector, stubClass(MetricsCollector), { lifecycle: Lifecycle.Singleton });
         injector.register(SteamCMD, stubClass(SteamCMD), { lifecycle: Lifecycle.Singleton });
         injector.register(LogReader, stubClass(LogReader), { lifecycle: Lifecycle.Singleton });
+        injector.register(AdmEvents, stubClass(AdmEvents), { lifecycle: Lifecycle.Singleton });
+        injector.register(LogSearch, stubClass(LogSearch), { lifecycle: Lifecycle.Singleton });
         injector.register(Backups, stubClass(Backups), { lifecycle: Lifecycle.Singleton });
         injector.register(MissionFiles, stubClass(MissionFiles), { lifecycle: Lifecycle.Singleton });
         injector.register(ConfigFileHelper, stubClass(ConfigFileHelper), { lifecycle: Lifecycle.Singleton });
+        injector.register(EconomyStore, stubClass(EconomyStore), { lifecycle: Lifecycle.Singleton });
+        injector.register(REST, stubClass(REST), { lifecycle: Lifecycle.Singleton });
+        injector.register(DiscordBot, stubClass(DiscordBot), { lifecycle: Lifecycle.Singleton });
         
         manager = injector.resolve(Manager) as any;
         manager.config = {
@@ -100,11 +118,17 @@ describe('Test Interface', () => {
         }]);
         
         metrics = injector.resolve(Metrics) as any;
+        metricsCollector = injector.resolve(MetricsCollector) as any;
         steamCmd = injector.resolve(SteamCMD) as any;
         logReader = injector.resolve(LogReader) as any;
+        admEvents = injector.resolve(AdmEvents) as any;
+        logSearch = injector.resolve(LogSearch) as any;
         backups = injector.resolve(Backups) as any;
         missionFiles = injector.resolve(MissionFiles) as any;
         configFileHelper = injector.resolve(ConfigFileHelper) as any;
+        economyStore = injector.resolve(EconomyStore) as any;
+        rest = injector.resolve(REST) as any;
+        discord = injector.resolve(DiscordBot) as any;
     });
 
     it('execute-non existing', async () => {
@@ -440,7 +464,7 @@ describe('Test Interface', () => {
     });
 
     it('execute-metrics', async () => {
-        metrics.fetchMetrics.resolves([]);
+        metrics.fetchMetricsPage.resolves({ items: [] });
         const handler = injector.resolve(Interface);
         const request = {
             resource: 'metrics',
@@ -452,7 +476,54 @@ describe('Test Interface', () => {
         const response = await handler.execute(request);
 
         expect(response.status).to.equal(200);
-        expect(metrics.fetchMetrics.firstCall.firstArg).to.equal('test');
+        expect(response.body).to.deep.equal([]);
+        expect(metrics.fetchMetricsPage.firstCall.firstArg).to.equal('test');
+    });
+
+    it('execute-metrics-page', async () => {
+        metrics.fetchMetricsPage.resolves({ items: [], nextCursor: 5 });
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'metrics',
+            user: 'admin',
+            query: {
+                type: 'SYSTEM',
+                cursor: '3',
+                limit: '10',
+                fields: 'cpu, mem',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(response.body).to.deep.equal({ items: [], nextCursor: 5 });
+        expect(metrics.fetchMetricsPage.firstCall.args[1]).to.include({ cursor: 3, limit: 10 });
+        expect(metrics.fetchMetricsPage.firstCall.args[1].fields).to.deep.equal(['cpu', 'mem']);
+    });
+
+    it('execute-metrics-stream', async () => {
+        metrics.streamMetrics.callsFake(async (type, query, onPage) => {
+            await onPage({ items: [{ timestamp: 1, value: 1 }], nextCursor: 1 });
+            await onPage({ items: [{ timestamp: 2, value: 2 }] });
+            return 2;
+        });
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'metrics',
+            user: 'admin',
+            canStream: true,
+            query: {
+                type: 'SYSTEM',
+                stream: 'true',
+            },
+        } as any as Request;
+        const parts = [];
+        const response = await handler.execute(request, async (part) => parts.push(part));
+
+        expect(response.status).to.equal(200);
+        expect(response.body).to.deep.equal({ count: 2 });
+        expect(parts.length).to.equal(2);
+        expect(parts[1].body.items[0].timestamp).to.equal(2);
     });
 
     it('execute-metrics-missing type', async () => {
@@ -467,7 +538,121 @@ describe('Test Interface', () => {
         const response = await handler.execute(request);
 
         expect(response.status).to.equal(400);
-        expect(metrics.fetchMetrics.called).to.be.false;
+        expect(metrics.fetchMetricsPage.called).to.be.false;
+    });
+
+    it('execute-metricsources', async () => {
+        metricsCollector.getSourceStats.returns([{ type: 'PLAYERS', samples: 1 } as any]);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'metricsources',
+            user: 'admin',
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect((response.body as any[])[0].type).to.equal('PLAYERS');
+    });
+
+    it('execute-websocketstats', async () => {
+        rest.getWebsocketStats.returns([{ user: 'admin', queued: 2 } as any]);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'websocketstats',
+            user: 'admin',
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect((response.body as any[])[0].queued).to.equal(2);
+    });
+
+    it('execute-discordstats', async () => {
+        discord.getDispatchStats.returns([{ channelId: '1', avgDelay: 100 } as any]);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'discordstats',
+            user: 'admin',
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect((response.body as any[])[0].avgDelay).to.equal(100);
+    });
+
+    it('execute-instrumentation', async () => {
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'instrumentation',
+            user: 'admin',
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect((response.body as any).memory.heapUsed).to.be.greaterThan(0);
+        expect((response.body as any).histograms).to.be.an('array');
+    });
+
+    it('execute-entitytrack', async () => {
+        metrics.isEntityMetric.returns(true);
+        metrics.fetchEntityTrack.resolves([{ id: 1 } as any]);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'entitytrack',
+            user: 'admin',
+            query: {
+                type: 'INGAME_PLAYERS',
+                id: '1',
+                since: '1234',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(metrics.fetchEntityTrack.firstCall.args[0]).to.equal('INGAME_PLAYERS');
+        expect(metrics.fetchEntityTrack.firstCall.args[1]).to.deep.include({ id: 1, since: 1234 });
+    });
+
+    it('execute-entitytrack-id-0', async () => {
+        metrics.isEntityMetric.returns(true);
+        metrics.fetchEntityTrack.resolves([]);
+        const handler = injector.resolve(Interface);
+        const request = (id: any) => ({
+            resource: 'entitytrack',
+            user: 'admin',
+            query: {
+                type: 'INGAME_PLAYERS',
+                id,
+                name: 'test',
+            },
+        } as any as Request);
+
+        await handler.execute(request(0));
+        expect(metrics.fetchEntityTrack.firstCall.args[1]).to.deep.include({ id: 0 });
+
+        // an empty id falls back to the name
+        await handler.execute(request(''));
+        expect(metrics.fetchEntityTrack.secondCall.args[1].id).to.be.undefined;
+    });
+
+    it('execute-entityarea-wrong type', async () => {
+        metrics.isEntityMetric.returns(false);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'entityarea',
+            user: 'admin',
+            query: {
+                type: 'SYSTEM',
+                minX: '0',
+                maxX: '100',
+                minZ: '0',
+                maxZ: '100',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(400);
+        expect(metrics.fetchEntitiesInArea.called).to.be.false;
     });
 
     it('execute-deleteMetrics', async () => {
@@ -501,6 +686,82 @@ describe('Test Interface', () => {
         expect(logReader.fetchLogs.firstCall.firstArg).to.equal('test');
     });
 
+    it('execute-rconstats', async () => {
+        rcon.getCommandStats.returns({ players: { count: 1 } as any });
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'rconstats',
+            user: 'admin',
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(response.body).to.deep.equal({ players: { count: 1 } });
+    });
+
+    it('execute-logsearch', async () => {
+        logSearch.search.returns({ items: [] });
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'logsearch',
+            user: 'admin',
+            query: {
+                q: 'null pointer',
+                types: 'rpt,script',
+                since: '5',
+                cursor: '100:7',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(logSearch.search.firstCall.firstArg).to.deep.include({
+            query: 'null pointer',
+            types: ['RPT', 'SCRIPT'],
+            since: 5,
+            cursor: '100:7',
+        });
+    });
+
+    it('execute-admevents', async () => {
+        admEvents.queryEvents.returns([]);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'admevents',
+            user: 'admin',
+            query: {
+                types: 'kill, hit',
+                player: 'test',
+                cursor: '10',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(admEvents.queryEvents.firstCall.firstArg).to.deep.include({
+            types: ['KILL', 'HIT'],
+            player: 'test',
+            cursor: 10,
+        });
+    });
+
+    it('execute-admpositions', async () => {
+        admEvents.queryPositions.returns([]);
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'admpositions',
+            user: 'admin',
+            query: {
+                player: 'test',
+                since: '5',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(admEvents.queryPositions.firstCall.args.slice(0, 2)).to.deep.equal(['test', 5]);
+    });
+
     it('execute-login', async () => {
         manager.getUserLevel.callsFake((user): any => {
             return user === 'admin' ? 'test' : undefined;
@@ -582,6 +843,43 @@ describe('Test Interface', () => {
         expect(backups.createBackup.called).to.be.true;
     });
 
+    it('execute-restorebackup', async () => {
+        backups.restoreBackup.resolves({ restored: 1, unchanged: 0, removed: 0 });
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'restorebackup',
+            user: 'admin',
+            body: {
+                backup: 'mpmissions_1',
+                files: 'a.xml',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(backups.restoreBackup.firstCall.args).to.deep.equal(['mpmissions_1', ['a.xml']]);
+
+        await handler.execute({ ...request, body: { backup: 'mpmissions_1' } } as any);
+        expect(backups.restoreBackup.secondCall.args).to.deep.equal(['mpmissions_1', undefined]);
+    });
+
+    it('execute-diffbackups', async () => {
+        backups.diffBackups.resolves({ added: [], removed: [], changed: ['a.xml'] });
+        const handler = injector.resolve(Interface);
+        const request = {
+            resource: 'diffbackups',
+            user: 'admin',
+            query: {
+                from: 'mpmissions_1',
+            },
+        } as any as Request;
+        const response = await handler.execute(request);
+
+        expect(response.status).to.equal(200);
+        expect(response.body).to.deep.equal({ added: [], removed: [], changed: ['a.xml'] });
+        expect(backups.diffBackups.firstCall.args).to.deep.equal(['mpmissions_1', undefined]);
+    });
+
     it('execute-getbackups', async () => {
         backups.getBackups.resolves([]);
         const handler = injector.resolve(Interface);
@@ -639,6 +937,58 @@ describe('Test Interface', () => {
         const response = await handler.execute(request);
         expect(response.status).to.equal(200);
         expect(missionFiles.readMissionFile.callCount).to.equal(3);
+        expect(economyStore.flush.callCount).to.equal(3);
+    });
+
+    it('execute-economyentries', async () => {
+        economyStore.listEntries.resolves(['AKM']);
+        economyStore.getEntry.resolves({ tag: 'type', attributes: { name: 'AKM' }, children: [] });
+        const handler = injector.resolve(Interface);
+
+        let response = await handler.execute({
+            resource: 'economyentries',
+            user: 'admin',
+            query: { file: 'db/types.xml' },
+        } as any as Request);
+        expect(response.status).to.equal(200);
+        expect(response.body).to.deep.equal(['AKM']);
+
+        response = await handler.execute({
+            resource: 'economyentry',
+            user: 'admin',
+            query: { file: 'db/types.xml', name: 'AKM' },
+        } as any as Request);
+        expect(response.status).to.equal(200);
+        expect(economyStore.getEntry.calledOnceWith('db/types.xml', 'AKM')).to.be.true;
+    });
+
+    it('execute-editeconomyentry', async () => {
+        const handler = injector.resolve(Interface);
+        const entry = { tag: 'type', attributes: {}, children: [] };
+
+        let response = await handler.execute({
+            resource: 'updateeconomyentry',
+            user: 'admin',
+            body: { file: 'db/types.xml', name: 'AKM', entry },
+        });
+        expect(response.status).to.equal(200);
+        expect(economyStore.updateEntry.calledOnceWith('db/types.xml', 'AKM', entry)).to.be.true;
+
+        response = await handler.execute({
+            resource: 'patcheconomyentry',
+            user: 'admin',
+            body: { file: 'db/types.xml', name: 'AKM', patch: { nominal: 5 }, createBackup: 'true' },
+        });
+        expect(response.status).to.equal(200);
+        expect(economyStore.patchEntry.calledOnceWith('db/types.xml', 'AKM', { nominal: 5 }, true)).to.be.true;
+
+        response = await handler.execute({
+            resource: 'deleteeconomyentry',
+            user: 'admin',
+            body: { file: 'db/types.xml', name: 'AKM' },
+        });
+        expect(response.status).to.equal(200);
+        expect(economyStore.deleteEntry.calledOnce).to.be.true;
     });
 
     it('execute-readmissiondir', async () => {
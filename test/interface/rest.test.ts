@@ -10,8 +10,10 @@ import * as sinon from 'sinon';
 import * as websocket from 'websocket';
 import { EventBus } from '../../src/control/event-bus';
 import { InternalEventTypes } from '../../src/types/events';
-import { WebsocketCommand, WebsocketListenerEvent, WebsocketListenerType, WebsocketMessage } from '../../src/types/websocket';
+import { WebsocketCommand, WebsocketListenerEvents, WebsocketListenerType, WebsocketMessage } from '../../src/types/websocket';
+import { DEFAULT_WEBSOCKET_QUEUE_OPTIONS } from '../../src/interface/websocket-queue';
 import { Request } from '../../src/types/interface';
+import { EventEmitter } from 'events';
 
 
 describe('Test REST', () => {
@@ -158,8 +160,11 @@ describe('Test REST', () => {
 
         const rest = injector.resolve(REST);
 
+        rest.wsQueueOptions = { ...DEFAULT_WEBSOCKET_QUEUE_OPTIONS, batchInterval: 10 };
+
         let ws: websocket.w3cwebsocket;
         let answer: string;
+        let stats: any[];
         try {
             await rest.start();
 
@@ -184,7 +189,12 @@ describe('Test REST', () => {
                 } as WebsocketMessage<WebsocketListenerType>));
 
                 setTimeout(
-                    () => eventBus.emit(InternalEventTypes.LOG_ENTRY, 'Hello :)' as any),
+                    () => {
+                        // events are sent in batches
+                        eventBus.emit(InternalEventTypes.LOG_ENTRY, 'Hello :)' as any);
+                        eventBus.emit(InternalEventTypes.LOG_ENTRY, 'Hello again' as any);
+                        stats = rest.getWebsocketStats();
+                    },
                     10,
                 );
             };
@@ -199,12 +209,16 @@ describe('Test REST', () => {
         expect(ws.readyState).to.equal(ws.CLOSED);
         expect(rest.wsClients).to.be.undefined;
         expect(answer!).to.equal(JSON.stringify({
-            cmd: WebsocketCommand.LISTENER_EVENT,
+            cmd: WebsocketCommand.LISTENER_EVENTS,
             data: {
                 type: WebsocketListenerType.LOGS,
-                event: 'Hello :)',
+                events: ['Hello :)', 'Hello again'],
+                dropped: 0,
             },
-        } as  WebsocketMessage<WebsocketListenerEvent>));
+        } as  WebsocketMessage<WebsocketListenerEvents>));
+        expect(stats!.length).to.equal(1);
+        expect(stats![0].user).to.equal('admin');
+        expect(stats![0].queued).to.equal(2);
     });
 
     it('REST-ws-request', async () => {
@@ -317,6 +331,185 @@ describe('Test REST', () => {
         
     });
 
+    it('REST-handleCommand-ndjson', async () => {
+
+        manager.initDone = true;
+        interfaceService.execute.callsFake(async (request, partHandler) => {
+            await partHandler({ body: { items: [1] } });
+            await partHandler({ body: { items: [2] } });
+            return { status: 200, body: { count: 2 } };
+        });
+
+        const rest = injector.resolve(REST);
+
+        const req = {
+            headers: {
+                accept: 'application/x-ndjson',
+            },
+            query: {},
+        } as any;
+
+        const lines: string[] = [];
+        const res = {
+            headersSent: false,
+            status: sinon.stub().callsFake(() => res),
+            type: sinon.stub(),
+            write: (chunk) => {
+                res.headersSent = true;
+                lines.push(chunk);
+                return true;
+            },
+            end: sinon.stub(),
+            send: sinon.stub(),
+        } as any;
+
+        await rest['handleCommand'](req, res, 'metrics');
+
+        expect(interfaceService.execute.firstCall.firstArg.canStream).to.be.true;
+        expect(res.type.firstCall.firstArg).to.equal('application/x-ndjson');
+        expect(res.send.called).to.be.false;
+        expect(res.end.calledOnce).to.be.true;
+        expect(lines.map((x) => JSON.parse(x))).to.deep.equal([
+            { items: [1] },
+            { items: [2] },
+            { count: 2 },
+        ]);
+
+    });
+
+    it('REST-handleCommand-ndjson-slow-consumer', async () => {
+
+        manager.initDone = true;
+        let written = 0;
+        interfaceService.execute.callsFake(async (request, partHandler) => {
+            await partHandler({ body: { items: [1] } });
+            written++;
+            await partHandler({ body: { items: [2] } });
+            written++;
+            return { status: 200, body: { count: 2 } };
+        });
+
+        const rest = injector.resolve(REST);
+
+        const req = {
+            headers: {
+                accept: 'application/x-ndjson',
+            },
+            query: {},
+        } as any;
+
+        const lines: string[] = [];
+        const res = Object.assign(new EventEmitter(), {
+            headersSent: false,
+            destroyed: false,
+            writableEnded: false,
+            status: sinon.stub().callsFake(() => res),
+            type: sinon.stub(),
+            write: (chunk) => {
+                res.headersSent = true;
+                lines.push(chunk);
+                // the client never keeps up
+                return false;
+            },
+            end: sinon.stub().callsFake(() => {
+                res.writableEnded = true;
+            }),
+            send: sinon.stub(),
+        }) as any;
+
+        const done = rest['handleCommand'](req, res, 'metrics');
+
+        await sleep(10);
+        expect(lines.length).to.equal(1);
+        expect(written).to.equal(0);
+        expect(res.listenerCount('drain')).to.equal(1);
+        expect(res.listenerCount('close')).to.equal(1);
+
+        res.emit('drain');
+        await sleep(10);
+        expect(lines.length).to.equal(2);
+        expect(written).to.equal(1);
+        // the listeners of the consumed line are gone
+        expect(res.listenerCount('drain')).to.equal(1);
+        expect(res.listenerCount('close')).to.equal(1);
+
+        res.emit('drain');
+        await sleep(10);
+        res.emit('drain');
+        await done;
+
+        expect(written).to.equal(2);
+        expect(res.end.calledOnce).to.be.true;
+        expect(res.listenerCount('drain')).to.equal(0);
+        expect(res.listenerCount('close')).to.equal(0);
+        expect(lines.map((x) => JSON.parse(x))).to.deep.equal([
+            { items: [1] },
+            { items: [2] },
+            { count: 2 },
+        ]);
+
+    });
+
+    it('REST-handleCommand-ndjson-client-abort', async () => {
+
+        manager.initDone = true;
+
+        const rest = injector.resolve(REST);
+
+        const req = {
+            headers: {
+                accept: 'application/x-ndjson',
+            },
+            query: {},
+        } as any;
+
+        const lines: string[] = [];
+        const res = Object.assign(new EventEmitter(), {
+            headersSent: false,
+            destroyed: false,
+            writableEnded: false,
+            status: sinon.stub().callsFake(() => res),
+            type: sinon.stub(),
+            write: (chunk) => {
+                res.headersSent = true;
+                lines.push(chunk);
+                return false;
+            },
+            end: sinon.stub(),
+            send: sinon.stub(),
+        }) as any;
+
+        // disconnect while a line is waiting for drain
+        const pageErrors: Error[] = [];
+        interfaceService.execute.callsFake(async (request, partHandler) => {
+            try {
+                const pending = partHandler({ body: { items: [1] } });
+                res.destroyed = true;
+                res.emit('close');
+                await pending;
+            } catch (e) {
+                pageErrors.push(e);
+            }
+            // a disconnected client is rejected right away
+            try {
+                await partHandler({ body: { items: [2] } });
+            } catch (e) {
+                pageErrors.push(e);
+            }
+            return { status: 500, body: 'aborted' };
+        });
+
+        await rest['handleCommand'](req, res, 'metrics');
+
+        expect(pageErrors.length).to.equal(2);
+        expect(lines.length).to.equal(1);
+        expect(res.end.called).to.be.false;
+        expect(res.send.called).to.be.false;
+        expect(res.listenerCount('drain')).to.equal(0);
+        expect(res.listenerCount('close')).to.equal(0);
+
+    });
+
     it('REST-handleCommand-cors', async () => {
 
         const rest = injector.resolve(REST);
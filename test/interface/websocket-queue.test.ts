@@ -0,0 +1,103 @@
+import { expect } from '../expect';
+import { sleep } from '../util';
+import { WebsocketQueue } from '../../src/interface/websocket-queue';
+import { WebsocketCommand, WebsocketListenerType } from '../../src/types/websocket';
+
+describe('Test class WebsocketQueue', () => {
+
+    let queue: WebsocketQueue | undefined;
+
+    const createSocket = () => ({
+        readyState: 1,
+        bufferedAmount: 0,
+        sent: [] as any[],
+        send(data: string) {
+            this.sent.push(JSON.parse(data));
+        },
+    });
+
+    const createQueue = (socket: any, maxQueueSize: number = 100) => {
+        queue = new WebsocketQueue(socket, 'admin', {
+            batchInterval: 10,
+            maxBatchSize: 3,
+            maxBufferedAmount: 100,
+            maxQueueSize,
+        });
+        return queue;
+    };
+
+    afterEach(() => {
+        queue?.close();
+        queue = undefined;
+    });
+
+    it('WebsocketQueue-batches', async () => {
+        const socket = createSocket();
+        const queue = createQueue(socket);
+
+        for (let i = 0; i < 5; i++) {
+            queue.push(WebsocketListenerType.LOGS, JSON.stringify({ i }));
+        }
+        queue.push(WebsocketListenerType.METRICS, '"metric"');
+        expect(socket.sent).to.be.empty;
+        expect(queue.getStats().queued).to.equal(6);
+
+        await sleep(15);
+        expect(socket.sent).to.deep.equal([
+            {
+                cmd: WebsocketCommand.LISTENER_EVENTS,
+                data: { type: WebsocketListenerType.LOGS, events: [{ i: 0 }, { i: 1 }, { i: 2 }], dropped: 0 },
+            },
+            {
+                cmd: WebsocketCommand.LISTENER_EVENTS,
+                data: { type: WebsocketListenerType.METRICS, events: ['metric'], dropped: 0 },
+            },
+        ]);
+
+        // the rest follows with the next batch
+        await sleep(15);
+        expect(socket.sent.length).to.equal(3);
+        expect(socket.sent[2].data.events).to.deep.equal([{ i: 3 }, { i: 4 }]);
+
+        const stats = queue.getStats();
+        expect(stats.user).to.equal('admin');
+        expect(stats.queued).to.equal(0);
+        expect(stats.events).to.equal(6);
+        expect(stats.frames).to.equal(3);
+        expect(stats.dropped).to.equal(0);
+    });
+
+    it('WebsocketQueue-slow-client', async () => {
+        const socket = createSocket();
+        const queue = createQueue(socket, 10);
+        socket.bufferedAmount = 1000;
+
+        for (let i = 0; i < 20; i++) {
+            queue.push(WebsocketListenerType.LOGS, `${i}`);
+        }
+
+        // nothing is sent while the client is busy, the oldest events are dropped
+        await sleep(15);
+        expect(socket.sent).to.be.empty;
+        expect(queue.getStats().queued).to.be.at.most(11);
+        expect(queue.getStats().dropped).to.be.at.least(9);
+
+        socket.bufferedAmount = 0;
+        await sleep(15);
+        expect(socket.sent.length).to.equal(1);
+        expect(socket.sent[0].data.events).to.deep.equal([10, 11, 12]);
+        expect(socket.sent[0].data.dropped).to.equal(10);
+    });
+
+    it('WebsocketQueue-closed', async () => {
+        const socket = createSocket();
+        const queue = createQueue(socket);
+        socket.readyState = 3;
+
+        queue.push(WebsocketListenerType.LOGS, '"test"');
+        await sleep(15);
+        expect(socket.sent).to.be.empty;
+        expect(queue.getStats().queued).to.equal(0);
+    });
+
+});
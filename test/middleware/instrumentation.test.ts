@@ -0,0 +1,45 @@
+import { expect } from '../expect';
+import { EventEmitter } from 'events';
+
+import { instrumentationMiddleware } from '../../src/middleware/instrumentation';
+import { HTTP_REQUEST_DURATION, instrumentation } from '../../src/util/instrumentation';
+
+describe('Test instrumentation middleware', () => {
+
+    it('instrumentation', async () => {
+
+        const middleware = instrumentationMiddleware('test');
+        let called = 0;
+        const next = () => {
+            called++;
+        };
+
+        const req = {
+            method: 'GET',
+            baseUrl: '/api',
+            route: { path: '/metrics' },
+        };
+        const resp = new EventEmitter() as any;
+        resp.statusCode = 200;
+        middleware(req as any, resp, next);
+        resp.emit('finish');
+
+        // requests without a route share a label
+        const unmatched = new EventEmitter() as any;
+        unmatched.statusCode = 404;
+        middleware({ method: 'GET' } as any, unmatched, next);
+        unmatched.emit('finish');
+
+        expect(called).to.equal(2);
+        expect(instrumentation.histogram(
+            HTTP_REQUEST_DURATION,
+            { server: 'test', method: 'GET', route: '/api/metrics', status: '2xx' },
+        ).count).to.equal(1);
+        expect(instrumentation.histogram(
+            HTTP_REQUEST_DURATION,
+            { server: 'test', method: 'GET', route: 'other', status: '4xx' },
+        ).count).to.equal(1);
+
+    });
+
+});
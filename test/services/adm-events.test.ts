@@ -0,0 +1,158 @@
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports'
+import { StubInstance, disableConsole, enableConsole, stubClass } from '../util';
+import * as sinon from 'sinon';
+import { DependencyContainer, Lifecycle, container } from 'tsyringe';
+import { Manager } from '../../src/control/manager';
+import { Database } from '../../src/services/database';
+import { EventBus } from '../../src/control/event-bus';
+import { InternalEventTypes } from '../../src/types/events';
+import { AdmEvents } from '../../src/services/adm-events';
+
+describe('Test class AdmEvents', () => {
+
+    let injector: DependencyContainer;
+
+    let manager: StubInstance<Manager>;
+    let database: StubInstance<Database>;
+    let eventBus: EventBus;
+
+    let eventStmt: { run: sinon.SinonStub };
+    let positionStmt: { run: sinon.SinonStub };
+    let db: { run: sinon.SinonStub, all: sinon.SinonStub, transaction: (fn: any) => any };
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        // restore mocks
+        ImportMock.restore();
+
+        container.reset();
+        injector = container.createChildContainer();
+
+        injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        injector.register(Database, stubClass(Database), { lifecycle: Lifecycle.Singleton });
+        injector.register(EventBus, EventBus, { lifecycle: Lifecycle.Singleton });
+
+        manager = injector.resolve(Manager) as any;
+        database = injector.resolve(Database) as any;
+        eventBus = injector.resolve(EventBus);
+
+        eventStmt = { run: sinon.stub() };
+        positionStmt = { run: sinon.stub() };
+        db = {
+            run: sinon.stub(),
+            all: sinon.stub().returns([]),
+            transaction: (fn) => fn({
+                prepare: (sql: string) => (sql.includes('ADM_POSITIONS') ? positionStmt : eventStmt),
+            }),
+        };
+        database.getDatabase.returns(db as any);
+    });
+
+    it('AdmEvents-ingest', async () => {
+
+        const admEvents = injector.resolve(AdmEvents);
+        await admEvents.start();
+
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('CREATE TABLE IF NOT EXISTS ADM_EVENTS'))).to.be.true;
+
+        const emit = (message: string): void => eventBus.emit(
+            InternalEventTypes.LOG_ENTRY,
+            { type: 'ADM', entry: { timestamp: 1, message } },
+        );
+        emit('AdminLog started on 2023-05-06 at 12:00:00');
+        emit('12:00:01 | Player "A" (id=A= pos=<1, 2, 3>)');
+        emit('12:00:02 | Player "A" (DEAD) (id=A= pos=<1, 2, 3>) killed by Player "B" (id=B= pos=<4, 5, 6>) with M4-A1 from 5 meters');
+        emit('12:00:03 | something irrelevant');
+        eventBus.emit(
+            InternalEventTypes.LOG_ENTRY,
+            { type: 'RPT', entry: { timestamp: 1, message: '12:00:01 | Player "A" (id=A= pos=<1, 2, 3>)' } },
+        );
+
+        // batched until flush
+        expect(eventStmt.run.called).to.be.false;
+        admEvents.flush();
+
+        expect(positionStmt.run.callCount).to.equal(1);
+        expect(positionStmt.run.firstCall.firstArg).to.deep.equal([
+            new Date(2023, 4, 6, 12, 0, 1).valueOf(),
+            'A=',
+            'A',
+            1,
+            3,
+            2,
+        ]);
+        expect(eventStmt.run.callCount).to.equal(1);
+        expect(eventStmt.run.firstCall.firstArg).to.include('KILL');
+        expect(eventStmt.run.firstCall.firstArg).to.include('M4-A1');
+
+        await admEvents.stop();
+
+        // no longer listening
+        emit('12:00:01 | Player "A" (id=A= pos=<1, 2, 3>)');
+        admEvents.flush();
+        expect(positionStmt.run.callCount).to.equal(1);
+
+    });
+
+    it('AdmEvents-batch', async () => {
+
+        const admEvents = injector.resolve(AdmEvents);
+        for (let i = 0; i < AdmEvents.BATCH_SIZE; i++) {
+            admEvents.ingest({ timestamp: 1, message: '12:00:01 | Player "A" (id=A= pos=<1, 2, 3>) committed suicide' });
+        }
+        expect(eventStmt.run.callCount).to.equal(AdmEvents.BATCH_SIZE);
+
+        // remaining events are written periodically
+        admEvents.flushInterval = 5;
+        await admEvents.start();
+        admEvents.ingest({ timestamp: 1, message: '12:00:01 | Player "A" (id=A= pos=<1, 2, 3>) committed suicide' });
+        await new Promise((r) => setTimeout(r, 30));
+        expect(eventStmt.run.callCount).to.equal(AdmEvents.BATCH_SIZE + 1);
+        await admEvents.stop();
+
+    });
+
+    it('AdmEvents-query', async () => {
+
+        const admEvents = injector.resolve(AdmEvents);
+        admEvents.ingest({ timestamp: 1, message: '12:00:01 | Player "A" (id=A= pos=<1, 2, 3>) committed suicide' });
+
+        admEvents.queryEvents({ types: ['KILL', 'HIT'], player: 'A=', since: 5, until: 10, cursor: 2, limit: 100_000 });
+
+        // pending events are written before querying
+        expect(eventStmt.run.calledOnce).to.be.true;
+        expect(db.all.firstCall.args[0]).to.include('type IN (?, ?)');
+        expect(db.all.firstCall.args.slice(1)).to.deep.equal([
+            2, 'KILL', 'HIT', 'A=', 'A=', 'A=', 'A=', 5, 10, AdmEvents.MAX_PAGE_SIZE,
+        ]);
+
+        admEvents.queryPositions('A', 1, undefined, 10);
+        expect(db.all.secondCall.args[0]).to.include('ADM_POSITIONS');
+        expect(db.all.secondCall.args.slice(1)).to.deep.equal(['A', 'A', 1, Number.MAX_SAFE_INTEGER, 10]);
+
+    });
+
+    it('AdmEvents-cleanup', async () => {
+
+        const admEvents = injector.resolve(AdmEvents);
+
+        manager.config = { admEventMaxAge: 0 } as any;
+        admEvents['cleanup']();
+        expect(db.run.called).to.be.false;
+
+        manager.config = { admEventMaxAge: 1000 } as any;
+        admEvents['cleanup']();
+        expect(db.run.callCount).to.equal(2);
+        expect(db.run.firstCall.firstArg).to.include('DELETE FROM ADM_EVENTS');
+
+    });
+
+});
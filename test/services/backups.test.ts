@@ -1,17 +1,21 @@
 import { expect } from '../expect';
 import { StubInstance, disableConsole, enableConsole, memfs, stubClass } from '../util';
 import * as sinon from 'sinon';
+import * as zlib from 'zlib';
 import { Backups } from '../../src/services/backups';
 import { DependencyContainer, Lifecycle, container } from 'tsyringe';
 import { Paths } from '../../src/services/paths';
 import { FSAPI, InjectionTokens } from '../../src/util/apis';
 import { Manager } from '../../src/control/manager';
+import { Monitor } from '../../src/services/monitor';
+import { ServerState } from '../../src/types/monitor';
 
 describe('Test class Backups', () => {
 
     let injector: DependencyContainer;
 
     let manager: StubInstance<Manager>;
+    let monitor: StubInstance<Monitor>;
     let paths: Paths;
     let fs: FSAPI;
 
@@ -31,9 +35,12 @@ describe('Test class Backups', () => {
         injector.register(InjectionTokens.childProcess, { useValue: {} });
         injector.register(Paths, Paths, { lifecycle: Lifecycle.Singleton });
         injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        injector.register(Monitor, stubClass(Monitor), { lifecycle: Lifecycle.Singleton });
 
         paths = injector.resolve(Paths);
         manager = injector.resolve(Manager) as any;
+        monitor = injector.resolve(Monitor) as any;
+        (monitor as any).serverState = ServerState.STOPPED;
     });
 
     it('Backups', async () => {
@@ -59,6 +66,144 @@ describe('Test class Backups', () => {
 
     });
 
+    it('Backups-snapshots', async () => {
+
+        const missions = '/test/testserver/mpmissions';
+        fs.mkdirSync(`${missions}/dayz.chernarus/storage_1`, { recursive: true });
+        fs.writeFileSync(`${missions}/dayz.chernarus/types.xml`, 'types');
+        fs.writeFileSync(`${missions}/dayz.chernarus/storage_1/data.bin`, 'data');
+        fs.writeFileSync(`${missions}/init.c`, 'init');
+
+        paths.setCwd('/test');
+        manager.config = {
+            backupPath: 'backups',
+            backupMaxAge: 1,
+        } as any;
+        manager.getServerPath.returns('/test/testserver');
+
+        const backup = injector.resolve(Backups);
+        const stored = (b: string, file: string) => `/test/backups/${b}/files/${file}.gz`;
+
+        const first = await backup.createBackup();
+        expect(first).to.deep.include({ files: 3, linked: 0, stored: 3, totalBytes: 13 });
+        expect(Object.keys(backup.readManifest(first.backup).files)).to.deep.equal([
+            'dayz.chernarus/storage_1/data.bin',
+            'dayz.chernarus/types.xml',
+            'init.c',
+        ]);
+        expect(zlib.gunzipSync(fs.readFileSync(stored(first.backup, 'init.c')) as Buffer).toString()).to.equal('init');
+
+        // unchanged files are linked
+        const second = await backup.createBackup();
+        expect(second.backup).to.not.equal(first.backup);
+        expect(second).to.deep.include({ linked: 3, stored: 0, storedBytes: 0 });
+        expect(fs.statSync(stored(second.backup, 'init.c')).ino).to.equal(fs.statSync(stored(first.backup, 'init.c')).ino);
+        expect(backup.readManifest(second.backup).previous).to.equal(first.backup);
+
+        // touched but same content, changed, added and removed files
+        const later = new Date(Date.now() + 60000);
+        fs.utimesSync(`${missions}/dayz.chernarus/storage_1/data.bin`, later, later);
+        fs.writeFileSync(`${missions}/dayz.chernarus/types.xml`, 'types v2');
+        fs.writeFileSync(`${missions}/new.xml`, 'new');
+        fs.unlinkSync(`${missions}/init.c`);
+        const third = await backup.createBackup();
+        expect(third).to.deep.include({ files: 3, linked: 1, stored: 2 });
+
+        expect(await backup.diffBackups(first.backup, third.backup)).to.deep.equal({
+            added: ['new.xml'],
+            removed: ['init.c'],
+            changed: ['dayz.chernarus/types.xml'],
+        });
+        expect(await backup.diffBackups(third.backup)).to.deep.equal({ added: [], removed: [], changed: [] });
+
+        // current state
+        fs.writeFileSync(`${missions}/new.xml`, 'NEW');
+        fs.writeFileSync(`${missions}/dayz.chernarus/types.xml`, 'types v3');
+        expect(await backup.diffBackups(third.backup)).to.deep.equal({
+            added: [],
+            removed: [],
+            changed: ['dayz.chernarus/types.xml', 'new.xml'],
+        });
+
+        // partial restore
+        expect(await backup.restoreBackup(third.backup, ['new.xml'])).to.deep.equal({ restored: 1, unchanged: 0, removed: 0 });
+        expect(fs.readFileSync(`${missions}/new.xml`) + '').to.equal('new');
+        await expect(backup.restoreBackup(third.backup, ['init.c'])).to.be.rejectedWith('not part of backup');
+
+        // full restore
+        expect(await backup.restoreBackup(first.backup)).to.deep.equal({ restored: 2, unchanged: 1, removed: 1 });
+        expect(fs.readFileSync(`${missions}/dayz.chernarus/types.xml`) + '').to.equal('types');
+        expect(fs.readFileSync(`${missions}/init.c`) + '').to.equal('init');
+        expect(fs.existsSync(`${missions}/new.xml`)).to.be.false;
+
+        // missing stored files of the previous snapshot are stored again
+        fs.unlinkSync(stored(third.backup, 'dayz.chernarus/storage_1/data.bin'));
+        const fourth = await backup.createBackup();
+        expect(fourth).to.deep.include({ files: 3, linked: 0, stored: 3 });
+
+        await expect(backup.diffBackups('missing')).to.be.rejectedWith('does not exist');
+        await expect(backup.diffBackups(first.backup, 'missing')).to.be.rejectedWith('does not exist');
+        await expect(backup.restoreBackup('missing')).to.be.rejectedWith('does not exist');
+
+    });
+
+    it('Backups-legacy', async () => {
+
+        // backups of older versions are plain copies
+        const missions = '/test/testserver/mpmissions';
+        fs.mkdirSync(`${missions}/dayz.chernarus`, { recursive: true });
+        fs.writeFileSync(`${missions}/dayz.chernarus/types.xml`, 'types v2');
+        fs.writeFileSync(`${missions}/new.xml`, 'new');
+        fs.mkdirSync('/test/backups/mpmissions_2020-1-1-0-0/dayz.chernarus', { recursive: true });
+        fs.writeFileSync('/test/backups/mpmissions_2020-1-1-0-0/dayz.chernarus/types.xml', 'types');
+        fs.writeFileSync('/test/backups/mpmissions_2020-1-1-0-0/init.c', 'init');
+
+        paths.setCwd('/test');
+        manager.config = {
+            backupPath: 'backups',
+            backupMaxAge: 1,
+        } as any;
+        manager.getServerPath.returns('/test/testserver');
+
+        const backup = injector.resolve(Backups);
+
+        expect(await backup.diffBackups('mpmissions_2020-1-1-0-0')).to.deep.equal({
+            added: ['new.xml'],
+            removed: ['init.c'],
+            changed: ['dayz.chernarus/types.xml'],
+        });
+
+        const snapshot = await backup.createBackup();
+        expect(await backup.diffBackups('mpmissions_2020-1-1-0-0', snapshot.backup)).to.deep.equal({
+            added: ['new.xml'],
+            removed: ['init.c'],
+            changed: ['dayz.chernarus/types.xml'],
+        });
+
+        expect(await backup.restoreBackup('mpmissions_2020-1-1-0-0')).to.deep.equal({ restored: 2, unchanged: 0, removed: 1 });
+        expect(fs.readFileSync(`${missions}/dayz.chernarus/types.xml`) + '').to.equal('types');
+        expect(fs.readFileSync(`${missions}/init.c`) + '').to.equal('init');
+        expect(fs.existsSync(`${missions}/new.xml`)).to.be.false;
+
+    });
+
+    it('Backups-restore-running', async () => {
+
+        paths.setCwd('/test');
+        manager.config = {
+            backupPath: 'backups',
+            backupMaxAge: 1,
+        } as any;
+        manager.getServerPath.returns('/test/testserver');
+        (monitor as any).serverState = ServerState.STARTED;
+
+        const backup = injector.resolve(Backups);
+
+        // the server would overwrite the restored storage
+        await expect(backup.restoreBackup('mpmissions_2020-1-1-0-0')).to.be.rejectedWith('server is stopped');
+
+    });
+
     it('Backups-cleanup', async () => {
 
         // create an existing backup to get deleted
@@ -81,6 +226,7 @@ describe('Test class Backups', () => {
         await backup.cleanup();
 
         expect(unlinkStub.callCount).to.equal(1);
+        expect(unlinkStub.firstCall.args[0]).to.equal('/test/backups/mpmissions_at_some_time');
 
     });
 
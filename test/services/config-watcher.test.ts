@@ -73,6 +73,23 @@ describe('Test class ConfigWatcher', () => {
         changeCb!();
         await new Promise((r) => setTimeout(r, 10));
         expect(onChanged.callCount).to.equal(1);
+        expect(onChanged.firstCall.args[0]).to.equal(newConf);
+        expect(onChanged.firstCall.args[1]).to.deep.equal(['instanceId']);
+
+        // changes are detected against the last applied config
+        changeCb!();
+        await new Promise((r) => setTimeout(r, 10));
+        expect(onChanged.callCount).to.equal(1);
+
+        const newConf2 = new Config();
+        newConf2.instanceId = '9999';
+        newConf2.discordBotToken = 'token';
+        newConf2.events = [{ name: 'restart', type: 'restart', cron: '0 * * * *' }];
+        configFileHelper.readConfig.returns(newConf2);
+        changeCb!();
+        await new Promise((r) => setTimeout(r, 10));
+        expect(onChanged.callCount).to.equal(2);
+        expect(onChanged.secondCall.args[1]).to.have.members(['discordBotToken', 'events']);
 
         configWatcher.stopWatching();
         expect(watcher.close.callCount).to.equal(1);
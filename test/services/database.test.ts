@@ -1,9 +1,11 @@
 import { expect } from '../expect';
 import { StubInstance, disableConsole, enableConsole, stubClass } from '../util';
 import * as sinon from 'sinon';
-import { Database, DatabaseTypes, Sqlite3Wrapper } from '../../src/services/database';
+import { Database, DatabaseConnections, DatabaseTypes, Sqlite3Wrapper } from '../../src/services/database';
 import { DependencyContainer, Lifecycle, container } from 'tsyringe';
 import { Manager } from '../../src/control/manager';
+import { Paths } from '../../src/services/paths';
+import { instrumentation, SQLITE_QUERY_DURATION } from '../../src/util/instrumentation';
 
 describe('Test class Database', () => {
 
@@ -12,12 +14,15 @@ describe('Test class Database', () => {
 
     let injector: DependencyContainer;
     let manager: StubInstance<Manager>
+    let paths: StubInstance<Paths>;
+    let createdFiles: string[] = [];
 
     before(() => {
         disableConsole();
         origCreate = Sqlite3Wrapper['createDb'];
-        Sqlite3Wrapper['createDb'] = () => {
+        Sqlite3Wrapper['createDb'] = (file: string) => {
             createCalled++;
+            createdFiles.push(file);
             return {
                 prepare: (sql) => ({
                     all: sinon.stub(),
@@ -36,12 +41,18 @@ describe('Test class Database', () => {
 
     beforeEach(() => {
         createCalled = 0;
+        createdFiles = [];
 
         container.reset();
         injector = container.createChildContainer();
         injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        injector.register(Paths, stubClass(Paths), { lifecycle: Lifecycle.Singleton });
+        injector.register(DatabaseConnections, DatabaseConnections, { lifecycle: Lifecycle.Singleton });
 
         manager = injector.resolve(Manager) as any;
+        paths = injector.resolve(Paths) as any;
+        paths.cwd.returns('/instance');
+        paths.sharedCwd.returns('/shared');
     });
 
     it('Database', async () => {
@@ -61,4 +72,67 @@ describe('Test class Database', () => {
 
     });
 
+    it('Database-shared-connections', async () => {
+
+        // a second instance with the same shared dir
+        const other = injector.createChildContainer();
+        other.register(Database, Database, { lifecycle: Lifecycle.Singleton });
+        other.register(Paths, stubClass(Paths), { lifecycle: Lifecycle.Singleton });
+        const otherPaths = other.resolve(Paths) as StubInstance<Paths>;
+        otherPaths.cwd.returns('/other');
+        otherPaths.sharedCwd.returns('/shared');
+
+        const db = injector.resolve(Database);
+        const otherDb = other.resolve(Database);
+        expect(otherDb).to.not.equal(db);
+
+        const metrics = db.getDatabase(DatabaseTypes.METRICS);
+        expect(otherDb.getDatabase(DatabaseTypes.METRICS)['db']).to.equal(metrics['db']);
+        expect(db.getDatabase(DatabaseTypes.ADM_EVENTS)['db']).to.not.equal(otherDb.getDatabase(DatabaseTypes.ADM_EVENTS)['db']);
+        expect(createdFiles.map((x) => x.replace(/\\/g, '/'))).to.deep.equal([
+            '/shared/metrics.db',
+            '/instance/adm-events.db',
+            '/other/adm-events.db',
+        ]);
+
+        // the shared connection is closed with its last user
+        await db.stop();
+        expect((metrics['db'].close as sinon.SinonStub).callCount).to.equal(0);
+        await otherDb.stop();
+        expect((metrics['db'].close as sinon.SinonStub).callCount).to.equal(1);
+    });
+
+    it('Database-query-durations', async () => {
+
+        // a second instance with the same shared dir
+        const other = injector.createChildContainer();
+        other.register(Database, Database, { lifecycle: Lifecycle.Singleton });
+        other.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        (manager as any).instanceName = 'db-test-a';
+        (other.resolve(Manager) as any).instanceName = 'db-test-b';
+
+        const db = injector.resolve(Database);
+        const otherDb = other.resolve(Database);
+        db.getDatabase(DatabaseTypes.METRICS).run('SELECT 1');
+        db.getDatabase(DatabaseTypes.ADM_EVENTS).all('SELECT 1');
+        otherDb.getDatabase(DatabaseTypes.METRICS).run('SELECT 1');
+        otherDb.getDatabase(DatabaseTypes.METRICS).run('SELECT 1');
+
+        // the queries of the shared connection are counted per querying instance
+        const counts = (instance: string): Record<string, number> => {
+            const result = {};
+            for (const x of instrumentation.getHistograms(instance)) {
+                if (x.name === SQLITE_QUERY_DURATION && x.labels.instance === instance && x.count) {
+                    result[`${x.labels.db} ${x.labels.method}`] = x.count;
+                }
+            }
+            return result;
+        };
+        expect(counts('db-test-a')).to.deep.equal({ 'metrics run': 1, 'adm_events all': 1 });
+        expect(counts('db-test-b')).to.deep.equal({ 'metrics run': 2 });
+
+        await db.stop();
+        await otherDb.stop();
+    });
+
 });
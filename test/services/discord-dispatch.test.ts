@@ -0,0 +1,189 @@
+import * as http from 'http';
+import { expect } from '../expect';
+import { disableConsole, enableConsole, sleep } from '../util';
+import { FakeDiscordApi } from '../discord-api-server';
+import { Logger } from '../../src/util/logger';
+import {
+    createDiscordRestTransport,
+    DiscordDispatchQueue,
+    DiscordTransport,
+    embedLength,
+} from '../../src/services/discord-dispatch';
+
+describe('Test class DiscordDispatchQueue', () => {
+
+    let api: FakeDiscordApi;
+    let queue: DiscordDispatchQueue;
+    let transport: DiscordTransport;
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(async () => {
+        api = new FakeDiscordApi();
+        await api.start();
+        transport = createDiscordRestTransport(http as any, 'token', api.url);
+        queue = new DiscordDispatchQueue(new Logger('Discord'), {
+            batchInterval: 20,
+            maxQueueSize: 10,
+        });
+    });
+
+    afterEach(async () => {
+        queue.stop();
+        await api.stop();
+    });
+
+    const waitFor = async (condition: () => boolean, timeout: number = 2000): Promise<void> => {
+        const start = Date.now();
+        while (!condition() && Date.now() - start < timeout) {
+            await sleep(5);
+        }
+    };
+
+    it('DiscordDispatchQueue-batches', async () => {
+        queue.start(transport);
+
+        for (let i = 0; i < 5; i++) {
+            queue.push('1', { content: `kill ${i}` });
+        }
+        queue.push('1', { embeds: [{ title: 'Mod updated: A' }] });
+        queue.push('1', { embeds: [{ title: 'Mod updated: B' }] });
+        queue.push('2', { content: 'other channel' });
+
+        await waitFor(() => queue.getStats().every((x) => x.queued === 0 && x.sent > 0));
+
+        const channel1 = api.received.filter((x) => x.channelId === '1');
+        expect(channel1.length).to.equal(1);
+        expect(channel1[0].authorization).to.equal('Bot token');
+        expect(channel1[0].body).to.deep.equal({
+            content: 'kill 0\nkill 1\nkill 2\nkill 3\nkill 4',
+            embeds: [{ title: 'Mod updated: A' }, { title: 'Mod updated: B' }],
+        });
+        expect(api.received.find((x) => x.channelId === '2').body.content).to.equal('other channel');
+
+        const stats = queue.getStats().find((x) => x.channelId === '1');
+        expect(stats.sent).to.equal(7);
+        expect(stats.requests).to.equal(1);
+        expect(stats.queued).to.equal(0);
+        expect(stats.maxDelay).to.be.at.least(stats.avgDelay);
+        expect(stats.avgDelay).to.be.at.least(15);
+    });
+
+    it('DiscordDispatchQueue-limits', async () => {
+        queue.options.maxQueueSize = 100;
+        queue.start(transport);
+
+        // more than 10 embeds or 2000 chars need multiple messages
+        for (let i = 0; i < 12; i++) {
+            queue.push('1', { embeds: [{ title: `${i}` }] });
+        }
+        queue.push('1', { content: 'x'.repeat(1500) });
+        queue.push('1', { content: 'y'.repeat(1500) });
+
+        await waitFor(() => queue.getStats()[0]?.sent === 14);
+
+        const bodies = api.received.map((x) => x.body);
+        expect(bodies.length).to.equal(3);
+        expect(bodies[0].embeds.length).to.equal(10);
+        expect(bodies[1].embeds.length).to.equal(2);
+        expect(bodies[1].content).to.equal('x'.repeat(1500));
+        expect(bodies[2].content).to.equal('y'.repeat(1500));
+
+        expect(embedLength({
+            title: 'ab',
+            description: 'cd',
+            footer: { text: 'e' },
+            fields: [{ name: 'f', value: 'gh' }],
+        })).to.equal(8);
+    });
+
+    it('DiscordDispatchQueue-honors-rate-limit-headers', async () => {
+        api.limit = 2;
+        api.window = 200;
+        queue.start(transport);
+
+        // too long to be combined, so each is sent on its own and the bucket is exhausted after two of them
+        for (let i = 0; i < 4; i++) {
+            queue.push('1', { content: `${i}`.repeat(1500) });
+        }
+        await waitFor(() => queue.getStats()[0].sent === 4);
+
+        // the queue waited for the reset instead of running into 429s
+        expect(api.rateLimited).to.equal(0);
+        expect(api.received.map((x) => x.body.content[0]).join('')).to.equal('0123');
+        expect(api.received[2].time - api.received[0].time).to.be.at.least(150);
+    });
+
+    it('DiscordDispatchQueue-retries-after-429', async () => {
+        api.window = 100;
+        api.forceRateLimit = 1;
+        queue.start(transport);
+
+        queue.push('1', { content: 'test' });
+        await waitFor(() => queue.getStats()[0].sent === 1);
+
+        expect(api.rateLimited).to.equal(1);
+        expect(api.received[0].body.content).to.equal('test');
+        const stats = queue.getStats()[0];
+        expect(stats.rateLimited).to.equal(1);
+        expect(stats.sent).to.equal(1);
+        expect(stats.lastDelay).to.be.at.least(50);
+    });
+
+    it('DiscordDispatchQueue-global-rate-limit', async () => {
+        api.window = 100;
+        api.forceRateLimit = 1;
+        api.forceGlobal = true;
+        queue.start(transport);
+
+        queue.push('1', { content: 'a' });
+        await waitFor(() => queue.getStats()[0].rateLimited === 1);
+        const limitedAt = Date.now();
+        queue.push('2', { content: 'b' });
+
+        await waitFor(() => queue.getStats().every((x) => x.sent === 1));
+        // the other channel waited for the global limit as well
+        expect(api.received.find((x) => x.channelId === '2').time - limitedAt).to.be.at.least(60);
+        expect(api.rateLimited).to.equal(1);
+    });
+
+    it('DiscordDispatchQueue-collapses-overflow', async () => {
+        // nothing is sent before the queue is started
+        for (let i = 0; i < 25; i++) {
+            queue.push('1', { content: `${i}` });
+        }
+        await sleep(30);
+        expect(api.received).to.be.empty;
+        expect(queue.getStats()[0].queued).to.equal(10);
+        expect(queue.getStats()[0].collapsed).to.equal(15);
+
+        queue.start(transport);
+        await waitFor(() => queue.getStats()[0].sent === 10);
+
+        const lines = api.received[0].body.content.split('\n');
+        expect(lines[0]).to.contain('15 older message(s) were skipped');
+        expect(lines.slice(1)).to.deep.equal(['15', '16', '17', '18', '19', '20', '21', '22', '23', '24']);
+    });
+
+    it('DiscordDispatchQueue-failures', async () => {
+        queue.start(async () => ({ status: 400 }));
+        queue.push('1', { content: 'rejected' });
+        await waitFor(() => queue.getStats()[0].failed === 1);
+
+        queue.start(async () => {
+            throw new Error('connection refused');
+        });
+        queue.push('1', { content: 'error' });
+        await waitFor(() => queue.getStats()[0].failed === 2);
+
+        expect(queue.getStats()[0].failed).to.equal(2);
+        expect(queue.getStats()[0].sent).to.equal(0);
+    });
+
+});
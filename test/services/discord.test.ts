@@ -1,12 +1,15 @@
 import { expect } from '../expect';
 import { ImportMock } from 'ts-mock-imports'
-import { StubInstance, disableConsole, enableConsole, stubClass } from '../util';
+import { StubInstance, disableConsole, enableConsole, fakeHttps, sleep, stubClass } from '../util';
 import * as sinon from 'sinon';
+import * as http from 'http';
 import * as discordModule from 'discord.js';
 import { DiscordBot } from '../../src/services/discord';
 import { DependencyContainer, Lifecycle, container } from 'tsyringe';
 import { Manager } from '../../src/control/manager';
 import { DiscordMessageHandler } from '../../src/interface/discord-message-handler';
+import { InjectionTokens } from '../../src/util/apis';
+import { FakeDiscordApi } from '../discord-api-server';
 
 describe('Test class Discord', () => {
 
@@ -32,6 +35,7 @@ describe('Test class Discord', () => {
 
         injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
         injector.register(DiscordMessageHandler, stubClass(DiscordMessageHandler), { lifecycle: Lifecycle.Singleton });
+        fakeHttps(injector);
 
         manager = injector.resolve(Manager) as any;
         messageHandler = injector.resolve(DiscordMessageHandler) as any;
@@ -122,51 +126,46 @@ describe('Test class Discord', () => {
     it('Discord-relayMessage', async () => {
 
         const discordClientMock = ImportMock.mockClass<discordModule.Client>(discordModule, 'Client');
-        
-        const channel1 = {
-            name: 'channel1',
-            send: sinon.stub(),
-        };
-        const channel2 = {
-            name: 'channel2',
-            send: sinon.stub(),
-        };
-        const channels = [channel1, channel2];
-        (channels as any).filter2 = channels.filter;
-        (channels as any).filter = function (f) {
-            const ret = this.filter2(f);
-            ret.array = function () { return this; };
-            return ret;
-        }
-        const guilds = {
-            first: () => ({ channels })
-        };
-        discordClientMock.set('guilds', guilds as any);
+        discordClientMock.set('on', sinon.stub());
+        discordClientMock.set('login', sinon.stub());
+        discordClientMock.set('destroy', sinon.stub());
+
+        const api = new FakeDiscordApi();
+        await api.start();
+        injector.register(InjectionTokens.https, { useValue: http });
 
         manager.config = {
             discordBotToken: '1234',
-            discordChannels: [{
-                mode: 'rcon',
-                channel: 'channel1',
-            },{
-                mode: 'admin',
-                channel: 'channel2',
-            }]
+            channelRCON: '1',
+            channelAdmin: '2',
+            channelNoti: '',
         } as any;
 
         const discord = injector.resolve(DiscordBot);
-        discord['ready'] = true;
-        
-        // should return instantly
-        await discord.sendMessage({ type: 'rcon', message: 'test' });
-        
-        discord.client = discordClientMock.getMockInstance();
-        await discord.sendMessage({ type: 'rcon', message: 'test' });
-
-        expect(channel1.send.callCount).to.equal(1);
-        expect(channel2.send.callCount).to.equal(0);
+        discord.apiUrl = api.url;
+        discord.dispatchQueue.options = { batchInterval: 10, maxQueueSize: 10 };
 
+        // queued until the bot is logged in
+        await discord.sendMessage({ type: 'rcon', message: 'test' });
+        await discord.sendMessage({ type: 'rcon', message: 'test2' });
+        // no channel configured
+        await discord.sendMessage({ type: 'notification', message: 'test' });
+        await discord.start();
+        await discord.sendMessage({ type: 'admin', embed: { title: 'embed' } as any });
+        await discord.sendMessage({ channelID: '3', embeds: [{ title: 'embeds' } as any] });
+        await discord.sendMessage({ type: 'admin' });
 
+        await sleep(100);
+        await discord.stop();
+        await api.stop();
+
+        const received = new Map(api.received.map((x) => [x.channelId, x]));
+        expect(api.received.length).to.equal(3);
+        expect(received.get('1').authorization).to.equal('Bot 1234');
+        expect(received.get('1').body).to.deep.equal({ content: 'test\ntest2' });
+        expect(received.get('2').body).to.deep.equal({ embeds: [{ title: 'embed' }] });
+        expect(received.get('3').body).to.deep.equal({ embeds: [{ title: 'embeds' }] });
+        expect(discord.getDispatchStats().map((x) => x.sent)).to.deep.equal([2, 1, 1]);
     });
 
 });
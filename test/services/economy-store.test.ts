@@ -0,0 +1,212 @@
+import 'reflect-metadata';
+
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports';
+import * as sinon from 'sinon';
+import { StubInstance, disableConsole, enableConsole, memfs, sleep, stubClass } from '../util';
+import { DependencyContainer, Lifecycle, container } from 'tsyringe';
+import { Manager } from '../../src/control/manager';
+import { Backups } from '../../src/services/backups';
+import { Hooks } from '../../src/services/hooks';
+import { MissionFiles } from '../../src/services/mission-files';
+import { EconomyStore } from '../../src/services/economy-store';
+import { HookTypeEnum } from '../../src/config/config';
+import { FSAPI } from '../../src/util/apis';
+
+const TYPES_XML = [
+    '<?xml version="1.0" encoding="UTF-8" standalone="yes" ?>',
+    '<types>',
+    '\t<type name="AKM">',
+    '\t\t<nominal>10</nominal>',
+    '\t\t<flags count_in_cargo="0"/>',
+    '\t</type>',
+    '\t<!-- food -->',
+    '\t<type name="Apple">',
+    '\t\t<nominal>5</nominal>',
+    '\t</type>',
+    '\t<type name="Pear">',
+    '\t\t<nominal>5</nominal>',
+    '\t</type>',
+    '</types>',
+    '',
+].join('\r\n');
+
+describe('Test class EconomyStore', () => {
+
+    let injector: DependencyContainer;
+
+    let manager: StubInstance<Manager>;
+    let backups: StubInstance<Backups>;
+    let hooks: StubInstance<Hooks>;
+    let missionFiles: StubInstance<MissionFiles>;
+    let fs: FSAPI;
+
+    const typesPath = '/mission/db/types.xml';
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        ImportMock.restore();
+
+        container.reset();
+        injector = container.createChildContainer();
+
+        injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        injector.register(Backups, stubClass(Backups), { lifecycle: Lifecycle.Singleton });
+        injector.register(Hooks, stubClass(Hooks), { lifecycle: Lifecycle.Singleton });
+        injector.register(MissionFiles, stubClass(MissionFiles), { lifecycle: Lifecycle.Singleton });
+
+        fs = memfs(
+            {
+                '/mission/db': {
+                    'types.xml': TYPES_XML,
+                },
+            },
+            '/',
+            injector,
+        );
+
+        manager = injector.resolve(Manager) as any;
+        backups = injector.resolve(Backups) as any;
+        hooks = injector.resolve(Hooks) as any;
+        missionFiles = injector.resolve(MissionFiles) as any;
+
+        manager.config = { economyWriteDelay: 10 } as any;
+        missionFiles.getMissionPath.callsFake(async (file: string) => (file.includes('..') ? undefined : `/mission/${file}`));
+    });
+
+    afterEach(async () => {
+        injector.resolve(EconomyStore)['timers'].removeAllTimers();
+    });
+
+    it('EconomyStore-read', async () => {
+        const store = injector.resolve(EconomyStore);
+        await store.start();
+
+        expect(await store.listEntries('db/types.xml')).to.deep.equal(['AKM', 'Apple', 'Pear']);
+        expect(await store.getEntry('db/types.xml', 'AKM')).to.deep.equal({
+            tag: 'type',
+            attributes: { name: 'AKM' },
+            children: [
+                { tag: 'nominal', attributes: {}, children: [], text: '10' },
+                { tag: 'flags', attributes: { count_in_cargo: '0' }, children: [] },
+            ],
+        });
+        expect(await store.getEntry('db/types.xml', 'Banana')).to.be.undefined;
+        expect(Object.keys(await store.getEntries('db/types.xml', ['Apple', 'Banana', 'Pear']))).to.deep.equal(['Apple', 'Pear']);
+
+        // returned entries are copies
+        (await store.getEntry('db/types.xml', 'AKM')).children = [];
+        expect((await store.getEntry('db/types.xml', 'AKM')).children.length).to.equal(2);
+
+        expect(store.getStats()).to.deep.equal([
+            { file: 'db/types.xml', entries: 3, duplicates: 0, pendingEdits: 0, lastWrite: undefined },
+        ]);
+
+        await expect(store.listEntries('../types.xml')).to.be.rejectedWith('Invalid file');
+    });
+
+    it('EconomyStore-edit', async () => {
+        const store = injector.resolve(EconomyStore);
+
+        expect(await store.patchEntry('db/types.xml', 'AKM', { 'nominal': 20, 'flags@count_in_cargo': 1 })).to.deep.include({
+            children: [
+                { tag: 'nominal', attributes: {}, children: [], text: '20' },
+                { tag: 'flags', attributes: { count_in_cargo: '1' }, children: [] },
+            ],
+        });
+        await store.patchEntry('db/types.xml', 'AKM', { lifetime: 3600 }, true);
+        await store.updateEntry('db/types.xml', 'Banana', {
+            attributes: {},
+            children: [{ tag: 'nominal', attributes: {}, children: [], text: '3' }],
+        } as any);
+        expect(await store.deleteEntry('db/types.xml', 'Pear')).to.be.true;
+        expect(await store.deleteEntry('db/types.xml', 'Pear')).to.be.false;
+        await expect(store.patchEntry('db/types.xml', 'Pear', { nominal: 1 })).to.be.rejectedWith('not found');
+
+        // written debounced
+        expect(fs.readFileSync(typesPath) + '').to.equal(TYPES_XML);
+        expect(store.getStats()[0].pendingEdits).to.equal(4);
+        await sleep(50);
+
+        expect(fs.readFileSync(typesPath) + '').to.equal([
+            '<?xml version="1.0" encoding="UTF-8" standalone="yes" ?>',
+            '<types>',
+            '\t<type name="AKM">',
+            '\t\t<nominal>20</nominal>',
+            '\t\t<flags count_in_cargo="1"/>',
+            '\t\t<lifetime>3600</lifetime>',
+            '\t</type>',
+            '\t<!-- food -->',
+            '\t<type name="Apple">',
+            '\t\t<nominal>5</nominal>',
+            '\t</type>',
+            '\t<type name="Banana">',
+            '\t\t<nominal>3</nominal>',
+            '\t</type>',
+            '</types>',
+            '',
+        ].join('\r\n'));
+        expect(hooks.executeHooks.calledOnceWith(HookTypeEnum.missionChanged)).to.be.true;
+        expect(backups.createBackup.calledOnce).to.be.true;
+        expect(store.getStats()[0]).to.deep.include({ entries: 3, pendingEdits: 0 });
+        expect(store.getStats()[0].lastWrite).to.be.not.undefined;
+
+        // nothing to write
+        await store.flush('db/types.xml');
+        await store.flush('db/other.xml');
+        expect(hooks.executeHooks.callCount).to.equal(1);
+    });
+
+    it('EconomyStore-external-change', async () => {
+        manager.config.economyWriteDelay = 10000;
+        const store = injector.resolve(EconomyStore);
+
+        await store.patchEntry('db/types.xml', 'Apple', { nominal: 7 });
+        await store.patchEntry('db/types.xml', 'Pear', { nominal: 8 });
+
+        // the file was changed by someone else, pending edits are applied to the new content
+        fs.writeFileSync(
+            typesPath,
+            TYPES_XML.replace(/\t<type name="Pear">[\s\S]*?<\/type>\r\n/, '').replace('<nominal>10</nominal>', '<nominal>11</nominal>'),
+        );
+        expect(await store.listEntries('db/types.xml')).to.deep.equal(['AKM', 'Apple']);
+        expect((await store.getEntry('db/types.xml', 'Apple')).children[0].text).to.equal('7');
+
+        await store.stop();
+
+        const content = fs.readFileSync(typesPath) + '';
+        expect(content).to.contain('<nominal>11</nominal>');
+        expect(content).to.contain('<nominal>7</nominal>');
+        expect(content).to.not.contain('Pear');
+        expect(store.getStats()).to.be.empty;
+    });
+
+    it('EconomyStore-write-error', async () => {
+        const store = injector.resolve(EconomyStore);
+        await store.patchEntry('db/types.xml', 'Apple', { nominal: 7 });
+
+        const writeStub = sinon.stub(fs.promises, 'writeFile').rejects(new Error('disk full'));
+        await expect(store.flush()).to.be.rejectedWith('disk full');
+        expect(store.getStats()[0].pendingEdits).to.equal(1);
+
+        writeStub.restore();
+        await store.flush();
+        expect(fs.readFileSync(typesPath) + '').to.contain('<nominal>7</nominal>');
+
+        // failing debounced writes are logged
+        const failStub = sinon.stub(fs.promises, 'rename').rejects(new Error('locked'));
+        await store.patchEntry('db/types.xml', 'Apple', { nominal: 8 });
+        await sleep(50);
+        expect(failStub.called).to.be.true;
+        expect(store.getStats()[0].pendingEdits).to.equal(1);
+        failStub.restore();
+    });
+
+});
@@ -3,7 +3,6 @@ import { ImportMock } from 'ts-mock-imports'
 import { StubInstance, disableConsole, enableConsole, memfs, stubClass } from '../util';
 import * as sinon from 'sinon';
 import * as path from 'path';
-import * as tail from 'tail';
 import { ServerState } from '../../src/types/monitor';
 import { LogReader } from '../../src/services/log-reader';
 import { DependencyContainer, Lifecycle, container } from 'tsyringe';
@@ -49,29 +48,21 @@ describe('Test class LogReader', () => {
         fs = memfs(
             {
                 '/testserver/profs': {
-                    'server.rpt': 'test',
-                    'server.adm': 'test',
-                    'script.log': 'test',
-                    'test.txt': 'test',
+                    'server.rpt': 'test\n',
+                    'server.adm': 'test\n',
+                    'script.log': 'test\n',
+                    'test.txt': 'test\n',
                 },
             },
             '/',
             injector,
         );
 
-        const tailMock = ImportMock.mockClass<tail.Tail>(
-            tail,
-            'Tail',
-        );
         let lineRegister = 0;
-        tailMock.set('on', (t, c) => {
-            if (t === 'line') {
-                lineRegister++;
-                c('test');
-            }
+        eventBus.on(InternalEventTypes.LOG_ENTRY, async () => {
+            lineRegister++;
         });
 
-        
         manager.getProfilesPath.returns('/testserver/profs');
 
         const logReader = injector.resolve(LogReader);
@@ -86,23 +77,111 @@ describe('Test class LogReader', () => {
         expect(lineRegister).to.equal(3);
     });
 
+    it('LogReader-resume', async () => {
+
+        fs = memfs(
+            {
+                '/testserver/profs': {
+                    'server.rpt': 'line 1\nline 2\n',
+                },
+            },
+            '/',
+            injector,
+        );
+        manager.getProfilesPath.returns('/testserver/profs');
+
+        const lines: string[] = [];
+        eventBus.on(InternalEventTypes.LOG_ENTRY, async (x) => {
+            lines.push(x.entry.message);
+        });
+
+        const logReader = injector.resolve(LogReader);
+        logReader.offsetsPath = '/log-offsets.json';
+        await logReader['registerReaders']();
+        await logReader.stop();
+
+        expect(lines).to.deep.equal(['line 1', 'line 2']);
+        const offsets = JSON.parse(fs.readFileSync(logReader.offsetsPath, { encoding: 'utf-8' }));
+        expect(offsets.RPT.offset).to.equal(14);
+
+        // manager restart: only new lines are emitted, old lines are restored to the buffer
+        fs.appendFileSync('/testserver/profs/server.rpt', 'line 3\n');
+        logReader['offsets'] = undefined;
+        await logReader['registerReaders']();
+
+        expect(lines).to.deep.equal(['line 1', 'line 2', 'line 3']);
+        expect(logReader.getActiveFiles()).to.deep.equal(['/testserver/profs/server.rpt']);
+        expect(logReader.getLogType('/testserver/profs/server.ADM')).to.equal('ADM');
+        expect(logReader.getLogType('/testserver/profs/server.txt')).to.be.undefined;
+        expect((await logReader.fetchLogs('RPT')).map((x) => x.message)).to.deep.equal(['line 1', 'line 2', 'line 3']);
+
+        // removed files are reported, but followed further
+        fs.unlinkSync('/testserver/profs/server.rpt');
+        await logReader['logMap'].RPT.tail.poll();
+        await logReader.stop();
+
+    });
+
+    it('LogReader-buffer-size', async () => {
+
+        fs = memfs(
+            {
+                '/testserver/profs': {
+                    'server.rpt': 'line 1\nline 2\nline 3\nline 4\nline 5\n',
+                },
+            },
+            '/',
+            injector,
+        );
+        manager.getProfilesPath.returns('/testserver/profs');
+        manager.config = { logBufferSize: 10 } as any;
+
+        let emitted = 0;
+        eventBus.on(InternalEventTypes.LOG_ENTRY, async () => {
+            emitted++;
+        });
+
+        const logReader = injector.resolve(LogReader);
+        logReader.offsetsPath = '/log-offsets.json';
+        await logReader['registerReaders']();
+        expect(logReader['getStore']('RPT').CAPACITY).to.equal(10);
+
+        // other keys keep the stores
+        await logReader.applyConfig(['serverPort']);
+        expect(logReader['getStore']('RPT').CAPACITY).to.equal(10);
+
+        // the stores are recreated and refilled without emitting the lines again
+        manager.config.logBufferSize = 2;
+        await logReader.applyConfig(['logBufferSize']);
+        expect(logReader['getStore']('RPT').CAPACITY).to.equal(2);
+        expect((await logReader.fetchLogs('RPT')).length).to.equal(5);
+        expect(emitted).to.equal(5);
+        expect(logReader.getActiveFiles()).to.deep.equal(['/testserver/profs/server.rpt']);
+
+        await logReader.stop();
+
+    });
+
     it('LogReader-fetchLogs', async () => {
 
         const logReader = injector.resolve(LogReader);
 
-        logReader['logMap']['RPT']!.logLines = [
-            { timestamp: 1, message: 'test 1' },
-            { timestamp: 2, message: 'test 2' },
-            { timestamp: 3, message: 'test 3' },
-            { timestamp: 4, message: 'test 4' },
-            { timestamp: 5, message: 'test 5' },
-        ];
+        expect(await logReader.fetchLogs('RPT')).to.be.empty;
+
+        const store = logReader['getStore']('RPT');
+        for (let i = 1; i <= 5; i++) {
+            store.push({ timestamp: i, message: `test ${i}` });
+        }
 
         const all = await logReader.fetchLogs('RPT');
         const last2 = await logReader.fetchLogs('RPT', 3);
+        const page = await logReader.fetchLogs('RPT', 1, 2);
+        const latest = await logReader.fetchLogs('RPT', undefined, 2);
 
         expect(all.length).to.equal(5);
         expect(last2.length).to.equal(2);
+        expect(page.map((x) => x.timestamp)).to.deep.equal([2, 3]);
+        expect(latest.map((x) => x.timestamp)).to.deep.equal([4, 5]);
     });
 
 });
@@ -0,0 +1,240 @@
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports'
+import { StubInstance, disableConsole, enableConsole, memfs, stubClass } from '../util';
+import * as sinon from 'sinon';
+import { DependencyContainer, Lifecycle, container } from 'tsyringe';
+import { Manager } from '../../src/control/manager';
+import { Database } from '../../src/services/database';
+import { EventBus } from '../../src/control/event-bus';
+import { LogReader } from '../../src/services/log-reader';
+import { InternalEventTypes } from '../../src/types/events';
+import { LogSearch } from '../../src/services/log-search';
+import { FSAPI } from '../../src/util/apis';
+
+describe('Test class LogSearch', () => {
+
+    let injector: DependencyContainer;
+
+    let manager: StubInstance<Manager>;
+    let database: StubInstance<Database>;
+    let logReader: StubInstance<LogReader>;
+    let eventBus: EventBus;
+    let fs: FSAPI;
+
+    let lineStmt: { run: sinon.SinonStub };
+    let fileStmt: { run: sinon.SinonStub };
+    let ftsStmt: { run: sinon.SinonStub };
+    let db: { run: sinon.SinonStub, first: sinon.SinonStub, all: sinon.SinonStub, transaction: (fn: any) => any };
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        // restore mocks
+        ImportMock.restore();
+
+        container.reset();
+        injector = container.createChildContainer();
+
+        injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        injector.register(Database, stubClass(Database), { lifecycle: Lifecycle.Singleton });
+        injector.register(LogReader, stubClass(LogReader), { lifecycle: Lifecycle.Singleton });
+        injector.register(EventBus, EventBus, { lifecycle: Lifecycle.Singleton });
+        fs = memfs(
+            {
+                '/profs': {
+                    'DayZServer_x64_2023-05-06_23-59-00.RPT': '23:59:30 first\n00:00:10.5 second\nno time\n',
+                    'DayZServer_x64_2023-05-05_10-00-00.RPT': '10:00:01 older\n',
+                    'live.RPT': 'live\n',
+                    'test.txt': 'test\n',
+                },
+            },
+            '/',
+            injector,
+        );
+
+        manager = injector.resolve(Manager) as any;
+        database = injector.resolve(Database) as any;
+        logReader = injector.resolve(LogReader) as any;
+        eventBus = injector.resolve(EventBus);
+
+        manager.getProfilesPath.returns('/profs');
+        logReader.getActiveFiles.returns(['/profs/live.RPT']);
+        logReader.getLogType.callsFake((x) => (x.endsWith('.RPT') ? 'RPT' : undefined));
+
+        lineStmt = { run: sinon.stub() };
+        fileStmt = { run: sinon.stub() };
+        ftsStmt = { run: sinon.stub() };
+        db = {
+            run: sinon.stub(),
+            first: sinon.stub(),
+            all: sinon.stub().returns([]),
+            transaction: (fn) => fn({
+                prepare: (sql: string) => {
+                    if (sql.includes('MAX(id)')) {
+                        return { get: () => ({ id: 0 }) };
+                    }
+                    if (sql.includes('LOG_FILES')) {
+                        return fileStmt;
+                    }
+                    return sql.includes('LOG_LINES_FTS') ? ftsStmt : lineStmt;
+                },
+            }),
+        };
+        database.getDatabase.returns(db as any);
+    });
+
+    it('LogSearch-ingest', async () => {
+
+        // no history
+        manager.getProfilesPath.returns('/missing');
+
+        const logSearch = injector.resolve(LogSearch);
+        logSearch.flushInterval = 5;
+        await logSearch.start();
+
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('USING fts5'))).to.be.true;
+
+        const position = { file: '/profs/live.RPT', ino: 1, offset: 5, head: Buffer.from('live\n').toString('base64') };
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, { type: 'RPT', entry: { timestamp: 1, message: 'live' }, position });
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, { type: 'SCRIPT', entry: { timestamp: 2, message: 'no file' } });
+
+        // already indexed by a previous run
+        db.first.returns({ position: JSON.stringify({ ...position, file: '/profs/other.RPT', offset: 10 }) });
+        eventBus.emit(InternalEventTypes.LOG_ENTRY, { type: 'RPT', entry: { timestamp: 3, message: 'dup' }, position: { ...position, file: '/profs/other.RPT' } });
+
+        // batched until flush
+        expect(lineStmt.run.called).to.be.false;
+        await new Promise((r) => setTimeout(r, 30));
+
+        expect(lineStmt.run.args.map((x) => x[0])).to.deep.equal([
+            ['RPT', '/profs/live.RPT', 1, 'live'],
+            ['SCRIPT', null, 2, 'no file'],
+        ]);
+        expect(ftsStmt.run.calledOnceWith([0])).to.be.true;
+        expect(fileStmt.run.firstCall.firstArg).to.deep.equal(['/profs/live.RPT', 'RPT', JSON.stringify(position)]);
+
+        await logSearch.stop();
+
+    });
+
+    it('LogSearch-scan', async () => {
+
+        const logSearch = injector.resolve(LogSearch);
+        expect(await logSearch.scanHistory()).to.equal(4);
+
+        const at = (day: number, h: number, m: number, s: number, ms: number = 0): number => new Date(2023, 4, day, h, m, s, ms).valueOf();
+        expect(lineStmt.run.args.map((x) => x[0].slice(1))).to.deep.equal([
+            ['/profs/DayZServer_x64_2023-05-05_10-00-00.RPT', at(5, 10, 0, 1), '10:00:01 older'],
+            ['/profs/DayZServer_x64_2023-05-06_23-59-00.RPT', at(6, 23, 59, 30), '23:59:30 first'],
+            ['/profs/DayZServer_x64_2023-05-06_23-59-00.RPT', at(7, 0, 0, 10, 500), '00:00:10.5 second'],
+            ['/profs/DayZServer_x64_2023-05-06_23-59-00.RPT', at(7, 0, 0, 10, 500), 'no time'],
+        ]);
+
+        // indexed files are skipped
+        expect(await logSearch.scanHistory()).to.equal(0);
+
+        // appended
+        fs.appendFileSync('/profs/DayZServer_x64_2023-05-05_10-00-00.RPT', '10:00:02 appended\n');
+        db.first.returns({ ts: at(5, 10, 0, 1) });
+        expect(await logSearch.scanHistory()).to.equal(1);
+        expect(lineStmt.run.lastCall.firstArg.slice(2)).to.deep.equal([at(5, 10, 0, 2), '10:00:02 appended']);
+
+        // replaced
+        fs.writeFileSync('/profs/DayZServer_x64_2023-05-05_10-00-00.RPT', 'x\n');
+        expect(await logSearch.scanHistory()).to.equal(1);
+        expect(db.run.calledWith('DELETE FROM LOG_LINES WHERE file = ?', '/profs/DayZServer_x64_2023-05-05_10-00-00.RPT')).to.be.true;
+
+        manager.getProfilesPath.returns('/missing');
+        expect(await logSearch.scanHistory()).to.equal(0);
+
+    });
+
+    it('LogSearch-search', async () => {
+
+        const logSearch = injector.resolve(LogSearch);
+
+        expect(logSearch.search({ query: ' * ' }).items).to.be.empty;
+        expect(db.all.called).to.be.false;
+
+        db.all.returns([{ id: 5, timestamp: 20 }, { id: 3, timestamp: 20 }]);
+        const page = logSearch.search({ query: 'null "pointer mission*', types: ['RPT'], since: 1, until: 2, cursor: '30:10', limit: 2 });
+
+        expect(page.nextCursor).to.equal('20:3');
+        expect(db.all.firstCall.args[0]).to.include('l.type IN (?)');
+        expect(db.all.firstCall.args[0]).to.include('ORDER BY l.timestamp DESC, l.id DESC');
+        expect(db.all.firstCall.args.slice(1)).to.deep.equal([
+            '"null" """pointer" "mission"*', 30, 30, 10, 'RPT', 1, 2, 2,
+        ]);
+
+        const defaults = logSearch.search({ query: 'null' });
+        expect(defaults.nextCursor).to.be.undefined;
+        expect(db.all.secondCall.args.slice(1)).to.deep.equal(['"null"', LogSearch.DEFAULT_PAGE_SIZE]);
+
+        // invalid cursors start at the newest line
+        logSearch.search({ query: 'null', cursor: '10' });
+        expect(db.all.thirdCall.args.slice(1)).to.deep.equal(['"null"', LogSearch.DEFAULT_PAGE_SIZE]);
+
+    });
+
+    it('LogSearch-search-history-after-live', async () => {
+
+        // a minimal LOG_LINES table, the ids are assigned in insertion order
+        const rows: { id: number; type: string; file: string; timestamp: number; message: string }[] = [];
+        lineStmt.run.callsFake(([type, file, timestamp, message]) => {
+            rows.push({ id: rows.length + 1, type, file, timestamp, message });
+        });
+        db.all.callsFake((sql: string, ...params: any[]) => {
+            const cursor = sql.includes('l.timestamp < ?') ? { timestamp: params[1], id: params[3] } : undefined;
+            return rows
+                .filter((x) => !cursor || x.timestamp < cursor.timestamp || (x.timestamp === cursor.timestamp && x.id < cursor.id))
+                .sort((a, b) => (b.timestamp - a.timestamp) || (b.id - a.id))
+                .slice(0, params[params.length - 1]);
+        });
+
+        const logSearch = injector.resolve(LogSearch);
+
+        // the live line is indexed before the older rotated files
+        const position = { file: '/profs/live.RPT', ino: 1, offset: 5, head: Buffer.from('live\n').toString('base64') };
+        logSearch.add('RPT', new Date(2023, 4, 8).valueOf(), 'live', position);
+        logSearch.flush();
+        expect(await logSearch.scanHistory()).to.equal(4);
+
+        const messages: string[] = [];
+        let cursor: string | undefined;
+        do {
+            const page = logSearch.search({ query: 'x', cursor, limit: 2 });
+            messages.push(...page.items.map((x) => x.message));
+            cursor = page.nextCursor;
+        } while (cursor);
+
+        expect(messages).to.deep.equal([
+            'live',
+            'no time',
+            '00:00:10.5 second',
+            '23:59:30 first',
+            '10:00:01 older',
+        ]);
+
+    });
+
+    it('LogSearch-cleanup', async () => {
+
+        const logSearch = injector.resolve(LogSearch);
+
+        manager.config = { logSearchMaxAge: 0 } as any;
+        logSearch['cleanup']();
+        expect(db.run.called).to.be.false;
+
+        manager.config = { logSearchMaxAge: 1000 } as any;
+        logSearch['cleanup']();
+        expect(db.run.firstCall.firstArg).to.include('DELETE FROM LOG_LINES');
+
+    });
+
+});
@@ -0,0 +1,110 @@
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports';
+import * as http from 'http';
+import * as net from 'net';
+import { StubInstance, disableConsole, enableConsole, stubClass } from '../util';
+import { DependencyContainer, Lifecycle, container } from 'tsyringe';
+import { Manager } from '../../src/control/manager';
+import { ManagerInstrumentation } from '../../src/services/manager-instrumentation';
+import { instrumentation, SQLITE_QUERY_DURATION } from '../../src/util/instrumentation';
+
+const get = (port: number, url: string): Promise<{ status: number; body: string }> => new Promise((r, e) => {
+    http.get(`http://127.0.0.1:${port}${url}`, (res) => {
+        let body = '';
+        res.on('data', (x) => body += x);
+        res.on('end', () => r({ status: res.statusCode, body }));
+    }).on('error', e);
+});
+
+const freePort = (): Promise<number> => new Promise((r) => {
+    const server = net.createServer();
+    server.listen(0, '127.0.0.1', () => {
+        const port = (server.address() as net.AddressInfo).port;
+        server.close(() => r(port));
+    });
+});
+
+describe('Test class ManagerInstrumentation', () => {
+
+    let injector: DependencyContainer;
+
+    let manager: StubInstance<Manager>;
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        // restore mocks
+        ImportMock.restore();
+
+        container.reset();
+        injector = container.createChildContainer();
+
+        injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+
+        manager = injector.resolve(Manager) as any;
+    });
+
+    it('ManagerInstrumentation-endpoint', async () => {
+        const port = await freePort();
+        manager.getInstrumentationPort.returns(port);
+        instrumentation.observe(SQLITE_QUERY_DURATION, { method: 'run' }, 2);
+
+        const service = injector.resolve(ManagerInstrumentation);
+        await service.start();
+        try {
+            const metrics = await get(port, '/metrics');
+            expect(metrics.status).to.equal(200);
+            expect(metrics.body).to.include('dzsm_sqlite_query_duration_seconds_count{method="run"}');
+            expect(metrics.body).to.include('dzsm_event_loop_lag_seconds{stat="p99"}');
+            expect(metrics.body).to.include('dzsm_process_memory_bytes{type="rss"}');
+
+            expect((await get(port, '/other')).status).to.equal(404);
+
+            const report = service.getReport();
+            expect(report.histograms.some((x) => x.name === SQLITE_QUERY_DURATION)).to.be.true;
+        } finally {
+            await service.stop();
+        }
+
+        await expect(get(port, '/metrics')).to.be.rejected;
+        expect(instrumentation.toPrometheus()).to.not.include('dzsm_event_loop_lag_seconds');
+    });
+
+    it('ManagerInstrumentation-disabled', async () => {
+        manager.getInstrumentationPort.returns(-1);
+
+        const service = injector.resolve(ManagerInstrumentation);
+        await service.start();
+
+        expect(service['server']).to.be.undefined;
+        // the ui still gets the process metrics
+        expect(instrumentation.toPrometheus()).to.include('dzsm_event_loop_lag_seconds');
+
+        await service.stop();
+        await service.stop();
+        expect(instrumentation['processUsers']).to.equal(0);
+    });
+
+    it('ManagerInstrumentation-port-in-use', async () => {
+        const blocker = net.createServer();
+        await new Promise<void>((r) => blocker.listen(0, '127.0.0.1', () => r()));
+        manager.getInstrumentationPort.returns((blocker.address() as net.AddressInfo).port);
+
+        const service = injector.resolve(ManagerInstrumentation);
+        try {
+            // does not fail the start
+            await service.start();
+            await service.stop();
+        } finally {
+            await new Promise<void>((r) => blocker.close(() => r()));
+        }
+        expect(instrumentation['processUsers']).to.equal(0);
+    });
+
+});
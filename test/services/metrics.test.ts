@@ -10,6 +10,20 @@ import { Database } from '../../src/services/database';
 import { RCON } from '../../src/services/rcon';
 import { SystemReporter } from '../../src/services/system-reporter';
 import { MetricsCollector } from '../../src/services/metrics-collector';
+import { ManagerInstrumentation } from '../../src/services/manager-instrumentation';
+
+const fakeDb = (tables: string[] = [], rows: any[] = []) => {
+    const stmt = {
+        run: sinon.stub(),
+    };
+    return {
+        stmt,
+        run: sinon.stub(),
+        first: sinon.stub(),
+        all: sinon.stub().callsFake((sql: string) => sql.includes('sqlite_master') ? tables.map((name) => ({ name })) : rows),
+        transaction: (fn) => fn({ prepare: () => stmt }),
+    };
+};
 
 describe('Test class Metrics', () => {
 
@@ -39,6 +53,7 @@ describe('Test class Metrics', () => {
         injector.register(Database, stubClass(Database), { lifecycle: Lifecycle.Singleton });
         injector.register(RCON, stubClass(RCON), { lifecycle: Lifecycle.Singleton });
         injector.register(SystemReporter, stubClass(SystemReporter), { lifecycle: Lifecycle.Singleton });
+        injector.register(ManagerInstrumentation, stubClass(ManagerInstrumentation), { lifecycle: Lifecycle.Singleton });
 
         manager = injector.resolve(Manager) as any;
         database = injector.resolve(Database) as any;
@@ -48,9 +63,7 @@ describe('Test class Metrics', () => {
 
     it('Metrics', async () => {
 
-        const db = {
-            run: (sql) => {},
-        };
+        const db = fakeDb();
         database.getDatabase.returns(db as any);
         rcon.getPlayers.resolves([]);
         systemReporter.getSystemReport.resolves({} as any);
@@ -67,9 +80,7 @@ describe('Test class Metrics', () => {
 
     it('Metrics-tick', async () => {
 
-        const db = {
-            run: sinon.stub(),
-        }
+        const db = fakeDb();
         database.getDatabase.returns(db as any);
         rcon = injector.resolve(RCON) as any;
         rcon.getPlayers.resolves([]);
@@ -77,6 +88,7 @@ describe('Test class Metrics', () => {
 
         manager.config = {
             metricPollIntervall: 10,
+            metricMaxAge: 1000,
         } as any;
 
         const metrics = injector.resolve(Metrics);
@@ -93,39 +105,529 @@ describe('Test class Metrics', () => {
         expect(metricsCollector['interval']).to.be.undefined;
 
         expect(db.run.callCount).to.be.greaterThanOrEqual(3);
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('CREATE TABLE IF NOT EXISTS SYSTEM_D'))).to.be.true;
 
     });
 
-    it('Metrics-delete', async () => {
+    it('MetricsCollector-sources', async () => {
+
+        injector.register(Metrics, stubClass(Metrics), { lifecycle: Lifecycle.Singleton });
+        const metrics = injector.resolve(Metrics) as any as StubInstance<Metrics>;
+        metrics.pushMetricValue.resolves();
+
+        // rcon never answers
+        rcon.getPlayers.returns(new Promise(() => {}));
+        systemReporter.getSystemReport.resolves({ cpu: 1 } as any);
+
+        manager.config = {
+            metricPollIntervall: 1000,
+            metricSourceTimeout: 20,
+            metricSources: {
+                SYSTEM: { timeout: 1000 },
+            },
+        } as any;
+
+        const metricsCollector = injector.resolve(MetricsCollector);
+        metricsCollector.initialTimeout = 1;
+        await metricsCollector.start();
+
+        await new Promise((r) => setTimeout(r, 60));
+        await metricsCollector.stop();
 
-        const db = {
-            run: sinon.stub(),
+        // system sample is not delayed by rcon
+        expect(metrics.pushMetricValue.callCount).to.equal(1);
+        expect(metrics.pushMetricValue.firstCall.args[0]).to.equal('SYSTEM');
+
+        const stats = metricsCollector.getSourceStats();
+        const players = stats.find((x) => x.type === 'PLAYERS');
+        const system = stats.find((x) => x.type === 'SYSTEM');
+        expect(players.timeouts).to.equal(1);
+        expect(players.samples).to.equal(0);
+        expect(players.lastLatency).to.be.greaterThanOrEqual(15);
+        expect(system.samples).to.equal(1);
+        expect(system.timeouts).to.equal(0);
+        expect(system.lastLatency).to.be.lessThan(players.lastLatency);
+
+    });
+
+    it('MetricsCollector-retention', async () => {
+
+        const clock = sinon.useFakeTimers({ toFake: ['setTimeout', 'clearTimeout', 'setInterval', 'clearInterval'] });
+        try {
+            injector.register(Metrics, stubClass(Metrics), { lifecycle: Lifecycle.Singleton });
+            const metrics = injector.resolve(Metrics) as any as StubInstance<Metrics>;
+            rcon.getPlayers.resolves([]);
+            systemReporter.getSystemReport.resolves({} as any);
+
+            manager.config = {
+                metricPollIntervall: 86_400_000,
+                metricMaxAge: 1000,
+                metricRollupMaxAge: { minute: 1000, quarterHour: 1000, hour: 1000 },
+            } as any;
+
+            const metricsCollector = injector.resolve(MetricsCollector);
+            metricsCollector.initialTimeout = 10;
+            await metricsCollector.start();
+
+            // cleaned up once on start, then every retention interval
+            clock.tick(10);
+            expect(metrics.deleteMetrics.callCount).to.equal(1);
+            expect(metrics.deleteRollups.callCount).to.equal(1);
+
+            clock.tick(metricsCollector.retentionInterval);
+            expect(metrics.deleteMetrics.callCount).to.equal(2);
+            expect(metrics.deleteMetrics.lastCall.args[0]).to.equal(1000);
+
+            // failures do not stop the schedule
+            metrics.deleteMetrics.throws(new Error('locked'));
+            clock.tick(metricsCollector.retentionInterval);
+            metrics.deleteMetrics.resetBehavior();
+            clock.tick(metricsCollector.retentionInterval);
+            expect(metrics.deleteMetrics.callCount).to.equal(4);
+
+            await metricsCollector.stop();
+            clock.tick(metricsCollector.retentionInterval);
+            expect(metrics.deleteMetrics.callCount).to.equal(4);
+        } finally {
+            clock.restore();
         }
+
+    });
+
+    it('MetricsCollector-timeout-running', async () => {
+
+        let resolve: (x: any) => void;
+        const source = { type: 'PLAYERS', sample: () => new Promise((r) => resolve = r) };
+        manager.config = {
+            metricSourceTimeout: 10,
+        } as any;
+
+        const metricsCollector = injector.resolve(MetricsCollector);
+        const stats = () => metricsCollector.getSourceStats().find((x) => x.type === 'PLAYERS');
+
+        await metricsCollector['sample'](source as any);
+        expect(stats().timeouts).to.equal(1);
+
+        // the timed out sample is still in progress
+        await metricsCollector['sample'](source as any);
+        expect(stats().skipped).to.equal(1);
+
+        resolve([]);
+        await new Promise((r) => setTimeout(r, 0));
+        expect(metricsCollector['running'].has('PLAYERS')).to.be.false;
+        expect(stats().samples).to.equal(0);
+
+    });
+
+    it('Metrics-delete', async () => {
+
+        const today = Math.floor(new Date().valueOf() / Metrics.PARTITION_SIZE);
+        const db = fakeDb([
+            'SYSTEM',
+            `SYSTEM_D${today - 3}`,
+            `SYSTEM_D${today}`,
+            `INGAME_PLAYERS_ENTITIES_D${today - 3}`,
+        ]);
+        db.first.returns({ timestamp: 1 });
         database.getDatabase.returns(db as any);
 
         const metrics = injector.resolve(Metrics);
-        
+
+        await metrics.deleteMetrics(Metrics.PARTITION_SIZE);
+
+        const sqls = db.run.getCalls().map((x) => x.firstArg.trim());
+        expect(sqls).to.include(`DROP TABLE IF EXISTS SYSTEM_D${today - 3}`);
+        expect(sqls).to.include(`DROP TABLE IF EXISTS INGAME_PLAYERS_ENTITIES_D${today - 3}`);
+        expect(sqls).to.not.include(`DROP TABLE IF EXISTS SYSTEM_D${today}`);
+        // legacy table is still cleaned up row wise
+        expect(sqls.some((x) => x.startsWith('DELETE FROM SYSTEM WHERE'))).to.be.true;
+        expect(sqls).to.not.include('DROP TABLE IF EXISTS SYSTEM');
+
+        // dropped partitions are not read anymore
+        db.all.resetHistory();
+        await metrics.fetchMetrics('SYSTEM');
+        expect(db.all.getCalls().map((x) => x.firstArg)).to.satisfy(
+            (x: string[]) => x.every((sql) => !sql.includes(`SYSTEM_D${today - 3}`)),
+        );
+
+    });
+
+    it('Metrics-delete-empty-legacy', async () => {
+
+        const db = fakeDb(['AUDIT']);
+        db.first.returns(undefined);
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
         await metrics.deleteMetrics(5);
-        expect(db.run.callCount).to.be.greaterThanOrEqual(1);
+        expect(db.run.getCalls().map((x) => x.firstArg.trim())).to.include('DROP TABLE IF EXISTS AUDIT');
+
+    });
+
+    it('Metrics-instance-tables', async () => {
+
+        const db = fakeDb(['SYSTEM_D1', 'I_chernarus_1_SYSTEM_D2']);
+        database.getDatabase.returns(db as any);
+        manager.instanceName = 'chernarus-1';
+
+        const metrics = injector.resolve(Metrics);
+        await metrics.start();
+        await metrics.pushMetricValue('SYSTEM', { timestamp: 3 * Metrics.PARTITION_SIZE, value: {} });
+        await metrics.fetchMetrics('SYSTEM');
+
+        const runSqls = db.run.getCalls().map((x) => x.firstArg.trim());
+        expect(runSqls.some((x) => x.includes('CREATE TABLE IF NOT EXISTS I_chernarus_1_SYSTEM_ROLLUP_MINUTE'))).to.be.true;
+        expect(runSqls.some((x) => x.startsWith('INSERT INTO I_chernarus_1_SYSTEM_D3 '))).to.be.true;
+        expect(runSqls.some((x) => x.includes('INTO I_chernarus_1_SYSTEM_ROLLUP_MINUTE '))).to.be.true;
+
+        // the tables of other instances are not read
+        const readSqls = db.all.getCalls().map((x) => x.firstArg).filter((x) => !x.includes('sqlite_master'));
+        expect(readSqls.some((x) => x.includes('FROM I_chernarus_1_SYSTEM_D2'))).to.be.true;
+        expect(readSqls.some((x) => x.includes('FROM SYSTEM_D1'))).to.be.false;
 
     });
 
     it('Metrics-fetch', async () => {
 
-        const db = {
-            all: sinon.stub().returns([{
-                timestamp: 1234,
-                value: '{ "test": "test" }'
-            }]),
-        };
+        const db = fakeDb(['SYSTEM', 'SYSTEM_D1', 'SYSTEM_D2', 'SYSTEM_D10', 'PLAYERS_D1'], [{
+            timestamp: 1234,
+            value: '{ "test": "test" }'
+        }]);
         database.getDatabase.returns(db as any);
 
         const metrics = injector.resolve(Metrics);
         
         const res = await metrics.fetchMetrics('SYSTEM');
-        expect(res.length).to.equal(1);
+        expect(res.length).to.equal(4);
+        expect(res[0].value.test).to.equal('test');
+
+        const queried = db.all.getCalls().map((x) => x.firstArg).filter((x) => !x.includes('sqlite_master'));
+        expect(queried[0]).to.include('FROM SYSTEM WHERE');
+        expect(queried[1]).to.include('FROM SYSTEM_D1 WHERE');
+        expect(queried[2]).to.include('FROM SYSTEM_D2 WHERE');
+        expect(queried[3]).to.include('FROM SYSTEM_D10 WHERE');
+
+        // partitions before since are skipped
+        db.all.resetHistory();
+        await metrics.fetchMetrics('SYSTEM', 2 * Metrics.PARTITION_SIZE + 5);
+        expect(db.all.callCount).to.equal(3);
+
+    });
+
+    it('Metrics-push-entity', async () => {
+
+        const db = fakeDb();
+        const stmt = db.stmt;
+        database.getDatabase.returns(db as any);
+        manager.config = {
+            ingameMetricStorage: 'entity',
+        } as any;
+
+        const metrics = injector.resolve(Metrics);
+
+        await metrics.pushMetricValue('INGAME_PLAYERS', {
+            timestamp: 1234,
+            value: [
+                { id: 1, name: 'a', type: 'SurvivorM', position: '100.5 10 200.25', speed: '0 0 0', damage: 0 },
+                { id: 2, name: 'b', type: 'SurvivorF', position: '<300, 11, 400>', speed: '0 0 0', damage: 0 },
+            ],
+        });
+
+        // only the partition and the rollups are written
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('CREATE TABLE IF NOT EXISTS INGAME_PLAYERS_ENTITIES_D0'))).to.be.true;
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('INSERT INTO'))).to.be.false;
+        expect(stmt.run.callCount).to.equal(2);
+        expect(stmt.run.firstCall.firstArg).to.deep.equal([1234, 1, 'a', 'SurvivorM', 100.5, 10, 200.25, '0 0 0', 0]);
+        expect(stmt.run.secondCall.firstArg.slice(4, 7)).to.deep.equal([300, 11, 400]);
+
+        // non entity metrics are not affected by the storage mode
+        db.run.resetHistory();
+        await metrics.pushMetricValue('SYSTEM', { timestamp: 1234, value: {} });
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('INSERT INTO SYSTEM_D0'))).to.be.true;
+
+    });
+
+    it('Metrics-push-both', async () => {
+
+        const db = fakeDb(['INGAME_VEHICLES_D0', 'INGAME_VEHICLES_ENTITIES_D0']);
+        const stmt = db.stmt;
+        database.getDatabase.returns(db as any);
+        manager.config = {
+            ingameMetricStorage: 'both',
+        } as any;
+
+        const metrics = injector.resolve(Metrics);
+
+        await metrics.pushMetricValue('INGAME_VEHICLES', {
+            timestamp: 1234,
+            value: [{ id: 1, name: 'car', type: 'OffroadHatchback', position: '1 2 3', speed: '0 0 0', damage: 0.5 }],
+        });
+
+        // partitions exist already
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('CREATE TABLE'))).to.be.false;
+        expect(db.run.firstCall.firstArg).to.include('INSERT INTO INGAME_VEHICLES_D0');
+        expect(stmt.run.callCount).to.equal(1);
+
+    });
+
+    it('Metrics-fetch-entity-snapshots', async () => {
+
+        const db = fakeDb(['INGAME_PLAYERS_ENTITIES_D0'], [
+            { timestamp: 1, id: 1, name: 'a', type: 't', x: 1, y: 2, z: 3, speed: '0 0 0', damage: 0 },
+            { timestamp: 1, id: 2, name: 'b', type: 't', x: 4, y: 5, z: 6, speed: '0 0 0', damage: 0 },
+            { timestamp: 2, id: 1, name: 'a', type: 't', x: 7, y: 8, z: 9, speed: '0 0 0', damage: 0 },
+        ]);
+        database.getDatabase.returns(db as any);
+        manager.config = {
+            ingameMetricStorage: 'entity',
+        } as any;
+
+        const metrics = injector.resolve(Metrics);
+
+        const res = await metrics.fetchMetrics('INGAME_PLAYERS');
+        expect(db.all.lastCall.firstArg).to.include('INGAME_PLAYERS_ENTITIES_D0');
+        expect(res.length).to.equal(2);
+        expect(res[0].value.length).to.equal(2);
+        expect(res[0].value[1].position).to.equal('4 5 6');
+        expect(res[1].value[0].entryType).to.equal('PLAYER');
+
+    });
+
+    it('Metrics-entity-empty-sample', async () => {
+
+        const db = fakeDb(['INGAME_PLAYERS_ENTITIES_D0']);
+        const stmt = db.stmt;
+        database.getDatabase.returns(db as any);
+        manager.config = {
+            ingameMetricStorage: 'entity',
+        } as any;
+
+        const metrics = injector.resolve(Metrics);
+
+        await metrics.pushMetricValue('INGAME_PLAYERS', {
+            timestamp: 1000,
+            value: [{ id: 1, name: 'a', type: 't', position: '1 2 3', speed: '0 0 0', damage: 0 }],
+        });
+        await metrics.pushMetricValue('INGAME_PLAYERS', { timestamp: 2000, value: [] });
+
+        // the empty sample is recorded by a placeholder row
+        expect(stmt.run.callCount).to.equal(2);
+        expect(stmt.run.secondCall.firstArg.slice(0, 2)).to.deep.equal([2000, Metrics.EMPTY_SAMPLE_ID]);
+
+        // read back what was written
+        const columns = ['timestamp', 'id', 'name', 'type', 'x', 'y', 'z', 'speed', 'damage'];
+        const rows = stmt.run.getCalls().map((call) => {
+            const row = {};
+            columns.forEach((col, i) => row[col] = call.firstArg[i]);
+            return row;
+        });
+        db.all.callsFake((sql: string) => sql.includes('sqlite_master') ? [{ name: 'INGAME_PLAYERS_ENTITIES_D0' }] : rows);
+
+        const res = await metrics.fetchMetrics('INGAME_PLAYERS');
+        expect(res.map((x) => x.timestamp)).to.deep.equal([1000, 2000]);
+        expect(res[0].value.length).to.equal(1);
+        expect(res[1].value).to.deep.equal([]);
+
+        // the placeholder is no entity
+        const callCount = db.all.callCount;
+        expect(await metrics.fetchEntityTrack('INGAME_PLAYERS', { id: Metrics.EMPTY_SAMPLE_ID })).to.be.empty;
+        expect(db.all.callCount).to.equal(callCount);
+
+    });
+
+    it('Metrics-fetch-entity-track', async () => {
+
+        const db = fakeDb(['INGAME_PLAYERS_ENTITIES_D0']);
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
+        await metrics.fetchEntityTrack('INGAME_PLAYERS', { id: 5, since: 10 });
+        expect(db.all.lastCall.args[0]).to.include('WHERE id = ?');
+        expect(db.all.lastCall.args.slice(1, 3)).to.deep.equal([5, 10]);
+
+        await metrics.fetchEntityTrack('INGAME_PLAYERS', { name: 'test' });
+        expect(db.all.lastCall.args[0]).to.include('WHERE name = ?');
+
+        const callCount = db.all.callCount;
+        expect(await metrics.fetchEntityTrack('INGAME_PLAYERS', {})).to.be.empty;
+        expect(db.all.callCount).to.equal(callCount);
+
+    });
+
+    it('Metrics-fetch-entity-area', async () => {
+
+        const db = fakeDb(['INGAME_VEHICLES_ENTITIES_D0', 'INGAME_VEHICLES_ENTITIES_D5']);
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
+        await metrics.fetchEntitiesInArea('INGAME_VEHICLES', { minX: 100, maxX: 0, minZ: 0, maxZ: 50, until: 1000 });
+        expect(db.all.lastCall.args[0]).to.include('INGAME_VEHICLES_ENTITIES_D0');
+        expect(db.all.lastCall.args.slice(3)).to.deep.equal([0, 100, 0, 50]);
+        expect(db.all.getCalls().some((x) => x.firstArg.includes('INGAME_VEHICLES_ENTITIES_D5'))).to.be.false;
+
+    });
+
+    it('Metrics-push-rollups', async () => {
+
+        const db = fakeDb();
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
+        await metrics.pushMetricValue('SYSTEM', { timestamp: 3_600_000 + 900_000 + 60_000 + 1, value: {} });
+        const rollupCalls = db.run.getCalls().filter((x) => x.firstArg.includes('INSERT OR IGNORE'));
+        expect(rollupCalls.map((x) => x.args[1])).to.deep.equal([76, 5, 1]);
+
+        db.run.resetHistory();
+        await metrics.pushMetricValue('AUDIT', { timestamp: 1234, value: {} });
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('_ROLLUP_'))).to.be.false;
+
+    });
+
+    it('Metrics-rollup-tier', async () => {
+
+        const metrics = injector.resolve(Metrics);
+
+        expect(metrics.getRollupTierFor('SYSTEM')).to.be.undefined;
+        expect(metrics.getRollupTierFor('SYSTEM', 10_000)).to.be.undefined;
+        expect(metrics.getRollupTierFor('SYSTEM', 60_000).tier).to.equal('minute');
+        expect(metrics.getRollupTierFor('SYSTEM', 1_000_000).tier).to.equal('quarterHour');
+        expect(metrics.getRollupTierFor('SYSTEM', 7_200_000).tier).to.equal('hour');
+        expect(metrics.getRollupTierFor('AUDIT', 7_200_000)).to.be.undefined;
+        expect(metrics.getRollupTierFor('INGAME_PLAYERS', 7_200_000)).to.be.undefined;
+
+    });
+
+    it('Metrics-rollup-tier-retention', async () => {
+
+        manager.config = {
+            metricMaxAge: 30 * 86_400_000,
+            metricRollupMaxAge: {
+                minute: 86_400_000,
+                quarterHour: 7 * 86_400_000,
+                hour: 0,
+            },
+        } as any;
+
+        const metrics = injector.resolve(Metrics);
+        const now = new Date().valueOf();
+
+        // recent ranges are served by the coarsest matching tier
+        expect(metrics.getRollupTierFor('SYSTEM', 1_000_000, now - 3_600_000).tier).to.equal('quarterHour');
+        // the quarter hour rollups were already cut off, the raw samples still cover the range
+        expect(metrics.getRollupTierFor('SYSTEM', 1_000_000, now - 10 * 86_400_000)).to.be.undefined;
+        expect(metrics.getRollupTierFor('SYSTEM', 1_000_000)).to.be.undefined;
+        // hourly rollups are kept forever
+        expect(metrics.getRollupTierFor('SYSTEM', 7_200_000).tier).to.equal('hour');
+
+        // finer tiers are used if they are retained longer
+        manager.config.metricRollupMaxAge = { minute: 0, quarterHour: 86_400_000, hour: 0 };
+        expect(metrics.getRollupTierFor('SYSTEM', 1_000_000, now - 10 * 86_400_000).tier).to.equal('minute');
+
+    });
+
+    it('Metrics-rollup-backfill', async () => {
+
+        const db = fakeDb(['SYSTEM', 'SYSTEM_D1']);
+        db.first.callsFake((sql: string) => (sql.includes('PLAYERS_ROLLUP') ? { bucket: 1 } : undefined));
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+        await metrics.start();
+
+        const backfills = db.run.getCalls().filter((x) => x.firstArg.includes('INSERT OR IGNORE'));
+        // empty rollup tables are filled from the legacy table and the partitions
+        expect(backfills.some((x) => x.firstArg.includes('SYSTEM_ROLLUP_MINUTE') && x.firstArg.includes('FROM SYSTEM\n'))).to.be.true;
+        expect(backfills.some((x) => x.firstArg.includes('SYSTEM_ROLLUP_HOUR') && x.firstArg.includes('FROM SYSTEM_D1'))).to.be.true;
+        expect(backfills.find((x) => x.firstArg.includes('SYSTEM_ROLLUP_HOUR')).args[1]).to.equal(3_600_000);
+        // filled tables are left alone
+        expect(backfills.some((x) => x.firstArg.includes('INTO PLAYERS_ROLLUP'))).to.be.false;
+        // excluded types have no rollups
+        expect(db.run.getCalls().some((x) => x.firstArg.includes('DROP TABLE IF EXISTS INGAME_PLAYERS_ROLLUP_MINUTE'))).to.be.true;
+
+    });
+
+    it('Metrics-fetch-rollups', async () => {
+
+        const db = fakeDb([], [{
+            timestamp: 1234,
+            value: '{ "test": "test" }',
+        }]);
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
+        const res = await metrics.fetchMetrics('PLAYERS', 1_800_000, 900_000);
+        expect(db.all.firstCall.args[0]).to.include('PLAYERS_ROLLUP_QUARTERHOUR');
+        expect(db.all.firstCall.args.slice(1)).to.deep.equal([2, 1_800_000, Number.MAX_SAFE_INTEGER]);
         expect(res[0].value.test).to.equal('test');
 
     });
 
+    it('Metrics-fetch-page', async () => {
+
+        const db = fakeDb(['SYSTEM_D0', 'SYSTEM_D1']);
+        db.all.callsFake((sql: string, ...params: any[]) => {
+            if (sql.includes('sqlite_master')) {
+                return [{ name: 'SYSTEM_D0' }, { name: 'SYSTEM_D1' }];
+            }
+            const limit = params[2];
+            const rows = sql.includes('SYSTEM_D0')
+                ? [{ timestamp: 1, value: '{ "cpu": 1, "mem": 2 }' }, { timestamp: 2, value: '{ "cpu": 3, "mem": 4 }' }]
+                : [{ timestamp: Metrics.PARTITION_SIZE + 1, value: '{ "cpu": 5, "mem": 6 }' }];
+            return rows.filter((x) => x.timestamp > params[0]).slice(0, limit);
+        });
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
+        const page1 = await metrics.fetchMetricsPage('SYSTEM', { limit: 2, fields: ['cpu'] });
+        expect(page1.items).to.deep.equal([
+            { timestamp: 1, value: { cpu: 1 } },
+            { timestamp: 2, value: { cpu: 3 } },
+        ]);
+        expect(page1.nextCursor).to.equal(2);
+        // the limit was reached with the first partition
+        expect(db.all.getCalls().some((x) => x.firstArg.includes('SYSTEM_D1'))).to.be.false;
+
+        const page2 = await metrics.fetchMetricsPage('SYSTEM', { limit: 2, cursor: page1.nextCursor });
+        expect(page2.items.length).to.equal(1);
+        expect(page2.items[0].value.mem).to.equal(6);
+        expect(page2.nextCursor).to.be.undefined;
+
+    });
+
+    it('Metrics-stream', async () => {
+
+        const metrics = injector.resolve(Metrics);
+        const fetchPage = sinon.stub(metrics, 'fetchMetricsPage');
+        fetchPage.onFirstCall().resolves({ items: [{ timestamp: 1, value: 1 }], nextCursor: 1 });
+        fetchPage.onSecondCall().resolves({ items: [{ timestamp: 2, value: 2 }], nextCursor: undefined });
+
+        const pages = [];
+        const count = await metrics.streamMetrics('SYSTEM', { fields: ['a'] }, async (page) => pages.push(page));
+
+        expect(count).to.equal(2);
+        expect(pages.length).to.equal(2);
+        expect(fetchPage.firstCall.args[1]).to.include({ limit: Metrics.PAGE_SIZE });
+        expect(fetchPage.secondCall.args[1]).to.include({ cursor: 1 });
+
+    });
+
+    it('Metrics-delete-rollups', async () => {
+
+        const db = fakeDb();
+        database.getDatabase.returns(db as any);
+
+        const metrics = injector.resolve(Metrics);
+
+        metrics.deleteRollups({ minute: 1000, hour: 0 });
+        expect(db.run.callCount).to.be.greaterThan(0);
+        expect(db.run.getCalls().every((x) => x.firstArg.includes('_ROLLUP_MINUTE'))).to.be.true;
+
+    });
+
 });
@@ -0,0 +1,161 @@
+import 'reflect-metadata';
+
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports';
+import * as sinon from 'sinon';
+import { StubInstance, disableConsole, enableConsole, memfs, stubClass } from '../util';
+import { DependencyContainer, Lifecycle, container } from 'tsyringe';
+import { Manager } from '../../src/control/manager';
+import { Paths } from '../../src/services/paths';
+import { ModStore } from '../../src/services/mod-store';
+import { FSAPI } from '../../src/util/apis';
+import * as detectOSModule from '../../src/util/detect-os';
+
+describe('Test class ModStore', () => {
+
+    let injector: DependencyContainer;
+
+    let manager: StubInstance<Manager>;
+    let paths: StubInstance<Paths>;
+    let fs: FSAPI;
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        ImportMock.restore();
+        ImportMock.mockFunction(detectOSModule, 'detectOS', 'linux');
+
+        container.reset();
+        injector = container.createChildContainer();
+
+        injector.register(Manager, stubClass(Manager), { lifecycle: Lifecycle.Singleton });
+        injector.register(Paths, stubClass(Paths), { lifecycle: Lifecycle.Singleton });
+
+        fs = memfs(
+            {
+                '/ws': {
+                    '1': {
+                        'meta.cpp': 'a',
+                        'Addons': {
+                            'One.pbo': 'one',
+                            'Shared.pbo': 'shared',
+                        },
+                    },
+                    '2': {
+                        'addons': {
+                            'shared.pbo': 'shared',
+                        },
+                    },
+                },
+                '/server': {
+                    '@one': {
+                        'old.txt': 'x',
+                        'Stale': {
+                            'file.txt': 'y',
+                        },
+                    },
+                    'linked': {},
+                },
+            },
+            '/',
+            injector,
+        );
+
+        manager = injector.resolve(Manager) as any;
+        paths = injector.resolve(Paths) as any;
+
+        manager.config = { modStorePath: 'store' } as any;
+        paths.sharedCwd.returns('/');
+        paths.isAbsolute.returns(false);
+        paths.removeLink.callsFake((target: string) => {
+            fs.unlinkSync(target);
+            return true;
+        });
+    });
+
+    afterEach(() => {
+        ImportMock.restore();
+    });
+
+    it('ModStore-ingest-deploy', async () => {
+        const store = injector.resolve(ModStore);
+        expect(store.getStorePath()).to.equal('/store');
+
+        expect(await store.ingest('1', '/ws/1')).to.deep.equal({ files: 3, hashed: 3, totalBytes: 10, storedBytes: 10 });
+        expect(Object.keys(store.readManifest('1').files)).to.deep.equal(['addons/one.pbo', 'addons/shared.pbo', 'meta.cpp']);
+
+        // identical files are stored once
+        expect(await store.ingest('2', '/ws/2')).to.deep.equal({ files: 1, hashed: 1, totalBytes: 6, storedBytes: 0 });
+
+        expect(await store.deploy('1', '/server/@one')).to.deep.equal({ linked: 3, copied: 0, unchanged: 0, removed: 2 });
+        expect(fs.readdirSync('/server/@one')).to.deep.equal(['addons', 'meta.cpp']);
+        expect(fs.readFileSync('/server/@one/addons/one.pbo') + '').to.equal('one');
+
+        // links of other install methods are replaced
+        fs.symlinkSync('/server/linked', '/server/@two');
+        expect(await store.deploy('2', '/server/@two')).to.deep.include({ linked: 1 });
+        expect(paths.removeLink.calledOnceWith('/server/@two')).to.be.true;
+        expect(fs.statSync('/server/@two/addons/shared.pbo').ino).to.equal(fs.statSync('/server/@one/addons/shared.pbo').ino);
+
+        // unchanged mods are not touched
+        expect(await store.ingest('1', '/ws/1')).to.deep.include({ hashed: 0 });
+        expect(await store.deploy('1', '/server/@one')).to.deep.equal({ linked: 0, copied: 0, unchanged: 3, removed: 0 });
+
+        // only changed files are replaced
+        fs.writeFileSync('/ws/1/Addons/One.pbo', 'one v2');
+        expect(await store.ingest('1', '/ws/1')).to.deep.include({ hashed: 1, storedBytes: 6 });
+        expect(await store.deploy('1', '/server/@one')).to.deep.equal({ linked: 1, copied: 0, unchanged: 2, removed: 0 });
+        expect(fs.readFileSync('/server/@one/addons/one.pbo') + '').to.equal('one v2');
+
+        await expect(store.deploy('3', '/server/@three')).to.be.rejectedWith('not ingested');
+    });
+
+    it('ModStore-copy-fallback', async () => {
+        const store = injector.resolve(ModStore);
+        const linkStub = sinon.stub(fs, 'linkSync').throws({ code: 'EXDEV' });
+
+        await store.ingest('1', '/ws/1');
+        expect(await store.deploy('1', '/server/@one')).to.deep.include({ linked: 0, copied: 3 });
+
+        // copies with the same content are kept once linking failed
+        fs.writeFileSync('/ws/1/meta.cpp', 'bb');
+        await store.ingest('1', '/ws/1');
+        expect(await store.deploy('1', '/server/@one')).to.deep.include({ copied: 2, unchanged: 1 });
+        expect(fs.readFileSync('/server/@one/meta.cpp') + '').to.equal('bb');
+
+        linkStub.restore();
+    });
+
+    it('ModStore-prune', async () => {
+        const store = injector.resolve(ModStore);
+
+        expect(await store.prune([])).to.equal(0);
+
+        await store.ingest('1', '/ws/1');
+        await store.ingest('2', '/ws/2');
+        fs.writeFileSync('/ws/2/addons/shared.pbo', 'changed');
+        await store.ingest('2', '/ws/2');
+
+        // removes mod 1 and the old content of mod 2
+        expect(await store.prune(['2'])).to.equal(10);
+        expect(store.readManifest('1')).to.be.undefined;
+        expect(fs.readdirSync('/store/objects').length).to.equal(1);
+    });
+
+    it('ModStore-prune-shared', async () => {
+        const store = injector.resolve(ModStore);
+        await store.ingest('1', '/ws/1');
+
+        // the other instances might still use the mod
+        paths.hasSharedCwd.returns(true);
+        expect(await store.prune([])).to.equal(0);
+        expect(store.readManifest('1')).to.not.be.undefined;
+    });
+
+});
@@ -75,6 +75,35 @@ describe('Test class ServerDetector', () => {
         expect(res[0].CreationDate).to.equal('2021-06-04 14:26:24');
     });
 
+    it('ServerDetector-knownPid', async () => {
+        const entry = {
+            Name: 'DayZ',
+            ProcessId: '1234',
+            ExecutablePath: 'test/DayZServer_x64.exe',
+            CreationDate: '20210604142624',
+        } as any;
+        processes.getProcessList.resolves([entry]);
+        manager.getServerExePath.returns('test/DayZServer_x64.exe');
+
+        const detector = injector.resolve(ServerDetector);
+        await detector.getDayZProcesses();
+        expect(processes.getProcessList.callCount).to.equal(1);
+
+        // the known process is sampled directly
+        processes.getProcess.resolves(entry);
+        detector['lastServerCheckResult'] = undefined;
+        expect((await detector.getDayZProcesses()).length).to.equal(1);
+        expect(processes.getProcess.firstCall.args).to.deep.equal(['1234', 'test/DayZServer_x64.exe']);
+        expect(processes.getProcessList.callCount).to.equal(1);
+
+        // full scan when it is gone
+        processes.getProcess.resolves(undefined);
+        processes.getProcessList.resolves([]);
+        detector['lastServerCheckResult'] = undefined;
+        expect(await detector.isServerRunning()).to.be.false;
+        expect(processes.getProcessList.callCount).to.equal(2);
+    });
+
     it('ServerDetector-serverNotRunning', async () => {
         processes.getProcessList.resolves([]);
         
@@ -533,6 +562,12 @@ describe('Test class SystemReporter', () => {
 
         expect(res).to.be.not.undefined;
         expect(res?.server).to.be.not.undefined;
+        expect(processes.getProcessCPUUsage.firstCall.args[1]).to.be.undefined;
+
+        // usages between the reports
+        const res2 = await reporter.getSystemReport();
+        expect(res2.manager.cpuTotal).to.be.greaterThanOrEqual(0);
+        expect(processes.getProcessCPUUsage.secondCall.args[1]).to.deep.include({ ProcessId: '1234' });
 
     });
 
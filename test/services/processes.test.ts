@@ -5,12 +5,13 @@ import {
     Processes,
     ProcessSpawner,
     WindowsProcessFetcher,
+    LinuxProcessFetcher,
 } from '../../src/services/processes';
 import * as childProcess from 'child_process';
 import * as nodePty from 'node-pty';
 import * as os from 'os';
 import * as sinon from 'sinon';
-import { disableConsole, enableConsole, stubClass } from '../util';
+import { disableConsole, enableConsole, memfs, stubClass } from '../util';
 import { DependencyContainer, container } from 'tsyringe';
 import { Paths } from '../../src/services/paths';
 import { LoggerFactory } from '../../src/services/loggerfactory';
@@ -212,6 +213,100 @@ describe('Test class WinProcessFetcher', () => {
 
 });
 
+describe('Test class LinuxProcessFetcher', () => {
+
+    let injector: DependencyContainer;
+
+    before(() => {
+        disableConsole();
+    });
+
+    after(() => {
+        enableConsole();
+    });
+
+    beforeEach(() => {
+        container.reset();
+        injector = container.createChildContainer();
+        injector.register(Paths, stubClass(Paths));
+        (injector.resolve(Paths).samePath as sinon.SinonStub).callsFake((a, b) => a === b);
+
+        const fs = memfs(
+            {
+                '/proc': {
+                    'stat': 'cpu  1 2 3 4\nbtime 1600000000\nprocesses 100\n',
+                    '1234': {
+                        // utime 500 ticks, stime 250 ticks, starttime 1000 ticks
+                        'stat': '1234 (DayZ (Server)) S 1 1234 1234 0 -1 4194560 100 0 0 0 500 250 0 0 20 0 50 0 1000 1000000 5000',
+                        'status': 'Name:\tDayZServer\nState:\tS (sleeping)\nVmRSS:\t  4096 kB\nRssAnon:\t  2048 kB\n',
+                        'cmdline': './DayZServer\0-config=serverDZ.cfg\0',
+                    },
+                    '99': {
+                        'stat': '99 (bash) S 1 99 99 0 -1 4194560 100 0 0 0 1 1 0 0 20 0 1 0 10 1000 50',
+                        'status': 'Name:\tbash\n',
+                        'cmdline': 'bash\0',
+                    },
+                    'self': {},
+                },
+                '/dayz': {
+                    'DayZServer': '',
+                },
+                '/bin': {
+                    'bash': '',
+                },
+            },
+            '/',
+            injector,
+        );
+        fs.symlinkSync('/dayz/DayZServer', '/proc/1234/exe');
+        fs.symlinkSync('/bin/bash', '/proc/99/exe');
+    });
+
+    it('LinuxProcesses-getProcess', async () => {
+        const fetcher = injector.resolve(LinuxProcessFetcher);
+
+        expect(fetcher.isSupported()).to.be.true;
+
+        const proc = await fetcher.getProcess('1234');
+        expect(proc).to.deep.include({
+            Name: 'DayZServer',
+            ProcessId: '1234',
+            ExecutablePath: '/dayz/DayZServer',
+            CommandLine: './DayZServer -config=serverDZ.cfg',
+            PrivatePageCount: String(2048 * 1024),
+            UserModeTime: String(5 * 10_000_000),
+            KernelModeTime: String(2.5 * 10_000_000),
+        });
+
+        // boot time + 10s
+        const created = new Date(1600000010000);
+        expect(proc.CreationDate).to.equal(
+            [
+                created.getFullYear(),
+                created.getMonth() + 1,
+                created.getDate(),
+                created.getHours(),
+                created.getMinutes(),
+                created.getSeconds(),
+            ].map((x) => String(x).padStart(2, '0')).join(''),
+        );
+        expect(proc.SampledAt).to.be.greaterThan(0);
+
+        expect(await fetcher.getProcess('4321')).to.be.undefined;
+    });
+
+    it('LinuxProcesses-getProcessList', async () => {
+        const fetcher = injector.resolve(LinuxProcessFetcher);
+
+        const result = await fetcher.getProcessList('/dayz/DayZServer');
+        expect(result.map((x) => x.ProcessId)).to.deep.equal(['1234']);
+
+        const all = await fetcher.getProcessList();
+        expect(all.map((x) => x.ProcessId).sort()).to.deep.equal(['1234', '99']);
+    });
+
+});
+
 describe('Test class ProcessesSpawner', () => {
 
     let injector: DependencyContainer;
@@ -334,6 +429,7 @@ describe('Test class Processes', () => {
         injector = container.createChildContainer();
         injector.register(ProcessSpawner, stubClass(ProcessSpawner));
         injector.register(WindowsProcessFetcher, stubClass(WindowsProcessFetcher));
+        injector.register(LinuxProcessFetcher, stubClass(LinuxProcessFetcher));
         injector.register(Paths, stubClass(Paths));
     });
 
@@ -376,6 +472,40 @@ describe('Test class Processes', () => {
         expect(processes.getProcessCPUUsage(result[0], result[0])).to.equal(0);
     });
 
+    it('Processes-getProcessCPUUsage-delta', () => {
+        const processes = injector.resolve(Processes);
+
+        const prev = Object.assign(new ProcessEntry(), {
+            ProcessId: '1',
+            UserModeTime: '0',
+            KernelModeTime: String(1000 * 10000),
+            SampledAt: 10_000,
+        });
+        // 500 ms of cpu time within 1000 ms
+        const cur = Object.assign(new ProcessEntry(), {
+            ProcessId: '1',
+            UserModeTime: String(500 * 10000),
+            KernelModeTime: String(1000 * 10000),
+            SampledAt: 11_000,
+        });
+
+        expect(processes.getProcessCPUUsage(cur, prev)).to.equal(
+            Math.round(50 / Math.max(os.cpus().length, 1)),
+        );
+    });
+
+    it('Processes-getProcess', async () => {
+        const processes = injector.resolve(Processes);
+
+        (injector.resolve(WindowsProcessFetcher).getProcessList as sinon.SinonStub).resolves([
+            Object.assign(new ProcessEntry(), { ProcessId: '1' }),
+            Object.assign(new ProcessEntry(), { ProcessId: '2' }),
+        ]);
+
+        expect((await processes.getProcess('2', 'test')).ProcessId).to.equal('2');
+        expect(await processes.getProcess('3', 'test')).to.be.undefined;
+    });
+
     it('Processes-killProcess', async () => {
         const processes = injector.resolve(Processes);
         
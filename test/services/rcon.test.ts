@@ -14,6 +14,7 @@ import { FSAPI, InjectionTokens } from '../../src/util/apis';
 import { Connection, Socket } from '@senfo/battleye';
 import { EventBus } from '../../src/control/event-bus';
 import { InternalEventTypes } from '../../src/types/events';
+import { FakeBattleyeServer } from '../battleye-server';
 
 describe('Test class RCON', () => {
 
@@ -49,6 +50,11 @@ describe('Test class RCON', () => {
         fs = memfs({}, '/', injector);
     });
 
+    afterEach(() => {
+        // connected instances schedule the roster reconcile
+        injector.resolve(RCON)['timers'].removeAllTimers();
+    });
+
     it('Battleye conf', () => {
         const conf = new BattleyeConf('1', '2');
         expect(conf.RConPassword).to.equal('1');
@@ -224,6 +230,129 @@ describe('Test class RCON', () => {
 
     });
 
+    it('RCON-roster', async () => {
+
+        let playersCalls = 0;
+        let msgCb: (msg: string) => void;
+        let playersData = `
+            1 127.0.0.1:1234 51 123abc(verified) player1
+            2 127.0.0.1:4321 90 abc123(verified) player2 (Lobby)
+        `;
+        const connection = {
+            command: async (cmd: string) => {
+                if (cmd === 'players') {
+                    playersCalls++;
+                    const data = playersData;
+                    // player connecting while the command is in flight
+                    msgCb?.('Player #4 late (127.0.0.4:4444) connected');
+                    return { data };
+                }
+            },
+            on: sinon.stub()
+                .callsFake((t, c) => {
+                    if (t === 'message') msgCb = c;
+                }),
+        } as any as Connection;
+        socket.connection.returns(connection);
+
+        const rcon = injector.resolve(RCON);
+
+        // not connected
+        expect(await rcon.getPlayers()).to.be.empty;
+
+        await rcon.start(true);
+        rcon['connected'] = true;
+
+        // initial sync
+        const synced = await rcon.getPlayers();
+        expect(playersCalls).to.equal(1);
+        expect(synced.map((x) => x.id)).to.deep.equal(['1', '2', '4']);
+        expect(synced[1].lobby).to.be.true;
+
+        // messages update the roster without round trips
+        msgCb('Player #3 newplayer (127.0.0.3:3333) connected');
+        msgCb('Player #3 newplayer - BE GUID: abcdef123');
+        msgCb('Verified GUID (fedcba321) of player #4 late');
+        msgCb('Player #9 unknown - BE GUID: 999');
+        msgCb('Player #1 player1 disconnected');
+        msgCb('Player #2 player2 (abc123) has been kicked by BattlEye: Client not responding');
+        msgCb('some other message');
+
+        const players = await rcon.getPlayers();
+        expect(playersCalls).to.equal(1);
+        expect(players).to.deep.equal([
+            { id: '4', name: 'late', ip: '127.0.0.4', port: '4444', ping: '', beguid: 'fedcba321', lobby: true },
+            { id: '3', name: 'newplayer', ip: '127.0.0.3', port: '3333', ping: '', beguid: 'abcdef123', lobby: true },
+        ]);
+
+        // reconcile replaces the roster, changes made while the command ran are kept
+        playersData = `
+            3 127.0.0.3:3333 20 abcdef123(verified) newplayer
+        `;
+        const reconciled = await rcon.reconcilePlayers();
+        expect(reconciled.map((x) => [x.id, x.ping, x.lobby])).to.deep.equal([
+            ['3', '20', false],
+            ['4', '', true],
+        ]);
+
+        // failed command keeps the roster
+        connection.command = async () => null;
+        expect((await rcon.reconcilePlayers()).length).to.equal(2);
+
+    });
+
+    it('RCON-scheduler', async () => {
+
+        const server = new FakeBattleyeServer();
+        server.handlers.set('players', () => '1 127.0.0.1:1234 51 123abc(verified) player1');
+        injector.register(InjectionTokens.rconSocket, { useValue: server.socketFactory });
+
+        const rcon = injector.resolve(RCON);
+        await rcon.start(true);
+        await sleep(10);
+
+        // greeting and initial roster sync
+        expect(rcon.isConnected()).to.be.true;
+        expect(server.received).to.deep.equal(['say -1 SWT admin CONNECTED.', 'players']);
+        expect((await rcon.getPlayers()).map((x) => x.name)).to.deep.equal(['player1']);
+
+        // admin actions skip queued polls, identical polls share one request
+        server.received = [];
+        server.latency.set('players', 20);
+        server.latency.set('bans', 20);
+        await Promise.all([
+            rcon.reconcilePlayers(),
+            rcon.getBans(),
+            rcon.reconcilePlayers(),
+            rcon.kick('1'),
+        ]);
+        expect(server.received).to.deep.equal(['players', 'kick 1', 'bans']);
+        expect(server.maxConcurrent).to.equal(1);
+
+        server.message('Player #1 player1 (123abc) has been kicked by BattlEye: Admin Kick');
+        expect(await rcon.getPlayers()).to.be.empty;
+
+        // commands without a response time out
+        rcon.commandTimeout = 20;
+        server.hang.add('#lock');
+        await rcon.lock();
+        await rcon.unlock();
+        expect(server.received.slice(-2)).to.deep.equal(['#lock', '#unlock']);
+
+        const stats = rcon.getCommandStats();
+        expect(stats.players).to.deep.include({ count: 2, coalesced: 1, errors: 0 });
+        expect(stats.players.maxLatency).to.be.gte(15);
+        expect(stats['#lock']).to.deep.include({ count: 1, timeouts: 1 });
+        expect(stats.kick.count).to.equal(1);
+
+        server.disconnect();
+        expect(rcon.isConnected()).to.be.false;
+        expect(await rcon.getPlayers()).to.be.empty;
+
+        await rcon.stop();
+
+    });
+
     it('RCON-kickAll', async () => {
     
         let kicks: string[] = [];
@@ -1,10 +1,10 @@
 import 'reflect-metadata';
 
 import { expect } from '../expect';
-import { StubInstance, disableConsole, enableConsole, fakeChildProcess, fakeHttps, memfs, stubClass } from '../util';
+import { StubInstance, disableConsole, enableConsole, fakeChildProcess, fakeHttps, memfs, sleep, stubClass } from '../util';
 import * as path from 'path';
 import * as requestModule from '../../src/util/request';
-import { SteamCMD, SteamMetaData } from '../../src/services/steamcmd';
+import { SteamCMD, SteamCmdLock, SteamMetaData } from '../../src/services/steamcmd';
 import { DAYZ_APP_ID, DAYZ_SERVER_APP_ID, PublishedFileDetail } from '../../src/types/steamcmd';
 import { DependencyContainer, Lifecycle, container } from 'tsyringe';
 import { Paths } from '../../src/services/paths';
@@ -15,6 +15,7 @@ import { Downloader } from '../../src/services/download';
 import { Config } from '../../src/config/config';
 import { ImportMock } from 'ts-mock-imports';
 import { EventBus } from '../../src/control/event-bus';
+import { ModStore } from '../../src/services/mod-store';
 
 describe('Test class SteamMetaData', () => {
 
@@ -193,6 +194,7 @@ describe('Test class SteamCMD', () => {
     let fs: FSAPI;
     let download: StubInstance<Downloader>;
     let steamMeta: StubInstance<SteamMetaData>;
+    let modStore: StubInstance<ModStore>;
     let eventBus: EventBus;
 
     before(() => {
@@ -213,13 +215,16 @@ describe('Test class SteamCMD', () => {
         injector.register(Downloader, stubClass(Downloader), { lifecycle: Lifecycle.Singleton });
         injector.register(SteamMetaData, stubClass(SteamMetaData), { lifecycle: Lifecycle.Singleton });
         injector.register(EventBus, EventBus, { lifecycle: Lifecycle.Singleton });
+        injector.register(ModStore, stubClass(ModStore), { lifecycle: Lifecycle.Singleton });
 
         fs = memfs({}, '/', injector);
         download = injector.resolve(Downloader) as any;
         manager = injector.resolve(Manager) as any;
         paths = injector.resolve(Paths) as any;
+        paths.sharedCwd.callsFake(() => paths.cwd());
         processes = injector.resolve(Processes) as any;
         steamMeta = injector.resolve(SteamMetaData) as any;
+        modStore = injector.resolve(ModStore) as any;
         eventBus = injector.resolve(EventBus);
     });
 
@@ -544,6 +549,104 @@ describe('Test class SteamCMD', () => {
     });
 
     
+    it('SteamCmd-updateMods-pipeline', async () => {
+
+        const modsBasePath = `/testcwd/testwspath/steamapps/workshop/content/${DAYZ_APP_ID}`;
+        fs = memfs(
+            {
+                [modsBasePath]: {
+                    '5': { 'meta.cpp': 'name = "Mod 5"' },
+                },
+                '/testcwd/testserver': {},
+            },
+            '/',
+            injector,
+        );
+        paths.cwd.returns('/testcwd');
+        paths.findFilesInDir.resolves([]);
+
+        manager.config = {
+            steamWorkshopPath: 'testwspath',
+            linkModDirs: true,
+            updateModsMaxBatchFileSize: 1_000_000_000,
+            updateModsConcurrency: 2,
+        } as any;
+        manager.getCombinedModIdList.returns(['1', '2', '3', '4', '5']);
+        manager.getServerPath.returns('/testcwd/testserver');
+        steamMeta.modNeedsUpdate.resolves(['1', '2', '3', '4']);
+        steamMeta.getModsMetaData.resolves([
+            { publishedfileid: '1', file_size: 600_000_000 },
+            { publishedfileid: '2', file_size: 500_000_000 },
+            { publishedfileid: '3', file_size: 400_000_000 },
+            { publishedfileid: '4', file_size: 300_000_000 },
+        ] as PublishedFileDetail[]);
+
+        const events: string[] = [];
+        let running = 0;
+        let maxRunning = 0;
+        processes.spawnForOutput.callsFake(async (cmd, args: string[]) => {
+            const mods = args.filter((x, i) => args[i - 1] === DAYZ_APP_ID);
+            running++;
+            maxRunning = Math.max(maxRunning, running);
+            await sleep(20);
+            for (const modId of mods) {
+                fs.mkdirSync(`${modsBasePath}/${modId}`, { recursive: true });
+                fs.writeFileSync(`${modsBasePath}/${modId}/meta.cpp`, `name = "Mod ${modId}"`);
+            }
+            events.push(`downloaded ${mods}`);
+            running--;
+            return { status: 0, stderr: '', stdout: '' };
+        });
+        paths.linkDirsFromTo.callsFake((from: string) => {
+            events.push(`installed ${path.basename(from)}`);
+            return true;
+        });
+
+        const steamCmd = injector.resolve(SteamCMD);
+
+        // first fit decreasing
+        expect(steamCmd.packModBatches(
+            [{ file_size: 1 }, { file_size: 5 }, { file_size: 3 }, { file_size: 2 }, {}],
+            2,
+            7,
+        ).map((batch) => batch.map((x) => x.file_size))).to.deep.equal([[5, 1], [3, 2], [undefined]]);
+
+        expect(await steamCmd.updateAllMods({ install: true })).to.be.true;
+
+        // the downloads share the workshop state, so they run one after another
+        expect(maxRunning).to.equal(1);
+        // the first batch was installed while the second one was still downloading
+        expect(events).to.deep.equal([
+            'downloaded 1,4',
+            'installed 1',
+            'installed 4',
+            'downloaded 2,3',
+            'installed 2',
+            'installed 3',
+        ]);
+        expect(steamCmd.listModUpdatedID).to.have.members(['1', '2', '3', '4']);
+        expect(steamCmd.isNewModUpdated).to.be.true;
+        expect(fs.existsSync('/testcwd/testserver/keys')).to.be.true;
+
+        const stats = steamCmd.lastModUpdateStats;
+        expect(stats.batches).to.equal(2);
+        expect(stats.download).to.deep.include({ mods: 4, bytes: 1_800_000_000 });
+        expect(stats.install).to.deep.include({ mods: 4, bytes: 1_800_000_000 });
+        expect(stats.download.throughput).to.be.greaterThan(0);
+        expect(stats.total).to.be.gte(stats.download.duration);
+
+        // already installed mods are skipped
+        expect(await steamCmd.installMods()).to.be.true;
+        expect(events.pop()).to.equal('installed 5');
+        expect(paths.linkDirsFromTo.callCount).to.equal(5);
+
+        // failed installs stop the pipeline
+        paths.linkDirsFromTo.returns(false);
+        expect(await steamCmd.updateAllMods({ install: true })).to.be.false;
+        expect(steamCmd.lastModUpdateStats.install.mods).to.equal(0);
+
+    });
+
     it('SteamCmd-checkMods', async () => {
 
        fs = memfs(
@@ -760,6 +863,50 @@ describe('Test class SteamCMD', () => {
         expect(fs.readFileSync('/testcwd/testserver/keys/testkey.bikey') + '').to.equal('bikey');
     });
 
+    it('SteamCmd-installMods-store', async () => {
+        fs = memfs(
+            {
+                'testcwd': {
+                    'testwspath/steamapps/workshop/content': {
+                        [DAYZ_APP_ID]: {
+                            '1234567': {
+                                'meta.cpp': 'name = "Test Mod"',
+                            },
+                        },
+                    },
+                    'testserver': {},
+                },
+            },
+            '/',
+            injector,
+        );
+        paths.cwd.returns('/testcwd');
+        paths.findFilesInDir.resolves([]);
+        modStore.ingest.resolves({ files: 1, hashed: 1, totalBytes: 1, storedBytes: 1 });
+        modStore.deploy.resolves({ linked: 1, copied: 0, unchanged: 0, removed: 0 });
+
+        manager.config = {
+            steamWorkshopPath: 'testwspath',
+            useModStore: true,
+        } as any;
+        manager.getCombinedModIdList.returns(['1234567']);
+        manager.getServerPath.returns('/testcwd/testserver');
+
+        const steamCmd = injector.resolve(SteamCMD);
+
+        expect(await steamCmd.installMods()).to.be.true;
+        expect(modStore.ingest.firstCall.args).to.deep.equal([
+            '1234567',
+            path.join('/testcwd/testwspath/steamapps/workshop/content', DAYZ_APP_ID, '1234567'),
+        ]);
+        expect(modStore.deploy.firstCall.args).to.deep.equal(['1234567', path.join('/testcwd/testserver', '@Test-Mod')]);
+        expect(modStore.prune.calledOnceWith(['1234567'])).to.be.true;
+        expect(paths.copyDirFromTo.called).to.be.false;
+
+        modStore.deploy.rejects(new Error('test'));
+        expect(await steamCmd.installMod('1234567')).to.be.false;
+    });
+
     it('SteamCmd-updateMods-Error', async () => {
 
         fs = memfs(
@@ -808,3 +955,49 @@ describe('Test class SteamCMD', () => {
     });
 
 });
+
+describe('Test class SteamCmdLock', () => {
+
+    const task = (calls: string[], name: string, fail?: boolean) => async () => {
+        calls.push(`start ${name}`);
+        await sleep(10);
+        calls.push(`end ${name}`);
+        if (fail) {
+            throw new Error(name);
+        }
+        return name;
+    };
+
+    it('SteamCmdLock-exclusive', async () => {
+        const lock = new SteamCmdLock();
+        const calls: string[] = [];
+
+        const results = await Promise.all([
+            lock.run('/steamcmd', task(calls, 'a')),
+            lock.run('/steamcmd', task(calls, 'b', true)).catch((e) => `failed ${e.message}`),
+            lock.run('/steamcmd', task(calls, 'c')),
+        ]);
+
+        // a failed call does not block the following ones
+        expect(results).to.deep.equal(['a', 'failed b', 'c']);
+        expect(calls).to.deep.equal(['start a', 'end a', 'start b', 'end b', 'start c', 'end c']);
+        expect(lock['installations'].size).to.equal(0);
+    });
+
+    it('SteamCmdLock-installations', async () => {
+        const lock = new SteamCmdLock();
+        const calls: string[] = [];
+
+        await Promise.all([
+            lock.run('/steamcmd', task(calls, 'batch 1')),
+            lock.run('/steamcmd', task(calls, 'batch 2')),
+            // other installations are independent
+            lock.run('/other', task(calls, 'other')),
+        ]);
+
+        expect(calls.slice(0, 2)).to.deep.equal(['start batch 1', 'start other']);
+        expect(calls.indexOf('start batch 2')).to.be.greaterThan(calls.indexOf('end batch 1'));
+        expect(lock['installations'].size).to.equal(0);
+    });
+
+});
@@ -0,0 +1,128 @@
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports'
+import { AdmParser } from '../../src/util/adm-parser';
+
+describe('Test AdmParser', () => {
+
+    let parser: AdmParser;
+
+    beforeEach(() => {
+        // restore mocks
+        ImportMock.restore();
+
+        parser = new AdmParser();
+        parser.parse('AdminLog started on 2023-05-06 at 23:59:00');
+    });
+
+    const at = (day: number, h: number, m: number, s: number): number => new Date(2023, 4, day, h, m, s).valueOf();
+
+    it('AdmParser-connect', () => {
+
+        const connect = parser.parse('23:59:01 | Player "Survivor"(id=ABC123=) is connected');
+        expect(connect).to.deep.equal({
+            timestamp: at(6, 23, 59, 1),
+            type: 'CONNECT',
+            playerName: 'Survivor',
+            playerId: 'ABC123=',
+        });
+
+        // midnight rollover
+        const disconnect = parser.parse('00:00:05 | Player "Survivor"(id=ABC123=) has been disconnected');
+        expect(disconnect.type).to.equal('DISCONNECT');
+        expect(disconnect.timestamp).to.equal(at(7, 0, 0, 5));
+
+    });
+
+    it('AdmParser-hit', () => {
+
+        const hit = parser.parse(
+            '23:59:10 | Player "Victim" (id=V1= pos=<4544.3, 10345.1, 339.2>)[HP: 85.3] hit by Player "Killer" (id=K1= pos=<4550.0, 10340.5, 338.9>) '
+            + 'into Torso(12) for 14.5 damage (Bullet_556x45) with M4-A1 from 35.2 meters',
+        );
+        expect(hit).to.deep.include({
+            type: 'HIT',
+            playerName: 'Victim',
+            playerId: 'V1=',
+            x: 4544.3,
+            y: 339.2,
+            z: 10345.1,
+            hp: 85.3,
+            sourceName: 'Killer',
+            sourceId: 'K1=',
+            sourceX: 4550,
+            bodyPart: 'Torso',
+            damage: 14.5,
+            ammo: 'Bullet_556x45',
+            weapon: 'M4-A1',
+            distance: 35.2,
+        });
+
+        const infected = parser.parse(
+            '23:59:11 | Player "Victim" (id=V1= pos=<4544.3, 10345.1, 339.2>)[HP: 75] hit by Infected into Head(0) for 10 damage (MeleeInfected)',
+        );
+        expect(infected).to.deep.include({
+            type: 'HIT',
+            sourceName: 'Infected',
+            bodyPart: 'Head',
+            damage: 10,
+            ammo: 'MeleeInfected',
+        });
+        expect(infected.weapon).to.be.undefined;
+
+    });
+
+    it('AdmParser-kill', () => {
+
+        const kill = parser.parse(
+            '23:59:12 | Player "Victim" (DEAD) (id=V1= pos=<4544.3, 10345.1, 339.2>) killed by Player "Killer" (id=K1= pos=<4550.0, 10340.5, 338.9>) '
+            + 'with M4-A1 from 35.2 meters',
+        );
+        expect(kill).to.deep.include({
+            type: 'KILL',
+            playerId: 'V1=',
+            sourceId: 'K1=',
+            weapon: 'M4-A1',
+            distance: 35.2,
+        });
+
+        const byInfected = parser.parse('23:59:13 | Player "Victim" (DEAD) (id=V1= pos=<1, 2, 3>) killed by Infected');
+        expect(byInfected.sourceName).to.equal('Infected');
+
+    });
+
+    it('AdmParser-misc', () => {
+
+        expect(parser.parse('23:59:20 | Player "A" (DEAD) (id=A= pos=<1, 2, 3>) died. Stats> Water: 10 Energy: 20 Bleed sources: 0').type)
+            .to.equal('DEATH');
+        expect(parser.parse('23:59:20 | Player "A" (id=A= pos=<1, 2, 3>) committed suicide').type).to.equal('SUICIDE');
+        expect(parser.parse('23:59:20 | Player "A" (id=A= pos=<1, 2, 3>) is unconscious').type).to.equal('UNCONSCIOUS');
+        expect(parser.parse('23:59:20 | Player "A" (id=A= pos=<1, 2, 3>) regained consciousness').type).to.equal('CONSCIOUS');
+
+        const position = parser.parse('23:59:20 | Player "A" (id=A= pos=<1, 2, 3>)');
+        expect(position).to.deep.include({ type: 'POSITION', playerId: 'A=', x: 1, y: 3, z: 2 });
+
+        const chat = parser.parse('23:59:21 | Chat("A"(id=A=)): hello there');
+        expect(chat).to.deep.include({ type: 'CHAT', playerName: 'A', playerId: 'A=', message: 'hello there' });
+
+        expect(parser.parse('23:59:21 | ##### PlayerList log: 1 players')).to.be.undefined;
+        expect(parser.parse('23:59:21 | Player "A" (id=A= pos=<1, 2, 3>) placed Fireplace')).to.be.undefined;
+        expect(parser.parse('')).to.be.undefined;
+        expect(parser.parse('garbage')).to.be.undefined;
+
+    });
+
+    it('AdmParser-no-header', () => {
+
+        parser.reset();
+        const received = new Date(2023, 4, 7, 0, 10, 0).valueOf();
+
+        // line written before midnight, read afterwards
+        const event = parser.parse('23:59:50 | Player "A" (id=A= pos=<1, 2, 3>) committed suicide', received);
+        expect(event.timestamp).to.equal(at(6, 23, 59, 50));
+
+        const event2 = parser.parse('00:09:50 | Player "A" (id=A= pos=<1, 2, 3>) committed suicide', received);
+        expect(event2.timestamp).to.equal(at(7, 0, 9, 50));
+
+    });
+
+});
@@ -0,0 +1,134 @@
+import { expect } from '../expect';
+import { sleep } from '../util';
+import { CommandPriority, CommandScheduler, CommandTimeoutError } from '../../src/util/command-scheduler';
+
+describe('Test class CommandScheduler', () => {
+
+    const createScheduler = (maxInFlight: number = 1, timeout: number = 1000) => {
+        const sent: string[] = [];
+        const pending = new Map<string, { res: (x: string) => void, rej: (e: Error) => void }>();
+        const scheduler = new CommandScheduler<string>(
+            (command) => {
+                sent.push(command);
+                return new Promise<string>((res, rej) => pending.set(command, { res, rej }));
+            },
+            maxInFlight,
+            timeout,
+        );
+        return { scheduler, sent, pending };
+    };
+
+    it('CommandScheduler-priority', async () => {
+        const { scheduler, sent, pending } = createScheduler();
+
+        const first = scheduler.schedule('players', { priority: CommandPriority.LOW });
+        const poll = scheduler.schedule('bans', { priority: CommandPriority.LOW });
+        const say = scheduler.schedule('say -1 test');
+        const kick = scheduler.schedule('kick 1', { priority: CommandPriority.HIGH });
+
+        expect(sent).to.deep.equal(['players']);
+        expect(scheduler.pending).to.equal(3);
+        expect(scheduler.running).to.equal(1);
+
+        pending.get('players').res('p');
+        expect(await first).to.equal('p');
+        expect(sent).to.deep.equal(['players', 'kick 1']);
+
+        pending.get('kick 1').res('k');
+        await kick;
+        pending.get('say -1 test').res('s');
+        await say;
+        pending.get('bans').res('b');
+        await poll;
+
+        expect(sent).to.deep.equal(['players', 'kick 1', 'say -1 test', 'bans']);
+        expect(scheduler.pending).to.equal(0);
+        expect(scheduler.running).to.equal(0);
+    });
+
+    it('CommandScheduler-coalesce', async () => {
+        const { scheduler, sent, pending } = createScheduler();
+
+        const blocker = scheduler.schedule('say -1 block');
+        const players1 = scheduler.schedule('players', { priority: CommandPriority.LOW, coalesce: true });
+        const bans = scheduler.schedule('bans', { priority: CommandPriority.LOW });
+        // promotes the queued poll
+        const players2 = scheduler.schedule('players', { priority: CommandPriority.NORMAL, coalesce: true });
+        // not coalescing
+        const players3 = scheduler.schedule('players', { priority: CommandPriority.LOW });
+
+        expect(players2).to.equal(players1);
+        expect(scheduler.pending).to.equal(3);
+
+        pending.get('say -1 block').res('');
+        await blocker;
+        expect(sent).to.deep.equal(['say -1 block', 'players']);
+
+        // in flight requests are shared as well
+        expect(scheduler.schedule('players', { coalesce: true })).to.equal(players1);
+
+        pending.get('players').res('list');
+        expect(await players1).to.equal('list');
+        expect(sent).to.deep.equal(['say -1 block', 'players', 'bans']);
+
+        // answered requests are not shared anymore
+        const players4 = scheduler.schedule('players', { coalesce: true });
+        expect(players4).to.not.equal(players1);
+
+        pending.get('bans').res('');
+        await bans;
+        pending.get('players').res('list4');
+        expect(await players4).to.equal('list4');
+        pending.get('players').res('list3');
+        expect(await players3).to.equal('list3');
+
+        expect(scheduler.getCommandStats().players.coalesced).to.equal(2);
+    });
+
+    it('CommandScheduler-timeout', async () => {
+        const { scheduler, sent, pending } = createScheduler(1, 20);
+
+        const hanging = scheduler.schedule('players');
+        const next = scheduler.schedule('kick 1', { timeout: 0 });
+
+        await expect(hanging).to.be.rejectedWith(CommandTimeoutError);
+        // slot was freed
+        expect(sent).to.deep.equal(['players', 'kick 1']);
+
+        await sleep(30);
+        pending.get('kick 1').res('done');
+        expect(await next).to.equal('done');
+
+        const stats = scheduler.getCommandStats();
+        expect(stats.players.timeouts).to.equal(1);
+        expect(stats.players.errors).to.equal(1);
+        expect(stats.players.lastError).to.include('timed out');
+        expect(stats.players.maxLatency).to.be.gte(15);
+        expect(stats.kick.timeouts).to.equal(0);
+        expect(stats.kick.count).to.equal(1);
+    });
+
+    it('CommandScheduler-errors', async () => {
+        const { scheduler, pending } = createScheduler(2);
+
+        const failing = scheduler.schedule('ban 1');
+        const other = scheduler.schedule('ban 2');
+        const queued = scheduler.schedule('players', { coalesce: true });
+
+        pending.get('ban 1').rej(new Error('failed'));
+        await expect(failing).to.be.rejectedWith('failed');
+
+        // queued commands are rejected on clear
+        const queued2 = scheduler.schedule('bans');
+        scheduler.clear(new Error('stopped'));
+        await expect(queued2).to.be.rejectedWith('stopped');
+
+        pending.get('ban 2').res('ok');
+        await other;
+        pending.get('players').res('ok');
+        await queued;
+
+        expect(scheduler.getCommandStats().ban).to.deep.include({ count: 2, errors: 1, lastError: 'failed' });
+    });
+
+});
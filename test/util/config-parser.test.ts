@@ -55,6 +55,30 @@ class Missions
 };
 `;
 
+const MOD_CFG = `
+#include "macros.hpp"
+#define ITEM(name) \\
+    class name {}
+
+class CfgPatches { class Test { units[] = {}; requiredAddons[] = {"DZ_Data", "DZ_Scripts"}; }; };
+class CfgVehicles
+{
+    class Inventory_Base;
+    class Test_Base: Inventory_Base { scope = 0; displayName = "He said ""hi"""; weight=1.5; hidden[]={{1,2},{3}}; };
+    class Test_Item : Test_Base
+    {
+        scope = 2; // comment "x";
+        /* class Commented { a = 1; }; */
+        model = "\\dz\\gear\\test.p3d";
+        canBeSplit = true;
+        itemSize[] += {1};
+        delete Foo;
+        identifier = SomeMacro;
+        class Empty {};
+    };
+};
+`;
+
 describe('Test class config parser', () => {
 
     before(() => {
@@ -106,4 +130,71 @@ describe('Test class config parser', () => {
         
     });
 
+    it('ConfigParser-classes', () => {
+
+        const parser = new ConfigParser();
+
+        const parsed = parser.cfg2json(MOD_CFG);
+
+        expect(parsed).to.deep.equal({
+            CfgPatches: {
+                Test: {
+                    units: [],
+                    requiredAddons: ['DZ_Data', 'DZ_Scripts'],
+                },
+            },
+            CfgVehicles: {
+                Test_Base: {
+                    scope: 0,
+                    displayName: 'He said ""hi""',
+                    weight: 1.5,
+                    hidden: [[1, 2], [3]],
+                    __inherited: 'Inventory_Base',
+                },
+                Test_Item: {
+                    scope: 2,
+                    model: '\\dz\\gear\\test.p3d',
+                    canBeSplit: true,
+                    Empty: {},
+                    __inherited: 'Test_Base',
+                },
+            },
+        });
+
+        const stringified = parser.json2cfg(parsed);
+        expect(stringified).to.contain('class Test_Item: Test_Base\r\n');
+        expect(stringified).to.contain('hidden[]={{1,2},{3}};');
+        expect(stringified).to.not.contain('__inherited');
+        expect(parser.cfg2json(stringified)).to.deep.equal(parsed);
+
+    });
+
+    it('ConfigParser-lenient', () => {
+
+        const parser = new ConfigParser();
+
+        expect(parser.cfg2json('a=1;;b=2; } x = 3; {y=1;}; z[] = {1;2,}; q[2]=1; s[] = 1; =5; c=0x10; w=4'))
+            .to.deep.equal({ a: 1, b: 2, x: 3, z: [1, 2], c: 16, w: 4 });
+
+        expect(() => parser.cfg2json('class A { a = 1;')).to.throw('unexpected end of file');
+        expect(() => parser.cfg2json('a = "x')).to.throw('unexpected end of file');
+        expect(() => parser.cfg2json('a[] = {1,')).to.throw('unexpected end of file');
+
+    });
+
+    it('ConfigParser-json2cfgStream', async () => {
+
+        const parser = new ConfigParser();
+        const parsed = parser.cfg2json(MOD_CFG);
+
+        const chunks: string[] = [];
+        for await (const chunk of parser.json2cfgStream(parsed)) {
+            chunks.push(chunk);
+        }
+
+        expect(chunks.length).to.equal(2);
+        expect(chunks.join('')).to.equal(parser.json2cfg(parsed));
+
+    });
+
 });
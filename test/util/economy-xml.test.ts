@@ -0,0 +1,107 @@
+import { expect } from '../expect';
+import {
+    joinEconomyXml,
+    parseEconomyElement,
+    patchEconomyElement,
+    serializeEconomyElement,
+    splitEconomyXml,
+} from '../../src/util/economy-xml';
+
+const TYPES_XML = `<?xml version="1.0" encoding="UTF-8" standalone="yes" ?>
+<types>
+    <!-- weapons -->
+    <type name="AKM">
+        <nominal>10</nominal>
+        <lifetime>28800</lifetime>
+        <flags count_in_cargo="0" count_in_hoarder="0"/>
+        <category name="weapons"/>
+        <usage name="Military"/>
+    </type>
+    <type name="Apple"><nominal>5</nominal><value name="Tier1"/></type>
+    <type name="Tom &amp; Jerry" note='a > b'/>
+</types>
+`;
+
+describe('Test economy xml', () => {
+
+    it('splitEconomyXml', () => {
+        const doc = splitEconomyXml(TYPES_XML);
+
+        expect(doc.segments.map((x) => x.name)).to.deep.equal(['AKM', 'Apple', 'Tom & Jerry']);
+        expect(doc.segments[0].before).to.contain('<!-- weapons -->');
+        expect(doc.segments[1].raw).to.equal('<type name="Apple"><nominal>5</nominal><value name="Tier1"/></type>');
+        expect(joinEconomyXml(doc)).to.equal(TYPES_XML);
+
+        expect(splitEconomyXml('<types/>').segments).to.be.empty;
+        expect(() => splitEconomyXml('no xml')).to.throw('missing root element');
+        expect(() => splitEconomyXml('<types><type name="a">')).to.throw('unclosed element');
+        expect(() => splitEconomyXml('<types><type name="a"/>')).to.throw('unclosed root element');
+        expect(() => splitEconomyXml('<types><!-- x')).to.throw('unclosed comment');
+        expect(() => splitEconomyXml('<types><![CDATA[ x')).to.throw('unclosed CDATA');
+        expect(() => splitEconomyXml('<types')).to.throw('unclosed tag');
+    });
+
+    it('parseEconomyElement', () => {
+        const doc = splitEconomyXml(TYPES_XML);
+
+        const akm = parseEconomyElement(doc.segments[0].raw);
+        expect(akm.tag).to.equal('type');
+        expect(akm.attributes).to.deep.equal({ name: 'AKM' });
+        expect(akm.children.map((x) => x.tag)).to.deep.equal(['nominal', 'lifetime', 'flags', 'category', 'usage']);
+        expect(akm.children[0].text).to.equal('10');
+        expect(akm.children[2].attributes).to.deep.equal({ count_in_cargo: '0', count_in_hoarder: '0' });
+
+        expect(parseEconomyElement(doc.segments[2].raw).attributes).to.deep.equal({ name: 'Tom & Jerry', note: 'a > b' });
+        expect(parseEconomyElement('<a><!-- x --><b>1 &lt; 2</b><![CDATA[y]]></a>').children[0].text).to.equal('1 < 2');
+
+        expect(() => parseEconomyElement('<a></b>')).to.throw('unexpected closing tag');
+        expect(() => parseEconomyElement('<a/><b/>')).to.throw('multiple root elements');
+        expect(() => parseEconomyElement('<a>')).to.throw('incomplete element');
+        expect(() => parseEconomyElement('< >')).to.throw('missing tag name');
+    });
+
+    it('serializeEconomyElement', () => {
+        const akm = parseEconomyElement(splitEconomyXml(TYPES_XML).segments[0].raw);
+        expect(`    ${serializeEconomyElement(akm, '    ')}`).to.equal(TYPES_XML.slice(
+            TYPES_XML.indexOf('    <type name="AKM">'),
+            TYPES_XML.indexOf('</type>') + 7,
+        ));
+
+        expect(serializeEconomyElement({ tag: 'a', attributes: { x: '"&"' }, children: [], text: '<>' }))
+            .to.equal('<a x="&quot;&amp;&quot;">&lt;&gt;</a>');
+        expect(serializeEconomyElement({ tag: 'a', attributes: {}, children: [{ tag: 'b', attributes: {}, children: [] }] }, '', '\t', '\r\n'))
+            .to.equal('<a>\r\n\t<b/>\r\n</a>');
+    });
+
+    it('patchEconomyElement', () => {
+        const akm = parseEconomyElement(splitEconomyXml(TYPES_XML).segments[0].raw);
+
+        patchEconomyElement(akm, {
+            'nominal': 20,
+            'restock': '0',
+            'lifetime': null,
+            'flags@count_in_cargo': 1,
+            'flags@count_in_hoarder': null,
+            'quantmin@x': null,
+            'cost': null,
+            'value@name': 'Tier2',
+            '@comment': 'patched',
+        });
+        expect(akm.attributes).to.deep.equal({ name: 'AKM', comment: 'patched' });
+        expect(serializeEconomyElement(akm)).to.equal([
+            '<type name="AKM" comment="patched">',
+            '    <nominal>20</nominal>',
+            '    <flags count_in_cargo="1"/>',
+            '    <category name="weapons"/>',
+            '    <usage name="Military"/>',
+            '    <restock>0</restock>',
+            '    <value name="Tier2"/>',
+            '</type>',
+        ].join('\n'));
+
+        patchEconomyElement(akm, { '@comment': null });
+        expect(akm.attributes).to.deep.equal({ name: 'AKM' });
+        expect(() => patchEconomyElement(akm, { '@name': 'x' })).to.throw('can not be patched');
+    });
+
+});
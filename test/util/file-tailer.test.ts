@@ -0,0 +1,102 @@
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports'
+import { memfs } from '../util';
+import { FSAPI } from '../../src/util/apis';
+import { FileTailer } from '../../src/util/file-tailer';
+import { TailPosition } from '../../src/types/log-reader';
+
+describe('Test FileTailer', () => {
+
+    let fs: FSAPI;
+    let lines: string[];
+    let positions: TailPosition[];
+    let tailer: FileTailer;
+
+    beforeEach(() => {
+        // restore mocks
+        ImportMock.restore();
+
+        fs = memfs({ '/logs': { 'server.rpt': 'line 1\nline 2\r\npartial' } }, '/');
+        lines = [];
+        positions = [];
+        tailer = new FileTailer(
+            fs,
+            '/logs/server.rpt',
+            (line, position) => {
+                lines.push(line);
+                positions.push(position);
+            },
+            undefined,
+            5,
+        );
+    });
+
+    afterEach(() => {
+        tailer.stop();
+    });
+
+    it('FileTailer-follow', async () => {
+
+        expect(await tailer.start()).to.equal(0);
+        expect(lines).to.deep.equal(['line 1', 'line 2']);
+        expect(positions[1].offset).to.equal(15);
+
+        fs.appendFileSync('/logs/server.rpt', ' line 3\nline 4\n');
+        await new Promise((r) => setTimeout(r, 30));
+        expect(lines).to.deep.equal(['line 1', 'line 2', 'partial line 3', 'line 4']);
+        expect(tailer.position.offset).to.equal(fs.statSync('/logs/server.rpt').size);
+
+    });
+
+    it('FileTailer-resume', async () => {
+
+        await tailer.start();
+        const position = tailer.position;
+        tailer.stop();
+        lines = [];
+
+        const backfill: string[] = [];
+        fs.appendFileSync('/logs/server.rpt', '\nline 4\n');
+        expect(await tailer.start(position, (x) => backfill.push(x))).to.equal(15);
+        expect(backfill).to.deep.equal(['line 1', 'line 2']);
+        expect(lines).to.deep.equal(['partial', 'line 4']);
+
+    });
+
+    it('FileTailer-rotate-truncate', async () => {
+
+        await tailer.start();
+        const position = tailer.position;
+        tailer.stop();
+
+        // truncated
+        lines = [];
+        fs.writeFileSync('/logs/server.rpt', 'new\n');
+        expect(await tailer.start(position)).to.equal(0);
+        expect(lines).to.deep.equal(['new']);
+
+        // replaced while following
+        lines = [];
+        fs.unlinkSync('/logs/server.rpt');
+        fs.writeFileSync('/logs/server.rpt', 'rotated 1\nrotated 2\n');
+        await tailer.poll();
+        expect(lines).to.deep.equal(['rotated 1', 'rotated 2']);
+
+    });
+
+    it('FileTailer-error', async () => {
+
+        const errors: Error[] = [];
+        tailer = new FileTailer(fs, '/logs/server.rpt', () => {}, (e) => errors.push(e));
+        await tailer.start();
+
+        fs.unlinkSync('/logs/server.rpt');
+        await tailer.poll();
+        await tailer.poll();
+
+        // reported once
+        expect(errors.length).to.equal(1);
+
+    });
+
+});
@@ -0,0 +1,122 @@
+import { expect } from '../expect';
+import { sleep } from '../util';
+import { GC_DURATION, Histogram, instanceLabels, Instrumentation } from '../../src/util/instrumentation';
+
+describe('Test class Instrumentation', () => {
+
+    it('Histogram-observe', () => {
+        const histogram = new Histogram('test', {});
+
+        histogram.observe(0.5);
+        histogram.observe(5);
+        histogram.observe(7);
+        histogram.observe(20000);
+
+        // le 1, le 5, le 10, ..., +Inf
+        expect(histogram.counts[0]).to.equal(1);
+        expect(histogram.counts[1]).to.equal(1);
+        expect(histogram.counts[2]).to.equal(1);
+        expect(histogram.counts[histogram.counts.length - 1]).to.equal(1);
+        expect(histogram.count).to.equal(4);
+        expect(histogram.max).to.equal(20000);
+        expect(histogram.snapshot().avg).to.equal(5003.125);
+    });
+
+    it('Histogram-time', async () => {
+        const histogram = new Histogram('test', {});
+
+        expect(histogram.time(() => 1)).to.equal(1);
+        expect(histogram.count).to.equal(1);
+
+        // async functions are timed until they are settled
+        const result = histogram.time(async () => {
+            await sleep(20);
+            throw new Error('failed');
+        });
+        expect(histogram.count).to.equal(1);
+        await expect(result).to.be.rejectedWith('failed');
+        expect(histogram.count).to.equal(2);
+        expect(histogram.max).to.be.greaterThanOrEqual(15);
+    });
+
+    it('Instrumentation-prometheus', () => {
+        const instrumentation = new Instrumentation();
+
+        instrumentation.observe('dzsm_test_seconds', { method: 'run' }, 3);
+        instrumentation.observe('dzsm_test_seconds', { method: 'run' }, 30);
+        instrumentation.observe('dzsm_test_seconds', { method: 'say "hi"' }, 1);
+        // same labels share the histogram
+        expect(instrumentation.histogram('dzsm_test_seconds', { method: 'run' }).count).to.equal(2);
+
+        instrumentation.registerGauge('dzsm_test_gauge', 'Test gauge', () => [{ value: 42 }]);
+
+        const lines = instrumentation.toPrometheus().split('\n');
+        expect(lines).to.include('# TYPE dzsm_test_seconds histogram');
+        expect(lines).to.include('dzsm_test_seconds_bucket{method="run",le="0.001"} 0');
+        expect(lines).to.include('dzsm_test_seconds_bucket{method="run",le="0.005"} 1');
+        expect(lines).to.include('dzsm_test_seconds_bucket{method="run",le="0.05"} 2');
+        expect(lines).to.include('dzsm_test_seconds_bucket{method="run",le="+Inf"} 2');
+        expect(lines).to.include('dzsm_test_seconds_sum{method="run"} 0.033');
+        expect(lines).to.include('dzsm_test_seconds_count{method="run"} 2');
+        expect(lines).to.include('dzsm_test_seconds_count{method="say \\"hi\\""} 1');
+        expect(lines).to.include('# TYPE dzsm_test_gauge gauge');
+        expect(lines).to.include('dzsm_test_gauge 42');
+
+        instrumentation.unregisterGauge('dzsm_test_gauge');
+        expect(instrumentation.toPrometheus()).to.not.include('dzsm_test_gauge');
+    });
+
+    it('Instrumentation-instances', () => {
+        const instrumentation = new Instrumentation();
+
+        expect(instanceLabels(undefined, { a: 'b' })).to.deep.equal({ a: 'b' });
+        instrumentation.observe('dzsm_test_seconds', instanceLabels('chernarus', { method: 'run' }), 1);
+        instrumentation.observe('dzsm_test_seconds', instanceLabels('livonia', { method: 'run' }), 1);
+        instrumentation.observe('dzsm_shared_seconds', {}, 1);
+
+        // each instance sees its own and the process wide series
+        const chernarus = instrumentation.toPrometheus('chernarus');
+        expect(chernarus).to.include('dzsm_test_seconds_count{method="run",instance="chernarus"} 1');
+        expect(chernarus).to.not.include('livonia');
+        expect(chernarus).to.include('dzsm_shared_seconds_count 1');
+        expect(instrumentation.getReport('livonia').histograms.map((x) => x.labels.instance))
+            .to.deep.equal(['livonia', undefined]);
+
+        // without an instance, everything is read
+        expect(instrumentation.getHistograms().length).to.equal(3);
+    });
+
+    it('Instrumentation-process', async () => {
+        const instrumentation = new Instrumentation();
+
+        // two users (i.e. server instances) share the process metrics
+        instrumentation.startProcessMetrics();
+        instrumentation.startProcessMetrics();
+
+        await sleep(30);
+        const start = Date.now();
+        while (Date.now() - start < 60) {
+            // block the event loop
+        }
+        await sleep(30);
+        instrumentation['rollLagWindow']();
+
+        const report = instrumentation.getReport();
+        expect(report.eventLoopLag.max).to.be.greaterThanOrEqual(40);
+        expect(report.memory.heapUsed).to.be.greaterThan(0);
+        expect(instrumentation.toPrometheus()).to.include('dzsm_event_loop_lag_seconds{stat="max"}');
+
+        instrumentation.stopProcessMetrics();
+        expect(instrumentation.toPrometheus()).to.include('dzsm_process_memory_bytes{type="heapUsed"}');
+
+        instrumentation.stopProcessMetrics();
+        expect(instrumentation.toPrometheus()).to.not.include('dzsm_process_memory_bytes');
+        expect(instrumentation.getReport().eventLoopLag.max).to.equal(0);
+
+        // unbalanced stops are ignored
+        instrumentation.stopProcessMetrics();
+        expect(instrumentation['processUsers']).to.equal(0);
+        expect(instrumentation.getHistograms().every((x) => x.name === GC_DURATION)).to.be.true;
+    });
+
+});
@@ -0,0 +1,117 @@
+import { expect } from '../expect';
+import { ImportMock } from 'ts-mock-imports'
+import { memfs } from '../util';
+import { LogStore } from '../../src/util/log-store';
+import { FSAPI } from '../../src/util/apis';
+
+describe('Test LogStore', () => {
+
+    let fs: FSAPI;
+
+    beforeEach(() => {
+        // restore mocks
+        ImportMock.restore();
+
+        fs = memfs({}, '/');
+    });
+
+    it('LogStore-ring', async () => {
+
+        const store = new LogStore(fs, '/store', 10);
+        for (let i = 1; i <= 8; i++) {
+            store.push({ timestamp: i, message: `line ${i}` });
+        }
+
+        expect(store.segmentFiles).to.be.empty;
+        expect((await store.fetch()).length).to.equal(8);
+        expect((await store.fetch(6)).map((x) => x.timestamp)).to.deep.equal([7, 8]);
+        expect(await store.fetch(8)).to.be.empty;
+
+    });
+
+    it('LogStore-spill', async () => {
+
+        const store = new LogStore(fs, '/store', 8, 64, 2);
+        for (let i = 1; i <= 100; i++) {
+            store.push({ timestamp: i, message: `line ${i}\nwith newline` });
+        }
+
+        // only the ring buffer is kept in memory
+        expect(store['count']).to.be.lessThanOrEqual(8);
+        expect(store.size).to.equal(100);
+        expect(store.segmentFiles.length).to.be.greaterThan(1);
+
+        const all = await store.fetch();
+        expect(all.map((x) => x.timestamp)).to.deep.equal([...Array(100).keys()].map((x) => x + 1));
+        expect(all[0].message).to.equal('line 1 with newline');
+
+        const range = await store.fetch(41, 5);
+        expect(range.map((x) => x.timestamp)).to.deep.equal([42, 43, 44, 45, 46]);
+
+        store.clear();
+        expect(store.size).to.equal(0);
+        expect(fs.readdirSync('/store')).to.be.empty;
+
+    });
+
+    it('LogStore-same-timestamp', async () => {
+
+        const store = new LogStore(fs, '/store', 4, 1024, 1);
+        for (let i = 0; i < 12; i++) {
+            // lines read in one go share a timestamp
+            const stored = store.push({ timestamp: 1000, message: `line ${i}` });
+            expect(stored.timestamp).to.equal(1000 + i);
+        }
+        // older lines (e.g. a clock going back) are moved after the last line as well
+        expect(store.push({ timestamp: 5, message: 'line 12' }).timestamp).to.equal(1012);
+
+        // every page honours the limit and no line is lost between pages
+        const messages: string[] = [];
+        let since = 0;
+        for (let page = await store.fetch(since, 2); page.length; page = await store.fetch(since, 2)) {
+            expect(page.length).to.be.lessThanOrEqual(2);
+            messages.push(...page.map((x) => x.message));
+            since = page[page.length - 1].timestamp;
+        }
+        expect(messages).to.deep.equal([...Array(13).keys()].map((x) => `line ${x}`));
+
+        // the sequence restarts after clearing
+        store.clear();
+        expect(store.push({ timestamp: 5, message: 'new' }).timestamp).to.equal(5);
+
+    });
+
+    it('LogStore-latest', async () => {
+
+        const store = new LogStore(fs, '/store', 8, 64, 2);
+        for (let i = 1; i <= 100; i++) {
+            store.push({ timestamp: i, message: `line ${i}` });
+        }
+
+        // without since, the newest lines are returned
+        const expected = (count: number) => [...Array(count).keys()].map((x) => 101 - count + x);
+        expect((await store.fetch(undefined, 3)).map((x) => x.timestamp)).to.deep.equal(expected(3));
+        expect((await store.fetch(undefined, 50)).map((x) => x.timestamp)).to.deep.equal(expected(50));
+        expect((await store.fetch(undefined, 200)).map((x) => x.timestamp)).to.deep.equal(expected(100));
+
+    });
+
+    it('LogStore-leftover-segments', async () => {
+
+        fs.mkdirSync('/store', { recursive: true });
+        fs.writeFileSync('/store/segment-0.log', '1\told\n');
+        fs.writeFileSync('/store/segment-7.log', '2\told\n');
+        fs.writeFileSync('/store/other.txt', 'keep');
+
+        // segments of earlier runs are removed on startup
+        const store = new LogStore(fs, '/store', 2, 1024, 1);
+        expect(fs.readdirSync('/store')).to.deep.equal(['other.txt']);
+
+        for (let i = 1; i <= 10; i++) {
+            store.push({ timestamp: i, message: `line ${i}` });
+        }
+        expect((await store.fetch()).length).to.equal(10);
+
+    });
+
+});
@@ -0,0 +1,102 @@
+import { expect } from '../expect';
+import { sleep } from '../util';
+import { formatTaskTimings, GraphTask, runTaskGraph, TaskGraphError, validateTaskGraph } from '../../src/util/task-graph';
+
+describe('Test TaskGraph', () => {
+
+    const createTask = (name: string, ms: number, events: string[], dependsOn?: string[]): GraphTask => ({
+        name,
+        dependsOn,
+        run: async () => {
+            events.push(`start ${name}`);
+            await sleep(ms);
+            events.push(`end ${name}`);
+        },
+    });
+
+    it('TaskGraph-validate', () => {
+        const run = async () => {};
+        expect(() => validateTaskGraph([{ name: 'a', run }, { name: 'a', run }])).to.throw('Duplicate task: a');
+        expect(() => validateTaskGraph([{ name: 'a', dependsOn: ['b'], run }])).to.throw('unknown task b');
+        expect(() => validateTaskGraph([
+            { name: 'a', dependsOn: ['c'], run },
+            { name: 'b', dependsOn: ['a'], run },
+            { name: 'c', dependsOn: ['b'], run },
+        ])).to.throw('Cyclic task dependency: a -> c -> b -> a');
+        expect(() => validateTaskGraph([
+            { name: 'a', run },
+            { name: 'b', dependsOn: ['a'], run },
+            { name: 'c', dependsOn: ['a', 'b'], run },
+        ])).not.to.throw();
+    });
+
+    it('TaskGraph-concurrent', async () => {
+        const events: string[] = [];
+        const result = await runTaskGraph([
+            createTask('c', 5, events, ['a', 'b']),
+            createTask('a', 30, events),
+            createTask('b', 5, events),
+            createTask('d', 5, events, ['b']),
+        ]);
+
+        // independent tasks are started at once
+        expect(events.slice(0, 2)).to.deep.equal(['start a', 'start b']);
+        // d only waits for b
+        expect(events.indexOf('start d')).to.be.below(events.indexOf('end a'));
+        // c waits for both
+        expect(events.indexOf('start c')).to.be.above(events.indexOf('end a'));
+
+        expect(result.timings.map((x) => x.name).sort()).to.deep.equal(['a', 'b', 'c', 'd']);
+        expect(result.duration).to.be.at.least(30);
+        // b and d ran while a was running
+        const a = result.timings.find((x) => x.name === 'a');
+        const d = result.timings.find((x) => x.name === 'd');
+        expect(d.start + d.duration).to.be.at.most(a.start + a.duration);
+        expect(result.criticalPath.map((x) => x.name)).to.deep.equal(['a', 'c']);
+        expect(formatTaskTimings(result.criticalPath)).to.match(/^a \(\d+ms\) -> c \(\d+ms\)$/);
+    });
+
+    it('TaskGraph-empty', async () => {
+        const result = await runTaskGraph([]);
+        expect(result.timings).to.be.empty;
+        expect(result.criticalPath).to.be.empty;
+    });
+
+    it('TaskGraph-failure', async () => {
+        const events: string[] = [];
+        const error = await runTaskGraph([
+            {
+                name: 'a',
+                run: async () => {
+                    throw new Error('Test');
+                },
+            },
+            createTask('b', 10, events, ['a']),
+            createTask('c', 10, events, ['b']),
+            createTask('d', 10, events),
+        ]).catch((e) => e);
+
+        expect(error).to.be.instanceOf(TaskGraphError);
+        expect(error.message).to.equal('Test');
+        // unrelated tasks are finished, dependents are skipped
+        expect(events).to.deep.equal(['start d', 'end d']);
+        const timings = new Map(error.result.timings.map((x) => [x.name, x]));
+        expect(timings.get('a').error.message).to.equal('Test');
+        expect(timings.get('b').skipped).to.be.true;
+        expect(timings.get('c').skipped).to.be.true;
+        expect(formatTaskTimings([timings.get('c')])).to.equal('c (skipped)');
+        expect(error.result.criticalPath.map((x) => x.name)).to.deep.equal(['d']);
+    });
+
+    it('TaskGraph-non-error-rejection', async () => {
+        const error = await runTaskGraph([
+            {
+                name: 'a',
+                // eslint-disable-next-line prefer-promise-reject-errors
+                run: () => Promise.reject('reason'),
+            },
+        ]).catch((e) => e);
+        expect(error.reason.message).to.equal('Task a failed: reason');
+    });
+
+});
@@ -1,10 +1,10 @@
 import { HttpClient } from '@angular/common/http';
 import { Injectable } from '@angular/core';
-import { Config, LogType, LogTypeEnum, MetricType, MetricTypeEnum, MetricWrapper, ServerInfo, SystemReport, isSameServerInfo } from '../models';
+import { Config, InstrumentationReport, LogType, LogTypeEnum, MetricPage, MetricType, MetricTypeEnum, MetricWrapper, ServerInfo, SystemReport, isSameServerInfo } from '../models';
 import { AuthService } from '../../auth/services/auth.service';
 import Chart from 'chart.js';
-import { BehaviorSubject, Observable, of, Subject, Subscription, timer } from 'rxjs';
-import { catchError, map, tap } from 'rxjs/operators';
+import { BehaviorSubject, EMPTY, Observable, of, Subject, Subscription, timer } from 'rxjs';
+import { catchError, expand, map, tap } from 'rxjs/operators';
 
 const processError = (err: any, prefix?: string): Observable<any> => {
     let message = '';
@@ -17,6 +17,9 @@ const processError = (err: any, prefix?: string): Observable<any> => {
     return of(null);
 };
 
+const METRIC_PAGE_SIZE = 500;
+const LOG_PAGE_SIZE = 1000;
+
 type ApiFetcherTypes = LogType | MetricType;
 interface Timestamped {
     timestamp: number;
@@ -28,6 +31,7 @@ export class ApiFetcher<K extends ApiFetcherTypes, T extends Timestamped> {
     private dataInserted$ = new Subject<T>();
 
     private apiPath: string;
+    private isMetric = false;
 
     public constructor(
         private httpClient: HttpClient,
@@ -38,6 +42,7 @@ export class ApiFetcher<K extends ApiFetcherTypes, T extends Timestamped> {
             this.apiPath = `/api/logs`;
         } else if (Object.keys(MetricTypeEnum).includes(dataType)) {
             this.apiPath = `/api/metrics`;
+            this.isMetric = true;
         } else {
             throw new Error('Unknown data type');
         }
@@ -103,12 +108,44 @@ export class ApiFetcher<K extends ApiFetcherTypes, T extends Timestamped> {
     }
 
     private fetchFromServer(since?: number): Observable<T[]> {
-        return this.httpClient.get<T>(
+        if (this.isMetric) {
+            return this.fetchPagesFromServer(since);
+        }
+        return this.fetchLogsFromServer();
+    }
+
+    // logs start with the newest page, then page forward from the last line (server timestamps, not the client clock)
+    private fetchLogsFromServer(): Observable<T[]> {
+        const fetchPage = (since?: number): Observable<T[] | null> => this.httpClient.get<T[]>(
+            this.apiPath,
+            {
+                params: {
+                    type: this.dataType,
+                    ...(since ? { since: String(since), limit: String(LOG_PAGE_SIZE) } : {}),
+                },
+                headers: this.getAuthHeaders(),
+                withCredentials: true,
+            },
+        ).pipe(
+            catchError((e) => processError(e, `Failed to fetch ${this.dataType} from ${this.apiPath}`)),
+        );
+
+        const last = this.lastUpdated;
+        return fetchPage(last || undefined).pipe(
+            expand((page) => (last && page && page.length >= LOG_PAGE_SIZE ? fetchPage(page[page.length - 1].timestamp) : EMPTY)),
+            map((page) => page ?? []),
+        );
+    }
+
+    // metrics are fetched page by page, so neither side has to hold the whole history at once
+    private fetchPagesFromServer(since?: number): Observable<T[]> {
+        const fetchPage = (cursor: number): Observable<MetricPage<any> | null> => this.httpClient.get<MetricPage<any>>(
             this.apiPath,
             {
                 params: {
                     type: this.dataType,
-                    since: String(since ?? 0),
+                    cursor: String(cursor),
+                    limit: String(METRIC_PAGE_SIZE),
                 },
                 headers: this.getAuthHeaders(),
                 withCredentials: true,
@@ -116,6 +153,11 @@ export class ApiFetcher<K extends ApiFetcherTypes, T extends Timestamped> {
         ).pipe(
             catchError((e) => processError(e, `Failed to fetch ${this.dataType} from ${this.apiPath}`)),
         );
+
+        return fetchPage(since ?? 0).pipe(
+            expand((page) => (page?.nextCursor ? fetchPage(page.nextCursor) : EMPTY)),
+            map((page) => (page?.items ?? []) as any as T[]),
+        );
     }
 
 }
@@ -272,7 +314,33 @@ export class AppCommonService {
             },
         }[type][metric];
 
-        return this.getApiFetcher<MetricTypeEnum.SYSTEM, MetricWrapper<SystemReport>>(MetricTypeEnum.SYSTEM)!.data.pipe(
+        return this.lineChart<SystemReport>(MetricTypeEnum.SYSTEM, `${metric.toUpperCase()} Usage`, dataMapper, 100);
+    }
+
+    public instrumentationChart(metric: 'lag' | 'heap'): Observable<Chart.ChartConfiguration> {
+
+        const chart = {
+            lag: {
+                label: 'Event Loop Lag p99 (ms)',
+                dataMapper: (x: MetricWrapper<InstrumentationReport>) => x.value.eventLoopLag.p99,
+            },
+            heap: {
+                label: 'Heap Used (MB)',
+                dataMapper: (x: MetricWrapper<InstrumentationReport>) => Math.round(x.value.memory.heapUsed / 1024 / 1024),
+            },
+        }[metric];
+
+        return this.lineChart<InstrumentationReport>(MetricTypeEnum.INSTRUMENTATION, chart.label, chart.dataMapper);
+    }
+
+    private lineChart<T>(
+        type: MetricType,
+        label: string,
+        dataMapper: (x: MetricWrapper<T>) => number,
+        max?: number,
+    ): Observable<Chart.ChartConfiguration> {
+
+        return this.getApiFetcher<MetricType, MetricWrapper<T>>(type)!.data.pipe(
             map((values) => {
                 let last = 0;
                 const lastTime = values?.length ? values[values.length - 1].timestamp : 0;
@@ -291,7 +359,7 @@ export class AppCommonService {
                         }),
                         datasets: [
                             {
-                                label: `${metric.toUpperCase()} Usage`,
+                                label,
                                 lineTension: 0.2,
                                 backgroundColor: 'rgba(2,117,216,0.2)',
                                 borderColor: 'rgba(2,117,216,1)',
@@ -328,7 +396,7 @@ export class AppCommonService {
                                 {
                                     ticks: {
                                         min: 0,
-                                        max: 100,
+                                        max,
                                         // maxTicksLimit: 5,
                                     },
                                     gridLines: {
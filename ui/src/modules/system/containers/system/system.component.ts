@@ -1,5 +1,7 @@
 import { ChangeDetectionStrategy, Component, OnInit } from '@angular/core';
-import { MetricType, MetricWrapper, MetricTypeEnum } from '../../../app-common/models';
+import { Observable } from 'rxjs';
+import { map } from 'rxjs/operators';
+import { InstrumentationHistogram, InstrumentationReport, MetricType, MetricWrapper, MetricTypeEnum } from '../../../app-common/models';
 import { ApiFetcher, AppCommonService } from '../../../app-common/services/app-common.service';
 
 @Component({
@@ -30,4 +32,23 @@ export class SystemComponent implements OnInit {
         return this.getFetcher(MetricTypeEnum.SYSTEM);
     }
 
+    public getInstrumentationFetcher(): ApiFetcher<MetricType, MetricWrapper<any>> {
+        return this.getFetcher(MetricTypeEnum.INSTRUMENTATION);
+    }
+
+    /**
+     * @returns the timings of the latest instrumentation sample, slowest first
+     */
+    public getTimings(): Observable<InstrumentationHistogram[]> {
+        return this.getInstrumentationFetcher().latestData.pipe(
+            map((x: MetricWrapper<InstrumentationReport> | null) => [...(x?.value.histograms ?? [])]
+                .filter((histogram) => histogram.count > 0)
+                .sort((a, b) => b.avg - a.avg)),
+        );
+    }
+
+    public formatLabels(histogram: InstrumentationHistogram): string {
+        return Object.keys(histogram.labels).map((x) => histogram.labels[x]).join(' ');
+    }
+
 }